@@ -141,6 +141,11 @@ public:
    virtual sampleCount RealtimeProcess(int group, float **inbuf, float **outbuf, sampleCount numSamples) = 0;
    virtual bool RealtimeProcessEnd() = 0;
 
+   // Whether the processors added by RealtimeAddProcessor() may also be used
+   // to process the selected tracks offline, each on a thread of its own.
+   // GetLatency() is asked once, after they are added, for all of them.
+   virtual bool SupportsParallelProcessing() { return false; }
+
    virtual bool ShowInterface(wxWindow *parent, bool forceModal = false) = 0;
 
    virtual bool GetAutomationParameters(EffectAutomationParameters & parms) = 0;
@@ -117,6 +117,13 @@ wxArrayString aStr;
 unsigned int currentLine;
 size_t currentPosition;
 
+// Commands received between BeginBatch and EndBatch lines are sent to
+// Audacity together when EndBatch comes, and get no responses before then.
+// Audacity runs them one after another and sends back the responses of
+// each, with an empty line between those of one command and the next.
+bool inBatch = false;
+wxString batch;
+
 // Send the received command to Audacity and build an array of response lines.
 // The response lines can be retrieved by calling DoSrvMore repeatedly.
 int DoSrv(char *pIn)
@@ -124,6 +131,27 @@ int DoSrv(char *pIn)
    wxString Str1(pIn, wxConvISO8859_1);
    Str1.Replace( wxT("\r"), wxT(""));
    Str1.Replace( wxT("\n"), wxT(""));
+
+   if( Str1 == wxT("BeginBatch") )
+   {
+      inBatch = true;
+      batch = wxEmptyString;
+      aStr.Clear();
+      return 1;
+   }
+   if( inBatch && Str1 != wxT("EndBatch") )
+   {
+      batch += Str1 + wxT("\n");
+      aStr.Clear();
+      return 1;
+   }
+   if( inBatch )
+   {
+      inBatch = false;
+      Str1 = batch;
+      batch = wxEmptyString;
+   }
+
    Str2 = wxEmptyString;
    (*pScriptServerFn)( &Str1 , &Str2);
 
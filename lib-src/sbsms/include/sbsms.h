@@ -94,7 +94,9 @@ class SBSMSImp;
 
 class SBSMS {
  public:
-  SBSMS(int channels, SBSMSQuality *quality, bool bSynthesize);
+  // bMultithreaded only has an effect when built with MULTITHREADED
+#define SBSMS_MULTITHREADED_OPTION 1
+  SBSMS(int channels, SBSMSQuality *quality, bool bSynthesize, bool bMultithreaded = true);
   ~SBSMS();
 
   long read(SBSMSInterface *iface, audio *buf, long n);
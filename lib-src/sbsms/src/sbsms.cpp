@@ -53,7 +53,7 @@ class ThreadInterface;
 
 class SBSMSImp {
 public:
-  SBSMSImp(int channels, SBSMSQuality *quality, bool bSynthesize);
+  SBSMSImp(int channels, SBSMSQuality *quality, bool bSynthesize, bool bMultithreaded);
   ~SBSMSImp();
   inline long read(SBSMSInterface *iface, audio *buf, long n);
   inline void addRenderer(SBSMSRenderer *renderer);
@@ -390,18 +390,10 @@ ThreadInterface :: ~ThreadInterface()
     pthread_cond_broadcast(&trial2Cond[c]);
     pthread_mutex_unlock(&trial2Mutex[c]);
     pthread_join(trial2Thread[c],NULL);
-    pthread_mutex_lock(&adjust2Mutex);
-    pthread_cond_broadcast(&adjust2Cond);
-    pthread_mutex_unlock(&adjust2Mutex);
-    pthread_join(adjust2Thread,NULL);
     pthread_mutex_lock(&trial1Mutex[c]);
     pthread_cond_broadcast(&trial1Cond[c]);
     pthread_mutex_unlock(&trial1Mutex[c]);
     pthread_join(trial1Thread[c],NULL);
-    pthread_mutex_lock(&adjust1Mutex);
-    pthread_cond_broadcast(&adjust1Cond);
-    pthread_mutex_unlock(&adjust1Mutex);
-    pthread_join(adjust1Thread,NULL);
     if(bRenderThread) {
       pthread_mutex_lock(&renderMutex[c]);
       pthread_cond_broadcast(&renderCond[c]);
@@ -409,6 +401,15 @@ ThreadInterface :: ~ThreadInterface()
       pthread_join(renderThread[c],NULL);
     }
   }
+  // There is one of each of these, whatever the number of channels
+  pthread_mutex_lock(&adjust2Mutex);
+  pthread_cond_broadcast(&adjust2Cond);
+  pthread_mutex_unlock(&adjust2Mutex);
+  pthread_join(adjust2Thread,NULL);
+  pthread_mutex_lock(&adjust1Mutex);
+  pthread_cond_broadcast(&adjust1Cond);
+  pthread_mutex_unlock(&adjust1Mutex);
+  pthread_join(adjust1Thread,NULL);
 }
 
 void ThreadInterface :: signalReadWrite() 
@@ -529,7 +530,7 @@ void ThreadInterface :: waitReadWrite() {
       }
     }
   }
-  if(!bReady) {
+  if(bActive && !bReady) {
     pthread_cond_wait(&readWriteCond,&readWriteMutex);
   }
   pthread_mutex_unlock(&readWriteMutex);
@@ -537,7 +538,7 @@ void ThreadInterface :: waitReadWrite() {
 
 void ThreadInterface :: waitAnalyze(int i) {
   pthread_mutex_lock(&analyzeMutex[i]);
-  if(!top->analyzeInit(i,false)) {
+  if(bActive && !top->analyzeInit(i,false)) {
     pthread_cond_wait(&analyzeCond[i],&analyzeMutex[i]);
   }
   pthread_mutex_unlock(&analyzeMutex[i]);
@@ -545,7 +546,7 @@ void ThreadInterface :: waitAnalyze(int i) {
 
 void ThreadInterface :: waitExtract(int c) {
   pthread_mutex_lock(&extractMutex[c]);
-  if(!top->extractInit(c,false)) {
+  if(bActive && !top->extractInit(c,false)) {
     pthread_cond_wait(&extractCond[c],&extractMutex[c]);
   }
   pthread_mutex_unlock(&extractMutex[c]);
@@ -553,7 +554,7 @@ void ThreadInterface :: waitExtract(int c) {
 
 void ThreadInterface :: waitAssign(int c) {
   pthread_mutex_lock(&assignMutex[c]);
-  if(!top->markInit(c,false) && !top->assignInit(c,false)) {
+  if(bActive && !top->markInit(c,false) && !top->assignInit(c,false)) {
     pthread_cond_wait(&assignCond[c],&assignMutex[c]);
   }
   pthread_mutex_unlock(&assignMutex[c]);
@@ -561,7 +562,7 @@ void ThreadInterface :: waitAssign(int c) {
 
 void ThreadInterface :: waitTrial2(int c) {
   pthread_mutex_lock(&trial2Mutex[c]);
-  if(!top->trial2Init(c,false)) {
+  if(bActive && !top->trial2Init(c,false)) {
     pthread_cond_wait(&trial2Cond[c],&trial2Mutex[c]);
   }
   pthread_mutex_unlock(&trial2Mutex[c]);
@@ -569,7 +570,7 @@ void ThreadInterface :: waitTrial2(int c) {
 
 void ThreadInterface :: waitAdjust2() {
   pthread_mutex_lock(&adjust2Mutex);
-  if(!top->adjust2Init(false)) {
+  if(bActive && !top->adjust2Init(false)) {
     pthread_cond_wait(&adjust2Cond,&adjust2Mutex);
   }
   pthread_mutex_unlock(&adjust2Mutex);
@@ -577,7 +578,7 @@ void ThreadInterface :: waitAdjust2() {
 
 void ThreadInterface :: waitTrial1(int c) {
   pthread_mutex_lock(&trial1Mutex[c]);
-  if(!top->trial1Init(c,false)) {
+  if(bActive && !top->trial1Init(c,false)) {
     pthread_cond_wait(&trial1Cond[c],&trial1Mutex[c]);
   }
   pthread_mutex_unlock(&trial1Mutex[c]);
@@ -585,7 +586,7 @@ void ThreadInterface :: waitTrial1(int c) {
 
 void ThreadInterface :: waitAdjust1() {
   pthread_mutex_lock(&adjust1Mutex);
-  if(!top->adjust1Init(false)) {
+  if(bActive && !top->adjust1Init(false)) {
     pthread_cond_wait(&adjust1Cond,&adjust1Mutex);
   }
   pthread_mutex_unlock(&adjust1Mutex);
@@ -593,7 +594,7 @@ void ThreadInterface :: waitAdjust1() {
 
 void ThreadInterface :: waitRender(int c) {
   pthread_mutex_lock(&renderMutex[c]);
-  if(!top->renderInit(c,false)) {
+  if(bActive && !top->renderInit(c,false)) {
     pthread_cond_wait(&renderCond[c],&renderMutex[c]);
   }
   pthread_mutex_unlock(&renderMutex[c]);
@@ -609,9 +610,9 @@ void SBSMSImp :: reset()
   nPresamplesDone = 0;
 }
 
-SBSMS :: SBSMS(int channels, SBSMSQuality *quality, bool bSynthesize)
-{ imp = new SBSMSImp(channels,quality,bSynthesize); }
-SBSMSImp :: SBSMSImp(int channels, SBSMSQuality *quality, bool bSynthesize)
+SBSMS :: SBSMS(int channels, SBSMSQuality *quality, bool bSynthesize, bool bMultithreaded)
+{ imp = new SBSMSImp(channels,quality,bSynthesize,bMultithreaded); }
+SBSMSImp :: SBSMSImp(int channels, SBSMSQuality *quality, bool bSynthesize, bool bMultithreaded)
 {
   this->channels = channels;
   this->quality = new SBSMSQuality(&quality->params);
@@ -621,7 +622,9 @@ SBSMSImp :: SBSMSImp(int channels, SBSMSQuality *quality, bool bSynthesize)
   nPrepad = quality->getMaxPresamples();
   reset();
 #ifdef MULTITHREADED
-  threadInterface = new ThreadInterface(this,bSynthesize);
+  // Without the threads, the stages are run in turn by read() and
+  // renderFrame(), as in a single threaded build
+  threadInterface = bMultithreaded ? new ThreadInterface(this,bSynthesize) : NULL;
 #endif
 }
 
@@ -705,7 +708,7 @@ long SBSMSImp :: read(SBSMSInterface *iface, audio *buf, long n)
     nReadTotal += nRead;
     if(nRead) {
 #ifdef MULTITHREADED
-      if(threadInterface->bRenderThread) {
+      if(threadInterface && threadInterface->bRenderThread) {
         for(int c=0; c<channels; c++) {
           threadInterface->signalRender(c);
         }
@@ -713,24 +716,25 @@ long SBSMSImp :: read(SBSMSInterface *iface, audio *buf, long n)
 #endif
     } else {
 #ifdef MULTITHREADED
-      threadInterface->waitReadWrite();
+      if(threadInterface) threadInterface->waitReadWrite();
 #endif
       if(top->writeInit()) {
         write(iface);
 #ifdef MULTITHREADED
-        threadInterface->signalAnalyze();
+        if(threadInterface) threadInterface->signalAnalyze();
 #endif
       }
     }
 #ifdef MULTITHREADED
-    if(!threadInterface->bRenderThread) {
-      for(int c=0; c<channels; c++) {     
-        threadInterface->signalRender(c);
+    if(threadInterface) {
+      if(!threadInterface->bRenderThread) {
+        for(int c=0; c<channels; c++) {     
+          threadInterface->signalRender(c);
+        }
       }
-    }
-#else
-    top->process(true);
+    } else
 #endif
+    top->process(true);
     nSamplesOutputed += nRead;
   }
   return nReadTotal;
@@ -753,24 +757,24 @@ long SBSMSImp :: renderFrame(SBSMSInterface *iface)
     }
     if(nRendered) {
 #ifdef MULTITHREADED
-      threadInterface->signalAdjust1();
+      if(threadInterface) threadInterface->signalAdjust1();
 #endif
     } else {
 #ifdef MULTITHREADED
-      threadInterface->waitReadWrite();  
+      if(threadInterface) threadInterface->waitReadWrite();  
 #endif      
       if(top->writeInit()) {
         write(iface);
       }
       
 #ifdef MULTITHREADED
-      threadInterface->signalAnalyze();
+      if(threadInterface) threadInterface->signalAnalyze();
 #endif
     }
 #ifdef MULTITHREADED
-#else
-    top->process(false);
+    if(!threadInterface)
 #endif
+    top->process(false);
     if(nSamplesOutputed >= iface->getSamplesToOutput()) {
       top->renderComplete(iface->getSamplesToOutput());
     }
@@ -74,7 +74,7 @@ sub stopTiming{
 sub sendCommand{
    my $command = shift;
    if ($^O eq 'MSWin32') {
-      print TO_SRV "$command\r\n\0";
+      print TO_SRV "$command\r\n\0";
    } else {
       # Don't explicitly send \0 on Linux or reads after the first one fail...
       print TO_SRV "$command\n";
@@ -189,6 +189,33 @@ sub stressTest{
    }
 }
 
+# Send the same commands in one batch, which takes one round trip
+sub batchStressTest{
+   startTiming();
+   sendCommand("BeginBatch");
+   my $n = 0;
+   while($n < 600){
+      sendCommand("GetAllMenuCommands: ShowStatus=0");
+      ++$n;
+   }
+   sendCommand("EndBatch");
+
+   # The responses of each command end with an empty line
+   $n = 0;
+   while($n < 600){
+      getResponses();
+      ++$n;
+   }
+   stopTiming();
+}
+
+# Read a second of the first track as raw floats, and write it back
+sub sampleRoundTrip{
+   my $file = shift;
+   doCommand("GetSamples: TrackIndex=0 Start=0 Length=44100 Filename=$file");
+   doCommand("SetSamples: TrackIndex=0 Start=0 Filename=$file");
+}
+
 # Get help on a command
 sub help{
    my $cmdName = shift;
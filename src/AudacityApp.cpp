@@ -79,6 +79,7 @@ It handles initialization and termination by subclassing wxApp.
 #include "Project.h"
 #include "Screenshot.h"
 #include "Sequence.h"
+#include "Tracer.h"
 #include "WaveTrack.h"
 #include "Internat.h"
 #include "prefs/PrefsDialog.h"
@@ -1028,6 +1029,7 @@ int AudacityApp::FilterEvent(wxEvent & event)
 bool AudacityApp::OnInit()
 {
    delete wxLog::SetActiveTarget(new AudacityLogger);
+   TRACE_THREAD_NAME("Main");
 
    m_aliasMissingWarningShouldShow = true;
    m_LastMissingBlockFile = NULL;
@@ -294,14 +294,18 @@ writing audio.
 
 #include "AudacityApp.h"
 #include "AudioIO.h"
+#include "DirManager.h"
 #include "Mix.h"
 #include "MixerBoard.h"
+#include "MeterTap.h"
 #include "Resample.h"
 #include "RingBuffer.h"
 #include "Prefs.h"
 #include "Project.h"
+#include "Tracer.h"
 #include "WaveTrack.h"
 
+#include "effects/EffectWorkQueue.h"
 #include "toolbars/ControlToolBar.h"
 #include "widgets/Meter.h"
 
@@ -451,6 +455,50 @@ class MidiThread : public AudioThread {
 };
 #endif
 
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+// Moves the captured samples to the tracks, so that writing them
+// doesn't hold up the filling of the playback buffers
+class CaptureThread : public AudioThread {
+ public:
+   virtual ExitCode Entry();
+};
+
+// Helps the capture thread with the channels when there are several
+class CaptureWriterThread : public AudioThread {
+ public:
+   virtual ExitCode Entry();
+};
+
+// Most channels written at once, beside the capture thread's own
+static const int kMaxCaptureWriters = 7;
+
+// A channel of the capture tracks, as an item of EffectWorkQueue
+struct CaptureChannel
+{
+   int mChannel;
+   sampleCount mDone;
+   bool mResult;
+};
+
+// The channels of one call of FillCaptureBuffers()
+class CaptureQueue : public EffectWorkQueue<CaptureChannel>
+{
+ public:
+   CaptureQueue(std::vector<CaptureChannel> &channels, int avail,
+                XMLStringWriter *appendLogs, bool flush)
+   :  EffectWorkQueue<CaptureChannel>(channels),
+      mAvail(avail),
+      mAppendLogs(appendLogs),
+      mFlush(flush)
+   {
+   }
+
+   int mAvail;
+   XMLStringWriter *mAppendLogs;
+   bool mFlush;
+};
+#endif
+
 
 //////////////////////////////////////////////////////////////////////
 //
@@ -465,6 +513,11 @@ void InitAudioIO()
 #ifdef EXPERIMENTAL_MIDI_OUT
    gAudioIO->mMidiThread->Run();
 #endif
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+   gAudioIO->mCaptureThread->Run();
+   for (int t = 0; t < gAudioIO->mNumCaptureWriters; t++)
+      gAudioIO->mCaptureWriters[t]->Run();
+#endif
 
    // Make sure device prefs are initialized
    if (gPrefs->Read(wxT("AudioIO/RecordingDevice"), wxT("")) == wxT("")) {
@@ -524,6 +577,16 @@ AudioIO::AudioIO()
    mAudioThreadShouldCallFillBuffersOnce = false;
    mAudioThreadFillBuffersLoopRunning = false;
    mAudioThreadFillBuffersLoopActive = false;
+#ifdef EXPERIMENTAL_TRACING
+   mCallbackTrace = NULL;
+#endif
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+   mCaptureThreadShouldCallFillBuffersOnce = false;
+   mCaptureThreadFillBuffersLoopRunning = false;
+   mCaptureThreadFillBuffersLoopActive = false;
+   mCaptureQueue = NULL;
+   mCaptureWritersBusy = 0;
+#endif
    mPortStreamV19 = NULL;
 
 #ifdef EXPERIMENTAL_MIDI_OUT
@@ -603,6 +666,19 @@ AudioIO::AudioIO()
    // Start thread
    mThread = new AudioThread();
    mThread->Create();
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+   mCaptureThread = new CaptureThread();
+   mCaptureThread->Create();
+
+   // GetCPUCount() is -1 when it isn't known
+   mNumCaptureWriters = wxMax(0, wxMin(wxThread::GetCPUCount() - 1,
+                                       kMaxCaptureWriters));
+   mCaptureWriters = new AudioThread *[mNumCaptureWriters];
+   for (int t = 0; t < mNumCaptureWriters; t++) {
+      mCaptureWriters[t] = new CaptureWriterThread();
+      mCaptureWriters[t]->Create();
+   }
+#endif
 
 #if defined(USE_PORTMIXER)
    mPortMixer = NULL;
@@ -642,11 +718,22 @@ AudioIO::~AudioIO()
       (Kill is the not-graceful way.) */
    wxTheApp->Yield();
    mThread->Delete();
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+   mCaptureThread->Delete();
+   for (int t = 0; t < mNumCaptureWriters; t++)
+      mCaptureWriters[t]->Delete();
+#endif
 
    if(mSilentBuf)
       DeleteSamples(mSilentBuf);
 
    delete mThread;
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+   delete mCaptureThread;
+   for (int t = 0; t < mNumCaptureWriters; t++)
+      delete mCaptureWriters[t];
+   delete [] mCaptureWriters;
+#endif
 }
 
 void AudioIO::SetMixer(int inputSource)
@@ -972,6 +1059,13 @@ bool AudioIO::StartPortAudioStream(double sampleRate,
    mInputMeter = NULL;
    mOutputMeter = NULL;
 
+#ifdef EXPERIMENTAL_TRACING
+   // The callback must not lock or allocate, so its trace buffer is made
+   // here, before its first stream
+   if (!mCallbackTrace)
+      mCallbackTrace = Tracer::NewBuffer("Audio callback");
+#endif
+
    mLastPaError = paNoError;
    // pick a rate to do the audio I/O at, from those available. The project
    // rate is suggested, but we may get something else if it isn't supported
@@ -1212,6 +1306,9 @@ int AudioIO::StartStream(WaveTrackArray playbackTracks,
    mCutPreviewGapLen = cutPreviewGapLen;
    mPlaybackBuffers = NULL;
    mPlaybackMixers = NULL;
+#ifdef EXPERIMENTAL_MIXER_METER_TAPS
+   mPlaybackMeterTaps = NULL;
+#endif
    mCaptureBuffers = NULL;
    mResample = NULL;
 
@@ -1337,6 +1434,12 @@ int AudioIO::StartStream(WaveTrackArray playbackTracks,
                                                mRate, floatSample, false);
                mPlaybackMixers[i]->ApplyTrackGains(false);
             }
+
+#ifdef EXPERIMENTAL_MIXER_METER_TAPS
+            mPlaybackMeterTaps = new MeterTap[mPlaybackTracks.GetCount()];
+            for( unsigned int i = 0; i < mPlaybackTracks.GetCount(); i++ )
+               mPlaybackMeterTaps[i].Reset(mRate);
+#endif
          }
 
          if( mNumCaptureChannels > 0 )
@@ -1427,6 +1530,19 @@ int AudioIO::StartStream(WaveTrackArray playbackTracks,
          mWarpedTime = mTime - mT0;
    }
 
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+   mPendingRecoveryLog = wxT("");
+   mLastRecoveryLogMillis = ::wxGetLocalTimeMillis();
+   if (mCaptureTracks.GetCount() > 0)
+      PreallocateCaptureBlockFiles();
+#endif
+
+   mStats.Reset(mRate,
+                mNumPlaybackChannels > 0 ?
+                   (int)(mRate * mPlaybackRingBufferSecs + 0.5f) : 0,
+                mNumCaptureChannels > 0 ?
+                   (int)(mRate * mCaptureRingBufferSecs + 0.5) : 0);
+
    // We signal the audio thread to call FillBuffers, to prime the RingBuffers
    // so that they will have data in them when the stream starts.  Having the
    // audio thread call FillBuffers here makes the code more predictable, since
@@ -1477,6 +1593,9 @@ int AudioIO::StartStream(WaveTrackArray playbackTracks,
    }
 
    mAudioThreadFillBuffersLoopRunning = true;
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+   mCaptureThreadFillBuffersLoopRunning = true;
+#endif
 #ifdef EXPERIMENTAL_MIDI_OUT
    // If audio is not running, mNumFrames will not be incremented and
    // MIDI will hang waiting for it unless we do it here.
@@ -1523,6 +1642,11 @@ void AudioIO::StartStreamCleanup(bool bOnlyBuffers)
       mPlaybackMixers = NULL;
    }
 
+#ifdef EXPERIMENTAL_MIXER_METER_TAPS
+   delete [] mPlaybackMeterTaps;
+   mPlaybackMeterTaps = NULL;
+#endif
+
    if(mCaptureBuffers)
    {
       for( unsigned int i = 0; i < mCaptureTracks.GetCount(); i++ )
@@ -1743,6 +1867,9 @@ void AudioIO::StopStream()
    //
 
    mAudioThreadFillBuffersLoopRunning = false;
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+   mCaptureThreadFillBuffersLoopRunning = false;
+#endif
 
    // Audacity can deadlock if it tries to update meters while
    // we're stopping PortAudio (because the meter updating code
@@ -1768,12 +1895,24 @@ void AudioIO::StopStream()
    }
   #endif
 
+   // FillBuffers() reads the time of the stream, so let the audio thread
+   // leave it before the stream is closed
+   while (mAudioThreadFillBuffersLoopActive)
+      wxMilliSleep(1);
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+   while (mCaptureThreadFillBuffersLoopActive)
+      wxMilliSleep(1);
+#endif
+
    if (mPortStreamV19) {
       Pa_AbortStream( mPortStreamV19 );
       Pa_CloseStream( mPortStreamV19 );
       mPortStreamV19 = NULL;
    }
 
+   if (mStreamToken > 0)
+      mStats.Log();
+
    if (mNumPlaybackChannels > 0)
    {
       wxCommandEvent e(EVT_AUDIOIO_PLAYBACK);
@@ -1839,8 +1978,15 @@ void AudioIO::StopStream()
       // call FillBuffers one last time (it normally would not do so since
       // Pa_GetStreamActive() would now return false
       mAudioThreadShouldCallFillBuffersOnce = true;
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+      mCaptureThreadShouldCallFillBuffersOnce = true;
+#endif
 
-      while( mAudioThreadShouldCallFillBuffersOnce == true )
+      while( mAudioThreadShouldCallFillBuffersOnce == true
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+             || mCaptureThreadShouldCallFillBuffersOnce == true
+#endif
+           )
       {
          // LLL:  Experienced recursive yield here...once.
          wxGetApp().Yield(true); // Pass true for onlyIfNeeded to avoid recursive call error.
@@ -1864,6 +2010,11 @@ void AudioIO::StopStream()
          delete[] mPlaybackMixers;
       }
 
+#ifdef EXPERIMENTAL_MIXER_METER_TAPS
+      delete [] mPlaybackMeterTaps;
+      mPlaybackMeterTaps = NULL;
+#endif
+
       //
       // Offset all recorded tracks to account for latency
       //
@@ -1882,6 +2033,10 @@ void AudioIO::StopStream()
          double recordingOffset =
             mLastRecordingOffset + latencyCorrection / 1000.0;
 
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+         mCaptureTracks[0]->GetDirManager()->ReleasePreallocatedBlockFileNames();
+#endif
+
          for( unsigned int i = 0; i < mCaptureTracks.GetCount(); i++ )
             {
                delete mCaptureBuffers[i];
@@ -2063,6 +2218,21 @@ double AudioIO::GetStreamTime()
    return NormalizeStreamTime(mTime);
 }
 
+#ifdef EXPERIMENTAL_MIXER_METER_TAPS
+bool AudioIO::GetTrackMeter(const WaveTrack *track, double t0, double t1,
+                            float *peak, float *rms, int *peakRun, int *numFrames)
+{
+   if (!IsStreamActive() || !mPlaybackMeterTaps)
+      return false;
+
+   for (unsigned int i = 0; i < mPlaybackTracks.GetCount(); i++)
+      if (mPlaybackTracks[i] == track)
+         return mPlaybackMeterTaps[i].Get(t0, t1, peak, rms, peakRun, numFrames);
+
+   return false;
+}
+#endif
+
 
 wxArrayLong AudioIO::GetSupportedPlaybackRates(int devIndex, double rate)
 {
@@ -2339,6 +2509,8 @@ finished:
 
 AudioThread::ExitCode AudioThread::Entry()
 {
+   TRACE_THREAD_NAME("Audio thread");
+
    while( !TestDestroy() )
    {
       // Set LoopActive outside the tests to avoid race condition
@@ -2360,6 +2532,47 @@ AudioThread::ExitCode AudioThread::Entry()
    return 0;
 }
 
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+AudioThread::ExitCode CaptureThread::Entry()
+{
+   TRACE_THREAD_NAME("Capture thread");
+
+   while( !TestDestroy() )
+   {
+      // Set LoopActive outside the tests to avoid race condition
+      gAudioIO->mCaptureThreadFillBuffersLoopActive = true;
+      if( gAudioIO->mCaptureThreadShouldCallFillBuffersOnce )
+      {
+         gAudioIO->FillCaptureBuffers(true);
+         gAudioIO->mCaptureThreadShouldCallFillBuffersOnce = false;
+      }
+      else if( gAudioIO->mCaptureThreadFillBuffersLoopRunning )
+      {
+         gAudioIO->FillCaptureBuffers(false);
+      }
+      gAudioIO->mCaptureThreadFillBuffersLoopActive = false;
+
+      Sleep(10);
+   }
+
+   return 0;
+}
+
+AudioThread::ExitCode CaptureWriterThread::Entry()
+{
+   TRACE_THREAD_NAME("Capture writer");
+
+   while( !TestDestroy() )
+   {
+      // The capture thread wakes us when it has channels to write
+      if (gAudioIO->mCaptureWritersWake.WaitTimeout(10) == wxSEMA_NO_ERROR)
+         gAudioIO->WriteCaptureChannels();
+   }
+
+   return 0;
+}
+#endif
+
 
 #ifdef EXPERIMENTAL_MIDI_OUT
 MidiThread::ExitCode MidiThread::Entry()
@@ -2816,6 +3029,12 @@ wxString AudioIO::GetDeviceInfo()
 // (which communicates with the audio device).
 void AudioIO::FillBuffers()
 {
+   TRACE_SCOPE("AudioIO::FillBuffers");
+   // The stream is already closed when StopStream() has the last of the
+   // capture saved, and then there is no clock
+   PaStream *stream = mPortStreamV19;
+   double fillStart = stream ? Pa_GetStreamTime(stream) : 0.0;
+
    unsigned int i;
 
    if( mPlaybackTracks.GetCount() > 0 )
@@ -2882,9 +3101,19 @@ void AudioIO::FillBuffers()
                //that causes a crash since this is not the GUI thread and wxASSERT is a GUI call.
                if(deltat > 0.0)
                {
+#ifdef EXPERIMENTAL_MIXER_METER_TAPS
+                  double mixT0 = mPlaybackMixers[i]->MixGetCurrentTime();
+#endif
                   processed = mPlaybackMixers[i]->Process(lrint(deltat * mRate));
                   warpedSamples = mPlaybackMixers[i]->GetBuffer();
                   mPlaybackBuffers[i]->Put(warpedSamples, floatSample, processed);
+#ifdef EXPERIMENTAL_MIXER_METER_TAPS
+                  // The meters of the Mixer Board take these instead of
+                  // reading the track again
+                  mPlaybackMeterTaps[i].Put(mixT0,
+                                            mPlaybackMixers[i]->MixGetCurrentTime(),
+                                            (const float *)warpedSamples, processed);
+#endif
                }
                //if looping and processed is less than the full chunk/block/buffer that gets pulled from
                //other longer tracks, then we still need to advance the ring buffers or
@@ -2918,72 +3147,179 @@ void AudioIO::FillBuffers()
       }
    }  // end of playback buffering
 
-   if( mCaptureTracks.GetCount() > 0 ) // start record buffering
+#ifndef EXPERIMENTAL_CAPTURE_WRITERS
+   FillCaptureBuffers(mAudioThreadShouldCallFillBuffersOnce);
+#endif
+
+   if (stream)
+      mStats.AddFillBuffers(Pa_GetStreamTime(stream) - fillStart);
+}
+
+// Appends what the capture buffers hold to the capture tracks, once there
+// is enough of it or when flush is set
+void AudioIO::FillCaptureBuffers(bool flush)
+{
+   if( mCaptureTracks.GetCount() == 0 )
+      return;
+
+   TRACE_SCOPE("AudioIO::FillCaptureBuffers");
+
+   int commonlyAvail = GetCommonlyAvailCapture();
+
+   //
+   // Determine how much this will add to captured tracks
+   //
+   double deltat = commonlyAvail / mRate;
+
+   if (flush || deltat >= mMinCaptureSecsToCopy)
    {
-      int commonlyAvail = GetCommonlyAvailCapture();
+      // Append captured samples to the end of the WaveTracks.
+      // The WaveTracks have their own buffering for efficiency.
+      XMLStringWriter blockFileLog;
+      int numChannels = mCaptureTracks.GetCount();
+      XMLStringWriter *appendLogs = new XMLStringWriter[numChannels];
+
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+      // The channels go to separate tracks and files, so they are written
+      // side by side by the capture writers, this thread taking a share
+      std::vector<CaptureChannel> channels(numChannels);
+      for (int i = 0; i < numChannels; i++) {
+         channels[i].mChannel = i;
+         channels[i].mDone = 0;
+         channels[i].mResult = false;
+      }
+      CaptureQueue queue(channels, commonlyAvail, appendLogs, flush);
 
-      //
-      // Determine how much this will add to captured tracks
-      //
-      double deltat = commonlyAvail / mRate;
+      mCaptureChannelLock.Lock();
+      mCaptureQueue = &queue;
+      mCaptureChannelLock.Unlock();
 
-      if (mAudioThreadShouldCallFillBuffersOnce ||
-          deltat >= mMinCaptureSecsToCopy)
-      {
-         // Append captured samples to the end of the WaveTracks.
-         // The WaveTracks have their own buffering for efficiency.
-         XMLStringWriter blockFileLog;
-         int numChannels = mCaptureTracks.GetCount();
+      for (int t = 0; t < wxMin(mNumCaptureWriters, numChannels - 1); t++)
+         mCaptureWritersWake.Post();
+
+      WriteCaptureChannels();
+
+      // All the channels are taken; let the writers that took some finish
+      // them, and take the queue away from those that come late
+      mCaptureChannelLock.Lock();
+      mCaptureQueue = NULL;
+      while (mCaptureWritersBusy > 0) {
+         mCaptureChannelLock.Unlock();
+         wxMilliSleep(1);
+         mCaptureChannelLock.Lock();
+      }
+      mCaptureChannelLock.Unlock();
+#else
+      for (int i = 0; i < numChannels; i++)
+         WriteCaptureChannel(i, commonlyAvail, appendLogs[i], flush);
+#endif
 
-         for( i = 0; (int)i < numChannels; i++ )
+      for (int i = 0; i < numChannels; i++)
+      {
+         if (!appendLogs[i].IsEmpty())
          {
-            int avail = commonlyAvail;
-            sampleFormat trackFormat = mCaptureTracks[i]->GetSampleFormat();
+            blockFileLog.StartTag(wxT("recordingrecovery"));
+            blockFileLog.WriteAttr(wxT("channel"), i);
+            blockFileLog.WriteAttr(wxT("numchannels"), numChannels);
+            blockFileLog.WriteSubTree(appendLogs[i]);
+            blockFileLog.EndTag(wxT("recordingrecovery"));
+         }
+      }
+      delete [] appendLogs;
+
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+      // The recovery log is opened and written once a second at most,
+      // rather than for each call
+      mPendingRecoveryLog += blockFileLog;
+      wxLongLong now = ::wxGetLocalTimeMillis();
+      if (flush || now - mLastRecoveryLogMillis >= 1000)
+      {
+         if (mListener && !mPendingRecoveryLog.IsEmpty())
+            mListener->OnAudioIONewBlockFiles(mPendingRecoveryLog);
+         mPendingRecoveryLog = wxT("");
+         mLastRecoveryLogMillis = now;
+      }
 
-            XMLStringWriter appendLog;
+      if (!flush)
+         PreallocateCaptureBlockFiles();
+#else
+      if (mListener && !blockFileLog.IsEmpty())
+         mListener->OnAudioIONewBlockFiles(blockFileLog);
+#endif
+   }
+}
 
-            if( mFactor == 1.0 )
-            {
-               samplePtr temp = NewSamples(avail, trackFormat);
-               mCaptureBuffers[i]->Get   (temp, trackFormat, avail);
-               mCaptureTracks[i]-> Append(temp, trackFormat, avail, 1,
-                                          &appendLog);
-               DeleteSamples(temp);
-            }
-            else
-            {
-               int size = lrint(avail * mFactor);
-               samplePtr temp1 = NewSamples(avail, floatSample);
-               samplePtr temp2 = NewSamples(size, floatSample);
-               mCaptureBuffers[i]->Get(temp1, floatSample, avail);
-               /* we are re-sampling on the fly. The last resampling call
-                * must flush any samples left in the rate conversion buffer
-                * so that they get recorded
-                */
-               size = mResample[i]->Process(mFactor, (float *)temp1, avail, !IsStreamActive(),
-                                            &size, (float *)temp2, size);
-               mCaptureTracks[i]-> Append(temp2, floatSample, size, 1,
-                                          &appendLog);
-               DeleteSamples(temp1);
-               DeleteSamples(temp2);
-            }
+void AudioIO::WriteCaptureChannel(int channel, int avail,
+                                  XMLStringWriter &appendLog, bool flush)
+{
+   sampleFormat trackFormat = mCaptureTracks[channel]->GetSampleFormat();
 
-            if (!appendLog.IsEmpty())
-            {
-               blockFileLog.StartTag(wxT("recordingrecovery"));
-               blockFileLog.WriteAttr(wxT("channel"), (int)i);
-               blockFileLog.WriteAttr(wxT("numchannels"), numChannels);
-               blockFileLog.WriteSubTree(appendLog);
-               blockFileLog.EndTag(wxT("recordingrecovery"));
-            }
-         }
+   if( mFactor == 1.0 )
+   {
+      samplePtr temp = NewSamples(avail, trackFormat);
+      mCaptureBuffers[channel]->Get   (temp, trackFormat, avail);
+      mCaptureTracks[channel]-> Append(temp, trackFormat, avail, 1,
+                                       &appendLog);
+      DeleteSamples(temp);
+   }
+   else
+   {
+      int size = lrint(avail * mFactor);
+      samplePtr temp1 = NewSamples(avail, floatSample);
+      samplePtr temp2 = NewSamples(size, floatSample);
+      mCaptureBuffers[channel]->Get(temp1, floatSample, avail);
+      /* we are re-sampling on the fly. The last resampling call
+       * must flush any samples left in the rate conversion buffer
+       * so that they get recorded.  That is the call to flush, once the
+       * stream has stopped; this may run on a thread that must not ask
+       * the stream itself.
+       */
+      size = mResample[channel]->Process(mFactor, (float *)temp1, avail, flush,
+                                         &size, (float *)temp2, size);
+      mCaptureTracks[channel]-> Append(temp2, floatSample, size, 1,
+                                       &appendLog);
+      DeleteSamples(temp1);
+      DeleteSamples(temp2);
+   }
+}
 
-         if (mListener && !blockFileLog.IsEmpty())
-            mListener->OnAudioIONewBlockFiles(blockFileLog);
-      }
-   }  // end of record buffering
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+void AudioIO::WriteCaptureChannels()
+{
+   mCaptureChannelLock.Lock();
+   CaptureQueue *queue = mCaptureQueue;
+   if (queue)
+      mCaptureWritersBusy++;
+   mCaptureChannelLock.Unlock();
+   if (!queue)
+      return;
+
+   CaptureChannel *channel;
+   while ((channel = queue->Next()) != NULL)
+   {
+      TRACE_SCOPE("Capture channel");
+      WriteCaptureChannel(channel->mChannel, queue->mAvail,
+                          queue->mAppendLogs[channel->mChannel],
+                          queue->mFlush);
+      queue->Finish(channel, true);
+   }
+
+   mCaptureChannelLock.Lock();
+   mCaptureWritersBusy--;
+   mCaptureChannelLock.Unlock();
 }
 
+void AudioIO::PreallocateCaptureBlockFiles()
+{
+   // Names for about 30 seconds of blocks of each channel
+   WaveTrack *track = mCaptureTracks[0];
+   int blocksPerChannel =
+      (int)(track->GetRate() * 30.0 / track->GetMaxBlockSize()) + 1;
+   track->GetDirManager()->PreallocateBlockFileNames(
+      blocksPerChannel * mCaptureTracks.GetCount());
+}
+#endif
+
 void AudioIO::SetListener(AudioIOListener* listener)
 {
    if (IsBusy())
@@ -3431,6 +3767,27 @@ static void DoSoftwarePlaythrough(const void *inputBuffer,
          outputBuffer[2*i + 1] = outputBuffer[2*i];
 }
 
+// Adds the time the callback takes to the stats, however it returns
+class CallbackTimer
+{
+ public:
+   CallbackTimer(unsigned long numFrames)
+   :  mNumFrames((int)numFrames),
+      mStart(Pa_GetStreamTime(gAudioIO->mPortStreamV19))
+   {
+   }
+
+   ~CallbackTimer()
+   {
+      gAudioIO->mStats.AddCallback(mNumFrames,
+         Pa_GetStreamTime(gAudioIO->mPortStreamV19) - mStart);
+   }
+
+ private:
+   int mNumFrames;
+   double mStart;
+};
+
 int audacityAudioCallback(const void *inputBuffer, void *outputBuffer,
                           unsigned long framesPerBuffer,
 // If there were more of these conditionally used arguments, it 
@@ -3441,8 +3798,14 @@ int audacityAudioCallback(const void *inputBuffer, void *outputBuffer,
 #else
                           const PaStreamCallbackTimeInfo * WXUNUSED(timeInfo),
 #endif
-                          const PaStreamCallbackFlags WXUNUSED(statusFlags), void * WXUNUSED(userData) )
+                          const PaStreamCallbackFlags statusFlags, void * WXUNUSED(userData) )
 {
+   TRACE_SCOPE_TO(gAudioIO->mCallbackTrace, "audacityAudioCallback");
+   CallbackTimer timer(framesPerBuffer);
+
+   gAudioIO->mStats.AddDeviceFlags((statusFlags & paOutputUnderflow) != 0,
+                                   (statusFlags & paInputOverflow) != 0);
+
    int numPlaybackChannels = gAudioIO->mNumPlaybackChannels;
    int numPlaybackTracks = gAudioIO->mPlaybackTracks.GetCount();
    int numCaptureChannels = gAudioIO->mNumCaptureChannels;
@@ -3625,6 +3988,16 @@ int audacityAudioCallback(const void *inputBuffer, void *outputBuffer,
                numSolo++;
 #endif
 
+         // Near the end of the selection the buffers run out as they should
+         if (numPlaybackTracks > 0) {
+            int filled = gAudioIO->mPlaybackBuffers[0]->AvailForGet();
+            for (t = 1; t < numPlaybackTracks; t++)
+               filled = std::min(filled, gAudioIO->mPlaybackBuffers[t]->AvailForGet());
+            gAudioIO->mStats.AddPlaybackFill(filled, (int)framesPerBuffer,
+               gAudioIO->mPlayLooped ||
+               gAudioIO->mTime + framesPerBuffer / gAudioIO->mRate < gAudioIO->mT1);
+         }
+
          WaveTrack **chans = (WaveTrack **) alloca(numPlaybackChannels * sizeof(WaveTrack *));
          float **tempBufs = (float **) alloca(numPlaybackChannels * sizeof(float *));
          for (int c = 0; c < numPlaybackChannels; c++)
@@ -3829,6 +4202,8 @@ int audacityAudioCallback(const void *inputBuffer, void *outputBuffer,
                len = avail;
          }
 
+         gAudioIO->mStats.AddCaptureRoom((int)len, (int)framesPerBuffer);
+
          if (len < framesPerBuffer)
          {
             gAudioIO->mLostSamples += (framesPerBuffer - len);
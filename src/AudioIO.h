@@ -32,6 +32,8 @@
 #include <wx/string.h>
 #include <wx/thread.h>
 
+#include "AudioIOStats.h"
+#include "ondemand/ODTaskThread.h"
 #include "WaveTrack.h"
 #include "SampleFormat.h"
 
@@ -42,7 +44,11 @@ class Resample;
 class TimeTrack;
 class AudioThread;
 class Meter;
+class XMLStringWriter;
+class MeterTap;
 class TimeTrack;
+class TraceBuffer;
+class CaptureQueue;
 class wxDialog;
 
 extern AUDACITY_DLL_API AudioIO *gAudioIO;
@@ -290,6 +296,22 @@ class AUDACITY_DLL_API AudioIO {
     */
    double GetStreamTime();
 
+#ifdef EXPERIMENTAL_MIXER_METER_TAPS
+   /** \brief Peak and RMS of a playback track, as mixed by the audio thread
+    *
+    * For the meters of the Mixer Board, so that the track is not read
+    * again.  Gives the stretches of the track that end after t0 and not
+    * after t1, before the track's gain.  Returns false when the track is
+    * not playing or there are none.  Call from the main thread only.
+    */
+   bool GetTrackMeter(const WaveTrack *track, double t0, double t1,
+                      float *peak, float *rms, int *peakRun, int *numFrames);
+#endif
+
+   /** \brief Counts of underruns, overruns and the time the callback and
+    * FillBuffers() took, during the stream now running or the last one */
+   const AudioIOStats &GetStats() const { return mStats; }
+
    sampleFormat GetCaptureFormat() { return mCaptureFormat; }
    int GetNumCaptureChannels() { return mNumCaptureChannels; }
 
@@ -359,6 +381,15 @@ private:
                              unsigned int numCaptureChannels,
                              sampleFormat captureFormat);
    void FillBuffers();
+   void FillCaptureBuffers(bool flush);
+   void WriteCaptureChannel(int channel, int avail, XMLStringWriter &appendLog,
+                            bool flush);
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+   /** \brief Writes channels of mCaptureQueue not yet taken by another
+    * thread, until there are none left */
+   void WriteCaptureChannels();
+   void PreallocateCaptureBlockFiles();
+#endif
 
 #ifdef EXPERIMENTAL_MIDI_OUT
    void PrepareMidiIterator(bool send = true, double offset = 0);
@@ -484,6 +515,13 @@ private:
 #endif
 
    AudioThread        *mThread;
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+   AudioThread        *mCaptureThread;
+   // Help the capture thread with the channels; they live as long as it
+   AudioThread       **mCaptureWriters;
+   int                 mNumCaptureWriters;
+   wxSemaphore         mCaptureWritersWake;
+#endif
 #ifdef EXPERIMENTAL_MIDI_OUT
    AudioThread         *mMidiThread;
 #endif
@@ -494,6 +532,9 @@ private:
    WaveTrackArray      mPlaybackTracks;
 
    Mixer             **mPlaybackMixers;
+#ifdef EXPERIMENTAL_MIXER_METER_TAPS
+   MeterTap           *mPlaybackMeterTaps;
+#endif
    volatile int        mStreamToken;
    static int          mNextStreamToken;
    double              mFactor;
@@ -517,9 +558,26 @@ private:
    unsigned int        mNumPlaybackChannels;
    sampleFormat        mCaptureFormat;
    int                 mLostSamples;
+   AudioIOStats        mStats;
+#ifdef EXPERIMENTAL_TRACING
+   TraceBuffer        *mCallbackTrace;
+#endif
    volatile bool       mAudioThreadShouldCallFillBuffersOnce;
    volatile bool       mAudioThreadFillBuffersLoopRunning;
    volatile bool       mAudioThreadFillBuffersLoopActive;
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+   volatile bool       mCaptureThreadShouldCallFillBuffersOnce;
+   volatile bool       mCaptureThreadFillBuffersLoopRunning;
+   volatile bool       mCaptureThreadFillBuffersLoopActive;
+   // The channels being written, and how many writers are taking them,
+   // guarded by mCaptureChannelLock
+   CaptureQueue       *mCaptureQueue;
+   int                 mCaptureWritersBusy;
+   ODLock              mCaptureChannelLock;
+   // Recovery log of the blocks written since it was last given to mListener
+   wxString            mPendingRecoveryLog;
+   wxLongLong          mLastRecoveryLogMillis;
+#endif
 
    wxLongLong          mLastPlaybackTimeMillis;
 
@@ -563,6 +621,11 @@ private:
    AudioIOListener*    mListener;
 
    friend class AudioThread;
+   friend class CallbackTimer;
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+   friend class CaptureThread;
+   friend class CaptureWriterThread;
+#endif
 #ifdef EXPERIMENTAL_MIDI_OUT
    friend class MidiThread;
 #endif
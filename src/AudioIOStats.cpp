@@ -0,0 +1,166 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  AudioIOStats.cpp
+
+*******************************************************************//**
+
+\class AudioIOStats
+\brief Counts of how well the audio thread and the PortAudio callback
+kept up during one stream.
+
+*//*******************************************************************/
+
+#include "Audacity.h"
+
+#include <wx/log.h>
+
+#include "AudioIOStats.h"
+
+// Upper limits of the bins of the callback load, the time a call takes
+// over the time its buffer lasts; the last bin is for calls that took
+// longer than their buffer lasts.
+static const double kLoadLimits[] = { 0.10, 0.25, 0.50, 0.75, 1.00 };
+static const wxChar *kLoadNames[] = {
+   wxT("CallbackLoadUnder10%"),
+   wxT("CallbackLoadUnder25%"),
+   wxT("CallbackLoadUnder50%"),
+   wxT("CallbackLoadUnder75%"),
+   wxT("CallbackLoadUnder100%"),
+   wxT("CallbackLoadOver100%"),
+};
+
+AudioIOStats::AudioIOStats()
+{
+   Reset(44100.0, 0, 0);
+}
+
+void AudioIOStats::Reset(double rate, int playbackBufferSize, int captureBufferSize)
+{
+   mRate = rate;
+   mPlaybackBufferSize = playbackBufferSize;
+   mCaptureBufferSize = captureBufferSize;
+
+   mCallbacks = 0;
+   mPlaybackUnderruns = 0;
+   mCaptureOverruns = 0;
+   mLostSamples = 0;
+   mOutputUnderflows = 0;
+   mInputOverflows = 0;
+   mMinPlaybackFill = -1;
+   mMinCaptureRoom = -1;
+   for (int i = 0; i < kNumLoadBins; i++)
+      mLoadBins[i] = 0;
+   mMaxCallback = 0;
+   mMaxLoad = 0;
+
+   mFillBuffersCalls = 0;
+   mFillBuffersTotal = 0;
+   mMaxFillBuffers = 0;
+}
+
+void AudioIOStats::AddCallback(int numFrames, double duration)
+{
+   mCallbacks++;
+   if (duration > mMaxCallback)
+      mMaxCallback = duration;
+
+   if (numFrames <= 0)
+      return;
+
+   double load = duration * mRate / numFrames;
+   if (load > mMaxLoad)
+      mMaxLoad = load;
+
+   int bin = 0;
+   while (bin < kNumLoadBins - 1 && load >= kLoadLimits[bin])
+      bin++;
+   mLoadBins[bin]++;
+}
+
+void AudioIOStats::AddDeviceFlags(bool outputUnderflow, bool inputOverflow)
+{
+   if (outputUnderflow)
+      mOutputUnderflows++;
+   if (inputOverflow)
+      mInputOverflows++;
+}
+
+void AudioIOStats::AddPlaybackFill(int filled, int numFrames, bool more)
+{
+   if (mMinPlaybackFill < 0 || filled < mMinPlaybackFill)
+      mMinPlaybackFill = filled;
+   if (filled < numFrames && more)
+      mPlaybackUnderruns++;
+}
+
+void AudioIOStats::AddCaptureRoom(int room, int numFrames)
+{
+   if (mMinCaptureRoom < 0 || room < mMinCaptureRoom)
+      mMinCaptureRoom = room;
+   if (room < numFrames) {
+      mCaptureOverruns++;
+      mLostSamples += numFrames - room;
+   }
+}
+
+void AudioIOStats::AddFillBuffers(double duration)
+{
+   mFillBuffersCalls++;
+   mFillBuffersTotal += duration;
+   if (duration > mMaxFillBuffers)
+      mMaxFillBuffers = duration;
+}
+
+wxArrayString AudioIOStats::Format() const
+{
+   wxArrayString lines;
+
+   lines.Add(wxString::Format(wxT("Callbacks\t%d"), mCallbacks));
+   lines.Add(wxString::Format(wxT("PlaybackUnderruns\t%d"), mPlaybackUnderruns));
+   lines.Add(wxString::Format(wxT("CaptureOverruns\t%d"), mCaptureOverruns));
+   lines.Add(wxString::Format(wxT("CaptureLostSamples\t%d"), mLostSamples));
+   lines.Add(wxString::Format(wxT("DeviceOutputUnderflows\t%d"), mOutputUnderflows));
+   lines.Add(wxString::Format(wxT("DeviceInputOverflows\t%d"), mInputOverflows));
+
+   // Fill levels as seconds, and as parts of the buffers
+   if (mPlaybackBufferSize > 0 && mMinPlaybackFill >= 0) {
+      lines.Add(wxString::Format(wxT("MinPlaybackFillSecs\t%.4f"),
+                                 mMinPlaybackFill / mRate));
+      lines.Add(wxString::Format(wxT("MinPlaybackFillRatio\t%.4f"),
+                                 mMinPlaybackFill / (double)mPlaybackBufferSize));
+   }
+   if (mCaptureBufferSize > 0 && mMinCaptureRoom >= 0) {
+      lines.Add(wxString::Format(wxT("MinCaptureRoomSecs\t%.4f"),
+                                 mMinCaptureRoom / mRate));
+      lines.Add(wxString::Format(wxT("MinCaptureRoomRatio\t%.4f"),
+                                 mMinCaptureRoom / (double)mCaptureBufferSize));
+   }
+
+   for (int i = 0; i < kNumLoadBins; i++)
+      lines.Add(wxString::Format(wxT("%s\t%d"), kLoadNames[i], mLoadBins[i]));
+   lines.Add(wxString::Format(wxT("MaxCallbackMs\t%.3f"), mMaxCallback * 1000.0));
+   lines.Add(wxString::Format(wxT("MaxCallbackLoad\t%.3f"), mMaxLoad));
+
+   lines.Add(wxString::Format(wxT("FillBuffersCalls\t%d"), mFillBuffersCalls));
+   lines.Add(wxString::Format(wxT("MeanFillBuffersMs\t%.3f"),
+                              mFillBuffersCalls > 0 ?
+                              mFillBuffersTotal * 1000.0 / mFillBuffersCalls : 0.0));
+   lines.Add(wxString::Format(wxT("MaxFillBuffersMs\t%.3f"), mMaxFillBuffers * 1000.0));
+
+   return lines;
+}
+
+void AudioIOStats::Log() const
+{
+   wxArrayString lines = Format();
+   wxString text;
+   for (size_t i = 0; i < lines.GetCount(); i++) {
+      wxString line = lines[i];
+      line.Replace(wxT("\t"), wxT(": "));
+      text += wxT("   ") + line + wxT("\n");
+   }
+   wxLogMessage(wxT("Audio I/O stats of the stream at %.0f Hz:\n%s"),
+                mRate, text.c_str());
+}
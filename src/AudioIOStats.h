@@ -0,0 +1,96 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  AudioIOStats.h
+
+*******************************************************************//**
+
+\class AudioIOStats
+\brief Counts of how well the audio thread and the PortAudio callback
+kept up during one stream.
+
+  The callback counts the times the playback ring buffers held less than
+  it needed while there was more to play (underruns), the times the
+  capture ring buffers had no room for what it got (overruns), the flags
+  PortAudio sets when the device itself ran short, the least the playback
+  buffers held and the least room the capture buffers had, and how long
+  each call took against the time the buffer it filled lasts.  The audio
+  thread adds how long FillBuffers() took.
+
+  StartStream() resets the counts and StopStream() logs them; the
+  GetAudioStats script command reads them at any time.  Each count has one
+  writer, and a reader may see it a little out of date.
+
+*//*******************************************************************/
+
+#ifndef __AUDACITY_AUDIO_IO_STATS__
+#define __AUDACITY_AUDIO_IO_STATS__
+
+#include <wx/arrstr.h>
+
+class AudioIOStats
+{
+ public:
+   AudioIOStats();
+
+   /// Forgets all counts; called before a stream starts.  The sizes
+   /// are in samples, zero for no buffers.
+   void Reset(double rate, int playbackBufferSize, int captureBufferSize);
+
+   //
+   // For the PortAudio callback:
+   //
+
+   /// A call that handled numFrames frames in duration seconds
+   void AddCallback(int numFrames, double duration);
+   /// Flags PortAudio passed to the callback
+   void AddDeviceFlags(bool outputUnderflow, bool inputOverflow);
+   /// The playback buffers held 'filled' samples when numFrames were
+   /// needed; 'more' is false when the end of the selection was reached.
+   void AddPlaybackFill(int filled, int numFrames, bool more);
+   /// The capture buffers had room for 'room' samples when numFrames came
+   void AddCaptureRoom(int room, int numFrames);
+
+   //
+   // For the audio thread:
+   //
+
+   void AddFillBuffers(double duration);
+
+   //
+   // For anyone:
+   //
+
+   /// One "name<tab>value" line for each count
+   wxArrayString Format() const;
+   /// Writes the counts to the log
+   void Log() const;
+
+ private:
+   enum { kNumLoadBins = 6 };
+
+   double mRate;
+   int mPlaybackBufferSize;
+   int mCaptureBufferSize;
+
+   // Written by the callback
+   int mCallbacks;
+   int mPlaybackUnderruns;
+   int mCaptureOverruns;
+   int mLostSamples;
+   int mOutputUnderflows;
+   int mInputOverflows;
+   int mMinPlaybackFill;  // -1 until measured
+   int mMinCaptureRoom;   // -1 until measured
+   int mLoadBins[kNumLoadBins];
+   double mMaxCallback;
+   double mMaxLoad;
+
+   // Written by the audio thread
+   int mFillBuffersCalls;
+   double mFillBuffersTotal;
+   double mMaxFillBuffers;
+};
+
+#endif
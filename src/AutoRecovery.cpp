@@ -18,13 +18,22 @@ recover previous Audacity projects that were closed incorrectly.
 #include "Audacity.h"
 #include "AudacityApp.h"
 #include "FileNames.h"
+#include "Envelope.h"
+#include "Tags.h"
+#include "WaveClip.h"
+#include "WaveTrack.h"
 #include "blockfile/SimpleBlockFile.h"
 
 #include <wx/wxprec.h>
 #include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/ffile.h>
 #include <wx/dir.h>
 #include <wx/dialog.h>
 #include <wx/app.h>
+#include <wx/tokenzr.h>
+
+#include <set>
 
 enum {
    ID_RECOVER_ALL = 10000,
@@ -345,3 +354,566 @@ XMLTagHandler* RecordingRecoveryHandler::HandleXMLChild(const wxChar *tag)
 
    return NULL;
 }
+
+////////////////////////////////////////////////////////////////////////////
+/// Auto-save journal
+
+// Full auto-save files are written again after this many entries, so that
+// recovery does not have to replay too many
+static const int kMaxJournalEntries = 100;
+
+// 64-bit FNV-1a
+static const wxUint64 kHashBasis = wxULL(14695981039346656037);
+
+static void HashBytes(wxUint64 &hash, const void *data, size_t len)
+{
+   const unsigned char *p = (const unsigned char *)data;
+   for (size_t i = 0; i < len; i++) {
+      hash ^= p[i];
+      hash *= wxULL(1099511628211);
+   }
+}
+
+template <class T>
+static void HashValue(wxUint64 &hash, const T &value)
+{
+   HashBytes(hash, &value, sizeof(value));
+}
+
+static void HashString(wxUint64 &hash, const wxString &s)
+{
+   HashBytes(hash, s.c_str(), s.Length() * sizeof(wxChar));
+   HashValue(hash, s.Length());
+}
+
+static void HashClip(wxUint64 &hash, WaveClip *clip)
+{
+   HashValue(hash, clip->GetOffset());
+
+   Sequence *seq = clip->GetSequence();
+   HashValue(hash, seq->GetMaxBlockSize());
+   HashValue(hash, seq->GetSampleFormat());
+   HashValue(hash, seq->GetNumSamples());
+
+   // Block files don't change once made, except for the summary or data
+   // that on-demand tasks fill in later and the file an alias points to,
+   // so the name of a block file stands for the rest of its XML
+   BlockArray *blocks = seq->GetBlockArray();
+   HashValue(hash, blocks->GetCount());
+   for (unsigned int b = 0; b < blocks->GetCount(); b++) {
+      SeqBlock *sb = blocks->Item(b);
+      BlockFile *f = sb->f;
+      HashValue(hash, sb->start);
+      HashValue(hash, f->GetLength());
+      HashString(hash, f->GetFileName().GetFullName());
+      HashValue(hash, f->IsSummaryAvailable());
+      HashValue(hash, f->IsDataAvailable());
+      if (f->IsAlias())
+         HashString(hash, ((AliasBlockFile *)f)->GetAliasedFileName().GetFullPath());
+   }
+
+   Envelope *env = clip->GetEnvelope();
+   int numPoints = env->GetNumberOfPoints();
+   HashValue(hash, numPoints);
+   if (numPoints > 0) {
+      double *when = new double[numPoints];
+      double *value = new double[numPoints];
+      env->GetPoints(when, value, numPoints);
+      HashBytes(hash, when, numPoints * sizeof(double));
+      HashBytes(hash, value, numPoints * sizeof(double));
+      delete[] when;
+      delete[] value;
+   }
+
+   WaveClipList *cutLines = clip->GetCutLines();
+   HashValue(hash, cutLines->GetCount());
+   for (WaveClipList::compatibility_iterator it = cutLines->GetFirst(); it; it = it->GetNext())
+      HashClip(hash, it->GetData());
+}
+
+AutoSaveJournal::AutoSaveJournal()
+:  mValid(false),
+   mNextId(0),
+   mFileSize(0),
+   mAppended(0),
+   mEntries(0)
+{
+}
+
+// static
+void AutoSaveJournal::HashTrack(Track *t, TrackState &state)
+{
+   state.wave = t->GetKind() == Track::Wave;
+   state.hash = kHashBasis;
+   state.clips.clear();
+
+   if (state.wave) {
+      // Everything WaveTrack::WriteXML() writes, without formatting the
+      // XML of every block.  Each clip is hashed apart, so that only the
+      // clips that changed are written again.
+      WaveTrack *wt = (WaveTrack *)t;
+      HashString(state.hash, wt->GetName());
+      HashValue(state.hash, wt->GetChannel());
+      HashValue(state.hash, wt->GetLinked());
+      HashValue(state.hash, wt->GetMute());
+      HashValue(state.hash, wt->GetSolo());
+      HashValue(state.hash, wt->GetActualHeight());
+      HashValue(state.hash, wt->GetHeight());
+      HashValue(state.hash, wt->GetMinimized());
+      HashValue(state.hash, wt->GetSelected());
+      HashValue(state.hash, wt->GetRate());
+      HashValue(state.hash, wt->GetGain());
+      HashValue(state.hash, wt->GetPan());
+
+      for (WaveClipList::compatibility_iterator it = wt->GetClipIterator(); it; it = it->GetNext()) {
+         wxUint64 hash = kHashBasis;
+         HashClip(hash, it->GetData());
+         state.clips.push_back(hash);
+      }
+   }
+   else {
+      // Label, note and time tracks are small, so hash their XML
+      XMLStringWriter xml;
+      t->WriteXML(xml);
+      HashString(state.hash, xml);
+   }
+}
+
+// Writes what changed in the track since the file held old, which has the
+// same id, or the whole track when there is no old
+// static
+void AutoSaveJournal::WriteTrack(XMLWriter &entry, Track *t, const TrackState &state,
+                                 const TrackState *old)
+{
+   if (old && old->wave && state.wave) {
+      if (old->hash == state.hash && old->clips == state.clips)
+         return;
+
+      WaveTrack *wt = (WaveTrack *)t;
+      entry.StartTag(wxT("autosaveclips"));
+      entry.WriteAttr(wxT("id"), state.id);
+      entry.WriteAttr(wxT("clips"), (int)state.clips.size());
+      wt->WriteXMLAttrs(entry);
+
+      int index = 0;
+      for (WaveClipList::compatibility_iterator it = wt->GetClipIterator(); it; it = it->GetNext(), index++) {
+         if (index < (int)old->clips.size() && old->clips[index] == state.clips[index])
+            continue;
+         entry.StartTag(wxT("autosaveclip"));
+         entry.WriteAttr(wxT("index"), index);
+         it->GetData()->WriteXML(entry);
+         entry.EndTag(wxT("autosaveclip"));
+      }
+
+      entry.EndTag(wxT("autosaveclips"));
+      return;
+   }
+
+   if (old && old->wave == state.wave && old->hash == state.hash)
+      return;
+
+   entry.StartTag(wxT("autosavetrack"));
+   entry.WriteAttr(wxT("id"), state.id);
+   t->WriteXML(entry);
+   entry.EndTag(wxT("autosavetrack"));
+}
+
+// static
+wxString AutoSaveJournal::TagsXML(AudacityProject *proj)
+{
+   XMLStringWriter xml;
+   proj->GetTags()->WriteXML(xml);
+   return xml;
+}
+
+// static
+wxString AutoSaveJournal::ViewXML(AudacityProject *proj)
+{
+   XMLStringWriter xml;
+   xml.StartTag(wxT("autosaveview"));
+   proj->WriteXMLViewAttrs(xml);
+   xml.EndTag(wxT("autosaveview"));
+   return xml;
+}
+
+void AutoSaveJournal::Checkpoint(AudacityProject *proj, const wxString &fileName)
+{
+   mValid = false;
+
+   mTracks.clear();
+   mOrder.clear();
+   mNextId = 0;
+
+   TrackListIterator iter(proj->GetTracks());
+   for (Track *t = iter.First(); t; t = iter.Next()) {
+      TrackState state;
+      state.id = mNextId++;
+      HashTrack(t, state);
+      mTracks[t] = state;
+      mOrder.push_back(state.id);
+   }
+
+   mTags = TagsXML(proj);
+   mView = ViewXML(proj);
+
+   wxULongLong size = wxFileName::GetSize(fileName);
+   if (size == wxInvalidSize)
+      return;
+
+   mFileSize = size.GetValue();
+   mAppended = 0;
+   mEntries = 0;
+   mValid = true;
+}
+
+bool AutoSaveJournal::Append(AudacityProject *proj, const wxString &fileName)
+{
+   if (!mValid || fileName.IsEmpty() || !wxFileExists(fileName) ||
+       mEntries >= kMaxJournalEntries)
+      return false;
+
+   XMLStringWriter entry;
+   TrackStateMap tracks;
+   std::vector<int> order;
+   int nextId = mNextId;
+
+   std::vector<Track *> list;
+   TrackListIterator iter(proj->GetTracks());
+   for (Track *t = iter.First(); t; t = iter.Next())
+      list.push_back(t);
+
+   std::map<int, const TrackState *> states;
+   for (TrackStateMap::iterator it = mTracks.begin(); it != mTracks.end(); ++it)
+      states[it->second.id] = &it->second;
+
+   // A track keeps the id it had.  After an undo or redo every track is a
+   // new copy, so a new track takes the id of the one that was in its place,
+   // and only the clips that differ from that one's are written.
+   std::vector<int> trackIds(list.size(), -1);
+   std::set<int> taken;
+   for (size_t i = 0; i < list.size(); i++) {
+      TrackStateMap::iterator it = mTracks.find(list[i]);
+      if (it != mTracks.end()) {
+         trackIds[i] = it->second.id;
+         taken.insert(trackIds[i]);
+      }
+   }
+   for (size_t i = 0; i < list.size(); i++) {
+      if (trackIds[i] < 0 && i < mOrder.size() && !taken.count(mOrder[i])) {
+         trackIds[i] = mOrder[i];
+         taken.insert(trackIds[i]);
+      }
+      if (trackIds[i] < 0)
+         trackIds[i] = nextId++;
+   }
+
+   for (size_t i = 0; i < list.size(); i++) {
+      TrackState state;
+      state.id = trackIds[i];
+      HashTrack(list[i], state);
+
+      std::map<int, const TrackState *>::iterator old = states.find(state.id);
+      WriteTrack(entry, list[i], state, old != states.end() ? old->second : NULL);
+
+      tracks[list[i]] = state;
+      order.push_back(state.id);
+   }
+
+   if (order != mOrder) {
+      wxString ids;
+      for (size_t i = 0; i < order.size(); i++) {
+         if (i > 0)
+            ids += wxT(" ");
+         ids += wxString::Format(wxT("%d"), order[i]);
+      }
+      entry.StartTag(wxT("autosaveorder"));
+      entry.WriteAttr(wxT("ids"), ids);
+      entry.EndTag(wxT("autosaveorder"));
+   }
+
+   wxString tags = TagsXML(proj);
+   if (tags != mTags) {
+      entry.StartTag(wxT("autosavetags"));
+      entry.WriteSubTree(tags);
+      entry.EndTag(wxT("autosavetags"));
+   }
+
+   wxString view = ViewXML(proj);
+   if (view != mView)
+      entry.WriteSubTree(view);
+
+   if (!entry.IsEmpty()) {
+      if (mAppended + (wxFileOffset)entry.Length() > mFileSize)
+         return false;
+
+      wxFFile f(fileName, wxT("ab"));
+      bool ok = f.IsOpened() && f.Write(entry);
+      if (!f.Close() || !ok) {
+         // There may be part of the entry at the end of the file
+         mValid = false;
+         return false;
+      }
+
+      mAppended += entry.Length();
+      mEntries++;
+   }
+
+   mTracks = tracks;
+   mOrder = order;
+   mNextId = nextId;
+   mTags = tags;
+   mView = view;
+
+   return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+/// Auto-save journal handler
+
+AutoSaveJournalHandler::AutoSaveJournalHandler(AudacityProject* proj)
+{
+   mProject = proj;
+   mTrackId = -1;
+   mClipTrack = NULL;
+   mClipIndex = -1;
+
+   // The first entry follows the tracks of the full auto-save file
+   int id = 0;
+   TrackListIterator iter(proj->GetTracks());
+   for (Track *t = iter.First(); t; t = iter.Next())
+      mTracks[id++] = t;
+}
+
+AutoSaveJournalHandler::~AutoSaveJournalHandler()
+{
+   for (size_t i = 0; i < mReplacedClips.size(); i++)
+      delete mReplacedClips[i];
+   for (size_t i = 0; i < mReplacedTracks.size(); i++)
+      delete mReplacedTracks[i];
+}
+
+bool AutoSaveJournalHandler::HandleXMLTag(const wxChar *tag,
+                                          const wxChar **attrs)
+{
+   if (!wxStrcmp(tag, wxT("autosavetrack")))
+   {
+      mTrackId = -1;
+      mClipTrack = NULL;
+      long nValue;
+      while (*attrs)
+      {
+         const wxChar *attr = *attrs++;
+         const wxChar *value = *attrs++;
+
+         if (!value)
+            break;
+
+         const wxString strValue = value;
+         if (!wxStrcmp(attr, wxT("id")))
+         {
+            if (!XMLValueChecker::IsGoodInt(strValue) || !strValue.ToLong(&nValue) || nValue < 0)
+               return false;
+            mTrackId = nValue;
+         }
+      }
+      return mTrackId >= 0;
+   }
+
+   if (!wxStrcmp(tag, wxT("autosaveclips")))
+   {
+      mClipTrack = NULL;
+      const wxChar **trackAttrs = attrs;
+      long id = -1;
+      long clips = -1;
+      while (*attrs)
+      {
+         const wxChar *attr = *attrs++;
+         const wxChar *value = *attrs++;
+
+         if (!value)
+            break;
+
+         const wxString strValue = value;
+         long nValue;
+         if (!wxStrcmp(attr, wxT("id")) || !wxStrcmp(attr, wxT("clips")))
+         {
+            if (!XMLValueChecker::IsGoodInt(strValue) || !strValue.ToLong(&nValue) || nValue < 0)
+               return false;
+            if (!wxStrcmp(attr, wxT("id")))
+               id = nValue;
+            else
+               clips = nValue;
+         }
+      }
+
+      std::map<int, Track *>::iterator it = mTracks.find(id);
+      if (clips < 0 || it == mTracks.end() || it->second->GetKind() != Track::Wave)
+         return false;
+
+      // The track takes the attributes of a <wavetrack> tag and ignores
+      // the others
+      WaveTrack *wt = (WaveTrack *)it->second;
+      if (!wt->HandleXMLTag(wxT("wavetrack"), trackAttrs))
+         return false;
+
+      while (wt->GetNumClips() > clips)
+         mReplacedClips.push_back(
+            wt->RemoveAndReturnClip(wt->GetClipByIndex(wt->GetNumClips() - 1)));
+
+      mClipTrack = wt;
+      return true;
+   }
+
+   if (!wxStrcmp(tag, wxT("autosaveclip")))
+   {
+      mClipIndex = -1;
+      long nValue;
+      while (*attrs)
+      {
+         const wxChar *attr = *attrs++;
+         const wxChar *value = *attrs++;
+
+         if (!value)
+            break;
+
+         const wxString strValue = value;
+         if (!wxStrcmp(attr, wxT("index")))
+         {
+            if (!XMLValueChecker::IsGoodInt(strValue) || !strValue.ToLong(&nValue) || nValue < 0)
+               return false;
+            mClipIndex = nValue;
+         }
+      }
+
+      // Clips past the ones the track has are added in order
+      return mClipTrack && mClipIndex >= 0 && mClipIndex <= mClipTrack->GetNumClips();
+   }
+
+   if (!wxStrcmp(tag, wxT("autosaveorder")))
+   {
+      std::vector<Track *> order;
+      std::map<int, Track *> kept;
+      while (*attrs)
+      {
+         const wxChar *attr = *attrs++;
+         const wxChar *value = *attrs++;
+
+         if (!value)
+            break;
+
+         if (wxStrcmp(attr, wxT("ids")))
+            continue;
+
+         wxStringTokenizer tokens(value, wxT(" "));
+         while (tokens.HasMoreTokens())
+         {
+            const wxString strValue = tokens.GetNextToken();
+            long nValue;
+            if (!XMLValueChecker::IsGoodInt(strValue) || !strValue.ToLong(&nValue))
+               return false;
+            std::map<int, Track *>::iterator it = mTracks.find(nValue);
+            if (it == mTracks.end() || kept.count(nValue))
+               return false;
+            order.push_back(it->second);
+            kept[nValue] = it->second;
+         }
+      }
+
+      TrackList *tracks = mProject->GetTracks();
+      for (std::map<int, Track *>::iterator it = mTracks.begin(); it != mTracks.end(); ++it)
+      {
+         if (!kept.count(it->first))
+         {
+            tracks->Remove(it->second);
+            mReplacedTracks.push_back(it->second);
+         }
+      }
+      mTracks = kept;
+
+      for (size_t i = 0; i < order.size(); i++)
+      {
+         tracks->Remove(order[i]);
+         tracks->Add(order[i]);
+      }
+      return true;
+   }
+
+   if (!wxStrcmp(tag, wxT("autosavetags")))
+   {
+      mProject->GetTags()->Clear();
+      return true;
+   }
+
+   if (!wxStrcmp(tag, wxT("autosaveview")))
+   {
+      while (*attrs)
+      {
+         const wxChar *attr = *attrs++;
+         const wxChar *value = *attrs++;
+
+         if (!value || !XMLValueChecker::IsGoodString(value))
+            break;
+
+         mProject->HandleXMLViewAttr(attr, value);
+      }
+      return true;
+   }
+
+   return false;
+}
+
+XMLTagHandler* AutoSaveJournalHandler::HandleXMLChild(const wxChar *tag)
+{
+   if (!wxStrcmp(tag, wxT("tags")))
+      return mProject->GetTags();
+
+   if (!wxStrcmp(tag, wxT("autosaveclip")))
+      return this; // HandleXMLTag also handles <autosaveclip>
+
+   if (!wxStrcmp(tag, wxT("waveclip")))
+   {
+      if (!mClipTrack || mClipIndex < 0)
+         return NULL;
+
+      WaveClip *clip = mClipTrack->CreateClip();
+      if (mClipIndex < mClipTrack->GetNumClips() - 1)
+      {
+         mClipTrack->RemoveAndReturnClip(clip);
+         mReplacedClips.push_back(mClipTrack->ReplaceClip(mClipIndex, clip));
+      }
+      mClipIndex = -1;
+
+      return clip;
+   }
+
+   if (mTrackId < 0)
+      return NULL;
+
+   if (wxStrcmp(tag, wxT("wavetrack")) &&
+       wxStrcmp(tag, wxT("notetrack")) &&
+       wxStrcmp(tag, wxT("labeltrack")) &&
+       wxStrcmp(tag, wxT("timetrack")))
+      return NULL;
+
+   // The project makes the track and adds it at the end, as for the tracks
+   // of the full file; then it takes the place of the one it replaces
+   XMLTagHandler *handler = mProject->HandleXMLChild(tag);
+   if (!handler)
+      return NULL;
+
+   TrackList *tracks = mProject->GetTracks();
+   TrackListIterator iter(tracks);
+   Track *t = iter.Last();
+
+   std::map<int, Track *>::iterator it = mTracks.find(mTrackId);
+   if (it != mTracks.end())
+   {
+      tracks->Remove(t);
+      tracks->Replace(it->second, t);
+      mReplacedTracks.push_back(it->second);
+   }
+   mTracks[mTrackId] = t;
+   mTrackId = -1;
+
+   return handler;
+}
@@ -15,6 +15,14 @@
 #include "xml/XMLTagHandler.h"
 
 #include <wx/debug.h>
+#include <wx/string.h>
+
+#include <map>
+#include <vector>
+
+class Track;
+class WaveClip;
+class WaveTrack;
 
 //
 // Show auto recovery dialog if there are projects to recover. Should be
@@ -51,4 +59,97 @@ private:
    int mNumChannels;
 };
 
+//
+// What the current auto-save file holds, so that an auto-save can append
+// entries for only what changed since, instead of writing the whole
+// project again:
+//
+//    <autosavetrack id="3"><wavetrack .../></autosavetrack>
+//       replaces the track with that id, or adds a new one at the end
+//    <autosaveclips id="3" clips="2" name="..." ...>
+//       <autosaveclip index="1"><waveclip .../></autosaveclip>
+//    </autosaveclips>
+//       sets the attributes of the wave track with that id, keeps its
+//       first clips, and replaces or adds the clips listed
+//    <autosaveorder ids="0 3 1"/>
+//       removes the tracks that are not listed, and orders the others
+//    <autosavetags><tags .../></autosavetags>
+//    <autosaveview sel0="..." .../>
+//
+// The tracks of the full auto-save file have the ids 0, 1, 2... in order.
+//
+class AutoSaveJournal
+{
+public:
+   AutoSaveJournal();
+
+   // Remembers what a full auto-save file just written holds
+   void Checkpoint(AudacityProject *proj, const wxString &fileName);
+
+   // Appends what changed to the auto-save file.  Returns false when a full
+   // auto-save file should be written instead: there is none, something
+   // else was written to it, or the entries have grown larger than the
+   // file was.
+   bool Append(AudacityProject *proj, const wxString &fileName);
+
+   // Something other than the journal was appended to the auto-save file
+   void Invalidate() { mValid = false; }
+
+private:
+   struct TrackState {
+      int id;
+      bool wave;
+      // Of the attributes of a wave track, or of all of another track
+      wxUint64 hash;
+      // Of each clip of a wave track
+      std::vector<wxUint64> clips;
+   };
+   typedef std::map<Track *, TrackState> TrackStateMap;
+
+   static void HashTrack(Track *t, TrackState &state);
+   static void WriteTrack(XMLWriter &entry, Track *t, const TrackState &state,
+                          const TrackState *old);
+   static wxString TagsXML(AudacityProject *proj);
+   static wxString ViewXML(AudacityProject *proj);
+
+   bool mValid;
+
+   TrackStateMap mTracks;
+   std::vector<int> mOrder;
+   int mNextId;
+   wxString mTags;
+   wxString mView;
+
+   wxFileOffset mFileSize;    // of the full auto-save file
+   wxFileOffset mAppended;    // since it was written
+   int mEntries;
+};
+
+//
+// XML Handler for the <autosave...> tags of an auto-save journal
+//
+class AutoSaveJournalHandler: public XMLTagHandler
+{
+public:
+   AutoSaveJournalHandler(AudacityProject* proj);
+   virtual ~AutoSaveJournalHandler();
+   virtual bool HandleXMLTag(const wxChar *tag, const wxChar **attrs);
+   virtual XMLTagHandler *HandleXMLChild(const wxChar *tag);
+
+   // This class only knows reading tags
+   virtual void WriteXML(XMLWriter & WXUNUSED(xmlFile)) { wxASSERT(false); }
+
+private:
+   AudacityProject* mProject;
+   std::map<int, Track *> mTracks;
+   int mTrackId;   // of the <autosavetrack> being read, or -1
+   WaveTrack *mClipTrack;   // of the <autosaveclips> being read, or NULL
+   int mClipIndex;          // of the <autosaveclip> being read, or -1
+
+   // What the journal replaced or dropped.  A later entry may name the same
+   // block files, so these are deleted only when the whole file is read.
+   std::vector<WaveClip *> mReplacedClips;
+   std::vector<Track *> mReplacedTracks;
+};
+
 #endif
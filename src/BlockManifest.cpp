@@ -0,0 +1,421 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BlockManifest.cpp
+
+*******************************************************************//**
+
+\class BlockManifest
+\brief A binary index of the sequences of a saved project.
+
+*//****************************************************************//**
+
+\class DirManifest
+\brief The entries of the directories of the project data, for a quick
+project check.
+
+*//*******************************************************************/
+
+#include "Audacity.h"
+
+#include <string.h>
+#include <typeinfo>
+
+#include <wx/file.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+
+#include "BlockManifest.h"
+#include "BlockFile.h"
+#include "blockfile/SimpleBlockFile.h"
+#include "blockfile/SilentBlockFile.h"
+
+// "AUBM"
+static const wxUint32 kManifestMagic = 0x4d425541;
+static const wxUint32 kManifestVersion = 1;
+
+// "AUDM"
+static const wxUint32 kDirManifestMagic = 0x4d445541;
+static const wxUint32 kDirManifestVersion = 1;
+
+BlockManifest::BlockManifest()
+:  mNextSequence(0)
+{
+}
+
+void BlockManifest::AddSequence(sampleCount maxSamples, sampleFormat format,
+                                sampleCount numSamples, BlockArray *blocks)
+{
+   BlockManifestSequence seq;
+   seq.maxSamples = maxSamples;
+   seq.numSamples = numSamples;
+   seq.sampleFormat = format;
+   seq.complete = 1;
+   seq.firstBlock = mBlocks.size();
+   seq.numBlocks = blocks->GetCount();
+
+   // Only blocks that are built from their length and summary alone can be
+   // listed; ODDecodeBlockFile derives from SimpleBlockFile, so the types
+   // are compared exactly.
+   for (unsigned int b = 0; b < blocks->GetCount(); b++) {
+      BlockFile *f = blocks->Item(b)->f;
+      if (typeid(*f) != typeid(SimpleBlockFile) &&
+          typeid(*f) != typeid(SilentBlockFile)) {
+         seq.complete = 0;
+         seq.numBlocks = 0;
+         mSequences.push_back(seq);
+         return;
+      }
+   }
+
+   for (unsigned int b = 0; b < blocks->GetCount(); b++) {
+      SeqBlock *sb = blocks->Item(b);
+
+      BlockManifestBlock block;
+      block.start = sb->start;
+      block.len = sb->f->GetLength();
+      sb->f->GetMinMax(&block.min, &block.max, &block.rms);
+
+      if (typeid(*sb->f) == typeid(SilentBlockFile))
+         block.name = kSilentBlock;
+      else {
+         block.name = mNames.size();
+         wxCharBuffer name = sb->f->GetFileName().GetFullName().mb_str(wxConvUTF8);
+         const char *p = name.data();
+         mNames.insert(mNames.end(), p, p + strlen(p) + 1);
+      }
+
+      mBlocks.push_back(block);
+   }
+
+   mSequences.push_back(seq);
+}
+
+bool BlockManifest::Write(const wxString &fileName, const wxString &projectFileName)
+{
+   BlockManifestHeader header;
+   header.magic = kManifestMagic;
+   header.version = kManifestVersion;
+   header.numSequences = mSequences.size();
+   header.numBlocks = mBlocks.size();
+   header.namesSize = mNames.size();
+   header.reserved = 0;
+
+   if (!GetProjectStamp(projectFileName, &header.projectSize, &header.projectTime))
+      return false;
+
+   wxFile file;
+   if (!file.Create(fileName, true))
+      return false;
+
+   bool ok = file.Write(&header, sizeof(header)) == sizeof(header);
+   if (ok && !mSequences.empty()) {
+      size_t bytes = mSequences.size() * sizeof(BlockManifestSequence);
+      ok = file.Write(&mSequences[0], bytes) == bytes;
+   }
+   if (ok && !mBlocks.empty()) {
+      size_t bytes = mBlocks.size() * sizeof(BlockManifestBlock);
+      ok = file.Write(&mBlocks[0], bytes) == bytes;
+   }
+   if (ok && !mNames.empty())
+      ok = file.Write(&mNames[0], mNames.size()) == mNames.size();
+
+   if (!file.Close())
+      ok = false;
+
+   // A partial manifest fails the size check anyway, but don't leave it
+   if (!ok)
+      wxRemoveFile(fileName);
+
+   return ok;
+}
+
+bool BlockManifest::Read(const wxString &fileName, const wxString &projectFileName)
+{
+   mSequences.clear();
+   mBlocks.clear();
+   mNames.clear();
+   mNextSequence = 0;
+
+   // wxFile would log an error for a missing file
+   if (!wxFileExists(fileName))
+      return false;
+
+   wxInt64 projectSize, projectTime;
+   if (!GetProjectStamp(projectFileName, &projectSize, &projectTime))
+      return false;
+
+   wxFile file(fileName);
+   if (!file.IsOpened())
+      return false;
+
+   BlockManifestHeader header;
+   if (file.Read(&header, sizeof(header)) != sizeof(header) ||
+       header.magic != kManifestMagic ||
+       header.version != kManifestVersion ||
+       header.projectSize != projectSize ||
+       header.projectTime != projectTime)
+      return false;
+
+   wxFileOffset expected = sizeof(header) +
+      (wxFileOffset)header.numSequences * sizeof(BlockManifestSequence) +
+      (wxFileOffset)header.numBlocks * sizeof(BlockManifestBlock) +
+      header.namesSize;
+   if (file.Length() != expected)
+      return false;
+
+   mSequences.resize(header.numSequences);
+   mBlocks.resize(header.numBlocks);
+   mNames.resize(header.namesSize);
+
+   bool ok = true;
+   if (ok && !mSequences.empty()) {
+      size_t bytes = mSequences.size() * sizeof(BlockManifestSequence);
+      ok = file.Read(&mSequences[0], bytes) == (ssize_t)bytes;
+   }
+   if (ok && !mBlocks.empty()) {
+      size_t bytes = mBlocks.size() * sizeof(BlockManifestBlock);
+      ok = file.Read(&mBlocks[0], bytes) == (ssize_t)bytes;
+   }
+   if (ok && !mNames.empty())
+      ok = file.Read(&mNames[0], mNames.size()) == (ssize_t)mNames.size();
+
+   // Check the offsets, so that the records can be used without checks
+   if (ok && !mNames.empty() && mNames.back() != 0)
+      ok = false;
+   for (size_t s = 0; ok && s < mSequences.size(); s++) {
+      const BlockManifestSequence &seq = mSequences[s];
+      if (seq.firstBlock > mBlocks.size() ||
+          seq.numBlocks > mBlocks.size() - seq.firstBlock)
+         ok = false;
+   }
+   for (size_t b = 0; ok && b < mBlocks.size(); b++) {
+      if (mBlocks[b].name != kSilentBlock && mBlocks[b].name >= mNames.size())
+         ok = false;
+   }
+
+   if (!ok) {
+      mSequences.clear();
+      mBlocks.clear();
+      mNames.clear();
+   }
+
+   return ok;
+}
+
+const BlockManifestSequence *BlockManifest::NextSequence()
+{
+   if (mNextSequence >= mSequences.size())
+      return NULL;
+
+   return &mSequences[mNextSequence++];
+}
+
+const char *BlockManifest::GetName(const BlockManifestBlock &block) const
+{
+   if (block.name == kSilentBlock)
+      return NULL;
+
+   return &mNames[block.name];
+}
+
+// static
+wxString BlockManifest::GetFileName(const wxString &dataDir)
+{
+   return wxFileName(dataDir, wxT("blocks.manifest")).GetFullPath();
+}
+
+// static
+bool BlockManifest::GetProjectStamp(const wxString &projectFileName,
+                                    wxInt64 *size, wxInt64 *time)
+{
+   if (projectFileName.IsEmpty() || !wxFileExists(projectFileName))
+      return false;
+
+   wxULongLong fileSize = wxFileName::GetSize(projectFileName);
+   if (fileSize == wxInvalidSize)
+      return false;
+
+   *size = fileSize.GetValue();
+   *time = wxFileModificationTime(projectFileName);
+   return true;
+}
+
+//
+// DirManifest
+//
+// The file is a DirManifestHeader, then for each directory its time and
+// counts, then its path, files and subdirectories, each in UTF-8 and
+// ending in a null.
+//
+
+struct DirManifestHeader {
+   wxUint32 magic;
+   wxUint32 version;
+   wxUint32 numDirs;
+   wxUint32 reserved;
+};
+
+struct DirManifestDir {
+   wxInt64  time;
+   wxUint32 numFiles;
+   wxUint32 numDirs;
+};
+
+static void AppendString(std::vector<char> &data, const wxString &s)
+{
+   wxCharBuffer buf = s.mb_str(wxConvUTF8);
+   const char *p = buf.data();
+   data.insert(data.end(), p, p + strlen(p) + 1);
+}
+
+// Reads a string ending in a null at pos, if there is one before end
+static bool ReadString(const std::vector<char> &data, size_t &pos, wxString &s)
+{
+   if (pos >= data.size())
+      return false;
+
+   const char *start = &data[pos];
+   const void *nul = memchr(start, 0, data.size() - pos);
+   if (!nul)
+      return false;
+
+   s = wxString(start, wxConvUTF8);
+   pos = (const char *)nul - &data[0] + 1;
+   return true;
+}
+
+DirManifest::DirManifest()
+{
+}
+
+bool DirManifest::Read(const wxString &fileName)
+{
+   mDirs.clear();
+
+   // wxFile would log an error for a missing file
+   if (!wxFileExists(fileName))
+      return false;
+
+   wxFile file(fileName);
+   if (!file.IsOpened())
+      return false;
+
+   wxFileOffset length = file.Length();
+   if (length < (wxFileOffset)sizeof(DirManifestHeader))
+      return false;
+
+   std::vector<char> data((size_t)length);
+   if (file.Read(&data[0], data.size()) != (ssize_t)data.size())
+      return false;
+
+   DirManifestHeader header;
+   memcpy(&header, &data[0], sizeof(header));
+   if (header.magic != kDirManifestMagic ||
+       header.version != kDirManifestVersion)
+      return false;
+
+   size_t pos = sizeof(header);
+   for (wxUint32 d = 0; d < header.numDirs; d++) {
+      DirManifestDir rec;
+      if (data.size() - pos < sizeof(rec))
+         break;
+      memcpy(&rec, &data[pos], sizeof(rec));
+      pos += sizeof(rec);
+
+      wxString path;
+      if (!ReadString(data, pos, path))
+         break;
+
+      Dir &dir = mDirs[path];
+      dir.time = rec.time;
+
+      wxString name;
+      wxUint32 i;
+      for (i = 0; i < rec.numFiles && ReadString(data, pos, name); i++)
+         dir.files.Add(name);
+      if (i < rec.numFiles)
+         break;
+      for (i = 0; i < rec.numDirs && ReadString(data, pos, name); i++)
+         dir.dirs.Add(name);
+      if (i < rec.numDirs)
+         break;
+   }
+
+   if (mDirs.size() != header.numDirs || pos != data.size()) {
+      mDirs.clear();
+      return false;
+   }
+
+   return true;
+}
+
+bool DirManifest::Write(const wxString &fileName)
+{
+   DirManifestHeader header;
+   header.magic = kDirManifestMagic;
+   header.version = kDirManifestVersion;
+   header.numDirs = mDirs.size();
+   header.reserved = 0;
+
+   std::vector<char> data((const char *)&header,
+                          (const char *)&header + sizeof(header));
+
+   for (DirMap::const_iterator it = mDirs.begin(); it != mDirs.end(); ++it) {
+      const Dir &dir = it->second;
+
+      DirManifestDir rec;
+      rec.time = dir.time;
+      rec.numFiles = dir.files.GetCount();
+      rec.numDirs = dir.dirs.GetCount();
+      data.insert(data.end(), (const char *)&rec, (const char *)&rec + sizeof(rec));
+
+      AppendString(data, it->first);
+      for (size_t i = 0; i < dir.files.GetCount(); i++)
+         AppendString(data, dir.files[i]);
+      for (size_t i = 0; i < dir.dirs.GetCount(); i++)
+         AppendString(data, dir.dirs[i]);
+   }
+
+   wxFile file;
+   if (!file.Create(fileName, true))
+      return false;
+
+   bool ok = file.Write(&data[0], data.size()) == data.size();
+
+   if (!file.Close())
+      ok = false;
+
+   if (!ok)
+      wxRemoveFile(fileName);
+
+   return ok;
+}
+
+bool DirManifest::Find(const wxString &path, wxInt64 time,
+                       wxArrayString &files, wxArrayString &dirs) const
+{
+   DirMap::const_iterator it = mDirs.find(path);
+   if (it == mDirs.end() || it->second.time != time)
+      return false;
+
+   files = it->second.files;
+   dirs = it->second.dirs;
+   return true;
+}
+
+void DirManifest::Add(const wxString &path, wxInt64 time,
+                      const wxArrayString &files, const wxArrayString &dirs)
+{
+   Dir &dir = mDirs[path];
+   dir.time = time;
+   dir.files = files;
+   dir.dirs = dirs;
+}
+
+// static
+wxString DirManifest::GetFileName(const wxString &dataDir)
+{
+   return wxFileName(dataDir, wxT("dirs.manifest")).GetFullPath();
+}
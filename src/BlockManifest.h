@@ -0,0 +1,160 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BlockManifest.h
+
+*******************************************************************//**
+
+\class BlockManifest
+\brief A binary index of the sequences of a saved project.
+
+  When a project is saved, the layout of each of its sequences and the
+  name, length and min/max/rms of each of its block files are also
+  written to a small file in the _data directory.  Opening the project
+  builds the sequences from it instead of from the <waveblock> tags of
+  the .aup, which still has them all so that the project opens as
+  before in other versions of Audacity, or when the manifest is lost.
+
+  The file is a header, then one BlockManifestSequence for each
+  <sequence> of the .aup in the order they are written, then one
+  BlockManifestBlock for each block of those sequences, then the block
+  file names, each ending in a null.  The records have a fixed size, so
+  they are read in three reads and used in place.
+
+  The header holds the size and modification time of the .aup that was
+  saved with it.  When the .aup has changed since, the manifest is not
+  used.  A sequence with a block that is not a simple or silent block
+  file (alias and on-demand blocks) is marked incomplete and is loaded
+  from the .aup.
+
+*//*******************************************************************/
+
+#ifndef __AUDACITY_BLOCK_MANIFEST__
+#define __AUDACITY_BLOCK_MANIFEST__
+
+#include <map>
+#include <vector>
+
+#include <wx/defs.h>
+#include <wx/string.h>
+#include <wx/arrstr.h>
+
+#include "Sequence.h"
+
+// The records are written in native byte order; a manifest written on a
+// machine of the other order fails the check of the magic number.
+struct BlockManifestHeader {
+   wxUint32 magic;
+   wxUint32 version;
+   wxInt64  projectSize;   // of the .aup this was saved with
+   wxInt64  projectTime;
+   wxUint32 numSequences;
+   wxUint32 numBlocks;
+   wxUint32 namesSize;     // bytes
+   wxUint32 reserved;
+};
+
+struct BlockManifestSequence {
+   wxInt64  maxSamples;
+   wxInt64  numSamples;
+   wxInt32  sampleFormat;
+   wxUint32 complete;      // 0 when the blocks must be read from the .aup
+   wxUint32 firstBlock;
+   wxUint32 numBlocks;
+};
+
+struct BlockManifestBlock {
+   wxInt64  start;
+   wxInt64  len;
+   float    min;
+   float    max;
+   float    rms;
+   wxUint32 name;          // offset in the names, or kSilentBlock
+};
+
+class BlockManifest
+{
+public:
+   BlockManifest();
+
+   // Saving
+
+   void AddSequence(sampleCount maxSamples, sampleFormat format,
+                    sampleCount numSamples, BlockArray *blocks);
+   bool Write(const wxString &fileName, const wxString &projectFileName);
+
+   // Opening
+
+   // Reads the manifest, if there is one and it was saved with the
+   // project file as it is now.
+   bool Read(const wxString &fileName, const wxString &projectFileName);
+
+   // The record of the next <sequence> of the project file, or NULL when
+   // there are no more
+   const BlockManifestSequence *NextSequence();
+
+   const BlockManifestBlock &GetBlock(unsigned int i) const { return mBlocks[i]; }
+   // The name of the block file, or NULL for a silent block
+   const char *GetName(const BlockManifestBlock &block) const;
+
+   static const wxUint32 kSilentBlock = 0xffffffff;
+
+   // Name of the manifest in the _data directory
+   static wxString GetFileName(const wxString &dataDir);
+
+private:
+   static bool GetProjectStamp(const wxString &projectFileName,
+                               wxInt64 *size, wxInt64 *time);
+
+   std::vector<BlockManifestSequence> mSequences;
+   std::vector<BlockManifestBlock> mBlocks;
+   std::vector<char> mNames;
+
+   size_t mNextSequence;
+};
+
+//
+// The entries of each directory under the _data directory, as they were
+// when it was last listed, with its modification time then.  Adding,
+// removing or renaming an entry changes the modification time of a
+// directory, so while it is the same the entries are too, and the project
+// check uses them instead of reading the directory and looking for each
+// block file.  (FAT file systems don't keep the times of directories
+// up to date, so a block file deleted there by hand is not noticed until
+// something else in its directory changes.)
+//
+// Paths are relative to the _data directory, which is "".
+//
+class DirManifest
+{
+public:
+   DirManifest();
+
+   bool Read(const wxString &fileName);
+   bool Write(const wxString &fileName);
+
+   // Gets the entries of the directory, if it was listed when its
+   // modification time was the one given
+   bool Find(const wxString &path, wxInt64 time,
+             wxArrayString &files, wxArrayString &dirs) const;
+   void Add(const wxString &path, wxInt64 time,
+            const wxArrayString &files, const wxArrayString &dirs);
+
+   size_t GetCount() const { return mDirs.size(); }
+
+   // Name of the manifest in the _data directory
+   static wxString GetFileName(const wxString &dataDir);
+
+private:
+   struct Dir {
+      wxInt64 time;
+      wxArrayString files;
+      wxArrayString dirs;
+   };
+   typedef std::map<wxString, Dir> DirMap;
+
+   DirMap mDirs;
+};
+
+#endif
@@ -65,6 +65,8 @@
 
 #include <time.h> // to use time() for srand()
 
+#include <vector>
+
 #include <wx/defs.h>
 #include <wx/app.h>
 #include <wx/dir.h>
@@ -87,6 +89,7 @@
 
 #include "AudacityApp.h"
 #include "BlockFile.h"
+#include "BlockManifest.h"
 #include "blockfile/LegacyBlockFile.h"
 #include "blockfile/LegacyAliasBlockFile.h"
 #include "blockfile/SimpleBlockFile.h"
@@ -94,6 +97,7 @@
 #include "blockfile/PCMAliasBlockFile.h"
 #include "blockfile/ODPCMAliasBlockFile.h"
 #include "blockfile/ODDecodeBlockFile.h"
+#include "blockfile/SndFileReaderPool.h"
 #include "DirManager.h"
 #include "Internat.h"
 #include "Project.h"
@@ -103,6 +107,7 @@
 
 #include "prefs/PrefsDialog.h"
 #include "ondemand/ODManager.h"
+#include "ondemand/ODTaskThread.h"
 
 #if defined(__WXMAC__)
 #include <mach/mach.h>
@@ -220,6 +225,279 @@ static int RecursivelyEnumerateWithProgress(wxString dirPath,
    return count;
 }
 
+#ifdef EXPERIMENTAL_FSCK_MANIFEST
+
+// One directory of the project data tree
+struct DataDirListing
+{
+   wxString path;       // relative to the data directory
+   wxString fullPath;
+   wxInt64 time;
+   wxArrayString files;
+   wxArrayString dirs;
+};
+
+// The directories to be read, shared by the threads that read them
+class DataDirQueue
+{
+public:
+   DataDirQueue(std::vector<DataDirListing *> &dirs)
+   :  mDirs(dirs),
+      mNext(0),
+      mNumDone(0)
+   {
+   }
+
+   DataDirListing *Next()
+   {
+      DataDirListing *dir = NULL;
+      mLock.Lock();
+      if (mNext < mDirs.size())
+         dir = mDirs[mNext++];
+      mLock.Unlock();
+      return dir;
+   }
+
+   void Finish()
+   {
+      mLock.Lock();
+      mNumDone++;
+      mLock.Unlock();
+   }
+
+   size_t GetNumDone()
+   {
+      mLock.Lock();
+      size_t numDone = mNumDone;
+      mLock.Unlock();
+      return numDone;
+   }
+
+private:
+   ODLock mLock;
+   std::vector<DataDirListing *> &mDirs;
+   size_t mNext;
+   size_t mNumDone;
+};
+
+static void ListDataDir(DataDirListing *listing)
+{
+   wxDir dir(listing->fullPath);
+   if (!dir.IsOpened())
+      return;
+
+   wxString name;
+   bool cont = dir.GetFirst(&name, wxEmptyString, wxDIR_FILES);
+   while (cont) {
+      listing->files.Add(name);
+      cont = dir.GetNext(&name);
+   }
+
+   cont = dir.GetFirst(&name, wxEmptyString, wxDIR_DIRS);
+   while (cont) {
+      listing->dirs.Add(name);
+      cont = dir.GetNext(&name);
+   }
+}
+
+class DataDirThread : public wxThread
+{
+public:
+   DataDirThread():wxThread(wxTHREAD_JOINABLE)
+   {
+      mQueue = NULL;
+   }
+
+   void SetQueue(DataDirQueue *queue)
+   {
+      mQueue = queue;
+   }
+
+   virtual void *Entry()
+   {
+      DataDirListing *dir;
+      while ((dir = mQueue->Next()) != NULL) {
+         ListDataDir(dir);
+         mQueue->Finish();
+      }
+      return NULL;
+   }
+
+private:
+   DataDirQueue *mQueue;
+};
+
+// Reads the directories, on as many threads as there are CPUs
+static void ListDataDirs(std::vector<DataDirListing *> &dirs,
+                         int progress_count,
+                         int progress_bias,
+                         ProgressDialog* progress)
+{
+   int numThreads = wxMin(wxThread::GetCPUCount(), (int)dirs.size());
+   if (numThreads <= 1) {
+      for (size_t i = 0; i < dirs.size(); i++) {
+         ListDataDir(dirs[i]);
+         progress_bias += dirs[i]->files.GetCount();
+         if (progress)
+            progress->Update(progress_bias, progress_count);
+      }
+      return;
+   }
+
+   DataDirQueue queue(dirs);
+   DataDirThread *threads = new DataDirThread[numThreads];
+   for (int t = 0; t < numThreads; t++) {
+      threads[t].SetQueue(&queue);
+      threads[t].Create();
+      threads[t].Run();
+   }
+
+   size_t numDone;
+   while ((numDone = queue.GetNumDone()) < dirs.size()) {
+      // Not the number of files yet, but enough to show it moving
+      if (progress)
+         progress->Update(numDone, dirs.size());
+      wxMilliSleep(10);
+   }
+
+   for (int t = 0; t < numThreads; t++)
+      threads[t].Wait();
+   delete [] threads;
+}
+
+// Lists all files in the dirPath tree, as RecursivelyEnumerate() does with
+// bFiles and without bDirs, and adds their paths to filePathHash too.
+// A directory that has the modification time it had when it was last
+// listed still has the same entries, so those are taken from the manifest
+// and only the other directories are read, several at a time.  The
+// manifest is updated, and the return value says whether it changed.
+// Also counts the directories under dirPath that are empty.
+static bool EnumerateWithManifest(wxString dirPath,
+                                  DirManifest &manifest,
+                                  wxArrayString& filePathArray,
+                                  BlockHash& filePathHash,
+                                  int& emptyDirs,
+                                  int progress_count,
+                                  const wxChar* message)
+{
+   ProgressDialog *progress = NULL;
+
+   if (message)
+      progress = new ProgressDialog(_("Progress"), message);
+
+   // A directory changed within the resolution of its time could change
+   // again without its time changing, so it is not kept in the manifest
+   const wxInt64 settled = (wxInt64)time(NULL) - 2;
+
+   DirManifest updated;
+   bool changed = false;
+   int count = 0;
+   emptyDirs = 0;
+
+   std::vector<DataDirListing *> level;
+   DataDirListing *root = new DataDirListing();
+   root->fullPath = dirPath;
+   level.push_back(root);
+
+   while (!level.empty()) {
+      std::vector<DataDirListing *> toRead;
+      size_t i;
+      for (i = 0; i < level.size(); i++) {
+         DataDirListing *dir = level[i];
+         dir->time = wxFileModificationTime(dir->fullPath);
+         if (!manifest.Find(dir->path, dir->time, dir->files, dir->dirs))
+            toRead.push_back(dir);
+      }
+
+      if (!toRead.empty()) {
+         changed = true;
+         ListDataDirs(toRead, progress_count, count, progress);
+      }
+
+      std::vector<DataDirListing *> next;
+      for (i = 0; i < level.size(); i++) {
+         DataDirListing *dir = level[i];
+
+         if (dir->time > 0 && dir->time <= settled)
+            updated.Add(dir->path, dir->time, dir->files, dir->dirs);
+
+         size_t j;
+         for (j = 0; j < dir->files.GetCount(); j++) {
+            wxString filePath = dir->fullPath + wxFILE_SEP_PATH + dir->files[j];
+            filePathArray.Add(filePath);
+            filePathHash[filePath] = NULL;
+            count++;
+         }
+
+         for (j = 0; j < dir->dirs.GetCount(); j++) {
+            DataDirListing *subdir = new DataDirListing();
+            subdir->path = dir->path.IsEmpty() ? dir->dirs[j] :
+               dir->path + wxFILE_SEP_PATH + dir->dirs[j];
+            subdir->fullPath = dir->fullPath + wxFILE_SEP_PATH + dir->dirs[j];
+            next.push_back(subdir);
+         }
+
+         if (dir != root && dir->files.IsEmpty() && dir->dirs.IsEmpty())
+            emptyDirs++;
+
+         delete dir;
+      }
+
+      if (progress)
+         progress->Update(count, progress_count);
+
+      level = next;
+   }
+
+   if (updated.GetCount() != manifest.GetCount())
+      changed = true;
+   manifest = updated;
+
+   if (progress)
+      delete progress;
+
+   return changed;
+}
+
+// EnumerateWithManifest() with the manifest kept in the data directory.
+// It is not a block file, so the project check ignores it.
+static int EnumerateDataFiles(wxString dirPath,
+                              wxArrayString& filePathArray,
+                              BlockHash& filePathHash,
+                              int& emptyDirs,
+                              int progress_count,
+                              const wxChar* message)
+{
+   DirManifest manifest;
+   wxString manifestFileName = DirManifest::GetFileName(dirPath);
+   manifest.Read(manifestFileName);
+
+   if (EnumerateWithManifest(dirPath, manifest,
+                             filePathArray, filePathHash, emptyDirs,
+                             progress_count, message))
+      manifest.Write(manifestFileName);
+
+   return filePathArray.GetCount();
+}
+
+#endif // EXPERIMENTAL_FSCK_MANIFEST
+
+// The path of a block file relative to the data directory, where
+// MakeBlockFilePath() puts it, without looking at the disk
+static wxString BlockFileRelativePath(const wxString &name, const wxString &ext)
+{
+   wxString path;
+
+   if (name.GetChar(0) == wxT('d'))
+      path = name.Mid(0, name.Find(wxT('b'))) + wxFILE_SEP_PATH;
+   else if (name.GetChar(0) == wxT('e'))
+      path = name.Mid(0, 3) + wxFILE_SEP_PATH +
+             wxT("d") + name.Mid(3, 2) + wxFILE_SEP_PATH;
+
+   return path + name + wxT(".") + ext;
+}
+
+
 static int RecursivelyCountSubdirs(wxString dirPath)
 {
    bool bContinue;
@@ -350,6 +628,9 @@ DirManager::DirManager()
    mLoadingTarget = NULL;
    mMaxSamples = -1;
 
+   mSavingManifest = NULL;
+   mLoadingManifest = NULL;
+
    // toplevel pool hash is fully populated to begin
    {
       int i;
@@ -370,6 +651,13 @@ DirManager::~DirManager()
 {
    wxASSERT(mRef == 0); // MM: Otherwise, we shouldn't delete it
 
+   CloseManifest();
+
+#ifdef EXPERIMENTAL_POOLED_ALIAS_READERS
+   // Don't keep the files this project aliased open after it is closed
+   SndFileReaderPool::Get().CloseAll();
+#endif
+
    numDirManagers--;
    if (numDirManagers == 0) {
       CleanTempDir();
@@ -408,6 +696,11 @@ bool DirManager::SetProject(wxString& newProjPath, wxString& newProjName, const
    if (newProjPath == wxT(""))
       newProjPath = ::wxGetCwd();
 
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+   // Names made ahead are in the old directory
+   ReleasePreallocatedBlockFileNames();
+#endif
+
    this->projPath = newProjPath;
    this->projName = newProjName;
    if (newProjPath.Last() == wxFILE_SEP_PATH)
@@ -847,7 +1140,8 @@ wxFileName DirManager::MakeBlockFileName()
 
       baseFileName.Printf(wxT("e%02x%02x%03x"),topnum,midnum,filenum);
 
-      if (mBlockFileHash.find(baseFileName) == mBlockFileHash.end()){
+      if (mBlockFileHash.find(baseFileName) == mBlockFileHash.end() &&
+          mReservedNames.find(baseFileName) == mReservedNames.end()){
          // not in the hash, good.
          if (!this->AssignFile(ret, baseFileName, true))
          {
@@ -869,34 +1163,158 @@ wxFileName DirManager::MakeBlockFileName()
    return ret;
 }
 
+wxFileName DirManager::ReserveBlockFileName()
+{
+   mHashLock.Lock();
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+   if (!mPreallocatedNames.empty()) {
+      // Already in mReservedNames
+      wxFileName fileName = mPreallocatedNames.front();
+      mPreallocatedNames.pop_front();
+      mHashLock.Unlock();
+      return fileName;
+   }
+#endif
+   wxFileName fileName = MakeBlockFileName();
+   mReservedNames[fileName.GetName()] = NULL;
+   mHashLock.Unlock();
+
+   return fileName;
+}
+
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+void DirManager::PreallocateBlockFileNames(int count)
+{
+   mHashLock.Lock();
+   // Topped up in batches, not a name at a time as they are used
+   if ((int)mPreallocatedNames.size() < count / 2) {
+      while ((int)mPreallocatedNames.size() < count) {
+         wxFileName fileName = MakeBlockFileName();
+         mReservedNames[fileName.GetName()] = NULL;
+         mPreallocatedNames.push_back(fileName);
+      }
+   }
+   mHashLock.Unlock();
+}
+
+void DirManager::ReleasePreallocatedBlockFileNames()
+{
+   mHashLock.Lock();
+   while (!mPreallocatedNames.empty()) {
+      wxString name = mPreallocatedNames.front().GetName();
+      mPreallocatedNames.pop_front();
+      mReservedNames.erase(name);
+      BalanceInfoDel(name);
+   }
+   mHashLock.Unlock();
+}
+#endif
+
+void DirManager::AddBlockFile(const wxFileName &fileName, BlockFile *b)
+{
+   mHashLock.Lock();
+   mReservedNames.erase(fileName.GetName());
+   mBlockFileHash[fileName.GetName()]=b;
+   mHashLock.Unlock();
+}
+
 BlockFile *DirManager::NewSimpleBlockFile(
                                  samplePtr sampleData, sampleCount sampleLen,
                                  sampleFormat format,
                                  bool allowDeferredWrite)
 {
-   wxFileName fileName = MakeBlockFileName();
+#if defined(EXPERIMENTAL_BLOCK_DEDUP)
+   wxUint64 hash = SimpleBlockFile::CalcContentHash(sampleData, sampleLen, format);
 
-   BlockFile *newBlockFile =
+   BlockFile *sharedBlockFile =
+      FindBlockFileByContent(hash, sampleData, sampleLen, format);
+   if (sharedBlockFile)
+      return sharedBlockFile;
+#endif
+
+   wxFileName fileName = ReserveBlockFileName();
+
+   SimpleBlockFile *newBlockFile =
        new SimpleBlockFile(fileName, sampleData, sampleLen, format,
                            allowDeferredWrite);
 
-   mBlockFileHash[fileName.GetName()]=newBlockFile;
+   AddBlockFile(fileName, newBlockFile);
+
+#if defined(EXPERIMENTAL_BLOCK_DEDUP)
+   newBlockFile->SetContentHash(hash);
+
+   mHashLock.Lock();
+   mContentIndex.insert(ContentIndex::value_type(hash, newBlockFile));
+   mHashLock.Unlock();
+#endif
 
    return newBlockFile;
 }
 
+#if defined(EXPERIMENTAL_BLOCK_DEDUP)
+
+BlockFile *DirManager::FindBlockFileByContent(wxUint64 hash,
+                                              samplePtr sampleData,
+                                              sampleCount sampleLen,
+                                              sampleFormat format)
+{
+   // Different samples with the same hash are rare enough that only the
+   // first block of the right length is tried.  Locked blocks are being
+   // saved elsewhere, and are copied rather than shared by CopyBlockFile()
+   // too.
+   SimpleBlockFile *f = NULL;
+
+   mHashLock.Lock();
+   std::pair<ContentIndex::iterator, ContentIndex::iterator> range =
+      mContentIndex.equal_range(hash);
+   for (ContentIndex::iterator it = range.first; it != range.second; ++it) {
+      if (it->second->GetLength() == sampleLen && !it->second->IsLocked()) {
+         f = it->second;
+         // Hold it while its samples are compared
+         f->Ref();
+         break;
+      }
+   }
+   mHashLock.Unlock();
+
+   if (!f)
+      return NULL;
+
+   // A block whose file has gone missing would read as silence
+   bool same = f->GetNeedWriteCacheToDisk() ||
+               wxFileExists(f->GetFileName().GetFullPath());
+
+   if (same) {
+      samplePtr buffer = NewSamples(sampleLen, format);
+      same = f->ReadData(buffer, format, 0, sampleLen) == sampleLen &&
+             memcmp(buffer, sampleData, sampleLen * SAMPLE_SIZE(format)) == 0;
+      DeleteSamples(buffer);
+   }
+
+   if (!same) {
+      Deref(f);
+      return NULL;
+   }
+
+   return f;
+}
+
+#endif
+
 BlockFile *DirManager::NewAliasBlockFile(
                                  wxString aliasedFile, sampleCount aliasStart,
                                  sampleCount aliasLen, int aliasChannel)
 {
-   wxFileName fileName = MakeBlockFileName();
+   wxFileName fileName = ReserveBlockFileName();
 
    BlockFile *newBlockFile =
        new PCMAliasBlockFile(fileName,
                              aliasedFile, aliasStart, aliasLen, aliasChannel);
 
-   mBlockFileHash[fileName.GetName()]=newBlockFile;
+   AddBlockFile(fileName, newBlockFile);
+   mHashLock.Lock();
    aliasList.Add(aliasedFile);
+   mHashLock.Unlock();
 
    return newBlockFile;
 }
@@ -905,14 +1323,16 @@ BlockFile *DirManager::NewODAliasBlockFile(
                                  wxString aliasedFile, sampleCount aliasStart,
                                  sampleCount aliasLen, int aliasChannel)
 {
-   wxFileName fileName = MakeBlockFileName();
+   wxFileName fileName = ReserveBlockFileName();
 
    BlockFile *newBlockFile =
        new ODPCMAliasBlockFile(fileName,
                              aliasedFile, aliasStart, aliasLen, aliasChannel);
 
-   mBlockFileHash[fileName.GetName()]=newBlockFile;
+   AddBlockFile(fileName, newBlockFile);
+   mHashLock.Lock();
    aliasList.Add(aliasedFile);
+   mHashLock.Unlock();
 
    return newBlockFile;
 }
@@ -921,14 +1341,16 @@ BlockFile *DirManager::NewODDecodeBlockFile(
                                  wxString aliasedFile, sampleCount aliasStart,
                                  sampleCount aliasLen, int aliasChannel, int decodeType)
 {
-   wxFileName fileName = MakeBlockFileName();
+   wxFileName fileName = ReserveBlockFileName();
 
    BlockFile *newBlockFile =
        new ODDecodeBlockFile(fileName,
                              aliasedFile, aliasStart, aliasLen, aliasChannel, decodeType);
 
-   mBlockFileHash[fileName.GetName()]=newBlockFile;
-   aliasList.Add(aliasedFile); //OD TODO: check to see if we need to remove this when done decoding.
+   AddBlockFile(fileName, newBlockFile);
+   mHashLock.Lock();
+   aliasList.Add(aliasedFile);
+   mHashLock.Unlock(); //OD TODO: check to see if we need to remove this when done decoding.
                                //I don't immediately see a place where aliased files remove when a file is closed.
 
    return newBlockFile;
@@ -955,14 +1377,17 @@ bool DirManager::ContainsBlockFile(wxString filepath) const
 BlockFile *DirManager::CopyBlockFile(BlockFile *b)
 {
    if (!b->IsLocked()) {
-      b->Ref();
+      Ref(b);
       //mchinen:July 13 2009 - not sure about this, but it needs to be added to the hash to be able to save if not locked.
       //note that this shouldn't hurt mBlockFileHash's that already contain the filename, since it should just overwrite.
       //but it's something to watch out for.
       //
       // LLL: Except for silent block files which have uninitialized filename.
-      if (b->GetFileName().IsOk())
+      if (b->GetFileName().IsOk()) {
+         mHashLock.Lock();
          mBlockFileHash[b->GetFileName().GetName()]=b;
+         mHashLock.Unlock();
+      }
       return b;
    }
 
@@ -974,7 +1399,7 @@ BlockFile *DirManager::CopyBlockFile(BlockFile *b)
       b2 = b->Copy(wxFileName());
    else
    {
-      wxFileName newFile = MakeBlockFileName();
+      wxFileName newFile = ReserveBlockFileName();
 
       // We assume that the new file should have the same extension
       // as the existing file
@@ -985,17 +1410,27 @@ BlockFile *DirManager::CopyBlockFile(BlockFile *b)
       if(b->IsSummaryAvailable())
       {
          if( !wxCopyFile(b->GetFileName().GetFullPath(),
-                  newFile.GetFullPath()) )
+                  newFile.GetFullPath()) ) {
+            mHashLock.Lock();
+            mReservedNames.erase(newFile.GetName());
+            mHashLock.Unlock();
             return NULL;
+         }
       }
 
       b2 = b->Copy(newFile);
 
-      if (b2 == NULL)
+      if (b2 == NULL) {
+         mHashLock.Lock();
+         mReservedNames.erase(newFile.GetName());
+         mHashLock.Unlock();
          return NULL;
+      }
 
-      mBlockFileHash[newFile.GetName()]=b2;
+      AddBlockFile(newFile, b2);
+      mHashLock.Lock();
       aliasList.Add(newFile.GetFullPath());
+      mHashLock.Unlock();
    }
 
    return b2;
@@ -1073,36 +1508,149 @@ bool DirManager::HandleXMLTag(const wxChar *tag, const wxChar **attrs)
       return false;
    }
    else
-      *mLoadingTarget = pBlockFile;
+      *mLoadingTarget = AddLoadedBlockFile(pBlockFile);
+
+   return true;
+}
 
+BlockFile *DirManager::AddLoadedBlockFile(BlockFile *b)
+{
    //
    // If the block we loaded is already in the hash table, then the
    // object we just loaded is a duplicate, so we delete it and
    // return a reference to the existing object instead.
    //
 
-   wxString name = (*mLoadingTarget)->GetFileName().GetName();
+   wxString name = b->GetFileName().GetName();
    BlockFile *retrieved = mBlockFileHash[name];
    if (retrieved) {
       // Lock it in order to delete it safely, i.e. without having
       // it delete the file, too...
-      (*mLoadingTarget)->Lock();
-      delete (*mLoadingTarget);
+      b->Lock();
+      delete b;
 
       Ref(retrieved); // Add one to its reference count
-      *mLoadingTarget = retrieved;
-      return true;
+      return retrieved;
    }
 
    // This is a new object
-   mBlockFileHash[name]=*mLoadingTarget;
+   mBlockFileHash[name]=b;
    // MakeBlockFileName wasn't used so we must add the directory
    // balancing information
    BalanceInfoAdd(name);
 
+   return b;
+}
+
+void DirManager::BeginManifest()
+{
+   CloseManifest();
+   mSavingManifest = new BlockManifest();
+}
+
+void DirManager::AddToManifest(sampleCount maxSamples, sampleFormat format,
+                               sampleCount numSamples, BlockArray *blocks)
+{
+   if (mSavingManifest)
+      mSavingManifest->AddSequence(maxSamples, format, numSamples, blocks);
+}
+
+bool DirManager::WriteManifest(const wxString &projectFileName)
+{
+   bool ok = false;
+   if (mSavingManifest)
+      ok = mSavingManifest->Write(BlockManifest::GetFileName(GetDataFilesDir()),
+                                  projectFileName);
+   CloseManifest();
+   return ok;
+}
+
+bool DirManager::OpenManifest(const wxString &projectFileName)
+{
+   CloseManifest();
+   mLoadingManifest = new BlockManifest();
+   if (!mLoadingManifest->Read(BlockManifest::GetFileName(GetDataFilesDir()),
+                               projectFileName)) {
+      CloseManifest();
+      return false;
+   }
    return true;
 }
 
+const BlockManifestSequence *DirManager::NextManifestSequence()
+{
+   if (!mLoadingManifest)
+      return NULL;
+
+   return mLoadingManifest->NextSequence();
+}
+
+bool DirManager::LoadFromManifest(const BlockManifestSequence *seq, BlockArray *blocks,
+                                  sampleCount maxSamples, sampleFormat format,
+                                  sampleCount numSamples)
+{
+   if (!mLoadingManifest || !seq || blocks->GetCount() > 0)
+      return false;
+
+   if (!seq->complete ||
+       seq->maxSamples != maxSamples ||
+       seq->sampleFormat != format ||
+       seq->numSamples != numSamples)
+      return false;
+
+   // Make the checks of BuildFromXML() and HandleXMLTag() before building
+   // anything, so that the sequence is either loaded here or from the XML
+   unsigned int b;
+   for (b = 0; b < seq->numBlocks; b++) {
+      const BlockManifestBlock &block = mLoadingManifest->GetBlock(seq->firstBlock + b);
+      if (block.start < 0 || block.len <= 0 || block.len > maxSamples)
+         return false;
+
+      const char *name = mLoadingManifest->GetName(block);
+      if (name &&
+            (!XMLValueChecker::IsGoodFileString(wxString(name, wxConvUTF8)) ||
+             strlen(name) + 1 + GetProjectDataDir().Length() > PLATFORM_MAX_PATH))
+         return false;
+   }
+
+   blocks->Alloc(seq->numBlocks);
+   for (b = 0; b < seq->numBlocks; b++) {
+      const BlockManifestBlock &block = mLoadingManifest->GetBlock(seq->firstBlock + b);
+      const char *name = mLoadingManifest->GetName(block);
+
+      SeqBlock *sb = new SeqBlock();
+      sb->start = block.start;
+
+      if (!name)
+         sb->f = new SilentBlockFile(block.len);
+      else {
+         wxFileName fileName;
+         if (!AssignFile(fileName, wxString(name, wxConvUTF8), false))
+            // As in SimpleBlockFile::BuildFromXML(), leave it for ProjectFSCK()
+            fileName.Clear();
+         sb->f = AddLoadedBlockFile(new SimpleBlockFile(fileName, block.len,
+                                                        block.min, block.max,
+                                                        block.rms));
+      }
+
+      blocks->Add(sb);
+   }
+
+   return true;
+}
+
+void DirManager::CloseManifest()
+{
+   if (mSavingManifest) {
+      delete mSavingManifest;
+      mSavingManifest = NULL;
+   }
+   if (mLoadingManifest) {
+      delete mLoadingManifest;
+      mLoadingManifest = NULL;
+   }
+}
+
 bool DirManager::MoveOrCopyToNewProjectDirectory(BlockFile *f, bool copy)
 {
    // Check that this BlockFile corresponds to a file on disk
@@ -1165,7 +1713,14 @@ bool DirManager::CopyToNewProjectDirectory(BlockFile *f)
 
 void DirManager::Ref(BlockFile * f)
 {
+#if defined(EXPERIMENTAL_BLOCK_DEDUP)
+   // Blocks shared by content may be found and referenced by other threads
+   mHashLock.Lock();
    f->Ref();
+   mHashLock.Unlock();
+#else
+   f->Ref();
+#endif
    //printf("Ref(%d): %s\n",
    //       f->mRefCount,
    //       (const char *)f->mFileName.GetFullPath().mb_str());
@@ -1184,15 +1739,48 @@ void DirManager::Deref(BlockFile * f)
    //       f->mRefCount-1,
    //       (const char *)f->mFileName.GetFullPath().mb_str());
 
+#if defined(EXPERIMENTAL_BLOCK_DEDUP)
+   // Blocks shared by content may be found and referenced by other
+   // threads, so the last reference is given up only once the block is out
+   // of the hash tables, and the file is deleted outside the lock.
+   mHashLock.Lock();
+   bool last = (f->RefCount() <= 1);
+   if (last) {
+      mBlockFileHash.erase(theFileName);
+      BalanceInfoDel(theFileName);
+
+      wxUint64 hash;
+      SimpleBlockFile *sf = dynamic_cast<SimpleBlockFile *>(f);
+      if (sf && sf->GetContentHash(&hash)) {
+         std::pair<ContentIndex::iterator, ContentIndex::iterator> range =
+            mContentIndex.equal_range(hash);
+         for (ContentIndex::iterator it = range.first; it != range.second; ++it) {
+            if (it->second == sf) {
+               mContentIndex.erase(it);
+               break;
+            }
+         }
+      }
+   }
+   else
+      f->Deref();
+   mHashLock.Unlock();
+
+   if (last)
+      f->Deref();
+#else
    if (f->Deref()) {
       // If Deref() returned true, the reference count reached zero
       // and this block is no longer needed.  Remove it from the hash
       // table.
 
+      mHashLock.Lock();
       mBlockFileHash.erase(theFileName);
       BalanceInfoDel(theFileName);
+      mHashLock.Unlock();
 
    }
+#endif
 }
 
 bool DirManager::EnsureSafeFilename(wxFileName fName)
@@ -1275,6 +1863,11 @@ bool DirManager::EnsureSafeFilename(wxFileName fName)
    }
 
    if (needToRename) {
+#ifdef EXPERIMENTAL_POOLED_ALIAS_READERS
+      // An idle handle of the file would keep it open, and on Windows
+      // stop the rename
+      SndFileReaderPool::Get().Close(fName.GetFullPath());
+#endif
       if (!wxRenameFile(fName.GetFullPath(),
                         renamedFileName.GetFullPath()))
       {
@@ -1343,18 +1936,23 @@ bool DirManager::EnsureSafeFilename(wxFileName fName)
 
 void DirManager::Ref()
 {
+   mHashLock.Lock();
    wxASSERT(mRef > 0); // MM: If mRef is smaller, it should have been deleted already
    ++mRef;
+   mHashLock.Unlock();
 }
 
 void DirManager::Deref()
 {
+   mHashLock.Lock();
    wxASSERT(mRef > 0); // MM: If mRef is smaller, it should have been deleted already
 
    --mRef;
+   bool last = (mRef == 0);
+   mHashLock.Unlock();
 
    // MM: Automatically delete if refcount reaches zero
-   if (mRef == 0)
+   if (last)
       delete this;
 }
 
@@ -1402,6 +2000,20 @@ int DirManager::ProjectFSCK(const bool bForceError, const bool bAutoRecoverMode)
 
    wxArrayString filePathArray; // *all* files in the project directory/subdirectories
    wxString dirPath = (projFull != wxT("") ? projFull : mytemp);
+#ifdef EXPERIMENTAL_FSCK_MANIFEST
+   // The same files, for looking up the block files instead of checking
+   // that each one exists
+   BlockHash filePathHash;
+   int nEmptyDirs;
+   EnumerateDataFiles(
+      dirPath,
+      filePathArray,          // output: all files in project directory tree
+      filePathHash,
+      nEmptyDirs,
+      mBlockFileHash.size(),  // rough guess of how many BlockFiles will be found/processed, for progress
+      _("Inspecting project file data"));
+   const BlockHash *pFilePathHash = &filePathHash;
+#else
    RecursivelyEnumerateWithProgress(
       dirPath,
       filePathArray,          // output: all files in project directory tree
@@ -1409,6 +2021,8 @@ int DirManager::ProjectFSCK(const bool bForceError, const bool bAutoRecoverMode)
       true, false,
       mBlockFileHash.size(),  // rough guess of how many BlockFiles will be found/processed, for progress
       _("Inspecting project file data"));
+   const BlockHash *pFilePathHash = NULL;
+#endif
 
    //
    // MISSING ALIASED AUDIO FILES
@@ -1487,7 +2101,7 @@ _("Project check of \"%s\" folder \
    // Alias summary regeneration must happen after checking missing aliased files.
    //
    BlockHash missingAUFHash;              // missing (.auf) AliasBlockFiles
-   this->FindMissingAUFs(missingAUFHash);
+   this->FindMissingAUFs(missingAUFHash, pFilePathHash);
    if ((nResult != FSCKstatus_CLOSE_REQ) && !missingAUFHash.empty())
    {
       // In auto-recover mode, we just recreate the alias files, and do not ask user.
@@ -1538,7 +2152,7 @@ _("Project check of \"%s\" folder \
    // MISSING (.AU) SimpleBlockFiles
    //
    BlockHash missingAUHash;               // missing data (.au) blockfiles
-   this->FindMissingAUs(missingAUHash);
+   this->FindMissingAUs(missingAUHash, pFilePathHash);
    if ((nResult != FSCKstatus_CLOSE_REQ) && !missingAUHash.empty())
    {
       // In auto-recover mode, we just always create silent blocks.
@@ -1597,6 +2211,7 @@ _("Project check of \"%s\" folder \
    //
    wxArrayString orphanFilePathArray;     // orphan .au and .auf files
    this->FindOrphanBlockFiles(filePathArray, orphanFilePathArray);
+   bool bRemovedOrphans = false;
 
    if ((nResult != FSCKstatus_CLOSE_REQ) && !orphanFilePathArray.IsEmpty())
    {
@@ -1639,10 +2254,19 @@ other projects. \
          //    nResult |= FSCKstatus_CHANGED;
          for (size_t i = 0; i < orphanFilePathArray.GetCount(); i++)
             wxRemoveFile(orphanFilePathArray[i]);
+         bRemovedOrphans = true;
       }
    }
 
-   if ((nResult != FSCKstatus_CLOSE_REQ) && !ODManager::HasLoadedODFlag())
+#ifdef EXPERIMENTAL_FSCK_MANIFEST
+   // Reading every directory again is only worth it when one was empty or
+   // may have been emptied
+   bool bMayHaveEmptyDirs = (nEmptyDirs > 0) || bRemovedOrphans;
+#else
+   bool bMayHaveEmptyDirs = true;
+#endif
+   if ((nResult != FSCKstatus_CLOSE_REQ) && !ODManager::HasLoadedODFlag() &&
+         bMayHaveEmptyDirs)
    {
       // Remove any empty directories.
       ProgressDialog* pProgress =
@@ -1680,6 +2304,9 @@ void DirManager::FindMissingAliasedFiles(
       BlockHash& missingAliasedFileAUFHash,     // output: (.auf) AliasBlockFiles whose aliased files are missing
       BlockHash& missingAliasedFilePathHash)    // output: full paths of missing aliased files
 {
+   // Many blocks alias the same file, so check each file only once
+   BlockHash foundAliasedFilePathHash;
+
    BlockHash::iterator iter = mBlockFileHash.begin();
    while (iter != mBlockFileHash.end())
    {
@@ -1691,14 +2318,26 @@ void DirManager::FindMissingAliasedFiles(
          wxString aliasedFileFullPath = aliasedFileName.GetFullPath();
          // wxEmptyString can happen if user already chose to "replace... with silence".
          if ((aliasedFileFullPath != wxEmptyString) &&
-               !aliasedFileName.FileExists())
+               (foundAliasedFilePathHash.find(aliasedFileFullPath) ==
+                  foundAliasedFilePathHash.end()))
          {
-            missingAliasedFileAUFHash[key] = b;
-            if (missingAliasedFilePathHash.find(aliasedFileFullPath) ==
-                  missingAliasedFilePathHash.end()) // Add it only once.
+            bool bMissing = (missingAliasedFilePathHash.find(aliasedFileFullPath) !=
+                              missingAliasedFilePathHash.end());
+            if (!bMissing)
+            {
+               bMissing = !aliasedFileName.FileExists();
+               if (!bMissing)
+                  foundAliasedFilePathHash[aliasedFileFullPath] = NULL;
+            }
+
+            if (bMissing)
+            {
+               missingAliasedFileAUFHash[key] = b;
                // Not actually using the block here, just the path,
                // so set the block to NULL to create the entry.
+               // Does nothing when it is already there.
                missingAliasedFilePathHash[aliasedFileFullPath] = NULL;
+            }
          }
       }
       iter++;
@@ -1713,8 +2352,11 @@ void DirManager::FindMissingAliasedFiles(
 }
 
 void DirManager::FindMissingAUFs(
-      BlockHash& missingAUFHash)                // output: missing (.auf) AliasBlockFiles
+      BlockHash& missingAUFHash,                // output: missing (.auf) AliasBlockFiles
+      const BlockHash* pFilePathHash)           // input: all files in project directory, if known
 {
+   wxString dirPath = GetDataFilesDir();
+
    BlockHash::iterator iter = mBlockFileHash.begin();
    while (iter != mBlockFileHash.end())
    {
@@ -1724,6 +2366,17 @@ void DirManager::FindMissingAUFs(
       {
          /* don't look in hash; that might find files the user moved
             that the Blockfile abstraction can't find itself */
+         // But a file that was listed where MakeBlockFilePath() puts it
+         // is there; only look for the others.
+         if (pFilePathHash &&
+               (pFilePathHash->find(dirPath + wxFILE_SEP_PATH +
+                                    BlockFileRelativePath(key, wxT("auf"))) !=
+                  pFilePathHash->end()))
+         {
+            iter++;
+            continue;
+         }
+
          wxFileName fileName = MakeBlockFilePath(key);
          fileName.SetName(key);
          fileName.SetExt(wxT("auf"));
@@ -1739,8 +2392,11 @@ void DirManager::FindMissingAUFs(
 }
 
 void DirManager::FindMissingAUs(
-      BlockHash& missingAUHash)                 // missing data (.au) blockfiles
+      BlockHash& missingAUHash,                 // missing data (.au) blockfiles
+      const BlockHash* pFilePathHash)           // input: all files in project directory, if known
 {
+   wxString dirPath = GetDataFilesDir();
+
    BlockHash::iterator iter = mBlockFileHash.begin();
    while (iter != mBlockFileHash.end())
    {
@@ -1748,6 +2404,16 @@ void DirManager::FindMissingAUs(
       BlockFile *b = iter->second;
       if (!b->IsAlias())
       {
+         // A file that was listed where MakeBlockFilePath() puts it is there
+         if (pFilePathHash &&
+               (pFilePathHash->find(dirPath + wxFILE_SEP_PATH +
+                                    BlockFileRelativePath(key, wxT("au"))) !=
+                  pFilePathHash->end()))
+         {
+            iter++;
+            continue;
+         }
+
          wxFileName fileName = MakeBlockFilePath(key);
          fileName.SetName(key);
          fileName.SetExt(wxT("au"));
@@ -1804,6 +2470,17 @@ void DirManager::RemoveOrphanBlockfiles()
 {
    wxArrayString filePathArray; // *all* files in the project directory/subdirectories
    wxString dirPath = (projFull != wxT("") ? projFull : mytemp);
+#ifdef EXPERIMENTAL_FSCK_MANIFEST
+   BlockHash filePathHash;
+   int nEmptyDirs;
+   EnumerateDataFiles(
+      dirPath,
+      filePathArray,          // output: all files in project directory tree
+      filePathHash,
+      nEmptyDirs,
+      mBlockFileHash.size(),  // rough guess of how many BlockFiles will be found/processed, for progress
+      _("Inspecting project file data"));
+#else
    RecursivelyEnumerateWithProgress(
       dirPath,
       filePathArray,          // output: all files in project directory tree
@@ -1811,6 +2488,7 @@ void DirManager::RemoveOrphanBlockfiles()
       true, false,
       mBlockFileHash.size(),  // rough guess of how many BlockFiles will be found/processed, for progress
       _("Inspecting project file data"));
+#endif
 
    wxArrayString orphanFilePathArray;
    this->FindOrphanBlockFiles(
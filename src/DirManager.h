@@ -11,15 +11,22 @@
 #ifndef _DIRMANAGER_
 #define _DIRMANAGER_
 
+#include <deque>
+#include <map>
+
 #include <wx/list.h>
 #include <wx/string.h>
 #include <wx/filename.h>
 #include <wx/hashmap.h>
 
 #include "WaveTrack.h"
+#include "ondemand/ODTaskThread.h"
 
 class wxHashTable;
 class BlockFile;
+class SimpleBlockFile;
+class BlockManifest;
+struct BlockManifestSequence;
 class SequenceTest;
 
 #define FSCKstatus_CLOSE_REQ 0x1
@@ -70,6 +77,16 @@ class DirManager: public XMLTagHandler {
    BlockFile *NewODDecodeBlockFile( wxString aliasedFile, sampleCount aliasStart,
                                  sampleCount aliasLen, int aliasChannel, int decodeType);
 
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+   // Names up to count block files ahead, checking their directories on
+   // disk now, so that the next new block files need no look at the disk
+   // before they are written.  Does nothing while more than half of count
+   // are left.  Used while recording.
+   void PreallocateBlockFileNames(int count);
+   // Gives back the names not used yet
+   void ReleasePreallocatedBlockFileNames();
+#endif
+
    /// Returns true if the blockfile pointed to by b is contained by the DirManager
    bool ContainsBlockFile(BlockFile *b) const;
    /// Check for existing using filename using complete filename
@@ -108,6 +125,23 @@ class DirManager: public XMLTagHandler {
    void WriteXML(XMLWriter & WXUNUSED(xmlFile)) { wxASSERT(false); }; // This class only reads tags.
    bool AssignFile(wxFileName &filename,wxString value,bool check);
 
+   // The block manifest of the project (see BlockManifest.h).  While a
+   // manifest is begun, each Sequence::WriteXML() adds its sequence to it,
+   // and WriteManifest() saves it for the project file just written.
+   // After OpenManifest(), each <sequence> tag read takes the next record
+   // of the manifest, and its blocks from it when LoadFromManifest()
+   // returns true.
+   void BeginManifest();
+   void AddToManifest(sampleCount maxSamples, sampleFormat format,
+                      sampleCount numSamples, BlockArray *blocks);
+   bool WriteManifest(const wxString &projectFileName);
+   bool OpenManifest(const wxString &projectFileName);
+   const BlockManifestSequence *NextManifestSequence();
+   bool LoadFromManifest(const BlockManifestSequence *seq, BlockArray *blocks,
+                         sampleCount maxSamples, sampleFormat format,
+                         sampleCount numSamples);
+   void CloseManifest();
+
    // Clean the temp dir. Note that now where we have auto recovery the temp
    // dir is not cleaned at start up anymore. But it is cleaned when the
    // program is exited normally.
@@ -123,10 +157,14 @@ class DirManager: public XMLTagHandler {
    void FindMissingAliasedFiles(
          BlockHash& missingAliasedFileAUFHash,     // output: (.auf) AliasBlockFiles whose aliased files are missing
          BlockHash& missingAliasedFilePathHash);   // output: full paths of missing aliased files
+   // pFilePathHash, when given, has the full paths of all files in the
+   // project directory; only the block files not there are looked for.
    void FindMissingAUFs(
-         BlockHash& missingAUFHash);               // output: missing (.auf) AliasBlockFiles
+         BlockHash& missingAUFHash,                // output: missing (.auf) AliasBlockFiles
+         const BlockHash* pFilePathHash = NULL);   // input: all files in project directory, if known
    void FindMissingAUs(
-         BlockHash& missingAUHash);                // missing data (.au) blockfiles
+         BlockHash& missingAUHash,                 // missing data (.au) blockfiles
+         const BlockHash* pFilePathHash = NULL);   // input: all files in project directory, if known
    // Find .au and .auf files that are not in the project.
    void FindOrphanBlockFiles(
          const wxArrayString& filePathArray,       // input: all files in project directory
@@ -161,11 +199,43 @@ class DirManager: public XMLTagHandler {
    wxFileName MakeBlockFileName();
    wxFileName MakeBlockFilePath(wxString value);
 
+   // Names a new block file and holds the name until AddBlockFile(),
+   // so that the file can be written without holding mHashLock.
+   wxFileName ReserveBlockFileName();
+   void AddBlockFile(const wxFileName &fileName, BlockFile *b);
+
    bool MoveOrCopyToNewProjectDirectory(BlockFile *f, bool copy);
 
+   // Puts a block file just loaded in the hash, or returns the one already
+   // there with the same name
+   BlockFile *AddLoadedBlockFile(BlockFile *b);
+
    int mRef; // MM: Current refcount
 
    BlockHash mBlockFileHash; // repository for blockfiles
+   BlockHash mReservedNames; // names of blockfiles being created
+#ifdef EXPERIMENTAL_CAPTURE_WRITERS
+   // Names made by PreallocateBlockFileNames() and not used yet; they are
+   // in mReservedNames too.  Guarded by mHashLock.
+   std::deque<wxFileName> mPreallocatedNames;
+#endif
+
+#if defined(EXPERIMENTAL_BLOCK_DEDUP)
+   // Returns a block file with these samples, with a reference added for
+   // the caller, or NULL if there is none
+   BlockFile *FindBlockFileByContent(wxUint64 hash, samplePtr sampleData,
+                                     sampleCount sampleLen, sampleFormat format);
+
+   // The simple block files made by NewSimpleBlockFile(), by the hash of
+   // their samples.  Guarded by mHashLock.
+   typedef std::multimap<wxUint64, SimpleBlockFile *> ContentIndex;
+   ContentIndex mContentIndex;
+#endif
+
+   // Block files may be created and released by import worker threads,
+   // so the hash, the directory balancing info, aliasList and mRef
+   // are only touched with this held.
+   ODLock mHashLock;
    DirHash   dirTopPool;    // available toplevel dirs
    DirHash   dirTopFull;    // full toplevel dirs
    DirHash   dirMidPool;    // available two-level dirs
@@ -190,6 +260,9 @@ class DirManager: public XMLTagHandler {
 
    sampleCount mMaxSamples; // max samples per block
 
+   BlockManifest *mSavingManifest;
+   BlockManifest *mLoadingManifest;
+
    static wxString globaltemp;
    wxString mytemp;
    static int numDirManagers;
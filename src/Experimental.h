@@ -34,6 +34,75 @@
 // EQ accelerated code
 //#define EXPERIMENTAL_EQ_SSE_THREADED
 
+// Effects that can process a track in overlapping segments (Noise Reduction,
+// Equalization) do so on a pool of worker threads, one segment per thread at
+// a time.  The result is the same as processing each track in one pass.
+//#define EXPERIMENTAL_SEGMENTED_EFFECTS
+
+// Plug-in effects that can give each track (or stereo pair) a processor of
+// its own process the selected tracks on a pool of worker threads.
+//#define EXPERIMENTAL_PARALLEL_TRACK_EFFECTS
+
+// Sliding Time Scale/Pitch Shift runs the stages of SBSMS on threads of
+// their own, and reads and writes the tracks on others.  Effects Preferences
+// has a check box to turn it off.
+//#define EXPERIMENTAL_SBSMS_THREADS
+
+// Saving a project also writes a binary manifest of its sequences and
+// block files to the _data directory, and opening it builds the sequences
+// from the manifest instead of from the <waveblock> tags, unless the .aup
+// has changed since.
+//#define EXPERIMENTAL_BLOCK_MANIFEST
+
+// Auto-save appends only the clips and tracks that changed to the auto-save
+// file, and writes the whole project again when the appended entries outgrow
+// it.  Recovery replays the entries.
+//#define EXPERIMENTAL_AUTOSAVE_JOURNAL
+
+// The project check takes the entries of each directory of the project
+// data that has not changed since it was last checked from a manifest of
+// directories, instead of listing them and looking for every block file,
+// and lists the others on several threads.
+//#define EXPERIMENTAL_FSCK_MANIFEST
+
+// The check for new and changed plug-ins runs just after startup instead of
+// before the first window opens, and lists the plug-in directories on
+// several threads.
+//#define EXPERIMENTAL_PARALLEL_PLUGIN_SCAN
+
+// A new simple block file with the same samples as one already in the
+// project shares its file instead of writing another.  The samples are
+// compared, not only their hashes.
+//#define EXPERIMENTAL_BLOCK_DEDUP
+
+// Reads of alias blocks take a handle of the aliased file from a pool, or
+// open one, and call libsndfile without the global libsndfile mutex.
+//#define EXPERIMENTAL_POOLED_ALIAS_READERS
+
+// The audio thread measures the peak and RMS of each track as it mixes it
+// for playback, and the meters of the Mixer Board show those instead of
+// reading the tracks again.
+//#define EXPERIMENTAL_MIXER_METER_TAPS
+
+// Threads record the time taken by the audio callback, mixing, block I/O,
+// effects, on-demand tasks and drawing in buffers of their own, and
+// Help > Save Trace writes them for chrome://tracing or Perfetto.
+//#define EXPERIMENTAL_TRACING
+
+// While recording, a capture thread of its own moves the captured samples
+// to the tracks, writing the channels on several threads at once, with
+// block file names made ahead and the recovery log written once a second.
+//#define EXPERIMENTAL_CAPTURE_WRITERS
+
+// When zoomed out, TrackArtist draws the background and the min/max/rms
+// columns of each clip into an image and blits it, rather than drawing
+// rectangles and lines on the wxDC for each column.
+//#define EXPERIMENTAL_WAVEFORM_RASTER
+
+// FLAC export mixes into segments of whole frames that are encoded on
+// worker threads and written in order as one stream, with a seek table.
+//#define EXPERIMENTAL_PARALLEL_FLAC_EXPORT
+
 // LLL, 09 Nov 2013:
 // Allow all WASAPI devices, not just loopback
 #define EXPERIMENTAL_FULL_WASAPI
@@ -101,6 +170,17 @@
 // similarly for FFmpeg:
 // Won't build on Fedora 17 or Windows VC++, per http://bugzilla.audacityteam.org/show_bug.cgi?id=539.
 //#define EXPERIMENTAL_OD_FFMPEG 1
+// On-demand importing for MP3 (libmad) and Ogg Vorbis.  A header scan gives the
+// decoders their seek points, so the tracks are usable right away and blocks are
+// decoded in the background, starting where the user clicks or plays.
+// Like FLAC, a project saved before decoding ends needs these libraries to open.
+//#define EXPERIMENTAL_OD_MP3
+//#define EXPERIMENTAL_OD_OGG
+
+// When several files are imported at once, decode those whose importers can
+// run off the main thread (FLAC, MP3, Ogg Vorbis) on a pool of worker threads.
+// The tracks are still added in the order of the files.
+//#define EXPERIMENTAL_PARALLEL_IMPORT
 
 // Paul Licameli (PRL) 5 Oct 2014
 #define EXPERIMENTAL_SPECTRAL_EDITING
@@ -252,30 +252,9 @@ void RealFFT(int NumSamples, float *RealIn, float *RealOut, float *ImagOut)
 {
 #ifdef EXPERIMENTAL_USE_REALFFTF
    // Remap to RealFFTf() function
-   int i;
    HFFT hFFT = GetFFT(NumSamples);
    float *pFFT = new float[NumSamples];
-   // Copy the data into the processing buffer
-   for(i=0; i<NumSamples; i++)
-      pFFT[i] = RealIn[i];
-
-   // Perform the FFT
-   RealFFTf(pFFT, hFFT);
-
-   // Copy the data into the real and imaginary outputs
-   for(i=1;i<(NumSamples/2);i++) {
-      RealOut[i]=pFFT[hFFT->BitReversed[i]  ];
-      ImagOut[i]=pFFT[hFFT->BitReversed[i]+1];
-   }
-   // Handle the (real-only) DC and Fs/2 bins
-   RealOut[0] = pFFT[0];
-   RealOut[i] = pFFT[1];
-   ImagOut[0] = ImagOut[i] = 0;
-   // Fill in the upper half using symmetry properties
-   for(i++ ; i<NumSamples; i++) {
-      RealOut[i] =  RealOut[NumSamples-i];
-      ImagOut[i] = -ImagOut[NumSamples-i];
-   }
+   RealFFT(hFFT, RealIn, RealOut, ImagOut, pFFT);
    delete [] pFFT;
    ReleaseFFT(hFFT);
 
@@ -346,9 +325,51 @@ void RealFFT(int NumSamples, float *RealIn, float *RealOut, float *ImagOut)
 void InverseRealFFT(int NumSamples, float *RealIn, float *ImagIn, float *RealOut)
 {
    // Remap to RealFFTf() function
-   int i;
    HFFT hFFT = GetFFT(NumSamples);
    float *pFFT = new float[NumSamples];
+   InverseRealFFT(hFFT, RealIn, ImagIn, RealOut, pFFT);
+   delete [] pFFT;
+   ReleaseFFT(hFFT);
+}
+
+/*
+ * RealFFT, InverseRealFFT and PowerSpectrum with the tables and the
+ * processing buffer passed in by the caller.
+ */
+void RealFFT(HFFT hFFT, float *RealIn, float *RealOut, float *ImagOut,
+             float *pFFT)
+{
+   int i;
+   int NumSamples = hFFT->Points * 2;
+   // Copy the data into the processing buffer
+   if (pFFT != RealIn)
+      for(i=0; i<NumSamples; i++)
+         pFFT[i] = RealIn[i];
+
+   // Perform the FFT
+   RealFFTf(pFFT, hFFT);
+
+   // Copy the data into the real and imaginary outputs
+   for(i=1;i<(NumSamples/2);i++) {
+      RealOut[i]=pFFT[hFFT->BitReversed[i]  ];
+      ImagOut[i]=pFFT[hFFT->BitReversed[i]+1];
+   }
+   // Handle the (real-only) DC and Fs/2 bins
+   RealOut[0] = pFFT[0];
+   RealOut[i] = pFFT[1];
+   ImagOut[0] = ImagOut[i] = 0;
+   // Fill in the upper half using symmetry properties
+   for(i++ ; i<NumSamples; i++) {
+      RealOut[i] =  RealOut[NumSamples-i];
+      ImagOut[i] = -ImagOut[NumSamples-i];
+   }
+}
+
+void InverseRealFFT(HFFT hFFT, float *RealIn, float *ImagIn, float *RealOut,
+                    float *pFFT)
+{
+   int i;
+   int NumSamples = hFFT->Points * 2;
    // Copy the data into the processing buffer
    for(i=0; i<(NumSamples/2); i++)
       pFFT[2*i  ] = RealIn[i];
@@ -367,9 +388,28 @@ void InverseRealFFT(int NumSamples, float *RealIn, float *ImagIn, float *RealOut
 
    // Copy the data to the (purely real) output buffer
    ReorderToTime(hFFT, pFFT, RealOut);
+}
 
-   delete [] pFFT;
-   ReleaseFFT(hFFT);
+void PowerSpectrum(HFFT hFFT, float *In, float *Out, float *pFFT)
+{
+   int i;
+   int NumSamples = hFFT->Points * 2;
+   // Copy the data into the processing buffer
+   if (pFFT != In)
+      for(i=0; i<NumSamples; i++)
+         pFFT[i] = In[i];
+
+   // Perform the FFT
+   RealFFTf(pFFT, hFFT);
+
+   // Copy the data into the real and imaginary outputs
+   for(i=1;i<NumSamples/2;i++) {
+      Out[i]= (pFFT[hFFT->BitReversed[i]  ]*pFFT[hFFT->BitReversed[i]  ])
+         + (pFFT[hFFT->BitReversed[i]+1]*pFFT[hFFT->BitReversed[i]+1]);
+   }
+   // Handle the (real-only) DC and Fs/2 bins
+   Out[0] = pFFT[0]*pFFT[0];
+   Out[i] = pFFT[1]*pFFT[1];
 }
 #endif // EXPERIMENTAL_USE_REALFFTF
 
@@ -389,24 +429,9 @@ void PowerSpectrum(int NumSamples, float *In, float *Out)
 {
 #ifdef EXPERIMENTAL_USE_REALFFTF
    // Remap to RealFFTf() function
-   int i;
    HFFT hFFT = GetFFT(NumSamples);
    float *pFFT = new float[NumSamples];
-   // Copy the data into the processing buffer
-   for(i=0; i<NumSamples; i++)
-      pFFT[i] = In[i];
-
-   // Perform the FFT
-   RealFFTf(pFFT, hFFT);
-
-   // Copy the data into the real and imaginary outputs
-   for(i=1;i<NumSamples/2;i++) {
-      Out[i]= (pFFT[hFFT->BitReversed[i]  ]*pFFT[hFFT->BitReversed[i]  ])
-         + (pFFT[hFFT->BitReversed[i]+1]*pFFT[hFFT->BitReversed[i]+1]);
-   }
-   // Handle the (real-only) DC and Fs/2 bins
-   Out[0] = pFFT[0]*pFFT[0];
-   Out[i] = pFFT[1]*pFFT[1];
+   PowerSpectrum(hFFT, In, Out, pFFT);
    delete [] pFFT;
    ReleaseFFT(hFFT);
 
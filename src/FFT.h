@@ -75,6 +75,20 @@ void RealFFT(int NumSamples,
 #ifdef EXPERIMENTAL_USE_REALFFTF
 void InverseRealFFT(int NumSamples,
              float *RealIn, float *ImagIn, float *RealOut);
+
+/*
+ * The same three transforms for code that does many of one size:
+ * the tables come from GetFFT(NumSamples), which hands out one
+ * shared, cached set per size to any thread, and the caller passes
+ * a scratch buffer of NumSamples floats, so nothing is computed or
+ * allocated per call.  The input may be the scratch buffer.
+ */
+#include "RealFFTf.h"
+void PowerSpectrum(HFFT hFFT, float *In, float *Out, float *scratch);
+void RealFFT(HFFT hFFT, float *RealIn, float *RealOut, float *ImagOut,
+             float *scratch);
+void InverseRealFFT(HFFT hFFT, float *RealIn, float *ImagIn, float *RealOut,
+                    float *scratch);
 #endif
 
 /*
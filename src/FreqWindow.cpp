@@ -1068,6 +1068,10 @@ bool SpectrumAnalyst::Calculate(Algorithm alg, int windowFunc,
    float *out = new float[mWindowSize];
    float *out2 = new float[mWindowSize];
    float *win = new float[mWindowSize];
+#ifdef EXPERIMENTAL_USE_REALFFTF
+   HFFT hFFT = GetFFT(mWindowSize);
+   float *scratch = new float[mWindowSize];
+#endif
 
    // initialize the window
    for(int i=0; i<mWindowSize; i++)
@@ -1091,7 +1095,11 @@ bool SpectrumAnalyst::Calculate(Algorithm alg, int windowFunc,
 
    switch (alg) {
       case Spectrum:
+#ifdef EXPERIMENTAL_USE_REALFFTF
+         PowerSpectrum(hFFT, in, out, scratch);
+#else
          PowerSpectrum(mWindowSize, in, out);
+#endif
 
          for (i = 0; i < half; i++)
             mProcessed[i] += out[i];
@@ -1103,7 +1111,7 @@ bool SpectrumAnalyst::Calculate(Algorithm alg, int windowFunc,
 
          // Take FFT
 #ifdef EXPERIMENTAL_USE_REALFFTF
-         RealFFT(mWindowSize, in, out, out2);
+         RealFFT(hFFT, in, out, out2, scratch);
 #else
          FFT(mWindowSize, false, in, NULL, out, out2);
 #endif
@@ -1125,7 +1133,7 @@ bool SpectrumAnalyst::Calculate(Algorithm alg, int windowFunc,
          }
          // Take FFT
 #ifdef EXPERIMENTAL_USE_REALFFTF
-         RealFFT(mWindowSize, in, out, out2);
+         RealFFT(hFFT, in, out, out2, scratch);
 #else
          FFT(mWindowSize, false, in, NULL, out, out2);
 #endif
@@ -1137,7 +1145,7 @@ bool SpectrumAnalyst::Calculate(Algorithm alg, int windowFunc,
 
       case Cepstrum:
 #ifdef EXPERIMENTAL_USE_REALFFTF
-         RealFFT(mWindowSize, in, out, out2);
+         RealFFT(hFFT, in, out, out2, scratch);
 #else
          FFT(mWindowSize, false, in, NULL, out, out2);
 #endif
@@ -1157,7 +1165,7 @@ bool SpectrumAnalyst::Calculate(Algorithm alg, int windowFunc,
             }
             // Take IFFT
 #ifdef EXPERIMENTAL_USE_REALFFTF
-            InverseRealFFT(mWindowSize, in, NULL, out);
+            InverseRealFFT(hFFT, in, NULL, out, scratch);
 #else
             FFT(mWindowSize, true, in, NULL, out, out2);
 #endif
@@ -1281,6 +1289,10 @@ bool SpectrumAnalyst::Calculate(Algorithm alg, int windowFunc,
    delete[]out;
    delete[]out2;
    delete[]win;
+#ifdef EXPERIMENTAL_USE_REALFFTF
+   delete[]scratch;
+   ReleaseFFT(hFFT);
+#endif
 
    if (pYMin)
       *pYMin = mYMin;
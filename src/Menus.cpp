@@ -85,6 +85,7 @@ simplifies construction of menu items.
 #include "AboutDialog.h"
 #include "Benchmark.h"
 #include "Screenshot.h"
+#include "Tracer.h"
 #include "ondemand/ODManager.h"
 
 #include "Resample.h"
@@ -1167,6 +1168,10 @@ void AudacityProject::CreateMenusAndCommands()
    c->AddItem(wxT("Benchmark"), _("&Run Benchmark..."), FN(OnBenchmark));
 #endif
 
+#ifdef EXPERIMENTAL_TRACING
+   c->AddItem(wxT("SaveTrace"), _("Save &Trace..."), FN(OnSaveTrace));
+#endif
+
    c->AddSeparator();
 
    c->AddItem(wxT("DeviceInfo"), _("Au&dio Device Info..."), FN(OnAudioDeviceInfo),
@@ -5300,6 +5305,13 @@ void AudacityProject::OnImport()
    selectedFiles.Sort(CompareNoCaseFileName);
    ODManager::Pause();
 
+#ifdef EXPERIMENTAL_PARALLEL_IMPORT
+   if (selectedFiles.GetCount() > 1) {
+      gPrefs->Write(wxT("/DefaultOpenPath"), ::wxPathOnly(selectedFiles.Last()));
+      ImportFiles(selectedFiles);
+   }
+   else
+#endif
    for (size_t ff = 0; ff < selectedFiles.GetCount(); ff++) {
       wxString fileName = selectedFiles[ff];
 
@@ -6428,6 +6440,25 @@ void AudacityProject::OnScreenshot()
    ::OpenScreenshotTools();
 }
 
+#ifdef EXPERIMENTAL_TRACING
+void AudacityProject::OnSaveTrace()
+{
+   wxString fName = FileSelector(_("Save Trace As:"),
+                                 wxEmptyString,
+                                 wxT("audacity-trace.json"),
+                                 wxT("json"),
+                                 _("Trace files (*.json)|*.json"),
+                                 wxFD_SAVE | wxFD_OVERWRITE_PROMPT | wxRESIZE_BORDER,
+                                 this);
+
+   if (fName == wxT(""))
+      return;
+
+   if (!Tracer::Write(fName))
+      wxMessageBox(_("Couldn't write to file: ") + fName);
+}
+#endif
+
 void AudacityProject::OnAudioDeviceInfo()
 {
    wxString info = gAudioIO->GetDeviceInfo();
@@ -378,6 +378,9 @@ void OnShowLog();
 void OnHelpWelcome();
 void OnBenchmark();
 void OnScreenshot();
+#ifdef EXPERIMENTAL_TRACING
+void OnSaveTrace();
+#endif
 void OnAudioDeviceInfo();
 
        //
@@ -0,0 +1,142 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MeterTap.cpp
+
+*******************************************************************//**
+
+\class MeterTap
+\brief The peak and RMS of the audio of one playback track, in short
+stretches, as the audio thread mixes it.
+
+*//*******************************************************************/
+
+#include "Audacity.h"
+
+#include <math.h>
+
+#include "MeterTap.h"
+
+MeterTap::MeterTap()
+:  mWritten(0),
+   mSlotLen(1024),
+   mRun(0),
+   mRead(0)
+{
+   mCurrent.len = 0;
+}
+
+void MeterTap::Reset(double rate)
+{
+   // Stretches of 10 ms, so that each timer tick of the Mixer Board gets
+   // several, and the slots hold about 20 s
+   mSlotLen = (int)(rate / 100);
+   if (mSlotLen < 64)
+      mSlotLen = 64;
+
+   mWritten = 0;
+   mCurrent.len = 0;
+   mRun = 0;
+   mRead = 0;
+}
+
+void MeterTap::Flush()
+{
+   if (mCurrent.len == 0)
+      return;
+
+   mSlots[mWritten % kNumSlots] = mCurrent;
+   mWritten++;
+
+   mCurrent.len = 0;
+   mRun = 0;
+}
+
+void MeterTap::Put(double t0, double t1, const float *samples, int len)
+{
+   if (len <= 0)
+      return;
+
+   // Looping or a seek starts a new stretch
+   if (mCurrent.len > 0 && fabs(mCurrent.t1 - t0) > 1e-6)
+      Flush();
+
+   double dt = (t1 - t0) / len;
+
+   for (int i = 0; i < len; i++) {
+      if (mCurrent.len == 0) {
+         mCurrent.t0 = t0 + i * dt;
+         mCurrent.peak = 0;
+         mCurrent.sumSquares = 0;
+         mCurrent.peakRun = 0;
+      }
+
+      float s = samples[i];
+      float a = fabs(s);
+      if (a > mCurrent.peak)
+         mCurrent.peak = a;
+      mCurrent.sumSquares += s * s;
+
+      if (a >= 1.0) {
+         mRun++;
+         if (mRun > mCurrent.peakRun)
+            mCurrent.peakRun = mRun;
+      }
+      else
+         mRun = 0;
+
+      mCurrent.len++;
+      mCurrent.t1 = t0 + (i + 1) * dt;
+      if (mCurrent.len == mSlotLen)
+         Flush();
+   }
+}
+
+bool MeterTap::Get(double t0, double t1,
+                   float *peak, float *rms, int *peakRun, int *numFrames)
+{
+   int written = mWritten;
+   int first = written - kNumSlots + 1;
+   if (first < mRead)
+      first = mRead;
+
+   float maxPeak = 0;
+   double sumSquares = 0;
+   int maxRun = 0;
+   int frames = 0;
+   int oldest = written;
+   int newest = -1;
+
+   // When playing looped, the slots of the next pass have the same times
+   // and come after these, so take the first run of slots that match.
+   for (int i = first; i < written; i++) {
+      const Slot &slot = mSlots[i % kNumSlots];
+      if (slot.t1 > t0 && slot.t1 <= t1) {
+         if (slot.peak > maxPeak)
+            maxPeak = slot.peak;
+         if (slot.peakRun > maxRun)
+            maxRun = slot.peakRun;
+         sumSquares += slot.sumSquares;
+         frames += slot.len;
+         if (i < oldest)
+            oldest = i;
+         newest = i;
+      }
+      else if (newest >= 0)
+         break;
+   }
+
+   // A slot the writer has started on since may have been read half
+   // written; the meters will do without this update.
+   if (frames == 0 || oldest <= mWritten - kNumSlots)
+      return false;
+
+   mRead = newest + 1;
+
+   *peak = maxPeak;
+   *rms = sqrt(sumSquares / frames);
+   *peakRun = maxRun;
+   *numFrames = frames;
+   return true;
+}
@@ -0,0 +1,82 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MeterTap.h
+
+*******************************************************************//**
+
+\class MeterTap
+\brief The peak and RMS of the audio of one playback track, in short
+stretches, as the audio thread mixes it.
+
+  The Mixer Board meters used to read the audio of each track again on
+  the main thread.  Now AudioIO::FillBuffers() puts the peak, the sum of
+  squares and the longest run of full scale samples of each stretch of
+  the track it mixes here, with the track times of the stretch, and the
+  meters take those of the stretches being heard.
+
+  Like RingBuffer, there is one writer (the audio thread) and one reader
+  (the main thread) and no lock.  The writer fills a slot and then counts
+  it, and the reader checks the count again after reading, to drop slots
+  that may have been overwritten meanwhile.  The slots hold about twenty
+  seconds of audio, more than the playback buffers do.
+
+*//*******************************************************************/
+
+#ifndef __AUDACITY_METER_TAP__
+#define __AUDACITY_METER_TAP__
+
+#include "SampleFormat.h"
+
+class MeterTap
+{
+ public:
+   MeterTap();
+
+   //
+   // For the writer only:
+   //
+
+   /// Sets the length of the stretches, and forgets those put before;
+   /// called before the stream starts
+   void Reset(double rate);
+   /// The samples of the track from time t0 to t1, before its gain
+   void Put(double t0, double t1, const float *samples, int len);
+
+   //
+   // For the reader only:
+   //
+
+   /// The stretches that end after t0 and not after t1, and that come
+   /// after those of the last call.  Returns false when there are none.
+   bool Get(double t0, double t1,
+            float *peak, float *rms, int *peakRun, int *numFrames);
+
+ private:
+   void Flush();
+
+   enum { kNumSlots = 2048 };
+
+   struct Slot {
+      double t0;
+      double t1;
+      float peak;
+      float sumSquares;
+      int peakRun;      // longest run of full scale samples
+      int len;
+   };
+
+   Slot mSlots[kNumSlots];
+   volatile int mWritten; // slots ever counted
+
+   // The stretch being summed by the writer
+   int mSlotLen;
+   Slot mCurrent;
+   int mRun;
+
+   // The slot after the last one the reader took
+   int mRead;
+};
+
+#endif
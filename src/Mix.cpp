@@ -40,6 +40,7 @@
 #include "Prefs.h"
 #include "Project.h"
 #include "Resample.h"
+#include "Tracer.h"
 #include "float_cast.h"
 
 //TODO-MB: wouldn't it make more sense to delete the time track after 'mix and render'?
@@ -539,6 +540,8 @@ sampleCount Mixer::MixSameRate(int *channelFlags, WaveTrack *track,
 
 sampleCount Mixer::Process(sampleCount maxToProcess)
 {
+   TRACE_SCOPE("Mixer::Process");
+
    // MB: this is wrong! mT represented warped time, and mTime is too inaccurate to use
    // it here. It's also unnecessary I think.
    //if (mT >= mT1)
@@ -630,6 +630,57 @@ void MixerTrackCluster::UpdateMeter(const double t0, const double t1)
    //delete[] maxRight;
    //delete[] rmsRight;
 
+#ifdef EXPERIMENTAL_MIXER_METER_TAPS
+   // The audio thread has measured what it mixed of each track, so it
+   // isn't read again here.
+   float peak[2], rms[2];
+   int peakRun[2];
+   int nFrames, nRightFrames;
+   bool bSuccess = gAudioIO->GetTrackMeter(mLeftTrack, t0, t1,
+                                           &peak[0], &rms[0], &peakRun[0], &nFrames);
+   if (bSuccess)
+   {
+      if (mRightTrack)
+         bSuccess = gAudioIO->GetTrackMeter(mRightTrack, t0, t1,
+                                            &peak[1], &rms[1], &peakRun[1], &nRightFrames);
+      else
+      {
+         // Mono shows same in both meters.
+         peak[1] = peak[0];
+         rms[1] = rms[0];
+         peakRun[1] = peakRun[0];
+      }
+   }
+
+   if (bSuccess)
+   {
+      // Same gains and clipping as for the samples, below.
+      float gain[2];
+      gain[0] = mLeftTrack->GetChannelGain(0);
+      if (mRightTrack)
+         gain[1] = mRightTrack->GetChannelGain(1);
+      else
+         gain[1] = mLeftTrack->GetChannelGain(1);
+
+      for (int channel = 0; channel < 2; channel++)
+      {
+         if (gain[channel] < 1.0)
+         {
+            peak[channel] *= gain[channel];
+            rms[channel] *= gain[channel];
+            peakRun[channel] = 0;
+         }
+         if (peak[channel] > 1.0)
+            peak[channel] = 1.0;
+         if (rms[channel] > 1.0)
+            rms[channel] = 1.0;
+      }
+
+      mMeter->UpdateDisplay(2, nFrames, peak, rms, peakRun);
+   }
+   else
+      this->ResetMeter(false);
+#else
    sampleCount startSample = (sampleCount)((mLeftTrack->GetRate() * t0) + 0.5);
    sampleCount nFrames = (sampleCount)((mLeftTrack->GetRate() * (t1 - t0)) + 0.5);
    float* meterFloatsArray = NULL;
@@ -685,6 +736,7 @@ void MixerTrackCluster::UpdateMeter(const double t0, const double t1)
 
    delete[] meterFloatsArray;
    delete[] tempFloatsArray;
+#endif
 }
 
 // private
@@ -30,6 +30,8 @@
 #include <wx/listctrl.h>
 #include <wx/log.h>
 #include <wx/string.h>
+#include <wx/thread.h>
+#include <wx/timer.h>
 #include <wx/tokenzr.h>
 #include <wx/wfstream.h>
 
@@ -41,6 +43,7 @@
 #include "ModuleManager.h"
 #include "PlatformCompatibility.h"
 #include "Prefs.h"
+#include "Project.h"
 #include "ShuttleGui.h"
 #include "xml/XMLFileReader.h"
 #include "xml/XMLWriter.h"
@@ -1125,6 +1128,82 @@ const PluginID & PluginManager::RegisterImporterPlugin(ModuleInterface *provider
    return plug.GetID();
 }
 
+#if defined(EXPERIMENTAL_PARALLEL_PLUGIN_SCAN)
+
+// Lists the files of every numThreads'th plug-in directory, from the first
+// given.  Logging is left to the caller to suppress, on the main thread.
+class PluginDirThread : public wxThread
+{
+public:
+   PluginDirThread():wxThread(wxTHREAD_JOINABLE)
+   {
+      mDirs = NULL;
+      mSpecs = NULL;
+      mFiles = NULL;
+      mFlags = 0;
+      mFirst = 0;
+      mStep = 1;
+   }
+
+   void SetData(const wxArrayString *dirs, const wxArrayString *specs, int flags,
+                wxArrayString *files, size_t first, size_t step)
+   {
+      mDirs = dirs;
+      mSpecs = specs;
+      mFlags = flags;
+      mFiles = files;
+      mFirst = first;
+      mStep = step;
+   }
+
+   virtual void *Entry()
+   {
+      for (size_t i = mFirst, cnt = mDirs->GetCount(); i < cnt; i += mStep)
+      {
+         wxDir::GetAllFiles((*mDirs)[i], &mFiles[i], (*mSpecs)[i], mFlags);
+      }
+
+      return NULL;
+   }
+
+private:
+   const wxArrayString *mDirs;
+   const wxArrayString *mSpecs;
+   int mFlags;
+   wxArrayString *mFiles;
+   size_t mFirst;
+   size_t mStep;
+};
+
+// Runs the check for updates once startup is done
+class PluginCheckTimer : public wxTimer
+{
+public:
+   virtual void Notify()
+   {
+      // Wait until dialogs of the startup, like that of the recovery of
+      // projects, are closed
+      for (wxWindowList::compatibility_iterator node = wxTopLevelWindows.GetFirst();
+           node;
+           node = node->GetNext())
+      {
+         wxDialog *dialog = wxDynamicCast(node->GetData(), wxDialog);
+         if (dialog && dialog->IsModal())
+         {
+            Start(kPluginCheckDelay, wxTIMER_ONE_SHOT);
+            return;
+         }
+      }
+
+      PluginManager::Get().CheckForUpdates();
+   }
+
+   // ms
+   static const int kPluginCheckDelay = 500;
+};
+
+#endif
+
 void PluginManager::FindFilesInPathList(const wxString & pattern,
                                         const wxArrayString & pathList,
                                         wxArrayString & files,
@@ -1170,11 +1249,50 @@ void PluginManager::FindFilesInPathList(const wxString & pattern,
    }
 
    // Find all matching files in each path
+#if defined(EXPERIMENTAL_PARALLEL_PLUGIN_SCAN)
+   // The paths are listed on up to one thread per CPU, under the wxLogNull
+   // above, and the files are added in the order of the paths, as before.
+   // The strings are copies of their own, as they may share their data.
+   wxArrayString dirs;
+   wxArrayString specs;
+   for (size_t i = 0, cnt = paths.GetCount(); i < cnt; i++)
+   {
+      f = paths[i] + wxFILE_SEP_PATH + pattern;
+      dirs.Add(wxString(f.GetPath().c_str()));
+      specs.Add(wxString(f.GetFullName().c_str()));
+   }
+
+   wxArrayString *found = new wxArrayString[dirs.GetCount()];
+
+   // GetCPUCount() is -1 when it isn't known
+   int numThreads = wxMax(1, wxMin(wxThread::GetCPUCount(), (int) dirs.GetCount()));
+   PluginDirThread *threads = new PluginDirThread[numThreads];
+   for (int t = 0; t < numThreads; t++)
+   {
+      threads[t].SetData(&dirs, &specs, directories ? wxDIR_DEFAULT : wxDIR_FILES,
+                         found, t, numThreads);
+      threads[t].Create();
+      threads[t].Run();
+   }
+
+   for (int t = 0; t < numThreads; t++)
+   {
+      threads[t].Wait();
+   }
+   delete [] threads;
+
+   for (size_t i = 0, cnt = dirs.GetCount(); i < cnt; i++)
+   {
+      WX_APPEND_ARRAY(files, found[i]);
+   }
+   delete [] found;
+#else
    for (size_t i = 0, cnt = paths.GetCount(); i < cnt; i++)
    {
       f = paths[i] + wxFILE_SEP_PATH + pattern;
       wxDir::GetAllFiles(f.GetPath(), &files, f.GetFullName(), directories ? wxDIR_DEFAULT : wxDIR_FILES);
    }
+#endif
 
    return;
 }
@@ -1369,6 +1487,7 @@ PluginManager *PluginManager::mInstance = NULL;
 PluginManager::PluginManager()
 {
    mSettings = NULL;
+   mCheckTimer = NULL;
 }
 
 PluginManager::~PluginManager()
@@ -1416,12 +1535,25 @@ void PluginManager::Initialize()
    // Then look for providers (they may autoregister plugins)
    ModuleManager::Get().DiscoverProviders();
 
+#if defined(EXPERIMENTAL_PARALLEL_PLUGIN_SCAN)
+   // And finally check for updates, once the first window is up.  Until
+   // then the plugins are as they were found last time.
+   mCheckTimer = new PluginCheckTimer();
+   mCheckTimer->Start(PluginCheckTimer::kPluginCheckDelay, wxTIMER_ONE_SHOT);
+#else
    // And finally check for updates
    CheckForUpdates();
+#endif
 }
 
 void PluginManager::Terminate()
 {
+   if (mCheckTimer)
+   {
+      delete mCheckTimer;
+      mCheckTimer = NULL;
+   }
+
    // Get rid of all non-module plugins first
    PluginMap::iterator iter = mPlugins.begin();
    while (iter != mPlugins.end())
@@ -1821,6 +1953,10 @@ void PluginManager::CheckForUpdates()
 
    ProviderMap map;
 
+#if defined(EXPERIMENTAL_PARALLEL_PLUGIN_SCAN)
+   bool validityChanged = false;
+#endif
+
    // Always check for and disable missing plugins
    // 
    // Since the user's saved presets are in the registery, never delete them.  That is
@@ -1854,7 +1990,16 @@ void PluginManager::CheckForUpdates()
       }
       else
       {
+#if defined(EXPERIMENTAL_PARALLEL_PLUGIN_SCAN)
+         bool wasValid = plug.IsValid();
+#endif
          plug.SetValid(mm.IsPluginValid(plug.GetProviderID(), plugPath));
+#if defined(EXPERIMENTAL_PARALLEL_PLUGIN_SCAN)
+         if (plug.IsValid() != wasValid)
+         {
+            validityChanged = true;
+         }
+#endif
       }
 
       iter++;
@@ -1883,10 +2028,25 @@ void PluginManager::CheckForUpdates()
       {
          gPrefs->Write(wxT("/Plugins/Rescan"), false);
       }
+#if defined(EXPERIMENTAL_PARALLEL_PLUGIN_SCAN)
+      validityChanged = true;
+#endif
    }
 
    Save();
 
+#if defined(EXPERIMENTAL_PARALLEL_PLUGIN_SCAN)
+   // The menus were made before the check, so make them again if it
+   // found new plugins or lost old ones
+   if (validityChanged)
+   {
+      for (size_t i = 0; i < gAudacityProjects.GetCount(); i++)
+      {
+         gAudacityProjects[i]->RebuildMenuBar();
+      }
+   }
+#endif
+
    return;
 }
 
@@ -23,6 +23,8 @@
 #include "audacity/ModuleInterface.h"
 #include "audacity/PluginInterface.h"
 
+class wxTimer;
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // PluginDescriptor
@@ -315,7 +317,11 @@ private:
    PluginMap mPlugins;
    PluginMap::iterator mPluginsIter;
 
+   // Runs CheckForUpdates() once startup is done
+   wxTimer *mCheckTimer;
+
    friend class PluginRegistrationDialog;
+   friend class PluginCheckTimer;
 };
 
 #endif /* __AUDACITY_PLUGINMANAGER_H__ */
@@ -60,7 +60,9 @@
 #include <wx/fileconf.h>
 #include <wx/filename.h>
 #include <wx/stdpaths.h>
+#include <wx/thread.h>
 
+#include "Experimental.h"
 #include "FileNames.h"
 
 #include "sndfile.h"
@@ -78,6 +80,146 @@ pascal OSErr FSpGetFullPath(const FSSpec * spec,
 wxFileConfig *gPrefs = NULL;
 int gMenusDirty = 0;
 
+#ifdef EXPERIMENTAL_PARALLEL_IMPORT
+// wxFileConfig changes its current path even to read an entry, so two
+// threads reading at once can get the wrong value or corrupt the path.
+// Preferences are read from worker threads (e.g. when WaveTracks are
+// created by a parallel import), so the entries are accessed one at a time.
+// Everything else that moves or uses the current path takes the same lock,
+// so that the main thread can't move it while a worker is reading.
+class AudacityFileConfig : public wxFileConfig
+{
+public:
+   AudacityFileConfig(const wxString& appName, const wxString& vendorName,
+                      const wxString& localFilename, const wxString& globalFilename,
+                      long style)
+   :  wxFileConfig(appName, vendorName, localFilename, globalFilename, style),
+      mAccess(wxMUTEX_RECURSIVE)
+   {
+   }
+
+protected:
+   virtual bool DoReadString(const wxString& key, wxString *pStr) const
+   {
+      wxMutexLocker locker(mAccess);
+      return wxFileConfig::DoReadString(key, pStr);
+   }
+
+   virtual bool DoReadLong(const wxString& key, long *pl) const
+   {
+      wxMutexLocker locker(mAccess);
+      return wxFileConfig::DoReadLong(key, pl);
+   }
+
+   virtual bool DoWriteString(const wxString& key, const wxString& szValue)
+   {
+      wxMutexLocker locker(mAccess);
+      return wxFileConfig::DoWriteString(key, szValue);
+   }
+
+   virtual bool DoWriteLong(const wxString& key, long lValue)
+   {
+      wxMutexLocker locker(mAccess);
+      return wxFileConfig::DoWriteLong(key, lValue);
+   }
+
+public:
+   virtual void SetPath(const wxString& strPath)
+   {
+      wxMutexLocker locker(mAccess);
+      wxFileConfig::SetPath(strPath);
+   }
+
+   virtual bool GetFirstGroup(wxString& str, long& lIndex) const
+   {
+      wxMutexLocker locker(mAccess);
+      return wxFileConfig::GetFirstGroup(str, lIndex);
+   }
+
+   virtual bool GetNextGroup(wxString& str, long& lIndex) const
+   {
+      wxMutexLocker locker(mAccess);
+      return wxFileConfig::GetNextGroup(str, lIndex);
+   }
+
+   virtual bool GetFirstEntry(wxString& str, long& lIndex) const
+   {
+      wxMutexLocker locker(mAccess);
+      return wxFileConfig::GetFirstEntry(str, lIndex);
+   }
+
+   virtual bool GetNextEntry(wxString& str, long& lIndex) const
+   {
+      wxMutexLocker locker(mAccess);
+      return wxFileConfig::GetNextEntry(str, lIndex);
+   }
+
+   virtual size_t GetNumberOfEntries(bool bRecursive = false) const
+   {
+      wxMutexLocker locker(mAccess);
+      return wxFileConfig::GetNumberOfEntries(bRecursive);
+   }
+
+   virtual size_t GetNumberOfGroups(bool bRecursive = false) const
+   {
+      wxMutexLocker locker(mAccess);
+      return wxFileConfig::GetNumberOfGroups(bRecursive);
+   }
+
+   virtual bool HasGroup(const wxString& strName) const
+   {
+      wxMutexLocker locker(mAccess);
+      return wxFileConfig::HasGroup(strName);
+   }
+
+   virtual bool HasEntry(const wxString& strName) const
+   {
+      wxMutexLocker locker(mAccess);
+      return wxFileConfig::HasEntry(strName);
+   }
+
+   virtual bool Flush(bool bCurrentOnly = false)
+   {
+      wxMutexLocker locker(mAccess);
+      return wxFileConfig::Flush(bCurrentOnly);
+   }
+
+   virtual bool RenameEntry(const wxString& oldName, const wxString& newName)
+   {
+      wxMutexLocker locker(mAccess);
+      return wxFileConfig::RenameEntry(oldName, newName);
+   }
+
+   virtual bool RenameGroup(const wxString& oldName, const wxString& newName)
+   {
+      wxMutexLocker locker(mAccess);
+      return wxFileConfig::RenameGroup(oldName, newName);
+   }
+
+   virtual bool DeleteEntry(const wxString& key, bool bGroupIfEmptyToo = true)
+   {
+      wxMutexLocker locker(mAccess);
+      return wxFileConfig::DeleteEntry(key, bGroupIfEmptyToo);
+   }
+
+   virtual bool DeleteGroup(const wxString& key)
+   {
+      wxMutexLocker locker(mAccess);
+      return wxFileConfig::DeleteGroup(key);
+   }
+
+   virtual bool DeleteAll()
+   {
+      wxMutexLocker locker(mAccess);
+      return wxFileConfig::DeleteAll();
+   }
+
+private:
+   // recursive, since reading a number reads the string entry
+   mutable wxMutex mAccess;
+};
+#endif
+
 // Copy one entry from one wxConfig object to another
 static void CopyEntry(wxString path, wxConfigBase *src, wxConfigBase *dst, wxString entry)
 {
@@ -142,9 +284,15 @@ void InitPreferences()
 
    wxFileName configFileName(FileNames::DataDir(), wxT("audacity.cfg"));
 
+#ifdef EXPERIMENTAL_PARALLEL_IMPORT
+   gPrefs = new AudacityFileConfig(appName, wxEmptyString,
+                                   configFileName.GetFullPath(),
+                                   wxEmptyString, wxCONFIG_USE_LOCAL_FILE);
+#else
    gPrefs = new wxFileConfig(appName, wxEmptyString,
                              configFileName.GetFullPath(),
                              wxEmptyString, wxCONFIG_USE_LOCAL_FILE);
+#endif
 
    wxConfigBase::Set(gPrefs);
 
@@ -121,6 +121,7 @@ scroll information.  It also has some status flags.
 #include "widgets/ErrorDialog.h"
 #include "widgets/Meter.h"
 #include "widgets/Ruler.h"
+#include "widgets/ProgressDialog.h"
 #include "widgets/Warning.h"
 #include "xml/XMLFileReader.h"
 #include "PlatformCompatibility.h"
@@ -134,6 +135,8 @@ scroll information.  It also has some status flags.
 #ifdef EXPERIMENTAL_OD_FLAC
 #include "ondemand/ODDecodeFlacTask.h"
 #endif
+#include "ondemand/ODDecodeMP3Task.h"
+#include "ondemand/ODDecodeOggTask.h"
 #include "ModuleManager.h"
 
 #include "Theme.h"
@@ -767,6 +770,8 @@ AudacityProject::AudacityProject(wxWindow * parent, wxWindowID id,
      mAutoSaving(false),
      mIsRecovered(false),
      mRecordingRecoveryHandler(NULL),
+     mAutoSaveJournal(NULL),
+     mAutoSaveJournalHandler(NULL),
      mImportedDependencies(false),
      mWantSaveCompressed(false),
      mLastEffect(wxEmptyString),
@@ -1765,6 +1770,15 @@ void AudacityProject::OnScroll(wxScrollEvent & WXUNUSED(event))
          mViewInfo.h = mViewInfo.total - mViewInfo.screen;
       if (mViewInfo.h < 0.0)
          mViewInfo.h = 0.0;
+
+      //On-Demand: decode what the user is looking at first.
+      if (ODManager::IsInstanceCreated()) {
+         TrackListIterator iter(mTracks);
+         for (Track *t = iter.First(); t; t = iter.Next()) {
+            if (t->GetKind() == Track::Wave)
+               ODManager::Instance()->DemandTrackUpdate((WaveTrack *)t, mViewInfo.h);
+         }
+      }
    }
 
    int lastv = mViewInfo.vpos;
@@ -2131,6 +2145,9 @@ void AudacityProject::OnCloseWindow(wxCloseEvent & event)
    delete mImportXMLTagHandler;
    mImportXMLTagHandler = NULL;
 
+   delete mAutoSaveJournal;
+   mAutoSaveJournal = NULL;
+
    // Unregister for tracklist updates
    mTracks->Disconnect(EVT_TRACKLIST_UPDATED,
                        wxCommandEventHandler(AudacityProject::OnTrackListUpdated),
@@ -2569,6 +2586,9 @@ void AudacityProject::OpenFile(wxString fileName, bool addtohistory)
    XMLFileReader xmlFile;
 
    bool bParseSuccess = xmlFile.Parse(this, fileName);
+#ifdef EXPERIMENTAL_BLOCK_MANIFEST
+   mDirManager->CloseManifest();
+#endif
    if (bParseSuccess) {
       // By making a duplicate set of pointers to the existing blocks
       // on disk, we add one to their reference count, guaranteeing
@@ -2733,6 +2753,12 @@ void AudacityProject::OpenFile(wxString fileName, bool addtohistory)
       mRecordingRecoveryHandler = NULL;
    }
 
+   if (mAutoSaveJournalHandler)
+   {
+      delete mAutoSaveJournalHandler;
+      mAutoSaveJournalHandler = NULL;
+   }
+
    if (!bParseSuccess)
       return; // No need to do further processing if parse failed.
 
@@ -2775,6 +2801,20 @@ void AudacityProject::OpenFile(wxString fileName, bool addtohistory)
                   createdODTasks= createdODTasks | ODTask::eODFLAC;
                }
                else
+#endif
+#if defined(USE_LIBMAD) && defined(EXPERIMENTAL_OD_MP3)
+               if(!(createdODTasks&ODTask::eODMP3) && odFlags & ODTask::eODMP3) {
+                  newTask= new ODDecodeMP3Task;
+                  createdODTasks= createdODTasks | ODTask::eODMP3;
+               }
+               else
+#endif
+#if defined(USE_LIBVORBIS) && defined(EXPERIMENTAL_OD_OGG)
+               if(!(createdODTasks&ODTask::eODOGG) && odFlags & ODTask::eODOGG) {
+                  newTask= new ODDecodeOggTask;
+                  createdODTasks= createdODTasks | ODTask::eODOGG;
+               }
+               else
 #endif
                if(!(createdODTasks&ODTask::eODPCMSummary) && odFlags & ODTask::eODPCMSummary) {
                   newTask=new ODComputeSummaryTask;
@@ -2906,49 +2946,19 @@ bool AudacityProject::HandleXMLTag(const wxChar *tag, const wxChar **attrs)
                   return false;
                }
             }
+
+#ifdef EXPERIMENTAL_BLOCK_MANIFEST
+            // The manifest is only good for the file it was saved with,
+            // not for an auto-saved copy of it
+            if (!mIsRecovered)
+               mDirManager->OpenManifest(mFileName);
+#endif
          }
 
          requiredTags++;
       }
 
-      if (!wxStrcmp(attr, wxT("sel0"))) {
-         double t0;
-         Internat::CompatibleToDouble(value, &t0);
-         mViewInfo.selectedRegion.setT0(t0, false);
-      }
-
-      if (!wxStrcmp(attr, wxT("sel1"))) {
-         double t1;
-         Internat::CompatibleToDouble(value, &t1);
-         mViewInfo.selectedRegion.setT1(t1, false);
-      }
-
-      // PRL: to do: persistence of other fields of the selection
-
-      long longVpos = 0;
-      if (!wxStrcmp(attr, wxT("vpos")))
-         wxString(value).ToLong(&longVpos);
-      mViewInfo.track = NULL;
-      mViewInfo.vpos = longVpos;
-
-      if (!wxStrcmp(attr, wxT("h")))
-         Internat::CompatibleToDouble(value, &mViewInfo.h);
-
-      if (!wxStrcmp(attr, wxT("zoom")))
-         Internat::CompatibleToDouble(value, &mViewInfo.zoom);
-
-      if (!wxStrcmp(attr, wxT("rate"))) {
-         Internat::CompatibleToDouble(value, &mRate);
-         GetSelectionBar()->SetRate(mRate);
-      }
-
-      if (!wxStrcmp(attr, wxT("snapto"))) {
-         SetSnapTo(wxString(value) == wxT("on") ? true : false);
-      }
-
-      if (!wxStrcmp(attr, wxT("selectionformat"))) {
-         SetSelectionFormat(value);
-      }
+      HandleXMLViewAttr(attr, value);
    } // while
 
    // Specifically detect newer versions of Audacity
@@ -3022,6 +3032,50 @@ bool AudacityProject::HandleXMLTag(const wxChar *tag, const wxChar **attrs)
    return true;
 }
 
+// The selection, view and rate attributes of <project>, which an auto-save
+// journal also records when they change
+void AudacityProject::HandleXMLViewAttr(const wxChar *attr, const wxChar *value)
+{
+   if (!wxStrcmp(attr, wxT("sel0"))) {
+      double t0;
+      Internat::CompatibleToDouble(value, &t0);
+      mViewInfo.selectedRegion.setT0(t0, false);
+   }
+
+   if (!wxStrcmp(attr, wxT("sel1"))) {
+      double t1;
+      Internat::CompatibleToDouble(value, &t1);
+      mViewInfo.selectedRegion.setT1(t1, false);
+   }
+
+   // PRL: to do: persistence of other fields of the selection
+
+   long longVpos = 0;
+   if (!wxStrcmp(attr, wxT("vpos")))
+      wxString(value).ToLong(&longVpos);
+   mViewInfo.track = NULL;
+   mViewInfo.vpos = longVpos;
+
+   if (!wxStrcmp(attr, wxT("h")))
+      Internat::CompatibleToDouble(value, &mViewInfo.h);
+
+   if (!wxStrcmp(attr, wxT("zoom")))
+      Internat::CompatibleToDouble(value, &mViewInfo.zoom);
+
+   if (!wxStrcmp(attr, wxT("rate"))) {
+      Internat::CompatibleToDouble(value, &mRate);
+      GetSelectionBar()->SetRate(mRate);
+   }
+
+   if (!wxStrcmp(attr, wxT("snapto"))) {
+      SetSnapTo(wxString(value) == wxT("on") ? true : false);
+   }
+
+   if (!wxStrcmp(attr, wxT("selectionformat"))) {
+      SetSelectionFormat(value);
+   }
+}
+
 XMLTagHandler *AudacityProject::HandleXMLChild(const wxChar *tag)
 {
    if (!wxStrcmp(tag, wxT("tags"))) {
@@ -3060,6 +3114,16 @@ XMLTagHandler *AudacityProject::HandleXMLChild(const wxChar *tag)
       return mRecordingRecoveryHandler;
    }
 
+   if (!wxStrcmp(tag, wxT("autosavetrack")) ||
+       !wxStrcmp(tag, wxT("autosaveclips")) ||
+       !wxStrcmp(tag, wxT("autosaveorder")) ||
+       !wxStrcmp(tag, wxT("autosavetags")) ||
+       !wxStrcmp(tag, wxT("autosaveview"))) {
+      if (!mAutoSaveJournalHandler)
+         mAutoSaveJournalHandler = new AutoSaveJournalHandler(this);
+      return mAutoSaveJournalHandler;
+   }
+
    if (!wxStrcmp(tag, wxT("import"))) {
       if (mImportXMLTagHandler == NULL)
          mImportXMLTagHandler = new ImportXMLTagHandler(this);
@@ -3084,6 +3148,19 @@ void AudacityProject::WriteXMLHeader(XMLWriter &xmlFile)
    xmlFile.Write(wxT(">\n"));
 }
 
+void AudacityProject::WriteXMLViewAttrs(XMLWriter &xmlFile)
+{
+   xmlFile.WriteAttr(wxT("sel0"), mViewInfo.selectedRegion.t0(), 10);
+   xmlFile.WriteAttr(wxT("sel1"), mViewInfo.selectedRegion.t1(), 10);
+   // PRL: to do: persistence of other fields of the selection
+   xmlFile.WriteAttr(wxT("vpos"), mViewInfo.vpos);
+   xmlFile.WriteAttr(wxT("h"), mViewInfo.h, 10);
+   xmlFile.WriteAttr(wxT("zoom"), mViewInfo.zoom, 10);
+   xmlFile.WriteAttr(wxT("rate"), mRate);
+   xmlFile.WriteAttr(wxT("snapto"), GetSnapTo() ? wxT("on") : wxT("off"));
+   xmlFile.WriteAttr(wxT("selectionformat"), GetSelectionFormat());
+}
+
 void AudacityProject::WriteXML(XMLWriter &xmlFile)
 {
    // Warning: This block of code is duplicated in Save, for now...
@@ -3117,15 +3194,7 @@ void AudacityProject::WriteXML(XMLWriter &xmlFile)
    xmlFile.WriteAttr(wxT("projname"), projName);
    xmlFile.WriteAttr(wxT("version"), wxT(AUDACITY_FILE_FORMAT_VERSION));
    xmlFile.WriteAttr(wxT("audacityversion"), AUDACITY_VERSION_STRING);
-   xmlFile.WriteAttr(wxT("sel0"), mViewInfo.selectedRegion.t0(), 10);
-   xmlFile.WriteAttr(wxT("sel1"), mViewInfo.selectedRegion.t1(), 10);
-   // PRL: to do: persistence of other fields of the selection
-   xmlFile.WriteAttr(wxT("vpos"), mViewInfo.vpos);
-   xmlFile.WriteAttr(wxT("h"), mViewInfo.h, 10);
-   xmlFile.WriteAttr(wxT("zoom"), mViewInfo.zoom, 10);
-   xmlFile.WriteAttr(wxT("rate"), mRate);
-   xmlFile.WriteAttr(wxT("snapto"), GetSnapTo() ? wxT("on") : wxT("off"));
-   xmlFile.WriteAttr(wxT("selectionformat"), GetSelectionFormat());
+   WriteXMLViewAttrs(xmlFile);
 
    mTags->WriteXML(xmlFile);
 
@@ -3323,6 +3392,12 @@ bool AudacityProject::Save(bool overwrite /* = true */ ,
    // Write the AUP file.
    XMLFileWriter saveFile;
 
+#ifdef EXPERIMENTAL_BLOCK_MANIFEST
+   // The sequences add themselves to the manifest as they are written
+   if (!bWantSaveCompressed)
+      mDirManager->BeginManifest();
+#endif
+
    try
    {
       saveFile.Open(mFileName, wxT("wb"));
@@ -3341,6 +3416,10 @@ bool AudacityProject::Save(bool overwrite /* = true */ ,
 
       delete pException;
 
+#ifdef EXPERIMENTAL_BLOCK_MANIFEST
+      mDirManager->CloseManifest();
+#endif
+
       // When XMLWriter throws an exception, it tries to close it before,
       // so we can at least try to delete the incomplete file and move the
       // backup file over.
@@ -3364,6 +3443,12 @@ bool AudacityProject::Save(bool overwrite /* = true */ ,
       mWantSaveCompressed = false; // Don't want this mode for AudacityProject::WriteXML() any more.
    else
    {
+#ifdef EXPERIMENTAL_BLOCK_MANIFEST
+      // Stamped with the size and time of the file just written.  Without
+      // it the project still opens, from the XML alone.
+      mDirManager->WriteManifest(mFileName);
+#endif
+
       // Now that we have saved the file, we can delete the auto-saved version
       DeleteCurrentAutoSaveFile();
 
@@ -3634,6 +3719,12 @@ bool AudacityProject::Import(wxString fileName, WaveTrackArray* pTrackArray /*=
       }
    }
 
+   FinishImport(fileName, newTracks, numTracks);
+   return true;
+}
+
+void AudacityProject::FinishImport(wxString fileName, Track **newTracks, int numTracks)
+{
    AddImportedTracks(fileName, newTracks, numTracks);
 
    int mode = gPrefs->Read(wxT("/AudioFiles/NormalizeOnLoad"), 0L);
@@ -3646,9 +3737,68 @@ bool AudacityProject::Import(wxString fileName, WaveTrackArray* pTrackArray /*=
    }
 
    GetDirManager()->FillBlockfilesCache();
-   return true;
 }
 
+#ifdef EXPERIMENTAL_PARALLEL_IMPORT
+void AudacityProject::ImportFiles(const wxArrayString &fileNames)
+{
+   Importer &importer = Importer::Get();
+
+   // The job of each file, or NULL for files that have to be imported
+   // on the main thread
+   ImportJobArray jobs;
+   wxArrayPtrVoid fileJobs;
+   for (size_t ff = 0; ff < fileNames.GetCount(); ff++) {
+      ImportFileHandle *handle = importer.OpenForParallelImport(fileNames[ff]);
+      ImportJob *job = NULL;
+      if (handle) {
+         // Each file gets its own copy of the tags, the last file's win
+         // as when the files are imported one after the other
+         Tags *tags = new Tags;
+         *tags = *mTags;
+         job = new ImportJob(fileNames[ff], handle, tags);
+         jobs.Add(job);
+      }
+      fileJobs.Add(job);
+   }
+
+   int result = eProgressSuccess;
+   if (jobs.GetCount() > 1)
+      result = importer.ImportParallel(mTrackFactory, jobs);
+   else {
+      // Nothing to gain from the threads
+      for (size_t i = 0; i < jobs.GetCount(); i++)
+         delete jobs[i];
+      jobs.Clear();
+      for (size_t ff = 0; ff < fileJobs.GetCount(); ff++)
+         fileJobs[ff] = NULL;
+   }
+
+   for (size_t ff = 0; ff < fileNames.GetCount(); ff++) {
+      ImportJob *job = (ImportJob *)fileJobs[ff];
+      if (!job) {
+         if (result == eProgressSuccess)
+            Import(fileNames[ff]);
+         continue;
+      }
+
+      if ((job->result == eProgressSuccess || job->result == eProgressStopped) &&
+          job->numTracks > 0) {
+         *mTags = *job->tags;
+         wxGetApp().AddFileToHistory(job->fileName);
+         FinishImport(job->fileName, job->tracks, job->numTracks);
+      }
+      else if (job->result == eProgressSuccess) {
+         // The plugin found nothing to import.  Import() tries the
+         // other plugins and tells the user if none of them can.
+         Import(job->fileName);
+      }
+
+      delete job;
+   }
+}
+#endif
+
 bool AudacityProject::SaveAs(const wxString newFileName, bool bWantSaveCompressed /*= false*/, bool addToHistory /*= true*/)
 {
    wxString oldFileName = mFileName;
@@ -4610,6 +4760,15 @@ void AudacityProject::AutoSave()
 {
    //    SonifyBeginAutoSave(); // part of RBD's r10680 stuff now backed out
 
+#ifdef EXPERIMENTAL_AUTOSAVE_JOURNAL
+   // Usually only a few tracks changed since the auto-save file was
+   // written, so append just those to it
+   if (!mAutoSaveJournal)
+      mAutoSaveJournal = new AutoSaveJournal();
+   if (mAutoSaveJournal->Append(this, mAutoSaveFileName))
+      return;
+#endif
+
    // To minimize the possibility of race conditions, we first write to a
    // file with the extension ".tmp", then rename the file to .autosave
    wxString projName;
@@ -4666,6 +4825,10 @@ void AudacityProject::AutoSave()
    }
 
    mAutoSaveFileName += fn + wxT(".autosave");
+
+#ifdef EXPERIMENTAL_AUTOSAVE_JOURNAL
+   mAutoSaveJournal->Checkpoint(this, mAutoSaveFileName);
+#endif
    // no-op cruft that's not #ifdefed for NoteTrack
    // See above for further comments.
    //   SonifyEndAutoSave();
@@ -4768,6 +4931,11 @@ void AudacityProject::OnAudioIONewBlockFiles(const wxString& blockFileLog)
          return; // Keep recording going, there's not much we can do here
       f.Write(blockFileLog);
       f.Close();
+
+      // The journal would not know about these blocks, so the next
+      // auto-save writes the whole project again
+      if (mAutoSaveJournal)
+         mAutoSaveJournal->Invalidate();
    }
 }
 
@@ -55,6 +55,8 @@ class AudacityProject;
 class Importer;
 class ODLock;
 class RecordingRecoveryHandler;
+class AutoSaveJournal;
+class AutoSaveJournalHandler;
 class TrackList;
 class Tags;
 class EffectPlugs;
@@ -204,6 +206,11 @@ class AUDACITY_DLL_API AudacityProject:  public wxFrame,
 
    // If pNewTrackList is passed in non-NULL, it gets filled with the pointers to new tracks.
    bool Import(wxString fileName, WaveTrackArray *pTrackArray = NULL);
+#ifdef EXPERIMENTAL_PARALLEL_IMPORT
+   // Imports the files, several at a time where possible, adding the tracks
+   // in the order of fileNames.
+   void ImportFiles(const wxArrayString &fileNames);
+#endif
 
    void AddImportedTracks(wxString fileName,
                           Track **newTracks, int numTracks);
@@ -422,6 +429,10 @@ class AUDACITY_DLL_API AudacityProject:  public wxFrame,
 
    void WriteXMLHeader(XMLWriter &xmlFile);
 
+   // The selection, view and rate attributes of <project>
+   void WriteXMLViewAttrs(XMLWriter &xmlFile);
+   void HandleXMLViewAttr(const wxChar *attr, const wxChar *value);
+
    PlayMode mLastPlayMode;
    ViewInfo mViewInfo;
 
@@ -461,6 +472,10 @@ class AUDACITY_DLL_API AudacityProject:  public wxFrame,
    void AutoSave();
    void DeleteCurrentAutoSaveFile();
 
+   // Adds the tracks of a successful import and does the rest of the
+   // work Import() does once the file is decoded
+   void FinishImport(wxString fileName, Track **newTracks, int numTracks);
+
    static bool GetCacheBlockFiles();
 
  public:
@@ -597,6 +612,13 @@ class AUDACITY_DLL_API AudacityProject:  public wxFrame,
    // The handler that handles recovery of <recordingrecovery> tags
    RecordingRecoveryHandler* mRecordingRecoveryHandler;
 
+   // What the auto-save file holds, so that AutoSave() can append only
+   // what changed since
+   AutoSaveJournal* mAutoSaveJournal;
+
+   // The handler that replays the <autosave...> tags of a journal
+   AutoSaveJournalHandler* mAutoSaveJournalHandler;
+
    // Dependencies have been imported and a warning should be shown on save
    bool mImportedDependencies;
 
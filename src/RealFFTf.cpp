@@ -18,6 +18,9 @@
 *                   and BitReversed tables so they don't need to be reallocated
 *                   and recomputed on every call.
 *                 - Added Reorder* functions to undo the bit-reversal
+*              Modified 2015 for Audacity
+*                 - GetFFT and ReleaseFFT may be called from several threads
+*                 - The butterflies use SSE when the processor has it
 *
 *  Copyright (C) 2009  Philip VanBaren
 *
@@ -39,6 +42,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <wx/thread.h>
 #include "Experimental.h"
 
 #include "RealFFTf.h"
@@ -50,6 +54,26 @@
 #define	M_PI		3.14159265358979323846  /* pi */
 #endif
 
+/*
+*  The SSE butterflies are compiled on any x86 target, even when the compiler
+*  may not use SSE by itself, and are only called if the processor has it.
+*/
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define REALFFTF_SSE
+#include <xmmintrin.h>
+#include <intrin.h>
+#define REALFFTF_SSE_FUNC
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define REALFFTF_SSE
+#include <xmmintrin.h>
+#include <cpuid.h>
+#ifdef __SSE__
+#define REALFFTF_SSE_FUNC
+#else
+#define REALFFTF_SSE_FUNC __attribute__((target("sse")))
+#endif
+#endif
+
 /*
 *  Initialize the Sine table and Twiddle pointers (bit-reversed pointers)
 *  for the FFT routine.
@@ -126,11 +150,14 @@ void EndFFT(HFFT h)
 #define MAX_HFFT 10
 static HFFT hFFTArray[MAX_HFFT] = { NULL };
 static int nFFTLockCount[MAX_HFFT] = { 0 };
+/* The tables are shared, and handed out to any thread */
+static wxCriticalSection sFFTArrayLock;
 
 /* Get a handle to the FFT tables of the desired length */
 /* This version keeps common tables rather than allocating a new table every time */
 HFFT GetFFT(int fftlen)
 {
+   wxCriticalSectionLocker locker(sFFTArrayLock);
    int h,n = fftlen/2;
    for(h=0; (h<MAX_HFFT) && (hFFTArray[h] != NULL) && (n != hFFTArray[h]->Points); h++);
    if(h<MAX_HFFT) {
@@ -149,6 +176,7 @@ HFFT GetFFT(int fftlen)
 /* Release a previously requested handle to the FFT tables */
 void ReleaseFFT(HFFT hFFT)
 {
+   wxCriticalSectionLocker locker(sFFTArrayLock);
    int h;
    for(h=0; (h<MAX_HFFT) && (hFFTArray[h] != hFFT); h++);
    if(h<MAX_HFFT) {
@@ -161,6 +189,7 @@ void ReleaseFFT(HFFT hFFT)
 /* Deallocate any unused FFT tables */
 void CleanupFFT()
 {
+   wxCriticalSectionLocker locker(sFFTArrayLock);
    int h;
    for(h=0; (h<MAX_HFFT); h++) {
       if((nFFTLockCount[h] <= 0) && (hFFTArray[h] != NULL)) {
@@ -170,6 +199,67 @@ void CleanupFFT()
    }
 }
 
+#ifdef REALFFTF_SSE
+static bool HaveSSE()
+{
+#if defined(_M_X64) || defined(__x86_64__)
+   return true;
+#elif defined(_MSC_VER)
+   int info[4];
+   __cpuid(info, 1);
+   return (info[3] & (1 << 25)) != 0;
+#else
+   unsigned int eax, ebx, ecx, edx;
+   if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+      return false;
+   return (edx & bit_SSE) != 0;
+#endif
+}
+
+/* -1 until the processor has been checked */
+static int sUseSSE = -1;
+
+static bool UseSSE()
+{
+   if(sUseSSE < 0)
+      sUseSSE = HaveSSE() ? 1 : 0;
+   return sUseSSE != 0;
+}
+
+/*
+*  Does the butterflies of one group two at a time.  For each complex pair
+*  (Br,Bi) the rotated value is W = (Br*cos + Bi*sin, Bi*cos - Br*sin) for the
+*  forward FFT, then Bout = A + W and Aout = A - W.  The inverse FFT rotates
+*  the other way and halves the outputs.
+*/
+REALFFTF_SSE_FUNC
+static void ButterflyGroupSSE(fft_type *A, fft_type *B, fft_type *endptr2,
+                              fft_type sin, fft_type cos, bool inverse)
+{
+   __m128 c = _mm_set1_ps(cos);
+   __m128 s = inverse ? _mm_setr_ps(-sin, sin, -sin, sin)
+                      : _mm_setr_ps(sin, -sin, sin, -sin);
+   __m128 half = _mm_set1_ps(0.5f);
+   while(A<endptr2)
+   {
+      __m128 a = _mm_loadu_ps(A);
+      __m128 b = _mm_loadu_ps(B);
+      __m128 bswap = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2,3,0,1));
+      __m128 w = _mm_add_ps(_mm_mul_ps(b, c), _mm_mul_ps(bswap, s));
+      __m128 bout = _mm_add_ps(a, w);
+      __m128 aout = _mm_sub_ps(a, w);
+      if(inverse) {
+         bout = _mm_mul_ps(bout, half);
+         aout = _mm_mul_ps(aout, half);
+      }
+      _mm_storeu_ps(B, bout);
+      _mm_storeu_ps(A, aout);
+      A+=4;
+      B+=4;
+   }
+}
+#endif
+
 /*
 *  Forward FFT routine.  Must call InitializeFFT(fftlen) first!
 *
@@ -220,6 +310,14 @@ void RealFFTf(fft_type *buffer,HFFT h)
          sin=*sptr;
          cos=*(sptr+1);
          endptr2=B;
+#ifdef REALFFTF_SSE
+         if(ButterfliesPerGroup>1 && UseSSE())
+         {
+            ButterflyGroupSSE(A, B, endptr2, sin, cos, false);
+            B+=ButterfliesPerGroup*2;
+            A=endptr2;
+         }
+#endif
          while(A<endptr2)
          {
             v1=*B*cos + *(B+1)*sin;
@@ -357,6 +455,14 @@ void InverseRealFFTf(fft_type *buffer,HFFT h)
          sin=*(sptr++);
          cos=*(sptr++);
          endptr2=B;
+#ifdef REALFFTF_SSE
+         if(ButterfliesPerGroup>1 && UseSSE())
+         {
+            ButterflyGroupSSE(A, B, endptr2, sin, cos, true);
+            B+=ButterfliesPerGroup*2;
+            A=endptr2;
+         }
+#endif
          while(A<endptr2)
          {
             v1=*B*cos - *(B+1)*sin;
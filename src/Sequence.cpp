@@ -62,6 +62,8 @@ Sequence::Sequence(DirManager * projDirManager, sampleFormat format)
    mMinSamples = sMaxDiskBlockSize / SAMPLE_SIZE(mSampleFormat) / 2;
    mMaxSamples = mMinSamples * 2;
    mErrorOpening = false;
+   mFromManifest = false;
+   mManifestTags = 0;
 }
 
 Sequence::Sequence(const Sequence &orig, DirManager *projDirManager)
@@ -77,6 +79,8 @@ Sequence::Sequence(const Sequence &orig, DirManager *projDirManager)
    mMaxSamples = orig.mMaxSamples;
    mMinSamples = orig.mMinSamples;
    mErrorOpening = false;
+   mFromManifest = false;
+   mManifestTags = 0;
 
    mBlock = new BlockArray();
 
@@ -826,6 +830,12 @@ bool Sequence::HandleXMLTag(const wxChar *tag, const wxChar **attrs)
 
    /* handle waveblock tag and it's attributes */
    if (!wxStrcmp(tag, wxT("waveblock"))) {
+      // The blocks were already built from the block manifest
+      if (mFromManifest) {
+         mManifestTags++;
+         return true;
+      }
+
       SeqBlock *wb = new SeqBlock();
       wb->f = NULL;
       wb->start = 0;
@@ -884,6 +894,10 @@ bool Sequence::HandleXMLTag(const wxChar *tag, const wxChar **attrs)
 
    /* handle sequence tag and it's attributes */
    if (!wxStrcmp(tag, wxT("sequence"))) {
+      // Every <sequence> has a record in the block manifest, so take it
+      // before anything can fail
+      const BlockManifestSequence *manifest = mDirManager->NextManifestSequence();
+
       while(*attrs) {
          const wxChar *attr = *attrs++;
          const wxChar *value = *attrs++;
@@ -944,6 +958,10 @@ bool Sequence::HandleXMLTag(const wxChar *tag, const wxChar **attrs)
       //   return false;
       //}
 
+      mFromManifest = mDirManager->LoadFromManifest(manifest, mBlock, mMaxSamples,
+                                                    mSampleFormat, mNumSamples);
+      mManifestTags = 0;
+
       return true;
    }
 
@@ -955,6 +973,16 @@ void Sequence::HandleXMLEndTag(const wxChar *tag)
    if (wxStrcmp(tag, wxT("sequence")) != 0)
       return;
 
+   if (mFromManifest) {
+      mFromManifest = false;
+      if (mManifestTags != mBlock->GetCount()) {
+         wxLogWarning(
+            wxT("Sequence has %d blocks in the project file but %d in the block manifest."),
+            (int)mManifestTags, (int)mBlock->GetCount());
+         mErrorOpening = true;
+      }
+   }
+
    // Make sure that the sequence is valid.
    // First, replace missing blockfiles with SilentBlockFiles
    unsigned int b;
@@ -1017,6 +1045,8 @@ XMLTagHandler *Sequence::HandleXMLChild(const wxChar *tag)
 {
    if (!wxStrcmp(tag, wxT("waveblock")))
       return this;
+   else if (mFromManifest)
+      return NULL;
    else {
       mDirManager->SetLoadingFormat(mSampleFormat);
       return mDirManager;
@@ -1061,6 +1091,8 @@ void Sequence::WriteXML(XMLWriter &xmlFile)
    }
 
    xmlFile.EndTag(wxT("sequence"));
+
+   mDirManager->AddToManifest(mMaxSamples, mSampleFormat, mNumSamples, mBlock);
 }
 
 int Sequence::FindBlock(sampleCount pos, sampleCount lo,
@@ -194,6 +194,11 @@ class Sequence: public XMLTagHandler {
 
    bool          mErrorOpening;
 
+   // Set while loading a sequence whose blocks came from the block
+   // manifest; its <waveblock> tags are then only counted
+   bool          mFromManifest;
+   unsigned int  mManifestTags;
+
    ///To block the Delete() method against the ODCalcSummaryTask::Update() method
    ODLock   mDeleteUpdateMutex;
 
@@ -39,6 +39,10 @@ bool ComputeSpectrum(float * data, int width,
    float *in = new float[windowSize];
    float *out = new float[windowSize];
    float *out2 = new float[windowSize];
+#ifdef EXPERIMENTAL_USE_REALFFTF
+   HFFT hFFT = GetFFT(windowSize);
+   float *scratch = new float[windowSize];
+#endif
 
    int start = 0;
    int windows = 0;
@@ -51,7 +55,7 @@ bool ComputeSpectrum(float * data, int width,
       if (autocorrelation) {
          // Take FFT
 #ifdef EXPERIMENTAL_USE_REALFFTF
-         RealFFT(windowSize, in, out, out2);
+         RealFFT(hFFT, in, out, out2, scratch);
 #else
          FFT(windowSize, false, in, NULL, out, out2);
 #endif
@@ -67,14 +71,18 @@ bool ComputeSpectrum(float * data, int width,
 
          // Take FFT
 #ifdef EXPERIMENTAL_USE_REALFFTF
-         RealFFT(windowSize, in, out, out2);
+         RealFFT(hFFT, in, out, out2, scratch);
 #else
          FFT(windowSize, false, in, NULL, out, out2);
 #endif
 
       }
       else
+#ifdef EXPERIMENTAL_USE_REALFFTF
+         PowerSpectrum(hFFT, in, out, scratch);
+#else
          PowerSpectrum(windowSize, in, out);
+#endif
 
       // Take real part of result
       for (i = 0; i < half; i++)
@@ -132,6 +140,10 @@ bool ComputeSpectrum(float * data, int width,
    delete[]out;
    delete[]out2;
    delete[]processed;
+#ifdef EXPERIMENTAL_USE_REALFFTF
+   delete[]scratch;
+   ReleaseFFT(hFFT);
+#endif
 
    return true;
 }
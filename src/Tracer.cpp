@@ -0,0 +1,284 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  Tracer.cpp
+
+*******************************************************************//**
+
+\class Tracer
+\brief Records when scopes of code start and end on each thread, to be
+saved as a Chrome trace.
+
+*//*******************************************************************/
+
+#include "Tracer.h"
+
+#ifdef EXPERIMENTAL_TRACING
+
+#include <stdio.h>
+#include <vector>
+
+#include <wx/ffile.h>
+
+#ifdef __WXMSW__
+#include <windows.h>
+#else
+#include <pthread.h>
+#ifdef __WXMAC__
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+#endif
+
+#include "ondemand/ODTaskThread.h"
+
+// Events held for each thread
+static const int kNumEvents = 8192;
+// Buffers of threads that have ended are kept, with their events, until
+// there are this many buffers; then they are given to new threads.
+static const size_t kMaxBuffers = 32;
+
+struct TraceEvent
+{
+   const char *name;
+   wxInt64 start;
+   wxInt64 duration;
+};
+
+// The events of one thread.  Only the thread writes them; Write() reads
+// them without stopping it, and drops those that may have been
+// overwritten while it did.
+class TraceBuffer
+{
+ public:
+   TraceBuffer(int threadId)
+   :  mWritten(0),
+      mThreadId(threadId),
+      mThreadName(NULL),
+      mEnded(false)
+   {
+#ifdef __WXMSW__
+      mThread = NULL;
+#endif
+   }
+
+   TraceEvent mEvents[kNumEvents];
+   volatile int mWritten;
+
+   int mThreadId;
+   const char *mThreadName;
+   bool mEnded;
+#ifdef __WXMSW__
+   // The thread writing the buffer, to find out whether it has ended
+   HANDLE mThread;
+#endif
+};
+
+// All of the buffers, guarded by sBuffersLock.  Buffers are never deleted,
+// as a thread may be writing to its own at any time.
+static std::vector<TraceBuffer *> sBuffers;
+static ODLock sBuffersLock;
+static int sNextThreadId = 1;
+
+#ifdef __WXMSW__
+
+static DWORD sBufferKey = TlsAlloc();
+
+static TraceBuffer *GetThreadBuffer()
+{
+   return (TraceBuffer *)TlsGetValue(sBufferKey);
+}
+
+static void SetThreadBuffer(TraceBuffer *buffer)
+{
+   TlsSetValue(sBufferKey, buffer);
+}
+
+// Mark the buffers of threads that have ended; sBuffersLock must be held
+static void FindEndedThreads()
+{
+   for (size_t i = 0; i < sBuffers.size(); i++) {
+      TraceBuffer *buffer = sBuffers[i];
+      if (!buffer->mEnded && buffer->mThread &&
+          WaitForSingleObject(buffer->mThread, 0) == WAIT_OBJECT_0)
+         buffer->mEnded = true;
+   }
+}
+
+#else
+
+static pthread_key_t sBufferKey;
+static pthread_once_t sBufferKeyOnce = PTHREAD_ONCE_INIT;
+
+static void OnThreadEnd(void *buffer)
+{
+   sBuffersLock.Lock();
+   ((TraceBuffer *)buffer)->mEnded = true;
+   sBuffersLock.Unlock();
+}
+
+static void CreateBufferKey()
+{
+   pthread_key_create(&sBufferKey, OnThreadEnd);
+}
+
+static TraceBuffer *GetThreadBuffer()
+{
+   pthread_once(&sBufferKeyOnce, CreateBufferKey);
+   return (TraceBuffer *)pthread_getspecific(sBufferKey);
+}
+
+static void SetThreadBuffer(TraceBuffer *buffer)
+{
+   pthread_setspecific(sBufferKey, buffer);
+}
+
+// OnThreadEnd marks the buffers as threads end
+static void FindEndedThreads()
+{
+}
+
+#endif
+
+// The buffer of the calling thread, made the first time it records
+static TraceBuffer *GetBuffer()
+{
+   TraceBuffer *buffer = GetThreadBuffer();
+   if (buffer)
+      return buffer;
+
+   sBuffersLock.Lock();
+   if (sBuffers.size() >= kMaxBuffers) {
+      FindEndedThreads();
+      for (size_t i = 0; i < sBuffers.size(); i++) {
+         if (sBuffers[i]->mEnded) {
+            buffer = sBuffers[i];
+            buffer->mWritten = 0;
+            buffer->mThreadId = sNextThreadId++;
+            buffer->mThreadName = NULL;
+            buffer->mEnded = false;
+            break;
+         }
+      }
+   }
+   if (!buffer) {
+      buffer = new TraceBuffer(sNextThreadId++);
+      sBuffers.push_back(buffer);
+   }
+#ifdef __WXMSW__
+   // Windows has no call when a thread ends for TLS values, so hold a
+   // handle of the thread to ask FindEndedThreads() later
+   if (buffer->mThread)
+      CloseHandle(buffer->mThread);
+   buffer->mThread = OpenThread(SYNCHRONIZE, FALSE, GetCurrentThreadId());
+#endif
+   sBuffersLock.Unlock();
+
+   SetThreadBuffer(buffer);
+   return buffer;
+}
+
+wxInt64 Tracer::Now()
+{
+#ifdef __WXMSW__
+   static LARGE_INTEGER frequency;
+   if (frequency.QuadPart == 0)
+      QueryPerformanceFrequency(&frequency);
+   LARGE_INTEGER now;
+   QueryPerformanceCounter(&now);
+   return (wxInt64)(now.QuadPart / (double)frequency.QuadPart * 1000000.0);
+#elif defined(__WXMAC__)
+   static mach_timebase_info_data_t timebase;
+   if (timebase.denom == 0)
+      mach_timebase_info(&timebase);
+   return (wxInt64)(mach_absolute_time() * (double)timebase.numer / timebase.denom / 1000.0);
+#else
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (wxInt64)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#endif
+}
+
+void Tracer::Add(const char *name, wxInt64 start, wxInt64 end)
+{
+   Add(GetBuffer(), name, start, end);
+}
+
+void Tracer::Add(TraceBuffer *buffer, const char *name, wxInt64 start, wxInt64 end)
+{
+   TraceEvent &event = buffer->mEvents[buffer->mWritten % kNumEvents];
+   event.name = name;
+   event.start = start;
+   event.duration = end - start;
+   buffer->mWritten++;
+}
+
+void Tracer::SetThreadName(const char *name)
+{
+   GetBuffer()->mThreadName = name;
+}
+
+TraceBuffer *Tracer::NewBuffer(const char *threadName)
+{
+   // Never ended, so never given to another thread
+   TraceBuffer *buffer;
+   sBuffersLock.Lock();
+   buffer = new TraceBuffer(sNextThreadId++);
+   buffer->mThreadName = threadName;
+   sBuffers.push_back(buffer);
+   sBuffersLock.Unlock();
+   return buffer;
+}
+
+bool Tracer::Write(const wxString &fileName)
+{
+   wxFFile file(fileName, wxT("w"));
+   if (!file.IsOpened())
+      return false;
+
+   FILE *fp = file.fp();
+   fprintf(fp, "{\"traceEvents\":[\n");
+
+   // Names are string literals of the code, so they need no escapes
+   const char *separator = "";
+
+   sBuffersLock.Lock();
+   for (size_t b = 0; b < sBuffers.size(); b++) {
+      TraceBuffer *buffer = sBuffers[b];
+
+      int written = buffer->mWritten;
+      int first = written > kNumEvents ? written - kNumEvents : 0;
+      std::vector<TraceEvent> events;
+      for (int i = first; i < written; i++)
+         events.push_back(buffer->mEvents[i % kNumEvents]);
+
+      // The thread goes on writing while these are copied; drop those
+      // it may have overwritten
+      int overwritten = buffer->mWritten - kNumEvents - first + 1;
+      size_t skip = overwritten > 0 ? (size_t)overwritten : 0;
+
+      if (buffer->mThreadName) {
+         fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                     "\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                 separator, buffer->mThreadId, buffer->mThreadName);
+         separator = ",\n";
+      }
+
+      for (size_t i = skip; i < events.size(); i++) {
+         fprintf(fp, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                     "\"ts\":%.0f,\"dur\":%.0f}",
+                 separator, events[i].name, buffer->mThreadId,
+                 (double)events[i].start, (double)events[i].duration);
+         separator = ",\n";
+      }
+   }
+   sBuffersLock.Unlock();
+
+   fprintf(fp, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+   return file.Close();
+}
+
+#endif
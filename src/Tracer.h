@@ -0,0 +1,112 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  Tracer.h
+
+*******************************************************************//**
+
+\class Tracer
+\brief Records when scopes of code start and end on each thread, to be
+saved as a Chrome trace.
+
+  TRACE_SCOPE("name") at the top of a block records the time the block
+  takes as one event.  Each thread writes its events to a ring buffer of
+  its own, so recording takes no lock, only a lookup of the thread's
+  buffer and two reads of the clock; the oldest events are overwritten
+  when a buffer is full.  Tracer::Write() saves the events held by all of
+  the buffers in the JSON trace format of Chrome, which chrome://tracing
+  and Perfetto open, so that the threads can be seen side by side.
+
+  The first event of a thread makes its buffer, under a lock.  A thread
+  that must never lock or allocate, such as the audio callback, records
+  with TRACE_SCOPE_TO() into a buffer that another thread made for it
+  beforehand with Tracer::NewBuffer().
+
+  Unlike Profiler, which keeps averages of named tasks under a lock, this
+  is cheap enough for the audio callback.
+
+*//*******************************************************************/
+
+#ifndef __AUDACITY_TRACER__
+#define __AUDACITY_TRACER__
+
+#include <wx/defs.h>
+#include <wx/string.h>
+
+#include "Audacity.h"
+#include "Experimental.h"
+
+#ifdef EXPERIMENTAL_TRACING
+
+/// Records the time from here to the end of the block; NAME must be a
+/// string literal
+#define TRACE_SCOPE(NAME) TraceScope traceScope(NAME)
+/// Records the time from here to the end of the block into BUFFER, which
+/// Tracer::NewBuffer() made
+#define TRACE_SCOPE_TO(BUFFER, NAME) TraceScope traceScope(BUFFER, NAME)
+/// Names the calling thread in traces; NAME must be a string literal
+#define TRACE_THREAD_NAME(NAME) Tracer::SetThreadName(NAME)
+
+class TraceBuffer;
+
+class AUDACITY_DLL_API Tracer
+{
+ public:
+   /// Microseconds since some time in the past, from a clock that only
+   /// goes forward
+   static wxInt64 Now();
+
+   static void Add(const char *name, wxInt64 start, wxInt64 end);
+   static void SetThreadName(const char *name);
+
+   /// Makes a buffer for a thread that may not make its own, named
+   /// THREADNAME in traces.  It is kept until the program ends.
+   static TraceBuffer *NewBuffer(const char *threadName);
+   /// Records into BUFFER without locking or allocating
+   static void Add(TraceBuffer *buffer, const char *name, wxInt64 start, wxInt64 end);
+
+   /// Saves the events held now as a Chrome trace
+   static bool Write(const wxString &fileName);
+};
+
+class TraceScope
+{
+ public:
+   TraceScope(const char *name)
+   :  mBuffer(NULL),
+      mName(name),
+      mStart(Tracer::Now())
+   {
+   }
+
+   TraceScope(TraceBuffer *buffer, const char *name)
+   :  mBuffer(buffer),
+      mName(name),
+      mStart(Tracer::Now())
+   {
+   }
+
+   ~TraceScope()
+   {
+      if (mBuffer)
+         Tracer::Add(mBuffer, mName, mStart, Tracer::Now());
+      else
+         Tracer::Add(mName, mStart, Tracer::Now());
+   }
+
+ private:
+   TraceBuffer *mBuffer;
+   const char *mName;
+   wxInt64 mStart;
+};
+
+#else
+
+#define TRACE_SCOPE(NAME)
+#define TRACE_SCOPE_TO(BUFFER, NAME)
+#define TRACE_THREAD_NAME(NAME)
+
+#endif
+
+#endif
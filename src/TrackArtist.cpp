@@ -176,6 +176,7 @@ audio tracks.
 #include "Sequence.h"
 #include "Spectrum.h"
 #include "ViewInfo.h"
+#include "WaveformRaster.h"
 #include "widgets/Ruler.h"
 #include "Theme.h"
 #include "AllThemeResources.h"
@@ -942,7 +943,8 @@ void TrackArtist::DrawWaveformBackground(wxDC &dc, const wxRect &r, const double
                                          float zoomMin, float zoomMax, bool dB,
                                          const sampleCount where[],
                                          sampleCount ssel0, sampleCount ssel1,
-                                         bool drawEnvelope, bool bIsSyncLockSelected)
+                                         bool drawEnvelope, bool bIsSyncLockSelected,
+                                         WaveformRaster *raster)
 {
    // Visually (one vertical slice of the waveform background, on its side;
    // the "*" is the actual waveform background we're drawing
@@ -963,9 +965,11 @@ void TrackArtist::DrawWaveformBackground(wxDC &dc, const wxRect &r, const double
    int x, lx = 0;
    int l, w;
 
-   dc.SetPen(*wxTRANSPARENT_PEN);
-   dc.SetBrush(blankBrush);
-   dc.DrawRectangle(r);
+   if (!raster) {
+      dc.SetPen(*wxTRANSPARENT_PEN);
+      dc.SetBrush(blankBrush);
+      dc.DrawRectangle(r);
+   }
 
    for (x = 0; x < r.width; x++) {
       // First we compute the truncated shape of the waveform background.
@@ -994,6 +998,14 @@ void TrackArtist::DrawWaveformBackground(wxDC &dc, const wxRect &r, const double
       // We don't draw selection color for sync-lock selected tracks.
       sel = (ssel0 <= where[x] && where[x + 1] < ssel1) && !bIsSyncLockSelected;
 
+      if (raster) {
+         if (maxbot < mintop - 1)
+            raster->SetBackground(x, maxtop, maxbot - 1, mintop, minbot - 1, sel);
+         else
+            raster->SetBackground(x, maxtop, minbot - 1, 0, -1, sel);
+         continue;
+      }
+
       if (lmaxtop == maxtop &&
           lmintop == mintop &&
           lmaxbot == maxbot &&
@@ -1022,19 +1034,22 @@ void TrackArtist::DrawWaveformBackground(wxDC &dc, const wxRect &r, const double
       lx = x;
    }
 
-   dc.SetBrush(lsel ? selectedBrush : unselectedBrush);
-   l = r.x + lx;
-   w = x - lx;
-   if (lmaxbot < lmintop - 1) {
-      dc.DrawRectangle(l, r.y + lmaxtop, w, lmaxbot - lmaxtop);
-      dc.DrawRectangle(l, r.y + lmintop, w, lminbot - lmintop);
-   }
-   else {
-      dc.DrawRectangle(l, r.y + lmaxtop, w, lminbot - lmaxtop);
+   if (!raster) {
+      dc.SetBrush(lsel ? selectedBrush : unselectedBrush);
+      l = r.x + lx;
+      w = x - lx;
+      if (lmaxbot < lmintop - 1) {
+         dc.DrawRectangle(l, r.y + lmaxtop, w, lmaxbot - lmaxtop);
+         dc.DrawRectangle(l, r.y + lmintop, w, lminbot - lmintop);
+      }
+      else {
+         dc.DrawRectangle(l, r.y + lmaxtop, w, lminbot - lmaxtop);
+      }
    }
 
-   // If sync-lock selected, draw in linked graphics.
-   if (bIsSyncLockSelected && ssel0 < ssel1) {
+   // If sync-lock selected, draw in linked graphics.  The raster has no
+   // tiles, so it isn't used then.
+   if (bIsSyncLockSelected && ssel0 < ssel1 && !raster) {
       // Find the beginning/end of the selection
       int begin, end;
       for (x = 0; x < r.width && where[x] < ssel0; ++x);
@@ -1049,8 +1064,12 @@ void TrackArtist::DrawWaveformBackground(wxDC &dc, const wxRect &r, const double
 
    if (zoomMin < 0 && zoomMax > 0) {
       int half = (int)((zoomMax / (zoomMax - zoomMin)) * h);
-      dc.SetPen(*wxBLACK_PEN);
-      AColor::Line(dc, r.x, r.y + half, r.x + r.width, r.y + half);
+      if (raster)
+         raster->SetZeroLine(half);
+      else {
+         dc.SetPen(*wxBLACK_PEN);
+         AColor::Line(dc, r.x, r.y + half, r.x + r.width, r.y + half);
+      }
    }
 }
 
@@ -1059,12 +1078,14 @@ void TrackArtist::DrawWaveformBackground(wxDC &dc, const wxRect &r, const double
 void TrackArtist::DrawMinMaxRMS(wxDC &dc, const wxRect &r, const double env[],
                                 float zoomMin, float zoomMax, bool dB,
                                 const float min[], const float max[], const float rms[],
-                                const int bl[], bool showProgress, bool muted, const float gain)
+                                const int bl[], bool showProgress, bool muted, const float gain,
+                                WaveformRaster *raster)
 #else
 void TrackArtist::DrawMinMaxRMS(wxDC &dc, const wxRect &r, const double env[],
                                 float zoomMin, float zoomMax, bool dB,
                                 const float min[], const float max[], const float rms[],
-                                const int bl[], bool WXUNUSED(showProgress), bool muted)
+                                const int bl[], bool WXUNUSED(showProgress), bool muted,
+                                WaveformRaster *raster)
 #endif
 {
    // Display a line representing the
@@ -1157,6 +1178,18 @@ void TrackArtist::DrawMinMaxRMS(wxDC &dc, const wxRect &r, const double env[],
          r2[x] = r1[x];
       }
 
+      if (raster) {
+         if (bl[x] <= -1) {
+            int triX = fabs((double)((x + pixAnimOffset) % (2 * r.height)) - r.height) + r.height;
+            raster->SetLoading(x, bl[x], (r.height - triX % r.height) % r.height);
+         }
+         else
+            raster->SetWave(x, wxMin(h1, h2), wxMax(h1, h2));
+         if (bl[x] > -1 && r1[x] != r2[x])
+            raster->SetRms(x, r2[x], r1[x]);
+         continue;
+      }
+
       if (bl[x] <= -1) {
          if (drawStripes) {
             // TODO:unify with buffer drawing.
@@ -1189,13 +1222,15 @@ void TrackArtist::DrawMinMaxRMS(wxDC &dc, const wxRect &r, const double env[],
       }
    }
 
-   dc.SetPen(muted ? muteRmsPen : rmsPen);
-   for (int x = 0; x < r.width; x++) {
-      int xx = r.x + x;
-      if (bl[x] <= -1) {
-      }
-      else if (r1[x] != r2[x]) {
-         AColor::Line(dc, xx, r.y + r2[x], xx, r.y + r1[x]);
+   if (!raster) {
+      dc.SetPen(muted ? muteRmsPen : rmsPen);
+      for (int x = 0; x < r.width; x++) {
+         int xx = r.x + x;
+         if (bl[x] <= -1) {
+         }
+         else if (r1[x] != r2[x]) {
+            AColor::Line(dc, xx, r.y + r2[x], xx, r.y + r1[x]);
+         }
       }
    }
 
@@ -1204,7 +1239,10 @@ void TrackArtist::DrawMinMaxRMS(wxDC &dc, const wxRect &r, const double env[],
       dc.SetPen(muted ? muteClippedPen : clippedPen);
       while (--clipcnt >= 0) {
          int xx = clipped[clipcnt];
-         AColor::Line(dc, xx, r.y, xx, r.y + r.height);
+         if (raster)
+            raster->SetClipped(xx - r.x);
+         else
+            AColor::Line(dc, xx, r.y, xx, r.y + r.height);
       }
    }
 
@@ -1216,6 +1254,31 @@ void TrackArtist::DrawMinMaxRMS(wxDC &dc, const wxRect &r, const double env[],
    delete [] r2;
 }
 
+#ifdef EXPERIMENTAL_WAVEFORM_RASTER
+static void SetRasterColor(WaveformRaster &raster, WaveformRaster::Color color,
+                           const wxColour &colour)
+{
+   raster.SetColor(color, colour.Red(), colour.Green(), colour.Blue());
+}
+
+void TrackArtist::SetRasterColors(WaveformRaster &raster, bool muted)
+{
+   SetRasterColor(raster, WaveformRaster::Blank, blankBrush.GetColour());
+   SetRasterColor(raster, WaveformRaster::Unselected, unselectedBrush.GetColour());
+   SetRasterColor(raster, WaveformRaster::Selected, selectedBrush.GetColour());
+   SetRasterColor(raster, WaveformRaster::ZeroLine, *wxBLACK);
+   SetRasterColor(raster, WaveformRaster::Sample,
+                  (muted ? muteSamplePen : samplePen).GetColour());
+   SetRasterColor(raster, WaveformRaster::Rms,
+                  (muted ? muteRmsPen : rmsPen).GetColour());
+   SetRasterColor(raster, WaveformRaster::Clipped,
+                  (muted ? muteClippedPen : clippedPen).GetColour());
+   SetRasterColor(raster, WaveformRaster::LoadingEven, samplePen.GetColour());
+   SetRasterColor(raster, WaveformRaster::LoadingOdd, muteSamplePen.GetColour());
+   SetRasterColor(raster, WaveformRaster::LoadingWave, samplePen.GetColour());
+}
+#endif
+
 void TrackArtist::DrawIndividualSamples(wxDC &dc, const wxRect &r,
                                         float zoomMin, float zoomMax, bool dB,
                                         WaveClip *clip,
@@ -1591,20 +1654,33 @@ void TrackArtist::DrawClipWaveform(WaveTrack *track,
    double *envValues = new double[mid.width];
    clip->GetEnvelope()->GetValues(envValues, mid.width, t0 + tOffset, tstep);
 
+   // When zoomed out, the background and the waveform are drawn into an
+   // image blitted at once.  Individual samples and the tiles of sync-lock
+   // selected tracks are still drawn on the dc.
+   WaveformRaster *raster = NULL;
+#ifdef EXPERIMENTAL_WAVEFORM_RASTER
+   if (!showIndividualSamples && mid.height > 0 &&
+       !(!track->GetSelected() && ssel0 < ssel1)) {
+      raster = new WaveformRaster(mid.width, mid.height);
+      SetRasterColors(*raster, muted);
+   }
+#endif
+
    // Draw the background of the track, outlining the shape of
    // the envelope and using a colored pen for the selected
    // part of the waveform
    DrawWaveformBackground(dc, mid, envValues, zoomMin, zoomMax, dB,
                           where, ssel0, ssel1, drawEnvelope,
-                          !track->GetSelected());
+                          !track->GetSelected(), raster);
 
    if (!showIndividualSamples) {
 #ifdef EXPERIMENTAL_OUTPUT_DISPLAY
       DrawMinMaxRMS(dc, mid, envValues, zoomMin, zoomMax, dB,
-                    min, max, rms, bl, isLoadingOD, muted, track->GetChannelGain(track->GetChannel()));
+                    min, max, rms, bl, isLoadingOD, muted, track->GetChannelGain(track->GetChannel()),
+                    raster);
 #else
       DrawMinMaxRMS(dc, mid, envValues, zoomMin, zoomMax, dB,
-                    min, max, rms, bl, isLoadingOD, muted);
+                    min, max, rms, bl, isLoadingOD, muted, raster);
 #endif
    }
    else {
@@ -1613,6 +1689,13 @@ void TrackArtist::DrawClipWaveform(WaveTrack *track,
                             drawSamples, showPoints, muted);
    }
 
+   if (raster) {
+      wxImage image(mid.width, mid.height);
+      raster->Render(image.GetData());
+      dc.DrawBitmap(wxBitmap(image), mid.x, mid.y, false);
+      delete raster;
+   }
+
    if (drawEnvelope) {
       DrawEnvelope(dc, mid, envValues, zoomMin, zoomMax, dB);
       clip->GetEnvelope()->DrawPoints(dc, r, h, pps, dB, zoomMin, zoomMax);
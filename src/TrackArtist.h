@@ -35,6 +35,7 @@ class LabelTrack;
 class TimeTrack;
 class TrackList;
 class Ruler;
+class WaveformRaster;
 struct ViewInfo;
 
 #ifndef uchar
@@ -147,21 +148,29 @@ class AUDACITY_DLL_API TrackArtist {
 
    // Waveform utility functions
 
+   // When raster is given, these put their columns there instead of
+   // drawing them on dc
    void DrawWaveformBackground(wxDC & dc, const wxRect &r, const double env[],
                                float zoomMin, float zoomMax, bool dB,
                                const sampleCount where[],
                                sampleCount ssel0, sampleCount ssel1,
-                               bool drawEnvelope, bool bIsSyncLockSelected);
+                               bool drawEnvelope, bool bIsSyncLockSelected,
+                               WaveformRaster *raster);
 #ifdef EXPERIMENTAL_OUTPUT_DISPLAY
    void DrawMinMaxRMS(wxDC & dc, const wxRect & r, const double env[],
                       float zoomMin, float zoomMax, bool dB,
                       const float min[], const float max[], const float rms[],
-                      const int bl[], bool showProgress, bool muted, const float gain);
+                      const int bl[], bool showProgress, bool muted, const float gain,
+                      WaveformRaster *raster);
 #else
    void DrawMinMaxRMS(wxDC & dc, const wxRect & r, const double env[],
                       float zoomMin, float zoomMax, bool dB,
                       const float min[], const float max[], const float rms[],
-                      const int bl[], bool showProgress, bool muted);
+                      const int bl[], bool showProgress, bool muted,
+                      WaveformRaster *raster);
+#endif
+#ifdef EXPERIMENTAL_WAVEFORM_RASTER
+   void SetRasterColors(WaveformRaster &raster, bool muted);
 #endif
    void DrawIndividualSamples(wxDC & dc, const wxRect & r,
                               float zoomMin, float zoomMax, bool dB,
@@ -209,6 +209,7 @@ is time to refresh some aspect of the screen.
 #include "Track.h"
 #include "TrackArtist.h"
 #include "TrackPanelAx.h"
+#include "Tracer.h"
 #include "ViewInfo.h"
 #include "WaveTrack.h"
 
@@ -1385,6 +1386,8 @@ void TrackPanel::OnErase(wxEraseEvent & /* event */)
 ///  completing a repaint operation.
 void TrackPanel::OnPaint(wxPaintEvent & /* event */)
 {
+   TRACE_SCOPE("TrackPanel::OnPaint");
+
 #if DEBUG_DRAW_TIMING
    wxStopWatch sw;
 #endif
@@ -6825,6 +6828,8 @@ void TrackPanel::Refresh(bool eraseBackground /* = TRUE */,
 /// actual contents of each track are drawn by the TrackArtist.
 void TrackPanel::DrawTracks(wxDC * dc)
 {
+   TRACE_SCOPE("TrackPanel::DrawTracks");
+
    wxRegion region = GetUpdateRegion();
 
    wxRect clip = GetRect();
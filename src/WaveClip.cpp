@@ -355,7 +355,7 @@ WaveClip::~WaveClip()
    delete mSpecPxCache;
 #ifdef EXPERIMENTAL_USE_REALFFTF
    if(hFFT != NULL)
-      EndFFT(hFFT);
+      ReleaseFFT(hFFT);
    if(mWindow != NULL)
       delete[] mWindow;
 #endif
@@ -746,8 +746,8 @@ bool WaveClip::GetSpectrogram(float *freq, sampleCount *where,
       mWindowType = windowType;
       mWindowSize = windowSize;
       if(hFFT != NULL)
-         EndFFT(hFFT);
-      hFFT = InitializeFFT(mWindowSize);
+         ReleaseFFT(hFFT);
+      hFFT = GetFFT(mWindowSize);
       if(mWindow != NULL) delete[] mWindow;
       // Create the requested window function
       mWindow = new float[mWindowSize];
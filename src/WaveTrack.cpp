@@ -763,6 +763,15 @@ void WaveTrack::AddClip(WaveClip* clip)
       mClips.Append(clip);
 }
 
+WaveClip* WaveTrack::ReplaceClip(int index, WaveClip* clip)
+{
+   WaveClipList::compatibility_iterator node = mClips.Item(index);
+   WaveClip *old = node->GetData();
+   mClips.Insert(node, clip);
+   mClips.DeleteNode(node);
+   return old;
+}
+
 bool WaveTrack::HandleClear(double t0, double t1,
                             bool addCutLines, bool split)
 {
@@ -1534,6 +1543,18 @@ XMLTagHandler *WaveTrack::HandleXMLChild(const wxChar *tag)
 void WaveTrack::WriteXML(XMLWriter &xmlFile)
 {
    xmlFile.StartTag(wxT("wavetrack"));
+   WriteXMLAttrs(xmlFile);
+
+   for (WaveClipList::compatibility_iterator it=GetClipIterator(); it; it=it->GetNext())
+   {
+      it->GetData()->WriteXML(xmlFile);
+   }
+
+   xmlFile.EndTag(wxT("wavetrack"));
+}
+
+void WaveTrack::WriteXMLAttrs(XMLWriter &xmlFile)
+{
    xmlFile.WriteAttr(wxT("name"), mName);
    xmlFile.WriteAttr(wxT("channel"), mChannel);
    xmlFile.WriteAttr(wxT("linked"), mLinked);
@@ -1554,13 +1575,6 @@ void WaveTrack::WriteXML(XMLWriter &xmlFile)
    xmlFile.WriteAttr(wxT("rate"), mRate);
    xmlFile.WriteAttr(wxT("gain"), (double)mGain);
    xmlFile.WriteAttr(wxT("pan"), (double)mPan);
-
-   for (WaveClipList::compatibility_iterator it=GetClipIterator(); it; it=it->GetNext())
-   {
-      it->GetData()->WriteXML(xmlFile);
-   }
-
-   xmlFile.EndTag(wxT("wavetrack"));
 }
 
 bool WaveTrack::GetErrorOpening()
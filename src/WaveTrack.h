@@ -270,6 +270,8 @@ class AUDACITY_DLL_API WaveTrack: public Track {
    virtual void HandleXMLEndTag(const wxChar *tag);
    virtual XMLTagHandler *HandleXMLChild(const wxChar *tag);
    virtual void WriteXML(XMLWriter &xmlFile);
+   // The attributes of the <wavetrack> tag, without the clips
+   void WriteXMLAttrs(XMLWriter &xmlFile);
 
    // Returns true if an error occurred while reading from XML
    virtual bool GetErrorOpening();
@@ -365,6 +367,10 @@ class AUDACITY_DLL_API WaveTrack: public Track {
    // Append a clip to the track
    void AddClip(WaveClip* clip);
 
+   // Put a clip in place of the one at the given index, and return that
+   // one, which the caller deletes
+   WaveClip* ReplaceClip(int index, WaveClip* clip);
+
    // Merge two clips, that is append data from clip2 to clip1,
    // then remove clip2 from track.
    // clipidx1 and clipidx2 are indices into the clip list.
@@ -0,0 +1,151 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  WaveformRaster.cpp
+
+*******************************************************************//**
+
+\class WaveformRaster
+\brief Draws the background and the min/max/rms columns of a waveform
+into an RGB buffer, for a clip to be blitted at once.
+
+*//*******************************************************************/
+
+#include <stddef.h>
+
+#include "WaveformRaster.h"
+
+// The stripes of a column still loading repeat every kStripePeriod rows,
+// shifted down one row a column, and are kStripeLength rows long
+static const int kStripePeriod = 25;
+static const int kStripeLength = 7;
+
+WaveformRaster::WaveformRaster(int width, int height)
+:  mWidth(width),
+   mHeight(height),
+   mBackTop1(width, 0),
+   mBackBottom1(width, -1),
+   mBackTop2(width, 0),
+   mBackBottom2(width, -1),
+   mBackColor(width, Blank),
+   mWaveTop(width, 0),
+   mWaveBottom(width, -1),
+   mRmsTop(width, 0),
+   mRmsBottom(width, -1),
+   mClipped(width, 0),
+   mZeroLine(-1)
+{
+   for (int i = 0; i < NumColors; i++)
+      mPalette[i][0] = mPalette[i][1] = mPalette[i][2] = 0;
+}
+
+void WaveformRaster::SetColor(Color color, unsigned char red,
+                              unsigned char green, unsigned char blue)
+{
+   mPalette[color][0] = red;
+   mPalette[color][1] = green;
+   mPalette[color][2] = blue;
+}
+
+void WaveformRaster::SetBackground(int x, int top1, int bottom1,
+                                   int top2, int bottom2, bool selected)
+{
+   mBackTop1[x] = top1;
+   mBackBottom1[x] = bottom1;
+   mBackTop2[x] = top2;
+   mBackBottom2[x] = bottom2;
+   mBackColor[x] = selected ? Selected : Unselected;
+}
+
+void WaveformRaster::SetWave(int x, int top, int bottom)
+{
+   mWaveTop[x] = top;
+   mWaveBottom[x] = bottom;
+}
+
+void WaveformRaster::SetRms(int x, int top, int bottom)
+{
+   mRmsTop[x] = top;
+   mRmsBottom[x] = bottom;
+}
+
+void WaveformRaster::SetClipped(int x)
+{
+   mClipped[x] = 1;
+}
+
+void WaveformRaster::SetLoading(int x, int bl, int dotY)
+{
+   mLoadingX.push_back(x);
+   mLoadingColor.push_back((bl % 2) ? LoadingOdd : LoadingEven);
+   mLoadingDotY.push_back(dotY);
+}
+
+void WaveformRaster::SetZeroLine(int y)
+{
+   mZeroLine = y;
+}
+
+void WaveformRaster::Render(unsigned char *rgb) const
+{
+   if (mWidth <= 0 || mHeight <= 0)
+      return;
+
+   std::vector<unsigned char> row(mWidth);
+   unsigned char *colors = &row[0];
+
+   const int *backTop1 = &mBackTop1[0];
+   const int *backBottom1 = &mBackBottom1[0];
+   const int *backTop2 = &mBackTop2[0];
+   const int *backBottom2 = &mBackBottom2[0];
+   const unsigned char *backColor = &mBackColor[0];
+   const int *waveTop = &mWaveTop[0];
+   const int *waveBottom = &mWaveBottom[0];
+   const int *rmsTop = &mRmsTop[0];
+   const int *rmsBottom = &mRmsBottom[0];
+   const unsigned char *clipped = &mClipped[0];
+
+   for (int y = 0; y < mHeight; y++) {
+      const int zeroLine = (y == mZeroLine);
+
+      // Later colors are drawn over earlier ones.  Everything is read
+      // and picked with selects, so that there are no branches.
+      for (int x = 0; x < mWidth; x++) {
+         int inBack = ((y >= backTop1[x]) & (y <= backBottom1[x])) |
+                      ((y >= backTop2[x]) & (y <= backBottom2[x]));
+         int inWave = (y >= waveTop[x]) & (y <= waveBottom[x]);
+         int inRms = (y >= rmsTop[x]) & (y <= rmsBottom[x]);
+         int back = backColor[x];
+
+         int c = Blank;
+         c = inBack ? back : c;
+         c = zeroLine ? (int)ZeroLine : c;
+         c = inWave ? (int)Sample : c;
+         c = inRms ? (int)Rms : c;
+         c = clipped[x] ? (int)Clipped : c;
+         colors[x] = (unsigned char)c;
+      }
+
+      // Few columns are ever loading, so they are done one at a time
+      for (size_t i = 0; i < mLoadingX.size(); i++) {
+         int x = mLoadingX[i];
+         if (clipped[x])
+            continue;
+         int stripeY = y - x % kStripePeriod;
+         if (stripeY >= 0 && stripeY % kStripePeriod < kStripeLength)
+            colors[x] = mLoadingColor[i];
+         if (y == mLoadingDotY[i])
+            colors[x] = LoadingWave;
+      }
+
+      unsigned char *out = rgb + (size_t)y * mWidth * 3;
+      for (int x = 0; x < mWidth; x++) {
+         const unsigned char *color = mPalette[colors[x]];
+         out[0] = color[0];
+         out[1] = color[1];
+         out[2] = color[2];
+         out += 3;
+      }
+   }
+}
@@ -0,0 +1,110 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  WaveformRaster.h
+
+*******************************************************************//**
+
+\class WaveformRaster
+\brief Draws the background and the min/max/rms columns of a waveform
+into an RGB buffer, for a clip to be blitted at once.
+
+  TrackArtist used to draw each pixel column of a waveform with its own
+  rectangles and lines on the wxDC.  Now it gives the rows each column
+  covers here, for the background, the min to max line, the rms line and
+  the clipping line, and Render() writes the whole clip as an RGB image,
+  in the layout of wxImage::GetData().
+
+  Render() goes row by row, picking the color of each pixel of the row
+  from the spans of its column.  The inner loop has no branches or calls,
+  so the compiler can do it several columns at a time.
+
+  It knows nothing of wx, so the tests can render and compare buffers
+  without a display.
+
+*//*******************************************************************/
+
+#ifndef __AUDACITY_WAVEFORM_RASTER__
+#define __AUDACITY_WAVEFORM_RASTER__
+
+#include <vector>
+
+class WaveformRaster
+{
+ public:
+   /// The colors of the palette, in the order they are drawn over each
+   /// other
+   enum Color {
+      Blank,
+      Unselected,
+      Selected,
+      ZeroLine,
+      Sample,
+      Rms,
+      Clipped,
+      LoadingEven,   // stripes of a column still loading on demand
+      LoadingOdd,
+      LoadingWave,   // the dummy wave drawn over them
+      NumColors
+   };
+
+   WaveformRaster(int width, int height);
+
+   int GetWidth() const { return mWidth; }
+   int GetHeight() const { return mHeight; }
+
+   void SetColor(Color color, unsigned char red, unsigned char green,
+                 unsigned char blue);
+
+   //
+   // Spans are of rows of column x, from top to bottom, both included;
+   // an empty span has bottom < top.  Rows outside of the raster are
+   // ignored.
+   //
+
+   /// The background of column x, in two spans when the envelope leaves
+   /// a gap in the middle
+   void SetBackground(int x, int top1, int bottom1, int top2, int bottom2,
+                      bool selected);
+   /// The line from min to max
+   void SetWave(int x, int top, int bottom);
+   void SetRms(int x, int top, int bottom);
+   /// A line the full height of column x
+   void SetClipped(int x);
+   /// Column x is still loading: stripes of the color of bl instead of
+   /// the wave, with a dot of a dummy wave at row dotY
+   void SetLoading(int x, int bl, int dotY);
+   /// A line the full width at row y
+   void SetZeroLine(int y);
+
+   /// Writes the raster to rgb, three bytes a pixel, row by row
+   void Render(unsigned char *rgb) const;
+
+ private:
+   int mWidth;
+   int mHeight;
+   unsigned char mPalette[NumColors][3];
+
+   // One of each for each column
+   std::vector<int> mBackTop1;
+   std::vector<int> mBackBottom1;
+   std::vector<int> mBackTop2;
+   std::vector<int> mBackBottom2;
+   std::vector<unsigned char> mBackColor;
+   std::vector<int> mWaveTop;
+   std::vector<int> mWaveBottom;
+   std::vector<int> mRmsTop;
+   std::vector<int> mRmsBottom;
+   std::vector<unsigned char> mClipped;
+
+   // The columns still loading, with the color of their stripes and the
+   // row of their dots
+   std::vector<int> mLoadingX;
+   std::vector<unsigned char> mLoadingColor;
+   std::vector<int> mLoadingDotY;
+
+   int mZeroLine;  // -1 for none
+};
+
+#endif
@@ -28,6 +28,8 @@ The summary is eventually computed and written to a file in a background thread.
 
 #include "../AudacityApp.h"
 #include "PCMAliasBlockFile.h"
+#include "SndFileReaderPool.h"
+#include "../Tracer.h"
 #include "../FileFormats.h"
 #include "../Internat.h"
 
@@ -595,6 +597,7 @@ void *ODPCMAliasBlockFile::CalcSummary(samplePtr buffer, sampleCount len,
 int ODPCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
                                 sampleCount start, sampleCount len)
 {
+   TRACE_SCOPE("ODPCMAliasBlockFile::ReadData");
 
    LockRead();
 
@@ -610,10 +613,17 @@ int ODPCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
    memset(&info, 0, sizeof(info));
 
    wxString aliasPath = mAliasedFileName.GetFullPath();
-   //there are thread-unsafe crashes here - not sure why.  sf_open may be called on the same file
-   //from different threads, but this seems okay, unless it is implemented strangely..
-   static ODLock sfMutex;
 
+#ifdef EXPERIMENTAL_POOLED_ALIAS_READERS
+   // A handle of the file for this read alone, likely left open by the
+   // read of the block before
+   SndFileReader *reader = SndFileReaderPool::Get().Acquire(aliasPath);
+   SNDFILE *sf = NULL;
+   if (reader) {
+      sf = reader->sf;
+      info = reader->info;
+   }
+#else
    wxFile f;   // will be closed when it goes out of scope
    SNDFILE *sf = NULL;
 
@@ -625,6 +635,7 @@ int ODPCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
       sf = sf_open_fd(f.fd(), SFM_READ, &info, FALSE);
       ODManager::UnlockLibSndFileMutex();
    }
+#endif
 
    if (!sf){
 
@@ -641,9 +652,9 @@ int ODPCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
 
    mSilentAliasLog=FALSE;
 
-   ODManager::LockLibSndFileMutex();
+   LockSndFile();
    sf_seek(sf, mAliasStart + start, SEEK_SET);
-   ODManager::UnlockLibSndFileMutex();
+   UnlockSndFile();
 
    samplePtr buffer = NewSamples(len * info.channels, floatSample);
 
@@ -655,9 +666,9 @@ int ODPCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
       // and the calling method wants 16-bit data, go ahead and
       // read 16-bit data directly.  This is a pretty common
       // case, as most audio files are 16-bit.
-      ODManager::LockLibSndFileMutex();
+      LockSndFile();
       framesRead = sf_readf_short(sf, (short *)buffer, len);
-      ODManager::UnlockLibSndFileMutex();
+      UnlockSndFile();
 
       for (int i = 0; i < framesRead; i++)
          ((short *)data)[i] =
@@ -667,9 +678,9 @@ int ODPCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
       // Otherwise, let libsndfile handle the conversion and
       // scaling, and pass us normalized data as floats.  We can
       // then convert to whatever format we want.
-      ODManager::LockLibSndFileMutex();
+      LockSndFile();
       framesRead = sf_readf_float(sf, (float *)buffer, len);
-      ODManager::UnlockLibSndFileMutex();
+      UnlockSndFile();
       float *bufferPtr = &((float *)buffer)[mAliasChannel];
       CopySamples((samplePtr)bufferPtr, floatSample,
                   (samplePtr)data, format,
@@ -678,9 +689,13 @@ int ODPCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
 
    DeleteSamples(buffer);
 
+#ifdef EXPERIMENTAL_POOLED_ALIAS_READERS
+   SndFileReaderPool::Get().Release(reader);
+#else
    ODManager::LockLibSndFileMutex();
    sf_close(sf);
    ODManager::UnlockLibSndFileMutex();
+#endif
 
    UnlockRead();
    return framesRead;
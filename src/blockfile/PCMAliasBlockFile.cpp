@@ -16,8 +16,11 @@
 #include <sndfile.h>
 
 #include "PCMAliasBlockFile.h"
+#include "SndFileReaderPool.h"
+#include "../Tracer.h"
 #include "../FileFormats.h"
 #include "../Internat.h"
+#include "../Experimental.h"
 
 #include "../ondemand/ODManager.h"
 #include "../AudioIO.h"
@@ -73,6 +76,8 @@ PCMAliasBlockFile::~PCMAliasBlockFile()
 int PCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
                                 sampleCount start, sampleCount len)
 {
+   TRACE_SCOPE("PCMAliasBlockFile::ReadData");
+
    SF_INFO info;
 
    if(!mAliasedFileName.IsOk()){ // intentionally silenced
@@ -85,6 +90,17 @@ int PCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
 
    memset(&info, 0, sizeof(info));
 
+#ifdef EXPERIMENTAL_POOLED_ALIAS_READERS
+   // A handle of the file for this read alone, likely left open by the
+   // read of the block before
+   SndFileReader *reader =
+      SndFileReaderPool::Get().Acquire(mAliasedFileName.GetFullPath());
+   SNDFILE *sf = NULL;
+   if (reader) {
+      sf = reader->sf;
+      info = reader->info;
+   }
+#else
    wxFile f;   // will be closed when it goes out of scope
    SNDFILE *sf = NULL;
 
@@ -98,6 +114,7 @@ int PCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
          ODManager::UnlockLibSndFileMutex();
       }
    }
+#endif
 
    if (!sf){
       memset(data,0,SAMPLE_SIZE(format)*len);
@@ -113,9 +130,9 @@ int PCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
    if(silence) delete silence;
    mSilentAliasLog=FALSE;
 
-   ODManager::LockLibSndFileMutex();
+   LockSndFile();
    sf_seek(sf, mAliasStart + start, SEEK_SET);
-   ODManager::UnlockLibSndFileMutex();
+   UnlockSndFile();
    samplePtr buffer = NewSamples(len * info.channels, floatSample);
 
    int framesRead = 0;
@@ -126,9 +143,9 @@ int PCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
       // and the calling method wants 16-bit data, go ahead and
       // read 16-bit data directly.  This is a pretty common
       // case, as most audio files are 16-bit.
-      ODManager::LockLibSndFileMutex();
+      LockSndFile();
       framesRead = sf_readf_short(sf, (short *)buffer, len);
-      ODManager::UnlockLibSndFileMutex();
+      UnlockSndFile();
       for (int i = 0; i < framesRead; i++)
          ((short *)data)[i] =
             ((short *)buffer)[(info.channels * i) + mAliasChannel];
@@ -137,9 +154,9 @@ int PCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
       // Otherwise, let libsndfile handle the conversion and
       // scaling, and pass us normalized data as floats.  We can
       // then convert to whatever format we want.
-      ODManager::LockLibSndFileMutex();
+      LockSndFile();
       framesRead = sf_readf_float(sf, (float *)buffer, len);
-      ODManager::UnlockLibSndFileMutex();
+      UnlockSndFile();
       float *bufferPtr = &((float *)buffer)[mAliasChannel];
       CopySamples((samplePtr)bufferPtr, floatSample,
                   (samplePtr)data, format,
@@ -147,12 +164,30 @@ int PCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
    }
 
    DeleteSamples(buffer);
+#ifdef EXPERIMENTAL_POOLED_ALIAS_READERS
+   SndFileReaderPool::Get().Release(reader);
+#else
    ODManager::LockLibSndFileMutex();
    sf_close(sf);
    ODManager::UnlockLibSndFileMutex();
+#endif
    return framesRead;
 }
 
+void PCMAliasBlockFile::LockSndFile()
+{
+#ifndef EXPERIMENTAL_POOLED_ALIAS_READERS
+   ODManager::LockLibSndFileMutex();
+#endif
+}
+
+void PCMAliasBlockFile::UnlockSndFile()
+{
+#ifndef EXPERIMENTAL_POOLED_ALIAS_READERS
+   ODManager::UnlockLibSndFileMutex();
+#endif
+}
+
 /// Construct a new PCMAliasBlockFile based on this one, but writing
 /// the summary data to a new file.
 ///
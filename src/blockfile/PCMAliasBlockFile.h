@@ -45,6 +45,12 @@ class PCMAliasBlockFile : public AliasBlockFile
    virtual void Recover();
 
    static BlockFile *BuildFromXML(DirManager &dm, const wxChar **attrs);
+
+ protected:
+   /// Around the libsndfile calls of ReadData(): the global libsndfile
+   /// mutex, or nothing when each read has a handle of its own
+   static void LockSndFile();
+   static void UnlockSndFile();
 };
 
 #endif
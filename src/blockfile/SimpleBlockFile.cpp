@@ -70,6 +70,7 @@ to get its definition, rather than rolling our own.
 
 #include "sndfile.h"
 #include "../Internat.h"
+#include "../Tracer.h"
 
 
 static wxUint32 SwapUintEndianess(wxUint32 in)
@@ -102,6 +103,8 @@ SimpleBlockFile::SimpleBlockFile(wxFileName baseFileName,
    BlockFile(wxFileName(baseFileName.GetFullPath() + wxT(".au")), sampleLen)
 {
    mCache.active = false;
+   mHasContentHash = false;
+   mContentHash = 0;
 
    bool useCache = GetCache() && (!bypassCache);
 
@@ -140,6 +143,8 @@ SimpleBlockFile::SimpleBlockFile(wxFileName existingFile, sampleCount len,
    mRMS = rms;
 
    mCache.active = false;
+   mHasContentHash = false;
+   mContentHash = 0;
 }
 
 SimpleBlockFile::~SimpleBlockFile()
@@ -157,6 +162,8 @@ bool SimpleBlockFile::WriteSimpleBlockFile(
     sampleFormat format,
     void* summaryData)
 {
+   TRACE_SCOPE("SimpleBlockFile::Write");
+
    wxFFile file(mFileName.GetFullPath(), wxT("wb"));
    if( !file.IsOpened() ){
       // Can't do anything else.
@@ -379,6 +386,8 @@ bool SimpleBlockFile::ReadSummary(void *data)
 int SimpleBlockFile::ReadData(samplePtr data, sampleFormat format,
                         sampleCount start, sampleCount len)
 {
+   TRACE_SCOPE("SimpleBlockFile::ReadData");
+
    if (mCache.active)
    {
       //wxLogDebug("SimpleBlockFile::ReadData(): Data are already in cache.");
@@ -610,3 +619,44 @@ bool SimpleBlockFile::GetCache()
    return false;
 #endif
 }
+
+// 64-bit FNV-1a, taking the samples eight bytes at a time.  Blocks with
+// the same hash are still compared sample by sample before they share a
+// file, so it only has to be quick and spread the blocks out.
+wxUint64 SimpleBlockFile::CalcContentHash(samplePtr sampleData,
+                                          sampleCount sampleLen,
+                                          sampleFormat format)
+{
+   const wxUint64 prime = wxULL(1099511628211);
+   wxUint64 hash = wxULL(14695981039346656037);
+
+   hash = (hash ^ (wxUint64)format) * prime;
+   hash = (hash ^ (wxUint64)sampleLen) * prime;
+
+   size_t bytes = sampleLen * SAMPLE_SIZE(format);
+   size_t i = 0;
+   for (; i + sizeof(wxUint64) <= bytes; i += sizeof(wxUint64)) {
+      wxUint64 word;
+      memcpy(&word, sampleData + i, sizeof(word));
+      hash = (hash ^ word) * prime;
+   }
+   for (; i < bytes; i++)
+      hash = (hash ^ (unsigned char)sampleData[i]) * prime;
+
+   return hash;
+}
+
+bool SimpleBlockFile::GetContentHash(wxUint64 *hash) const
+{
+   if (!mHasContentHash)
+      return false;
+
+   *hash = mContentHash;
+   return true;
+}
+
+void SimpleBlockFile::SetContentHash(wxUint64 hash)
+{
+   mHasContentHash = true;
+   mContentHash = hash;
+}
@@ -83,6 +83,15 @@ class SimpleBlockFile : public BlockFile {
    virtual bool GetNeedFillCache() { return !mCache.active; }
    virtual void FillCache();
 
+   /// A hash of the samples, with their format and length, for finding
+   /// blocks with the same samples
+   static wxUint64 CalcContentHash(samplePtr sampleData, sampleCount sampleLen,
+                                   sampleFormat format);
+
+   /// The hash the block was made with, if it was given one
+   bool GetContentHash(wxUint64 *hash) const;
+   void SetContentHash(wxUint64 hash);
+
  protected:
 
    bool WriteSimpleBlockFile(samplePtr sampleData, sampleCount sampleLen,
@@ -91,6 +100,9 @@ class SimpleBlockFile : public BlockFile {
    void ReadIntoCache();
 
    SimpleBlockFileCache mCache;
+
+   bool mHasContentHash;
+   wxUint64 mContentHash;
 };
 
 #endif
@@ -0,0 +1,212 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SndFileReaderPool.cpp
+
+*******************************************************************//**
+
+\class SndFileReaderPool
+\brief Open libsndfile handles of aliased files, kept for the next read
+of the same file.
+
+*//*******************************************************************/
+
+#include "../Audacity.h"
+
+#include <string.h>
+
+#include <wx/filefn.h>
+#include <wx/log.h>
+#include <wx/stopwatch.h>
+
+#include "SndFileReaderPool.h"
+
+// Handles idle for longer than this are closed
+static const long kMaxIdleMs = 3000;
+// Most handles kept idle, over all files
+static const size_t kMaxIdle = 32;
+
+SndFileReader::SndFileReader()
+:  sf(NULL),
+   mSize(0),
+   mTime(0)
+{
+   memset(&info, 0, sizeof(info));
+}
+
+SndFileReader::~SndFileReader()
+{
+   if (sf)
+      sf_close(sf);
+   // mFile closes itself
+}
+
+bool SndFileReader::Open(const wxString &path, wxInt64 size, wxInt64 time)
+{
+   mPath = path;
+   mSize = size;
+   mTime = time;
+
+   if (!mFile.Open(path))
+      return false;
+
+   // Even though there is an sf_open() that takes a filename, use the one that
+   // takes a file descriptor since wxWidgets can open a file with a Unicode name and
+   // libsndfile can't (under Windows).
+   memset(&info, 0, sizeof(info));
+   sf = sf_open_fd(mFile.fd(), SFM_READ, &info, FALSE);
+
+   return sf != NULL;
+}
+
+SndFileReaderPool &SndFileReaderPool::Get()
+{
+   static SndFileReaderPool pool;
+   return pool;
+}
+
+SndFileReaderPool::SndFileReaderPool()
+:  mNumOpened(0),
+   mNumReused(0),
+   mNumContended(0)
+{
+}
+
+SndFileReaderPool::~SndFileReaderPool()
+{
+   CloseAll();
+}
+
+void SndFileReaderPool::Lock()
+{
+   if (mLock.TryLock() != wxMUTEX_NO_ERROR) {
+      mLock.Lock();
+      mNumContended++;
+   }
+}
+
+SndFileReader *SndFileReaderPool::Acquire(const wxString &path)
+{
+   // Stat the file on every read, so that a handle of a file that has
+   // been replaced or deleted since is not used
+   wxStructStat st;
+   if (!wxFileExists(path) || wxStat(path, &st) != 0)
+      return NULL;
+   wxInt64 size = st.st_size;
+   wxInt64 time = st.st_mtime;
+
+   SndFileReader *reader = NULL;
+   std::vector<SndFileReader *> expired;
+
+   Lock();
+   std::pair<ReaderMap::iterator, ReaderMap::iterator> range =
+      mIdle.equal_range(path);
+   for (ReaderMap::iterator it = range.first; it != range.second; ) {
+      SndFileReader *r = it->second;
+      mIdle.erase(it++);
+      if (r->mSize == size && r->mTime == time) {
+         reader = r;
+         break;
+      }
+      expired.push_back(r);
+   }
+   if (reader)
+      mNumReused++;
+   else
+      mNumOpened++;
+   mLock.Unlock();
+
+   for (size_t i = 0; i < expired.size(); i++)
+      delete expired[i];
+
+   if (reader)
+      return reader;
+
+   reader = new SndFileReader();
+   if (!reader->Open(path, size, time)) {
+      delete reader;
+      return NULL;
+   }
+
+   return reader;
+}
+
+void SndFileReaderPool::Release(SndFileReader *reader)
+{
+   std::vector<SndFileReader *> expired;
+
+   reader->mReleased = wxGetLocalTimeMillis();
+
+   Lock();
+   mIdle.insert(ReaderMap::value_type(reader->mPath, reader));
+   TakeExpired(expired);
+   mLock.Unlock();
+
+   for (size_t i = 0; i < expired.size(); i++)
+      delete expired[i];
+}
+
+void SndFileReaderPool::TakeExpired(std::vector<SndFileReader *> &expired)
+{
+   wxLongLong now = wxGetLocalTimeMillis();
+
+   ReaderMap::iterator oldest = mIdle.end();
+   for (ReaderMap::iterator it = mIdle.begin(); it != mIdle.end(); ) {
+      if (now - it->second->mReleased > kMaxIdleMs) {
+         expired.push_back(it->second);
+         mIdle.erase(it++);
+         continue;
+      }
+      if (oldest == mIdle.end() || it->second->mReleased < oldest->second->mReleased)
+         oldest = it;
+      ++it;
+   }
+
+   if (mIdle.size() > kMaxIdle && oldest != mIdle.end()) {
+      expired.push_back(oldest->second);
+      mIdle.erase(oldest);
+   }
+}
+
+void SndFileReaderPool::Close(const wxString &path)
+{
+   std::vector<SndFileReader *> expired;
+
+   Lock();
+   std::pair<ReaderMap::iterator, ReaderMap::iterator> range =
+      mIdle.equal_range(path);
+   for (ReaderMap::iterator it = range.first; it != range.second; ++it)
+      expired.push_back(it->second);
+   mIdle.erase(range.first, range.second);
+   mLock.Unlock();
+
+   for (size_t i = 0; i < expired.size(); i++)
+      delete expired[i];
+}
+
+void SndFileReaderPool::CloseAll()
+{
+   std::vector<SndFileReader *> expired;
+
+   Lock();
+   for (ReaderMap::iterator it = mIdle.begin(); it != mIdle.end(); ++it)
+      expired.push_back(it->second);
+   mIdle.clear();
+   mLock.Unlock();
+
+   for (size_t i = 0; i < expired.size(); i++)
+      delete expired[i];
+}
+
+void SndFileReaderPool::LogStats()
+{
+   Lock();
+   int opened = mNumOpened;
+   int reused = mNumReused;
+   int contended = mNumContended;
+   mLock.Unlock();
+
+   wxLogDebug(wxT("Alias reads: %d handles opened, %d reused, %d waits for the pool"),
+              opened, reused, contended);
+}
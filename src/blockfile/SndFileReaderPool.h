@@ -0,0 +1,101 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SndFileReaderPool.h
+
+*******************************************************************//**
+
+\class SndFileReaderPool
+\brief Open libsndfile handles of aliased files, kept for the next read
+of the same file.
+
+  Reading an alias block used to open the aliased file, parse its
+  header, seek, read and close it again, all under the global libsndfile
+  mutex of ODManager.  Now a reader takes a handle of the file from the
+  pool, or opens one, and uses it by itself with no lock held; libsndfile
+  is safe to use from several threads as long as each SNDFILE is used by
+  one thread at a time.  Only the pool's list of idle handles is locked,
+  and only while a handle is taken or given back.
+
+  A handle is dropped instead of reused when the file's size or time has
+  changed since it was opened, so a replaced file is read afresh, and a
+  deleted one is reported missing as before.  Idle handles are closed
+  after a few seconds, so that files aren't kept open (and, on Windows,
+  locked) for long after they were read.
+
+*//*******************************************************************/
+
+#ifndef __AUDACITY_SNDFILE_READER_POOL__
+#define __AUDACITY_SNDFILE_READER_POOL__
+
+#include <map>
+#include <vector>
+
+#include <wx/file.h>
+#include <wx/string.h>
+
+#include <sndfile.h>
+
+#include "../ondemand/ODTaskThread.h"
+
+class SndFileReader
+{
+ public:
+   SndFileReader();
+   ~SndFileReader();
+
+   bool Open(const wxString &path, wxInt64 size, wxInt64 time);
+
+   SNDFILE *sf;
+   SF_INFO info;
+
+ private:
+   friend class SndFileReaderPool;
+
+   wxFile mFile;
+   wxString mPath;
+   wxInt64 mSize;
+   wxInt64 mTime;
+   wxLongLong mReleased;   // ms, when it was last given back
+};
+
+class SndFileReaderPool
+{
+ public:
+   static SndFileReaderPool &Get();
+
+   /// Returns a handle of the file for the caller alone, or NULL if the
+   /// file is missing or can't be read by libsndfile.  Give it back with
+   /// Release().
+   SndFileReader *Acquire(const wxString &path);
+   void Release(SndFileReader *reader);
+
+   /// Closes the idle handles of one file, e.g. before it is renamed
+   void Close(const wxString &path);
+   void CloseAll();
+
+   /// Writes the number of handles opened and reused, and how often a
+   /// thread had to wait for the pool, to the debug log
+   void LogStats();
+
+ private:
+   SndFileReaderPool();
+   ~SndFileReaderPool();
+
+   void Lock();
+   // Takes the handles idle for too long, or over the limit, off the
+   // pool, to be closed outside the lock
+   void TakeExpired(std::vector<SndFileReader *> &expired);
+
+   typedef std::multimap<wxString, SndFileReader *> ReaderMap;
+   ReaderMap mIdle;
+
+   ODLock mLock;
+
+   int mNumOpened;
+   int mNumReused;
+   int mNumContended;
+};
+
+#endif
@@ -23,6 +23,7 @@
 #include "MessageCommand.h"
 #include "GetTrackInfoCommand.h"
 #include "GetProjectInfoCommand.h"
+#include "GetAudioStatsCommand.h"
 #include "HelpCommand.h"
 #include "SelectCommand.h"
 #include "CompareAudioCommand.h"
@@ -30,6 +31,7 @@
 #include "SetProjectInfoCommand.h"
 #include "PreferenceCommands.h"
 #include "ImportExportCommands.h"
+#include "SampleDataCommands.h"
 #include "OpenSaveCommands.h"
 
 CommandDirectory *CommandDirectory::mInstance = NULL;
@@ -48,6 +50,7 @@ CommandDirectory::CommandDirectory()
    AddCommand(new MessageCommandType());
    AddCommand(new GetTrackInfoCommandType());
    AddCommand(new GetProjectInfoCommandType());
+   AddCommand(new GetAudioStatsCommandType());
 
    AddCommand(new HelpCommandType());
    AddCommand(new SelectCommandType());
@@ -59,6 +62,8 @@ CommandDirectory::CommandDirectory()
    AddCommand(new GetPreferenceCommandType());
    AddCommand(new ImportCommandType());
    AddCommand(new ExportCommandType());
+   AddCommand(new GetSamplesCommandType());
+   AddCommand(new SetSamplesCommandType());
    AddCommand(new OpenProjectCommandType());
    AddCommand(new SaveProjectCommandType());
 }
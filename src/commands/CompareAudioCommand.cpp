@@ -18,7 +18,16 @@ threshold of difference in two selected tracks
 *//*******************************************************************/
 
 #include "CompareAudioCommand.h"
+
+#include <algorithm>
+#include <math.h>
+#include <vector>
+
+#include "../BlockFile.h"
 #include "../Project.h"
+#include "../Sequence.h"
+#include "../WaveClip.h"
+#include "../WaveTrack.h"
 #include "Command.h"
 
 wxString CompareAudioCommandType::BuildName()
@@ -71,14 +80,127 @@ bool CompareAudioCommand::GetSelection(AudacityProject &proj)
    return true;
 }
 
-double CompareAudioCommand::CompareSample(double value1, double value2)
+// A range of sample positions, [start, end)
+struct SampleRange
+{
+   sampleCount start;
+   sampleCount end;
+};
+
+static bool CompareRangeStarts(const SampleRange &a, const SampleRange &b)
+{
+   return a.start < b.start;
+}
+
+// Finds the ranges where both tracks hold the same block file at the same
+// position, as they do after duplicating, pasting or undoing.  Their samples
+// there are the same without reading them.
+static void FindSharedRanges(WaveTrack *track0, WaveTrack *track1,
+                             std::vector<SampleRange> &ranges)
+{
+   WaveClipList::compatibility_iterator it0, it1;
+   for (it0 = track0->GetClipIterator(); it0; it0 = it0->GetNext())
+   {
+      WaveClip *clip0 = it0->GetData();
+      for (it1 = track1->GetClipIterator(); it1; it1 = it1->GetNext())
+      {
+         WaveClip *clip1 = it1->GetData();
+         sampleCount clipStart = clip0->GetStartSample();
+         if (clip1->GetStartSample() != clipStart)
+            continue;
+
+         BlockArray *blocks0 = clip0->GetSequence()->GetBlockArray();
+         BlockArray *blocks1 = clip1->GetSequence()->GetBlockArray();
+         size_t i = 0, j = 0;
+         while (i < blocks0->GetCount() && j < blocks1->GetCount())
+         {
+            SeqBlock *b0 = blocks0->Item(i);
+            SeqBlock *b1 = blocks1->Item(j);
+            if (b0->start < b1->start)
+               i++;
+            else if (b1->start < b0->start)
+               j++;
+            else
+            {
+               if (b0->f == b1->f)
+               {
+                  SampleRange range;
+                  range.start = clipStart + b0->start;
+                  range.end = range.start + b0->f->GetLength();
+                  ranges.push_back(range);
+               }
+               i++;
+               j++;
+            }
+         }
+      }
+   }
+
+   std::sort(ranges.begin(), ranges.end(), CompareRangeStarts);
+}
+
+// Whether all samples of the track from start to start + len are zero, by
+// the summaries of its blocks.  A summary may cover more samples than asked
+// for, which can only make the answer false when it would be true.
+static bool IsSilent(WaveTrack *track, sampleCount start, sampleCount len)
 {
-   return fabs(value1 - value2);
+   WaveClipList::compatibility_iterator it;
+   for (it = track->GetClipIterator(); it; it = it->GetNext())
+   {
+      WaveClip *clip = it->GetData();
+      sampleCount s0 = std::max(start, clip->GetStartSample());
+      sampleCount s1 = std::min(start + len, clip->GetEndSample());
+      if (s0 >= s1)
+         continue;
+
+      float min, max;
+      if (!clip->GetSequence()->GetMinMax(s0 - clip->GetStartSample(), s1 - s0,
+                                          &min, &max) ||
+          min != 0.0 || max != 0.0)
+         return false;
+   }
+   // Gaps between clips read as zeros
+   return true;
 }
 
-inline int min(int a, int b)
+// Adds how many of the differences of two buffers exceed the threshold,
+// the largest difference, and the sum of their squares.  The loop has no
+// branches and keeps four independent sums, so that compilers can do it
+// in vector registers.
+static void CompareBuffers(const float *buff0, const float *buff1,
+                           sampleCount len, double threshold,
+                           long *count, double *maxDiff, double *sumSquares)
 {
-   return (a < b) ? a : b;
+   long counts[4] = { 0, 0, 0, 0 };
+   double maxes[4] = { 0, 0, 0, 0 };
+   double sums[4] = { 0, 0, 0, 0 };
+
+   sampleCount i = 0;
+   for (; i + 4 <= len; i += 4)
+   {
+      for (int k = 0; k < 4; k++)
+      {
+         double diff = fabs((double)buff0[i + k] - (double)buff1[i + k]);
+         counts[k] += (diff > threshold);
+         maxes[k] = (diff > maxes[k]) ? diff : maxes[k];
+         sums[k] += diff * diff;
+      }
+   }
+   for (; i < len; i++)
+   {
+      double diff = fabs((double)buff0[i] - (double)buff1[i]);
+      counts[0] += (diff > threshold);
+      maxes[0] = (diff > maxes[0]) ? diff : maxes[0];
+      sums[0] += diff * diff;
+   }
+
+   for (int k = 0; k < 4; k++)
+   {
+      *count += counts[k];
+      if (maxes[k] > *maxDiff)
+         *maxDiff = maxes[k];
+      *sumSquares += sums[k];
+   }
 }
 
 bool CompareAudioCommand::Apply(CommandExecutionContext context)
@@ -94,40 +216,60 @@ bool CompareAudioCommand::Apply(CommandExecutionContext context)
    Status(msg);
 
    long errorCount = 0;
+   double maxDiff = 0.0;
+   double sumSquares = 0.0;
    double errorThreshold = GetDouble(wxT("Threshold"));
 
    // Initialize buffers for track data to be analyzed
-   int buffSize = min(mTrack0->GetMaxBlockSize(), mTrack1->GetMaxBlockSize());
+   int buffSize = std::min(mTrack0->GetMaxBlockSize(), mTrack1->GetMaxBlockSize());
    float *buff0 = new float[buffSize];
    float *buff1 = new float[buffSize];
 
+   std::vector<SampleRange> shared;
+   FindSharedRanges(mTrack0, mTrack1, shared);
+   size_t nextShared = 0;
+   sampleCount sharedCount = 0;
+   sampleCount silentCount = 0;
+
    // Compare tracks block by block
-   long s0 = mTrack0->TimeToLongSamples(mT0);
-   long s1 = mTrack0->TimeToLongSamples(mT1);
-   long position = s0;
-   long length = s1 - s0;
+   sampleCount s0 = mTrack0->TimeToLongSamples(mT0);
+   sampleCount s1 = mTrack0->TimeToLongSamples(mT1);
+   sampleCount position = s0;
+   sampleCount length = s1 - s0;
    while (position < s1)
    {
-      // Get a block of data into the buffers
+      // Skip the samples that both tracks hold in the same block file
+      while (nextShared < shared.size() && shared[nextShared].end <= position)
+         nextShared++;
+      if (nextShared < shared.size() && shared[nextShared].start <= position)
+      {
+         sampleCount end = std::min(shared[nextShared].end, s1);
+         sharedCount += end - position;
+         position = end;
+         continue;
+      }
+
       sampleCount block = mTrack0->GetBestBlockSize(position);
       if (position + block > s1)
-      {
          block = s1 - position;
-      }
-      mTrack0->Get((samplePtr)buff0, floatSample, position, block);
-      mTrack1->Get((samplePtr)buff1, floatSample, position, block);
+      if (nextShared < shared.size() && shared[nextShared].start < position + block)
+         block = shared[nextShared].start - position;
+      if (block > buffSize)
+         block = buffSize;
 
-      int buffPos = 0;
-      for (buffPos = 0; buffPos < block; ++buffPos)
+      // Where both are silent, the differences are all zero
+      if (IsSilent(mTrack0, position, block) && IsSilent(mTrack1, position, block))
+         silentCount += block;
+      else
       {
-         if (CompareSample(buff0[buffPos], buff1[buffPos]) > errorThreshold)
-         {
-            ++errorCount;
-         }
+         mTrack0->Get((samplePtr)buff0, floatSample, position, block);
+         mTrack1->Get((samplePtr)buff1, floatSample, position, block);
+         CompareBuffers(buff0, buff1, block, errorThreshold,
+                        &errorCount, &maxDiff, &sumSquares);
       }
 
       position += block;
-      Progress((position - mT0) / length);
+      Progress((position - s0) / (double)length);
    }
 
    delete [] buff0;
@@ -135,8 +277,14 @@ bool CompareAudioCommand::Apply(CommandExecutionContext context)
 
    // Output the results
    double errorSeconds = mTrack0->LongSamplesToTime(errorCount);
+   double rmsDiff = length > 0 ? sqrt(sumSquares / length) : 0.0;
    Status(wxString::Format(wxT("%li"), errorCount));
    Status(wxString::Format(wxT("%.4f"), errorSeconds));
    Status(wxString::Format(wxT("Finished comparison: %li samples (%.3f seconds) exceeded the error threshold of %f."), errorCount, errorSeconds, errorThreshold));
+   Status(wxString::Format(wxT("%g"), maxDiff));
+   Status(wxString::Format(wxT("%g"), rmsDiff));
+   Status(wxString::Format(wxT("Largest difference %g, RMS difference %g; %lld samples were in shared blocks and %lld silent in both tracks."),
+                           maxDiff, rmsDiff,
+                           (long long)sharedCount, (long long)silentCount));
    return true;
 }
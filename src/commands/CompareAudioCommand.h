@@ -40,9 +40,6 @@ private:
    // Update member variables with project selection data (and validate)
    bool GetSelection(AudacityProject &proj);
 
-protected:
-   virtual double CompareSample(double value1, double value2);
-
 public:
    CompareAudioCommand(CommandType &type, CommandOutputTarget *target)
       : CommandImplementation(type, target)
@@ -0,0 +1,37 @@
+/**********************************************************************
+
+   Audacity - A Digital Audio Editor
+   Copyright 1999-2009 Audacity Team
+   File License: wxWidgets
+
+******************************************************************//**
+
+\file GetAudioStatsCommand.cpp
+\brief Contains definitions for GetAudioStatsCommand class.
+
+*//*******************************************************************/
+
+#include "GetAudioStatsCommand.h"
+#include "../AudioIO.h"
+
+wxString GetAudioStatsCommandType::BuildName()
+{
+   return wxT("GetAudioStats");
+}
+
+void GetAudioStatsCommandType::BuildSignature(CommandSignature & WXUNUSED(signature))
+{
+}
+
+Command *GetAudioStatsCommandType::Create(CommandOutputTarget *target)
+{
+   return new GetAudioStatsCommand(*this, target);
+}
+
+bool GetAudioStatsCommand::Apply(CommandExecutionContext WXUNUSED(context))
+{
+   wxArrayString lines = gAudioIO->GetStats().Format();
+   for (size_t i = 0; i < lines.GetCount(); i++)
+      Status(lines[i]);
+   return true;
+}
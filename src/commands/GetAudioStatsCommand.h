@@ -0,0 +1,42 @@
+/**********************************************************************
+
+   Audacity - A Digital Audio Editor
+   Copyright 1999-2009 Audacity Team
+   File License: wxWidgets
+
+******************************************************************//**
+
+\file GetAudioStatsCommand.h
+\brief Contains declaration of GetAudioStatsCommand class.
+
+\class GetAudioStatsCommand
+\brief Command which outputs the underruns, overruns and callback times
+of the audio stream now running or the last one, one per line on the
+status channel.
+
+*//*******************************************************************/
+
+#ifndef __GETAUDIOSTATSCOMMAND__
+#define __GETAUDIOSTATSCOMMAND__
+
+#include "Command.h"
+#include "CommandType.h"
+
+class GetAudioStatsCommandType : public CommandType
+{
+public:
+   virtual wxString BuildName();
+   virtual void BuildSignature(CommandSignature &signature);
+   virtual Command *Create(CommandOutputTarget *target);
+};
+
+class GetAudioStatsCommand : public CommandImplementation
+{
+public:
+   GetAudioStatsCommand(CommandType &type,
+                        CommandOutputTarget *target)
+      : CommandImplementation(type, target) {}
+   virtual bool Apply(CommandExecutionContext context);
+};
+
+#endif /* End of include guard: __GETAUDIOSTATSCOMMAND__ */
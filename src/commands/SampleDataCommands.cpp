@@ -0,0 +1,184 @@
+/**********************************************************************
+
+   Audacity - A Digital Audio Editor
+   Copyright 1999-2009 Audacity Team
+   File License: wxWidgets
+
+******************************************************************//**
+
+\file SampleDataCommands.cpp
+\brief Contains definitions for the GetSamplesCommand and
+SetSamplesCommand classes
+
+*//*******************************************************************/
+
+#include "SampleDataCommands.h"
+
+#include <algorithm>
+
+#include <wx/file.h>
+
+#include "../Project.h"
+#include "../Track.h"
+#include "../WaveTrack.h"
+
+// Samples copied at a time
+static const sampleCount kChunkLen = 1024 * 1024;
+
+static void AddSampleParameters(CommandSignature &signature)
+{
+   IntValidator *trackIndexValidator(new IntValidator());
+   signature.AddParameter(wxT("TrackIndex"), 0, trackIndexValidator);
+
+   IntValidator *startValidator(new IntValidator());
+   signature.AddParameter(wxT("Start"), 0, startValidator);
+
+   IntValidator *lengthValidator(new IntValidator());
+   signature.AddParameter(wxT("Length"), 0, lengthValidator);
+
+   Validator *filenameValidator(new Validator());
+   signature.AddParameter(wxT("Filename"), wxT(""), filenameValidator);
+}
+
+static WaveTrack *FindWaveTrack(AudacityProject *proj, long trackIndex)
+{
+   long i = 0;
+   TrackListIterator iter(proj->GetTracks());
+   Track *t = iter.First();
+   while (t && i != trackIndex)
+   {
+      t = iter.Next();
+      ++i;
+   }
+   if (!t || t->GetKind() != Track::Wave)
+      return NULL;
+   return (WaveTrack *)t;
+}
+
+// GetSamples
+
+wxString GetSamplesCommandType::BuildName()
+{
+   return wxT("GetSamples");
+}
+
+void GetSamplesCommandType::BuildSignature(CommandSignature &signature)
+{
+   AddSampleParameters(signature);
+}
+
+Command *GetSamplesCommandType::Create(CommandOutputTarget *target)
+{
+   return new GetSamplesCommand(*this, target);
+}
+
+bool GetSamplesCommand::Apply(CommandExecutionContext context)
+{
+   WaveTrack *track = FindWaveTrack(context.proj, GetLong(wxT("TrackIndex")));
+   if (!track)
+   {
+      Error(wxT("TrackIndex was invalid."));
+      return false;
+   }
+
+   sampleCount start = (sampleCount)GetDouble(wxT("Start"));
+   sampleCount len = (sampleCount)GetDouble(wxT("Length"));
+   if (start < 0 || len < 0)
+   {
+      Error(wxT("Start and Length must not be negative."));
+      return false;
+   }
+
+   wxFile file;
+   if (!file.Create(GetString(wxT("Filename")), true))
+   {
+      Error(wxT("Could not create the file."));
+      return false;
+   }
+
+   float *buffer = new float[(size_t)std::max((sampleCount)1, std::min(len, kChunkLen))];
+   bool result = true;
+   for (sampleCount done = 0; result && done < len; )
+   {
+      sampleCount chunkLen = std::min(len - done, kChunkLen);
+      size_t bytes = (size_t)chunkLen * sizeof(float);
+      result = track->Get((samplePtr)buffer, floatSample, start + done, chunkLen) &&
+               file.Write(buffer, bytes) == bytes;
+      done += chunkLen;
+   }
+   delete [] buffer;
+
+   if (!result)
+   {
+      Error(wxT("Could not write the samples."));
+      return false;
+   }
+   return true;
+}
+
+// SetSamples
+
+wxString SetSamplesCommandType::BuildName()
+{
+   return wxT("SetSamples");
+}
+
+void SetSamplesCommandType::BuildSignature(CommandSignature &signature)
+{
+   // A Length of zero takes all of the samples in the file
+   AddSampleParameters(signature);
+}
+
+Command *SetSamplesCommandType::Create(CommandOutputTarget *target)
+{
+   return new SetSamplesCommand(*this, target);
+}
+
+bool SetSamplesCommand::Apply(CommandExecutionContext context)
+{
+   WaveTrack *track = FindWaveTrack(context.proj, GetLong(wxT("TrackIndex")));
+   if (!track)
+   {
+      Error(wxT("TrackIndex was invalid."));
+      return false;
+   }
+
+   wxFile file;
+   if (!file.Open(GetString(wxT("Filename"))))
+   {
+      Error(wxT("Could not open the file."));
+      return false;
+   }
+
+   sampleCount start = (sampleCount)GetDouble(wxT("Start"));
+   sampleCount len = (sampleCount)GetDouble(wxT("Length"));
+   sampleCount inFile = (sampleCount)(file.Length() / sizeof(float));
+   if (len == 0)
+      len = inFile;
+   if (start < 0 || len < 0 || len > inFile)
+   {
+      Error(wxT("Start and Length must not be negative, nor Length more than the file holds."));
+      return false;
+   }
+
+   float *buffer = new float[(size_t)std::max((sampleCount)1, std::min(len, kChunkLen))];
+   bool result = true;
+   for (sampleCount done = 0; result && done < len; )
+   {
+      sampleCount chunkLen = std::min(len - done, kChunkLen);
+      size_t bytes = (size_t)chunkLen * sizeof(float);
+      result = file.Read(buffer, bytes) == (ssize_t)bytes &&
+               track->Set((samplePtr)buffer, floatSample, start + done, chunkLen);
+      done += chunkLen;
+   }
+   delete [] buffer;
+
+   if (!result)
+   {
+      Error(wxT("Could not set the samples."));
+      return false;
+   }
+
+   context.proj->PushState(_("Set samples by script"), _("Set Samples"));
+   return true;
+}
@@ -0,0 +1,75 @@
+/**********************************************************************
+
+   Audacity: A Digital Audio Editor
+   Audacity(R) is copyright (c) 1999-2009 Audacity Team.
+   File License: wxwidgets
+
+   SampleDataCommands.h
+
+******************************************************************//**
+
+\class GetSamplesCommand
+\brief Command for writing samples of a wave track to a file, as raw
+32-bit floats in the byte order of the machine
+
+\class SetSamplesCommand
+\brief Command for replacing samples of a wave track with those of a
+file of raw 32-bit floats
+
+  The samples pass through a file, not the pipe, so that a script can
+  move a lot of audio without a text encoding; a file on a memory file
+  system (such as /dev/shm) can be mapped by the script and shared.
+  Start and Length count samples from time zero of the track, as
+  WaveTrack::Get() and Set() do.
+
+*//*******************************************************************/
+
+#ifndef __SAMPLEDATACOMMANDS__
+#define __SAMPLEDATACOMMANDS__
+
+#include "Command.h"
+#include "CommandType.h"
+
+// GetSamples
+
+class GetSamplesCommandType : public CommandType
+{
+public:
+   virtual wxString BuildName();
+   virtual void BuildSignature(CommandSignature &signature);
+   virtual Command *Create(CommandOutputTarget *target);
+};
+
+class GetSamplesCommand : public CommandImplementation
+{
+public:
+   GetSamplesCommand(CommandType &type,
+                     CommandOutputTarget *target)
+      : CommandImplementation(type, target)
+   { }
+
+   virtual bool Apply(CommandExecutionContext context);
+};
+
+// SetSamples
+
+class SetSamplesCommandType : public CommandType
+{
+public:
+   virtual wxString BuildName();
+   virtual void BuildSignature(CommandSignature &signature);
+   virtual Command *Create(CommandOutputTarget *target);
+};
+
+class SetSamplesCommand : public CommandImplementation
+{
+public:
+   SetSamplesCommand(CommandType &type,
+                     CommandOutputTarget *target)
+      : CommandImplementation(type, target)
+   { }
+
+   virtual bool Apply(CommandExecutionContext context);
+};
+
+#endif /* End of include guard: __SAMPLEDATACOMMANDS__ */
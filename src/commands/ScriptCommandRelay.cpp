@@ -25,7 +25,9 @@ code out of ModuleManager.
 #include "AppCommandEvent.h"
 #include "ResponseQueue.h"
 #include "../Project.h"
+#include <vector>
 #include <wx/string.h>
+#include <wx/tokenzr.h>
 
 // Declare static class members
 CommandHandler *ScriptCommandRelay::sCmdHandler;
@@ -60,35 +62,72 @@ void ScriptCommandRelay::PostCommand(AudacityProject *project, Command *cmd)
    project->GetEventHandler()->AddPendingEvent(ev);
 }
 
-/// This is the function which actually obeys one command.  Rather than applying
-/// the command directly, an event containing a reference to the command is sent
+/// Gets the responses of one command, up to the empty line that ends them
+static wxString ReceiveResponses()
+{
+   wxString out;
+   wxString msg = ScriptCommandRelay::ReceiveResponse().GetMessage();
+   while (msg != wxT("\n"))
+   {
+      out += msg + wxT("\n");
+      msg = ScriptCommandRelay::ReceiveResponse().GetMessage();
+   }
+   return out;
+}
+
+/// This is the function which actually obeys commands.  Rather than applying
+/// a command directly, an event containing a reference to the command is sent
 /// to the main (GUI) thread. This is because having more than one thread access
 /// the GUI at a time causes problems with wxwidgets.
+///
+/// pIn may hold a batch of commands, one per line.  They are all sent to the
+/// main thread before any response is waited for, so that they run one after
+/// another without a round trip each.  The responses of each command are
+/// followed by an empty line, except those of the last.
 int ExecCommand(wxString *pIn, wxString *pOut)
 {
-   CommandBuilder builder(*pIn);
-   if (builder.WasValid())
+   wxArrayString lines = wxStringTokenize(*pIn, wxT("\n"), wxTOKEN_STRTOK);
+   if (lines.IsEmpty())
+      lines.Add(wxEmptyString);
+
+   // Build all of the commands first.  Those that fail put their responses
+   // in the queue at once, so take them before any command is sent.
+   wxArrayString outputs;
+   std::vector<Command *> commands;
+   for (size_t i = 0; i < lines.GetCount(); i++)
    {
-      AudacityProject *project = GetActiveProject();
-      project->SafeDisplayStatusMessage(wxT("Received script command"));
-      Command *cmd = builder.GetCommand();
-      ScriptCommandRelay::PostCommand(project, cmd);
+      CommandBuilder builder(lines[i]);
+      if (builder.WasValid())
+      {
+         commands.push_back(builder.GetCommand());
+         outputs.Add(wxEmptyString);
+      } else
+      {
+         commands.push_back(NULL);
+         wxString out = wxT("Syntax error!\n");
+         out += builder.GetErrorMessage() + wxT("\n");
+         builder.Cleanup();
+         outputs.Add(out + ReceiveResponses());
+      }
+   }
 
-      *pOut = wxEmptyString;
-   } else
+   AudacityProject *project = GetActiveProject();
+   project->SafeDisplayStatusMessage(wxT("Received script command"));
+   for (size_t i = 0; i < commands.size(); i++)
    {
-      *pOut = wxT("Syntax error!\n");
-      *pOut += builder.GetErrorMessage() + wxT("\n");
-      builder.Cleanup();
+      if (commands[i])
+         ScriptCommandRelay::PostCommand(project, commands[i]);
    }
 
-   // Wait until all responses from the command have been received.
-   // The last response is signalled by an empty line.
-   wxString msg = ScriptCommandRelay::ReceiveResponse().GetMessage();
-   while (msg != wxT("\n"))
+   // The main thread applies the commands in the order they were sent
+   *pOut = wxEmptyString;
+   for (size_t i = 0; i < commands.size(); i++)
    {
-      *pOut += msg + wxT("\n");
-      msg = ScriptCommandRelay::ReceiveResponse().GetMessage();
+      if (commands[i])
+         outputs[i] += ReceiveResponses();
+      if (i > 0)
+         *pOut += wxT("\n");
+      *pOut += outputs[i];
    }
 
    return 0;
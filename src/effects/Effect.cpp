@@ -30,20 +30,29 @@ greater use in future.
 #include <wx/timer.h>
 #include <wx/tglbtn.h>
 #include <wx/hashmap.h>
+#include <wx/log.h>
+#include <wx/stopwatch.h>
+#include <wx/thread.h>
 #include <wx/utils.h>
 
+#include <algorithm>
+
 #include "audacity/ConfigInterface.h"
 
 #include "Effect.h"
+#include "EffectManager.h"
 #include "../AudioIO.h"
 #include "../Mix.h"
 #include "../Prefs.h"
 #include "../Project.h"
+#include "../Tracer.h"
 #include "../WaveTrack.h"
 #include "../toolbars/ControlToolBar.h"
 #include "../widgets/AButton.h"
 #include "../widgets/ProgressDialog.h"
 #include "../ondemand/ODManager.h"
+#include "../ondemand/ODTaskThread.h"
+#include "EffectWorkQueue.h"
 #include "TimeWarper.h"
 
 #if defined(EXPERIMENTAL_REALTIME_EFFECTS) && defined(__WXMAC__)
@@ -706,7 +715,10 @@ bool Effect::DoEffect(wxWindow *parent, int flags,
       mProgress = new ProgressDialog(StripAmpersand(GetEffectName()),
                                      GetEffectAction(),
                                      pdlgHideStopButton);
-      returnVal = Process();
+      {
+         TRACE_SCOPE("Effect::Process");
+         returnVal = Process();
+      }
       delete mProgress;
       mProgress = NULL;
    }
@@ -776,6 +788,19 @@ bool Effect::Process()
    CopyInputTracks(Track::All);
    bool bGoodResult = true;
 
+#if defined(EXPERIMENTAL_PARALLEL_TRACK_EFFECTS)
+   if (!isGenerator && CanProcessTrackGroups())
+   {
+      bGoodResult = ProcessTrackGroups();
+      ReplaceProcessedTracks(bGoodResult);
+
+      return bGoodResult;
+   }
+#endif
+
+   wxStopWatch timer;
+   sampleCount processed = 0;
+
    mInBuffer = NULL;
    mOutBuffer = NULL;
 
@@ -932,9 +957,15 @@ bool Effect::Process()
          break;
       }
 
+      processed += right ? len * 2 : len;
       count++;
    }
 
+   if (bGoodResult && !isGenerator)
+   {
+      LogThroughput(processed, timer.Time(), 1);
+   }
+
    if (mOutBuffer)
    {
       for (int i = 0; i < mNumAudioOut; i++)
@@ -1334,6 +1365,593 @@ void Effect::GetSamples(WaveTrack *track, sampleCount *start, sampleCount *len)
    }
 }
 
+//
+// Processing in segments
+//
+
+// A piece of the selection in one track.  Reading starts at mStart, before
+// the output that is kept, from mKeepStart to mKeepEnd.
+struct EffectSegment
+{
+   EffectSegmentSelection *mSelection;
+   sampleCount mStart;
+   sampleCount mKeepStart;
+   sampleCount mKeepEnd;
+   sampleCount mEnd;       // where reading stops
+   bool mFinish;           // mEnd ends the selection
+
+   WaveTrack *mOutput;
+   sampleCount mDone;      // samples read so far
+   bool mResult;
+};
+
+typedef EffectWorkQueue<EffectSegment> EffectSegmentQueue;
+
+class EffectSegmentThread : public wxThread
+{
+public:
+   EffectSegmentThread():wxThread(wxTHREAD_JOINABLE)
+   {
+      mProcessor = NULL;
+      mQueue = NULL;
+   }
+
+   void SetData(EffectSegmentProcessor *processor, EffectSegmentQueue *queue)
+   {
+      mProcessor = processor;
+      mQueue = queue;
+   }
+
+   virtual void *Entry()
+   {
+      TRACE_THREAD_NAME("Effect segments");
+      EffectSegment *segment;
+      while ((segment = mQueue->Next()) != NULL) {
+         TRACE_SCOPE("Effect segment");
+         mQueue->Finish(segment, ProcessSegment(*segment));
+      }
+      return NULL;
+   }
+
+private:
+   bool ProcessSegment(EffectSegment & segment)
+   {
+      WaveTrack *track = segment.mSelection->mTrack;
+      sampleCount bufferSize = track->GetMaxBlockSize();
+      float *buffer = new float[bufferSize];
+
+      mProcessor->Reset();
+
+      bool bLoopSuccess = true;
+      sampleCount pos = segment.mStart;
+      while (pos < segment.mEnd) {
+         sampleCount block = std::min(segment.mEnd - pos, track->GetBestBlockSize(pos));
+         track->Get((samplePtr)buffer, floatSample, pos, block);
+         pos += block;
+
+         mProcessor->Process(buffer, block, segment.mOutput);
+
+         mQueue->SetDone(&segment, pos - segment.mStart);
+         if (mQueue->IsCancelled()) {
+            bLoopSuccess = false;
+            break;
+         }
+      }
+
+      if (bLoopSuccess && segment.mFinish)
+         mProcessor->Finish(segment.mOutput);
+      segment.mOutput->Flush();
+
+      delete [] buffer;
+      return bLoopSuccess;
+   }
+
+   EffectSegmentProcessor *mProcessor;
+   EffectSegmentQueue *mQueue;
+};
+
+bool Effect::ProcessSegments(EffectSegmentSelections & selections)
+{
+   size_t i;
+   sampleCount total = 0;
+   for (i = 0; i < selections.size(); i++) {
+      selections[i].mOutput = NULL;
+      total += selections[i].mLen;
+   }
+   if (total == 0)
+      return true;
+
+   EffectSegmentProcessor *first = CreateSegmentProcessor();
+   if (!first)
+      return false;
+
+   int numThreads = wxThread::GetCPUCount();
+   if (numThreads < 1)
+      numThreads = 1;
+
+   // About two segments per thread, so that they finish together, but
+   // long enough that little of the work is in warming up
+   const sampleCount alignment = first->GetAlignment();
+   sampleCount warmUp = first->GetWarmUp();
+   const sampleCount lookAhead = first->GetLookAhead();
+   sampleCount segmentLen = total;
+   if (warmUp >= 0) {
+      warmUp = (warmUp + alignment - 1) / alignment * alignment;
+      segmentLen = (total / (2 * numThreads) / alignment + 1) * alignment;
+      segmentLen = std::max(segmentLen, 4 * warmUp);
+   }
+
+   std::vector<EffectSegment> segments;
+   sampleCount toRead = 0;
+   for (i = 0; i < selections.size(); i++) {
+      EffectSegmentSelection & selection = selections[i];
+      const sampleCount end = selection.mStart + selection.mLen;
+      for (sampleCount keepStart = selection.mStart;
+           keepStart < end;
+           keepStart += segmentLen) {
+         EffectSegment segment;
+         segment.mSelection = &selection;
+         segment.mKeepStart = keepStart;
+         segment.mKeepEnd = std::min(end, keepStart + segmentLen);
+         segment.mStart = (warmUp < 0) ? selection.mStart :
+            std::max(selection.mStart, keepStart - warmUp);
+         segment.mEnd = (segment.mKeepEnd == end) ? end :
+            std::min(end, segment.mKeepEnd + lookAhead);
+         segment.mFinish = (segment.mEnd == end);
+         segment.mOutput =
+            mFactory->NewWaveTrack(floatSample, selection.mTrack->GetRate());
+         segment.mDone = 0;
+         segment.mResult = false;
+         segments.push_back(segment);
+         toRead += segment.mEnd - segment.mStart;
+      }
+   }
+
+   EffectSegmentQueue queue(segments);
+
+   numThreads = std::min(numThreads, (int)segments.size());
+   EffectSegmentThread *threads = new EffectSegmentThread[numThreads];
+   std::vector<EffectSegmentProcessor *> processors;
+   processors.push_back(first);
+   for (int t = 0; t < numThreads; t++) {
+      if (t > 0)
+         processors.push_back(CreateSegmentProcessor());
+      threads[t].SetData(processors[t], &queue);
+      threads[t].Create();
+      threads[t].Run();
+   }
+
+   bool bGoodResult = true;
+   while (!queue.IsDone()) {
+      if (bGoodResult && TotalProgress(queue.GetDone() / (double)toRead)) {
+         bGoodResult = false;
+         queue.Cancel();
+      }
+      wxMilliSleep(50);
+   }
+
+   for (int t = 0; t < numThreads; t++) {
+      threads[t].Wait();
+      delete processors[t];
+   }
+   delete [] threads;
+
+   for (i = 0; i < segments.size(); i++)
+      if (!segments[i].mResult)
+         bGoodResult = false;
+
+   // Put together the output kept from the segments of each selection,
+   // in order, converting to the format of the track
+   sampleCount bufferSize = 0;
+   float *buffer = NULL;
+   for (i = 0; bGoodResult && i < segments.size(); i++) {
+      EffectSegment & segment = segments[i];
+      EffectSegmentSelection & selection = *segment.mSelection;
+      WaveTrack *track = selection.mTrack;
+      if (!selection.mOutput)
+         selection.mOutput =
+            mFactory->NewWaveTrack(track->GetSampleFormat(), track->GetRate());
+
+      if (bufferSize < track->GetMaxBlockSize()) {
+         delete [] buffer;
+         bufferSize = track->GetMaxBlockSize();
+         buffer = new float[bufferSize];
+      }
+
+      // The last segment of the selection keeps the tail
+      const bool last = (segment.mKeepEnd == selection.mStart + selection.mLen);
+      WaveTrack *output = segment.mOutput;
+      sampleCount pos = segment.mKeepStart - segment.mStart;
+      sampleCount end = last ?
+         output->TimeToLongSamples(output->GetEndTime()) :
+         segment.mKeepEnd - segment.mStart;
+      while (pos < end) {
+         sampleCount block = std::min(end - pos, bufferSize);
+         output->Get((samplePtr)buffer, floatSample, pos, block);
+         selection.mOutput->Append((samplePtr)buffer, floatSample, block);
+         pos += block;
+      }
+
+      if (last)
+         selection.mOutput->Flush();
+   }
+   delete [] buffer;
+
+   for (i = 0; i < segments.size(); i++)
+      delete segments[i].mOutput;
+
+   if (!bGoodResult) {
+      for (i = 0; i < selections.size(); i++) {
+         delete selections[i].mOutput;
+         selections[i].mOutput = NULL;
+      }
+   }
+
+   return bGoodResult;
+}
+
+#if defined(EXPERIMENTAL_PARALLEL_TRACK_EFFECTS)
+
+//
+// Processing track groups in parallel
+//
+
+// A track, or a stereo pair, processed by a client processor of its own
+struct EffectTrackGroup
+{
+   WaveTrack *mLeft;
+   WaveTrack *mRight;
+   sampleCount mLeftStart;
+   sampleCount mRightStart;
+   sampleCount mLen;
+   int mProcessor;
+
+   sampleCount mDone;      // samples read so far
+   bool mResult;
+};
+
+typedef EffectWorkQueue<EffectTrackGroup> EffectTrackGroupQueue;
+
+class EffectTrackGroupThread : public wxThread
+{
+public:
+   EffectTrackGroupThread():wxThread(wxTHREAD_JOINABLE)
+   {
+      mClient = NULL;
+      mQueue = NULL;
+      mOutput = NULL;
+      mNumAudioIn = 0;
+      mNumAudioOut = 0;
+      mBlockSize = 0;
+      mBufferSize = 0;
+      mLatency = 0;
+   }
+
+   void SetData(EffectClientInterface *client, EffectTrackGroupQueue *queue,
+                EffectOutputQueue *output,
+                int numAudioIn, int numAudioOut,
+                sampleCount blockSize, sampleCount bufferSize,
+                sampleCount latency)
+   {
+      mClient = client;
+      mQueue = queue;
+      mOutput = output;
+      mNumAudioIn = numAudioIn;
+      mNumAudioOut = numAudioOut;
+      mBlockSize = blockSize;
+      mBufferSize = bufferSize;
+      mLatency = latency;
+   }
+
+   virtual void *Entry()
+   {
+      TRACE_THREAD_NAME("Effect tracks");
+      EffectTrackGroup *group;
+      while ((group = mQueue->Next()) != NULL) {
+         TRACE_SCOPE("Effect track group");
+         mQueue->Finish(group, ProcessGroup(*group));
+      }
+      return NULL;
+   }
+
+private:
+   // As Effect::ProcessTrack(), but with the group's own processor, whose
+   // latency is fixed.  The output goes to the main thread to be set.
+   bool ProcessGroup(EffectTrackGroup & group)
+   {
+      int numChannels = group.mRight ? 2 : 1;
+      int chans = wxMin(mNumAudioOut, numChannels);
+
+      // Always create the number of buffers the client expects even if we
+      // don't have the same number of channels.  The unused inputs stay
+      // silent and the unused outputs get tossed.
+      float **inBuffer = new float *[mNumAudioIn];
+      float **inBufPos = new float *[mNumAudioIn];
+      for (int i = 0; i < mNumAudioIn; i++)
+      {
+         inBuffer[i] = new float[mBufferSize];
+         for (int j = 0; j < mBufferSize; j++)
+         {
+            inBuffer[i][j] = 0.0;
+         }
+      }
+
+      float **outBuffer = new float *[mNumAudioOut];
+      float **outBufPos = new float *[mNumAudioOut];
+      for (int i = 0; i < mNumAudioOut; i++)
+      {
+         outBuffer[i] = new float[mBufferSize];
+      }
+
+      // Feed the processor silence after the selection until the delayed
+      // output has come out, and drop the same amount from the start
+      bool rc = true;
+      sampleCount toRead = group.mLen + mLatency;
+      sampleCount read = 0;
+      sampleCount written = 0;
+      sampleCount skip = mLatency;
+
+      while (read < toRead)
+      {
+         sampleCount cnt = wxMin(mBufferSize, toRead - read);
+         sampleCount avail = 0;
+         if (read < group.mLen)
+         {
+            avail = wxMin(cnt, group.mLen - read);
+         }
+
+         if (avail > 0)
+         {
+            group.mLeft->Get((samplePtr) inBuffer[0], floatSample, group.mLeftStart + read, avail);
+            if (group.mRight)
+            {
+               group.mRight->Get((samplePtr) inBuffer[1], floatSample, group.mRightStart + read, avail);
+            }
+         }
+         for (int i = 0; i < numChannels; i++)
+         {
+            for (sampleCount j = avail; j < cnt; j++)
+            {
+               inBuffer[i][j] = 0.0;
+            }
+         }
+
+         for (sampleCount block = 0; rc && block < cnt; block += mBlockSize)
+         {
+            for (int i = 0; i < mNumAudioIn; i++)
+            {
+               inBufPos[i] = inBuffer[i] + block;
+            }
+            for (int i = 0; i < mNumAudioOut; i++)
+            {
+               outBufPos[i] = outBuffer[i] + block;
+            }
+
+            try
+            {
+               mClient->RealtimeProcess(group.mProcessor, inBufPos, outBufPos,
+                                        wxMin(mBlockSize, cnt - block));
+            }
+            catch(...)
+            {
+               rc = false;
+            }
+         }
+         if (!rc)
+         {
+            break;
+         }
+         read += cnt;
+
+         sampleCount drop = wxMin(skip, cnt);
+         skip -= drop;
+         mOutput->Add(group.mLeft, group.mLeftStart + written,
+                      outBuffer[0] + drop, cnt - drop);
+         if (group.mRight && chans > 1)
+         {
+            mOutput->Add(group.mRight, group.mRightStart + written,
+                         outBuffer[1] + drop, cnt - drop);
+         }
+         written += cnt - drop;
+
+         mQueue->SetDone(&group, wxMin(read, group.mLen));
+         if (mQueue->IsCancelled())
+         {
+            rc = false;
+            break;
+         }
+      }
+
+      for (int i = 0; i < mNumAudioIn; i++)
+      {
+         delete [] inBuffer[i];
+      }
+      delete [] inBuffer;
+      delete [] inBufPos;
+
+      for (int i = 0; i < mNumAudioOut; i++)
+      {
+         delete [] outBuffer[i];
+      }
+      delete [] outBuffer;
+      delete [] outBufPos;
+
+      return rc;
+   }
+
+   EffectClientInterface *mClient;
+   EffectTrackGroupQueue *mQueue;
+   EffectOutputQueue *mOutput;
+   int mNumAudioIn;
+   int mNumAudioOut;
+   sampleCount mBlockSize;
+   sampleCount mBufferSize;
+   sampleCount mLatency;
+};
+
+bool Effect::CanProcessTrackGroups()
+{
+   if (mClient->GetType() != EffectTypeProcess ||
+       !mClient->SupportsParallelProcessing())
+   {
+      return false;
+   }
+
+   // The realtime processors may be in use for playback
+   if (EffectManager::Get().RealtimeIsActive())
+   {
+      return false;
+   }
+
+   // Stereo pairs are processed together only if the client takes two
+   // channels
+   int numGroups = (mNumAudioIn > 1 ? mNumGroups : mNumTracks);
+
+   return numGroups > 1 && wxThread::GetCPUCount() > 1;
+}
+
+bool Effect::ProcessTrackGroups()
+{
+   std::vector<EffectTrackGroup> groups;
+   sampleCount total = 0;
+   sampleCount max = 0;
+
+   TrackListIterator iter(mOutputTracks);
+   for (Track *t = iter.First(); t; t = iter.Next())
+   {
+      if (t->GetKind() != Track::Wave || !t->GetSelected())
+      {
+         if (t->IsSyncLockSelected())
+         {
+            t->SyncLockAdjust(mT1, mT0 + mDuration);
+         }
+         continue;
+      }
+
+      EffectTrackGroup group;
+      group.mLeft = (WaveTrack *)t;
+      group.mRight = NULL;
+      group.mRightStart = 0;
+      GetSamples(group.mLeft, &group.mLeftStart, &group.mLen);
+      if (group.mLeft->GetLinked() && mNumAudioIn > 1)
+      {
+         group.mRight = (WaveTrack *) iter.Next();
+         GetSamples(group.mRight, &group.mRightStart, &group.mLen);
+      }
+      group.mProcessor = (int) groups.size();
+      group.mDone = 0;
+      group.mResult = false;
+      groups.push_back(group);
+
+      total += group.mLen;
+      max = wxMax(max, group.mLeft->GetMaxBlockSize() * 2);
+   }
+
+   if (groups.empty())
+   {
+      return true;
+   }
+
+   // One processor for each group, at the rate of its tracks
+   if (!mClient->RealtimeInitialize())
+   {
+      return false;
+   }
+
+   bool bGoodResult = true;
+   for (size_t i = 0; bGoodResult && i < groups.size(); i++)
+   {
+      bGoodResult = mClient->RealtimeAddProcessor(groups[i].mRight ? 2 : 1,
+                                                  groups[i].mLeft->GetRate());
+   }
+
+   if (bGoodResult)
+   {
+      // Get the block size the client wants to use, and its latency, which
+      // is the same for all of the processors
+      sampleCount blockSize = mClient->GetBlockSize(max);
+      sampleCount bufferSize = ((max + (blockSize - 1)) / blockSize) * blockSize;
+      sampleCount latency = mClient->GetLatency();
+
+      EffectTrackGroupQueue queue(groups);
+
+      int numThreads = wxMin(wxThread::GetCPUCount(), (int) groups.size());
+      EffectOutputQueue output(numThreads * 4);
+      EffectTrackGroupThread *threads = new EffectTrackGroupThread[numThreads];
+      wxStopWatch timer;
+
+      mClient->RealtimeProcessStart();
+      for (int t = 0; t < numThreads; t++)
+      {
+         threads[t].SetData(mClient, &queue, &output, mNumAudioIn, mNumAudioOut,
+                            blockSize, bufferSize, latency);
+         threads[t].Create();
+         threads[t].Run();
+      }
+
+      // The workers' output is set into the tracks here, on the main thread
+      while (!queue.IsDone())
+      {
+         if (bGoodResult && !output.Write())
+         {
+            bGoodResult = false;
+            queue.Cancel();
+         }
+         if (bGoodResult && total > 0 &&
+             TotalProgress(queue.GetDone() / (double) total))
+         {
+            bGoodResult = false;
+            queue.Cancel();
+         }
+         if (!bGoodResult)
+         {
+            output.Discard();
+         }
+         wxMilliSleep(10);
+      }
+
+      for (int t = 0; t < numThreads; t++)
+      {
+         threads[t].Wait();
+      }
+      delete [] threads;
+      mClient->RealtimeProcessEnd();
+
+      if (bGoodResult && !output.Write())
+      {
+         bGoodResult = false;
+      }
+
+      sampleCount processed = 0;
+      for (size_t i = 0; i < groups.size(); i++)
+      {
+         if (!groups[i].mResult)
+         {
+            bGoodResult = false;
+         }
+         processed += groups[i].mRight ? groups[i].mLen * 2 : groups[i].mLen;
+      }
+
+      if (bGoodResult)
+      {
+         LogThroughput(processed, timer.Time(), numThreads);
+      }
+   }
+
+   mClient->RealtimeFinalize();
+
+   return bGoodResult;
+}
+
+#endif
+
+void Effect::LogThroughput(sampleCount samples, long ms, int numThreads)
+{
+   wxLogDebug(wxT("%s: processed %lld samples in %ld ms, %.0f samples/s, on %d thread(s)"),
+              GetEffectName().c_str(), (long long) samples, ms,
+              ms > 0 ? samples * 1000.0 / ms : 0.0, numThreads);
+}
+
 void Effect::SetTimeWarper(TimeWarper *warper)
 {
    if (mWarper != NULL)
@@ -13,6 +13,7 @@
 #define __AUDACITY_EFFECT__
 
 #include <set>
+#include <vector>
 
 #include <wx/bmpbuttn.h>
 #include <wx/dynarray.h>
@@ -66,6 +67,51 @@ class EffectUIHost;
 //and so can just drop the steps we don't want?
 #define SKIP_EFFECT_MILLISECOND 99999
 
+// Processes one channel for an effect that can process a track in segments
+// on several threads; see Effect::ProcessSegments().  Each thread has a
+// processor of its own, for its state and scratch buffers.
+//
+// This suits effects whose output depends on a bounded stretch of the
+// input around it, like FIR filters done by overlap-add or overlap-save:
+// a segment reads GetWarmUp() samples early so that its output comes out
+// the same as processing the whole selection in one pass, and the output
+// of the warm up is dropped.
+class AUDACITY_DLL_API EffectSegmentProcessor
+{
+public:
+   virtual ~EffectSegmentProcessor() {}
+
+   // Segments start at a multiple of this many samples from the start of
+   // the selection, e.g. the block size of an overlap-add
+   virtual sampleCount GetAlignment() = 0;
+   // How many samples to read before a segment, or -1 if the output
+   // depends on all of the input before it, so that each track must be
+   // one segment
+   virtual sampleCount GetWarmUp() = 0;
+   // How many samples to read after a segment, for all of its output to
+   // be appended
+   virtual sampleCount GetLookAhead() = 0;
+
+   // Starts again, as at the start of a selection
+   virtual void Reset() = 0;
+   // Processes the next len samples, appending to output whatever is
+   // complete.  Output sample n is for input sample n since Reset().
+   virtual void Process(float *buffer, sampleCount len, WaveTrack *output) = 0;
+   // At the end of the selection, appends the rest of the output and
+   // any tail
+   virtual void Finish(WaveTrack *output) = 0;
+};
+
+// The part of a track to process in segments, and its output
+struct EffectSegmentSelection
+{
+   WaveTrack *mTrack;
+   sampleCount mStart;
+   sampleCount mLen;
+   WaveTrack *mOutput;
+};
+typedef std::vector<EffectSegmentSelection> EffectSegmentSelections;
+
 class AUDACITY_DLL_API Effect : public EffectHostInterface
 {
  //
@@ -371,6 +417,20 @@ class AUDACITY_DLL_API Effect : public EffectHostInterface
    // Calculates the start time and selection length in samples
    void GetSamples(WaveTrack *track, sampleCount *start, sampleCount *len);
 
+   // Effects that can process a track in segments return a new processor
+   // for each thread; the caller deletes it.
+   virtual EffectSegmentProcessor *CreateSegmentProcessor() { return NULL; }
+
+   // Processes the selections in segments, on as many threads as there
+   // are CPUs, and sets the mOutput of each to a new track, in the format
+   // of the input, that starts at mStart and includes any tail.  Returns
+   // false if cancelled, with no outputs.
+   bool ProcessSegments(EffectSegmentSelections & selections);
+
+   // Logs how many samples a second the effect processed, to compare
+   // plug-ins, and the serial and parallel paths
+   void LogThroughput(sampleCount samples, long ms, int numThreads);
+
    void SetTimeWarper(TimeWarper *warper);
    TimeWarper *GetTimeWarper();
 
@@ -415,6 +475,14 @@ class AUDACITY_DLL_API Effect : public EffectHostInterface
                      sampleCount leftStart,
                      sampleCount rightStart,
                      sampleCount len);
+
+#if defined(EXPERIMENTAL_PARALLEL_TRACK_EFFECTS)
+   // Driver for client effects whose realtime processors can each process
+   // a track group on a thread of its own.  The output tracks are all
+   // replaced together by Process(), or not at all.
+   bool CanProcessTrackGroups();
+   bool ProcessTrackGroups();
+#endif
  
  //
  // private data
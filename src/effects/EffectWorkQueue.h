@@ -0,0 +1,192 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  EffectWorkQueue.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_EFFECT_WORK_QUEUE__
+#define __AUDACITY_EFFECT_WORK_QUEUE__
+
+#include <vector>
+
+#include <wx/utils.h>
+
+#include "audacity/Types.h"
+#include "../ondemand/ODTaskThread.h"
+#include "../WaveTrack.h"
+
+// Hands out the items to the worker threads, and gathers their progress.
+// Item has an mDone count of samples and an mResult.
+template <class Item>
+class EffectWorkQueue
+{
+public:
+   EffectWorkQueue(std::vector<Item> &items)
+   :  mItems(items),
+      mNext(0),
+      mNumDone(0),
+      mCancelled(false)
+   {
+   }
+
+   // Returns the next item to process, or NULL when there are none left
+   Item *Next()
+   {
+      Item *item = NULL;
+      mLock.Lock();
+      if (!mCancelled && mNext < mItems.size())
+         item = &mItems[mNext++];
+      else {
+         // Don't start any more; count the rest as done
+         mNumDone += mItems.size() - mNext;
+         mNext = mItems.size();
+      }
+      mLock.Unlock();
+      return item;
+   }
+
+   void Finish(Item *item, bool result)
+   {
+      mLock.Lock();
+      item->mResult = result;
+      mNumDone++;
+      mLock.Unlock();
+   }
+
+   void SetDone(Item *item, sampleCount done)
+   {
+      mLock.Lock();
+      item->mDone = done;
+      mLock.Unlock();
+   }
+
+   // Samples read so far, over all the items
+   sampleCount GetDone()
+   {
+      sampleCount done = 0;
+      mLock.Lock();
+      for (size_t i = 0; i < mItems.size(); i++)
+         done += mItems[i].mDone;
+      mLock.Unlock();
+      return done;
+   }
+
+   bool IsDone()
+   {
+      mLock.Lock();
+      bool done = (mNumDone == mItems.size());
+      mLock.Unlock();
+      return done;
+   }
+
+   void Cancel()
+   {
+      mLock.Lock();
+      mCancelled = true;
+      mLock.Unlock();
+   }
+
+   bool IsCancelled()
+   {
+      mLock.Lock();
+      bool cancelled = mCancelled;
+      mLock.Unlock();
+      return cancelled;
+   }
+
+private:
+   ODLock mLock;
+   std::vector<Item> &mItems;
+   size_t mNext;
+   size_t mNumDone;
+   bool mCancelled;
+};
+
+// Carries the samples the worker threads make to the main thread, which
+// sets them into the tracks.  WaveTrack::Set() drops the references of the
+// blocks it writes over, and tracks share blocks after Duplicate, a paste
+// or an undo, so only the main thread may call it.
+class EffectOutputQueue
+{
+public:
+   // Workers wait in Add() while this many runs are waiting to be set
+   EffectOutputQueue(size_t maxPending)
+   :  mMaxPending(maxPending)
+   {
+   }
+
+   ~EffectOutputQueue()
+   {
+      Discard();
+   }
+
+   // Copies len samples of buffer, to be set into track from start
+   void Add(WaveTrack *track, sampleCount start, const float *buffer, sampleCount len)
+   {
+      if (len <= 0)
+         return;
+
+      Output output;
+      output.mTrack = track;
+      output.mStart = start;
+      output.mLen = len;
+      output.mBuffer = new float[len];
+      for (sampleCount i = 0; i < len; i++)
+         output.mBuffer[i] = buffer[i];
+
+      // The main thread takes them all each time round its progress loop
+      mLock.Lock();
+      while (mPending.size() >= mMaxPending) {
+         mLock.Unlock();
+         wxMilliSleep(1);
+         mLock.Lock();
+      }
+      mPending.push_back(output);
+      mLock.Unlock();
+   }
+
+   // Sets what the workers have made so far; on the main thread only
+   bool Write()
+   {
+      std::vector<Output> outputs;
+      mLock.Lock();
+      outputs.swap(mPending);
+      mLock.Unlock();
+
+      bool result = true;
+      for (size_t i = 0; i < outputs.size(); i++) {
+         if (result)
+            result = outputs[i].mTrack->Set((samplePtr) outputs[i].mBuffer, floatSample,
+                                            outputs[i].mStart, outputs[i].mLen);
+         delete [] outputs[i].mBuffer;
+      }
+      return result;
+   }
+
+   // Drops what the workers have made so far, as when cancelled
+   void Discard()
+   {
+      mLock.Lock();
+      for (size_t i = 0; i < mPending.size(); i++)
+         delete [] mPending[i].mBuffer;
+      mPending.clear();
+      mLock.Unlock();
+   }
+
+private:
+   struct Output
+   {
+      WaveTrack *mTrack;
+      sampleCount mStart;
+      sampleCount mLen;
+      float *mBuffer;
+   };
+
+   ODLock mLock;
+   std::vector<Output> mPending;
+   size_t mMaxPending;
+};
+
+#endif
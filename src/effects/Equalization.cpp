@@ -78,6 +78,7 @@
 #include "../WaveTrack.h"
 #include "float_cast.h"
 #include <vector>
+#include <algorithm>
 
 #include <wx/bitmap.h>
 #include <wx/button.h>
@@ -240,7 +241,7 @@ void EffectEqualization::ReadPrefs()
 
 EffectEqualization::EffectEqualization()
 {
-   hFFT = InitializeFFT(windowSize);
+   hFFT = GetFFT(windowSize);
    mFFTBuffer = new float[windowSize];
    mFilterFuncR = new float[windowSize];
    mFilterFuncI = new float[windowSize];
@@ -263,7 +264,7 @@ EffectEqualization::EffectEqualization()
 EffectEqualization::~EffectEqualization()
 {
    if(hFFT)
-      EndFFT(hFFT);
+      ReleaseFFT(hFFT);
    hFFT = NULL;
    if(mFFTBuffer)
       delete[] mFFTBuffer;
@@ -419,6 +420,33 @@ bool EffectEqualization::Process()
 
    SelectedTrackListOfKindIterator iter(Track::Wave, mOutputTracks);
    WaveTrack *track = (WaveTrack *) iter.First();
+
+#ifdef EXPERIMENTAL_SEGMENTED_EFFECTS
+   EffectSegmentSelections selections;
+   while (track) {
+      double trackStart = track->GetStartTime();
+      double trackEnd = track->GetEndTime();
+      double t0 = mT0 < trackStart? trackStart: mT0;
+      double t1 = mT1 > trackEnd? trackEnd: mT1;
+
+      if (t1 > t0) {
+         EffectSegmentSelection selection;
+         selection.mTrack = track;
+         selection.mStart = track->TimeToLongSamples(t0);
+         selection.mLen = track->TimeToLongSamples(t1) - selection.mStart;
+         selections.push_back(selection);
+      }
+
+      track = (WaveTrack *) iter.Next();
+   }
+
+   bGoodResult = ProcessSegments(selections);
+   for (size_t i = 0; bGoodResult && i < selections.size(); i++) {
+      PasteOutput(selections[i].mTrack, selections[i].mOutput,
+                  selections[i].mStart, selections[i].mLen);
+      delete selections[i].mOutput;
+   }
+#else
    int count = 0;
    while (track) {
       double trackStart = track->GetStartTime();
@@ -441,6 +469,7 @@ bool EffectEqualization::Process()
       track = (WaveTrack *) iter.Next();
       count++;
    }
+#endif
 
    this->ReplaceProcessedTracks(bGoodResult);
    return bGoodResult;
@@ -476,7 +505,6 @@ bool EffectEqualization::ProcessOne(int count, WaveTrack * t,
    TrackProgress(count, 0.);
    bool bLoopSuccess = true;
    int wcopy = 0;
-   int offset = (mM - 1)/2;
 
    while(len)
    {
@@ -539,70 +567,7 @@ bool EffectEqualization::ProcessOne(int count, WaveTrack * t,
       output->Append((samplePtr)buffer, floatSample, mM-1);
       output->Flush();
 
-      // now move the appropriate bit of the output back to the track
-      // (this could be enhanced in the future to use the tails)
-      double offsetT0 = t->LongSamplesToTime((sampleCount)offset);
-      double lenT = t->LongSamplesToTime(originalLen);
-      // 'start' is the sample offset in 't', the passed in track
-      // 'startT' is the equivalent time value
-      // 'output' starts at zero
-      double startT = t->LongSamplesToTime(start);
-
-      //output has one waveclip for the total length, even though
-      //t might have whitespace seperating multiple clips
-      //we want to maintain the original clip structure, so
-      //only paste the intersections of the new clip.
-
-      //Find the bits of clips that need replacing
-      std::vector<std::pair<double, double> > clipStartEndTimes;
-      std::vector<std::pair<double, double> > clipRealStartEndTimes; //the above may be truncated due to a clip being partially selected
-      for (WaveClipList::compatibility_iterator it=t->GetClipIterator(); it; it=it->GetNext())
-      {
-         WaveClip *clip;
-         double clipStartT;
-         double clipEndT;
-
-         clip = it->GetData();
-         clipStartT = clip->GetStartTime();
-         clipEndT = clip->GetEndTime();
-         if( clipEndT <= startT )
-            continue;   // clip is not within selection
-         if( clipStartT >= startT + lenT )
-            continue;   // clip is not within selection
-
-         //save the actual clip start/end so that we can rejoin them after we paste.
-         clipRealStartEndTimes.push_back(std::pair<double,double>(clipStartT,clipEndT));
-
-         if( clipStartT < startT )  // does selection cover the whole clip?
-            clipStartT = startT; // don't copy all the new clip
-         if( clipEndT > startT + lenT )  // does selection cover the whole clip?
-            clipEndT = startT + lenT; // don't copy all the new clip
-
-         //save them
-         clipStartEndTimes.push_back(std::pair<double,double>(clipStartT,clipEndT));
-      }
-      //now go thru and replace the old clips with new
-      for(unsigned int i=0;i<clipStartEndTimes.size();i++)
-      {
-         Track *toClipOutput;
-         //remove the old audio and get the new
-         t->Clear(clipStartEndTimes[i].first,clipStartEndTimes[i].second);
-         output->Copy(clipStartEndTimes[i].first-startT+offsetT0,clipStartEndTimes[i].second-startT+offsetT0, &toClipOutput);
-         if(toClipOutput)
-         {
-            //put the processed audio in
-            bool bResult = t->Paste(clipStartEndTimes[i].first, toClipOutput);
-            wxASSERT(bResult); // TO DO: Actually handle this.
-            //if the clip was only partially selected, the Paste will have created a split line.  Join is needed to take care of this
-            //This is not true when the selection is fully contained within one clip (second half of conditional)
-            if( (clipRealStartEndTimes[i].first  != clipStartEndTimes[i].first ||
-               clipRealStartEndTimes[i].second != clipStartEndTimes[i].second) &&
-               !(clipRealStartEndTimes[i].first <= startT &&
-               clipRealStartEndTimes[i].second >= startT+lenT) )
-               t->Join(clipRealStartEndTimes[i].first,clipRealStartEndTimes[i].second);
-            delete toClipOutput;
-         }
-      }
+      PasteOutput(t, output, start, originalLen);
    }
 
    delete[] buffer;
@@ -613,8 +578,87 @@ bool EffectEqualization::ProcessOne(int count, WaveTrack * t,
    return bLoopSuccess;
 }
 
+// Replaces the selection in t with the output of the filter, which
+// starts at start and has a 'tail' each end
+void EffectEqualization::PasteOutput(WaveTrack * t, WaveTrack * output,
+                                     sampleCount start, sampleCount len)
+{
+   int offset = (mM - 1)/2;
+
+   // now move the appropriate bit of the output back to the track
+   // (this could be enhanced in the future to use the tails)
+   double offsetT0 = t->LongSamplesToTime((sampleCount)offset);
+   double lenT = t->LongSamplesToTime(len);
+   // 'start' is the sample offset in 't', the passed in track
+   // 'startT' is the equivalent time value
+   // 'output' starts at zero
+   double startT = t->LongSamplesToTime(start);
+
+   //output has one waveclip for the total length, even though
+   //t might have whitespace seperating multiple clips
+   //we want to maintain the original clip structure, so
+   //only paste the intersections of the new clip.
+
+   //Find the bits of clips that need replacing
+   std::vector<std::pair<double, double> > clipStartEndTimes;
+   std::vector<std::pair<double, double> > clipRealStartEndTimes; //the above may be truncated due to a clip being partially selected
+   for (WaveClipList::compatibility_iterator it=t->GetClipIterator(); it; it=it->GetNext())
+   {
+      WaveClip *clip;
+      double clipStartT;
+      double clipEndT;
+
+      clip = it->GetData();
+      clipStartT = clip->GetStartTime();
+      clipEndT = clip->GetEndTime();
+      if( clipEndT <= startT )
+         continue;   // clip is not within selection
+      if( clipStartT >= startT + lenT )
+         continue;   // clip is not within selection
+
+      //save the actual clip start/end so that we can rejoin them after we paste.
+      clipRealStartEndTimes.push_back(std::pair<double,double>(clipStartT,clipEndT));
+
+      if( clipStartT < startT )  // does selection cover the whole clip?
+         clipStartT = startT; // don't copy all the new clip
+      if( clipEndT > startT + lenT )  // does selection cover the whole clip?
+         clipEndT = startT + lenT; // don't copy all the new clip
+
+      //save them
+      clipStartEndTimes.push_back(std::pair<double,double>(clipStartT,clipEndT));
+   }
+   //now go thru and replace the old clips with new
+   for(unsigned int i=0;i<clipStartEndTimes.size();i++)
+   {
+      Track *toClipOutput;
+      //remove the old audio and get the new
+      t->Clear(clipStartEndTimes[i].first,clipStartEndTimes[i].second);
+      output->Copy(clipStartEndTimes[i].first-startT+offsetT0,clipStartEndTimes[i].second-startT+offsetT0, &toClipOutput);
+      if(toClipOutput)
+      {
+         //put the processed audio in
+         bool bResult = t->Paste(clipStartEndTimes[i].first, toClipOutput);
+         wxASSERT(bResult); // TO DO: Actually handle this.
+         //if the clip was only partially selected, the Paste will have created a split line.  Join is needed to take care of this
+         //This is not true when the selection is fully contained within one clip (second half of conditional)
+         if( (clipRealStartEndTimes[i].first  != clipStartEndTimes[i].first ||
+            clipRealStartEndTimes[i].second != clipStartEndTimes[i].second) &&
+            !(clipRealStartEndTimes[i].first <= startT &&
+            clipRealStartEndTimes[i].second >= startT+lenT) )
+            t->Join(clipRealStartEndTimes[i].first,clipRealStartEndTimes[i].second);
+         delete toClipOutput;
+      }
+   }
+}
+
 void EffectEqualization::Filter(sampleCount len,
                                 float *buffer)
+{
+   Filter(len, buffer, mFFTBuffer);
+}
+
+void EffectEqualization::Filter(sampleCount len,
+                                float *buffer, float *scratch)
 {
    int i;
    float re,im;
@@ -624,22 +668,140 @@ void EffectEqualization::Filter(sampleCount len,
 
    // Apply filter
    // DC component is purely real
-   mFFTBuffer[0] = buffer[0] * mFilterFuncR[0];
+   scratch[0] = buffer[0] * mFilterFuncR[0];
    for(i=1; i<(len/2); i++)
    {
       re=buffer[hFFT->BitReversed[i]  ];
       im=buffer[hFFT->BitReversed[i]+1];
-      mFFTBuffer[2*i  ] = re*mFilterFuncR[i] - im*mFilterFuncI[i];
-      mFFTBuffer[2*i+1] = re*mFilterFuncI[i] + im*mFilterFuncR[i];
+      scratch[2*i  ] = re*mFilterFuncR[i] - im*mFilterFuncI[i];
+      scratch[2*i+1] = re*mFilterFuncI[i] + im*mFilterFuncR[i];
    }
    // Fs/2 component is purely real
-   mFFTBuffer[1] = buffer[1] * mFilterFuncR[len/2];
+   scratch[1] = buffer[1] * mFilterFuncR[len/2];
 
    // Inverse FFT and normalization
-   InverseRealFFTf(mFFTBuffer, hFFT);
-   ReorderToTime(hFFT, mFFTBuffer, buffer);
+   InverseRealFFTf(scratch, hFFT);
+   ReorderToTime(hFFT, scratch, buffer);
 }
 
+#ifdef EXPERIMENTAL_SEGMENTED_EFFECTS
+
+// Does the overlap-add of ProcessOne() for one segment at a time.  Each
+// lump of L samples only adds to the one after it, so one lump of
+// warm-up gives the same output as processing the track in one pass.
+class EqualizationSegmentProcessor : public EffectSegmentProcessor
+{
+public:
+   EqualizationSegmentProcessor(EffectEqualization & effect)
+   :  mEffect(effect),
+      mM(effect.mM),
+      mL(EffectEqualization::windowSize - (effect.mM - 1))
+   {
+      mThisWindow = new float[EffectEqualization::windowSize];
+      mLastWindow = new float[EffectEqualization::windowSize];
+      mScratch = new float[EffectEqualization::windowSize];
+      mBuffer = new float[EffectEqualization::windowSize];
+      Reset();
+   }
+
+   virtual ~EqualizationSegmentProcessor()
+   {
+      delete[] mThisWindow;
+      delete[] mLastWindow;
+      delete[] mScratch;
+      delete[] mBuffer;
+   }
+
+   virtual sampleCount GetAlignment() { return mL; }
+   virtual sampleCount GetWarmUp() { return mL; }
+   virtual sampleCount GetLookAhead() { return 0; }
+
+   virtual void Reset()
+   {
+      for (int i = 0; i < EffectEqualization::windowSize; i++)
+         mLastWindow[i] = 0;
+      mFill = 0;
+      mLastCount = 0;
+   }
+
+   virtual void Process(float *buffer, sampleCount len, WaveTrack *output)
+   {
+      while (len > 0) {
+         int count = std::min((sampleCount)(mL - mFill), len);
+         for (int j = 0; j < count; j++)
+            mThisWindow[mFill + j] = buffer[j];
+         mFill += count;
+         buffer += count;
+         len -= count;
+
+         if (mFill == mL)
+            FilterLump(output);
+      }
+   }
+
+   virtual void Finish(WaveTrack *output)
+   {
+      if (mFill > 0)
+         FilterLump(output);
+
+      // mM-1 samples of 'tail' left in mLastWindow, as in ProcessOne()
+      int j;
+      int wcopy = mLastCount;
+      if (wcopy < mM - 1) {
+         for (j = 0; j < mM - 1 - wcopy; j++)
+            mBuffer[j] = mLastWindow[wcopy + j] + mThisWindow[mL + wcopy + j];
+         for ( ; j < mM - 1; j++)
+            mBuffer[j] = mLastWindow[wcopy + j];
+      } else {
+         for (j = 0; j < mM - 1; j++)
+            mBuffer[j] = mLastWindow[wcopy + j];
+      }
+      output->Append((samplePtr)mBuffer, floatSample, mM - 1);
+   }
+
+private:
+   void FilterLump(WaveTrack *output)
+   {
+      int j;
+      int wcopy = mFill;
+      for (j = wcopy; j < EffectEqualization::windowSize; j++)
+         mThisWindow[j] = 0;   //this includes the padding
+
+      mEffect.Filter(EffectEqualization::windowSize, mThisWindow, mScratch);
+
+      // Overlap - Add
+      for (j = 0; (j < mM - 1) && (j < wcopy); j++)
+         mBuffer[j] = mThisWindow[j] + mLastWindow[mL + j];
+      for (j = mM - 1; j < wcopy; j++)
+         mBuffer[j] = mThisWindow[j];
+      output->Append((samplePtr)mBuffer, floatSample, wcopy);
+
+      float *tempP = mThisWindow;
+      mThisWindow = mLastWindow;
+      mLastWindow = tempP;
+
+      mLastCount = wcopy;
+      mFill = 0;
+   }
+
+   EffectEqualization & mEffect;
+   const int mM;
+   const int mL;
+
+   float *mThisWindow;
+   float *mLastWindow;
+   float *mScratch;
+   float *mBuffer;
+   int mFill;        // samples of input in mThisWindow
+   int mLastCount;   // samples of input in the last lump filtered
+};
+
+EffectSegmentProcessor *EffectEqualization::CreateSegmentProcessor()
+{
+   return new EqualizationSegmentProcessor(*this);
+}
+
+#endif
 
 //----------------------------------------------------------------------------
 // EqualizationPanel
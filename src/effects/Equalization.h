@@ -122,9 +122,19 @@ public:
 private:
    bool ProcessOne(int count, WaveTrack * t,
                    sampleCount start, sampleCount len);
+   void PasteOutput(WaveTrack * t, WaveTrack * output,
+                    sampleCount start, sampleCount len);
 
    void Filter(sampleCount len,
                float *buffer);
+   // The same, with the caller's scratch buffer of len samples
+   void Filter(sampleCount len,
+               float *buffer, float *scratch);
+
+#ifdef EXPERIMENTAL_SEGMENTED_EFFECTS
+   virtual EffectSegmentProcessor *CreateSegmentProcessor();
+friend class EqualizationSegmentProcessor;
+#endif
 
    void ReadPrefs();
 
@@ -258,11 +258,20 @@ public:
                 SelectedTrackListOfKindIterator &iter, double mT0, double mT1);
 
 private:
+#ifdef EXPERIMENTAL_SEGMENTED_EFFECTS
+   friend class EffectNoiseReduction::SegmentProcessor;
+#endif
+
    bool ProcessOne(EffectNoiseReduction &effect,
                    Statistics &statistics,
                    TrackFactory &factory,
                    int count, WaveTrack *track,
                    sampleCount start, sampleCount len);
+   void PasteOutput(WaveTrack *track, WaveTrack *outputTrack,
+                    sampleCount start, sampleCount len);
+#ifdef EXPERIMENTAL_SEGMENTED_EFFECTS
+   int WarmUpSteps() const;
+#endif
 
    void StartNewTrack();
    void ProcessSamples(Statistics &statistics,
@@ -649,7 +658,7 @@ bool EffectNoiseReduction::Process()
 
 EffectNoiseReduction::Worker::~Worker()
 {
-   EndFFT(hFFT);
+   ReleaseFFT(hFFT);
    for(int ii = 0, nn = mQueue.size(); ii < nn; ++ii)
       delete mQueue[ii];
 }
@@ -658,6 +667,45 @@ bool EffectNoiseReduction::Worker::Process
 (EffectNoiseReduction &effect, Statistics &statistics, TrackFactory &factory,
  SelectedTrackListOfKindIterator &iter, double mT0, double mT1)
 {
+#ifdef EXPERIMENTAL_SEGMENTED_EFFECTS
+   // Profiling adds up statistics in order, so is done in one pass
+   if (!mDoProfile) {
+      EffectSegmentSelections selections;
+      WaveTrack *track = (WaveTrack *) iter.First();
+      while (track) {
+         if (track->GetRate() != mSampleRate) {
+            ::wxMessageBox(_("The sample rate of the noise profile must match that of the sound to be processed."));
+            return false;
+         }
+
+         double trackStart = track->GetStartTime();
+         double trackEnd = track->GetEndTime();
+         double t0 = std::max(trackStart, mT0);
+         double t1 = std::min(trackEnd, mT1);
+
+         if (t1 > t0) {
+            EffectSegmentSelection selection;
+            selection.mTrack = track;
+            selection.mStart = track->TimeToLongSamples(t0);
+            selection.mLen = track->TimeToLongSamples(t1) - selection.mStart;
+            selections.push_back(selection);
+         }
+         track = (WaveTrack *) iter.Next();
+      }
+
+      if (!effect.ProcessSegments(selections))
+         return false;
+
+      for (size_t ii = 0; ii < selections.size(); ++ii) {
+         EffectSegmentSelection &selection = selections[ii];
+         PasteOutput(selection.mTrack, selection.mOutput,
+                     selection.mStart, selection.mLen);
+         delete selection.mOutput;
+      }
+      return true;
+   }
+#endif
+
    int count = 0;
    WaveTrack *track = (WaveTrack *) iter.First();
    while (track) {
@@ -738,7 +786,7 @@ EffectNoiseReduction::Worker::Worker
 , mSampleRate(sampleRate)
 
 , mWindowSize(settings.WindowSize())
-, hFFT(InitializeFFT(mWindowSize))
+, hFFT(GetFFT(mWindowSize))
 , mFFTBuffer(mWindowSize)
 , mInWaveBuffer(mWindowSize)
 , mOutOverlapBuffer(mWindowSize)
@@ -1337,19 +1385,129 @@ bool EffectNoiseReduction::Worker::ProcessOne
       // Flush the output WaveTrack (since it's buffered)
       outputTrack->Flush();
 
-      // Take the output track and insert it in place of the original
-      // sample data (as operated on -- this may not match mT0/mT1)
-      double t0 = outputTrack->LongSamplesToTime(start);
-      double tLen = outputTrack->LongSamplesToTime(len);
-      // Filtering effects always end up with more data than they started with.  Delete this 'tail'.
-      outputTrack->HandleClear(tLen, outputTrack->GetEndTime(), false, false);
-      bool bResult = track->ClearAndPaste(t0, t0 + tLen, &*outputTrack, true, false);
-      wxASSERT(bResult); // TO DO: Actually handle this.
+      PasteOutput(track, &*outputTrack, start, len);
    }
 
    return bLoopSuccess;
 }
 
+void EffectNoiseReduction::Worker::PasteOutput
+(WaveTrack *track, WaveTrack *outputTrack, sampleCount start, sampleCount len)
+{
+   // Take the output track and insert it in place of the original
+   // sample data (as operated on -- this may not match mT0/mT1)
+   double t0 = outputTrack->LongSamplesToTime(start);
+   double tLen = outputTrack->LongSamplesToTime(len);
+   // Filtering effects always end up with more data than they started with.  Delete this 'tail'.
+   outputTrack->HandleClear(tLen, outputTrack->GetEndTime(), false, false);
+   bool bResult = track->ClearAndPaste(t0, t0 + tLen, outputTrack, true, false);
+   wxASSERT(bResult); // TO DO: Actually handle this.
+}
+
+#ifdef EXPERIMENTAL_SEGMENTED_EFFECTS
+
+// How many steps must be read before the output of a segment, for it
+// to come out exactly as in one pass, or -1 if there is no bound.
+int EffectNoiseReduction::Worker::WarmUpSteps() const
+{
+   // A window that is not noise raises the gains of the windows after it,
+   // by a release curve that ReduceNoise() cuts off at mNoiseAttenFactor.
+   // Count the steps to get there exactly as it does.
+   int releaseSteps = 0;
+   if (mNoiseReductionChoice != NRC_ISOLATE_NOISE) {
+      const int maxReleaseSteps = 1 << 16;
+      float gain = 1.0;
+      while (gain > mNoiseAttenFactor) {
+         gain = std::max(mNoiseAttenFactor, gain * mOneBlockRelease);
+         if (++releaseSteps > maxReleaseSteps)
+            return -1;
+      }
+   }
+
+   // Before the release, the window must have been classified, from the
+   // windows around it, and the zero-padded windows of a fresh history
+   // must have passed
+   return releaseSteps + mHistoryLen + mNWindowsToExamine + mStepsPerWindow;
+}
+
+//----------------------------------------------------------------------------
+// EffectNoiseReduction::SegmentProcessor
+//----------------------------------------------------------------------------
+
+// Reduces noise in segments of a track on worker threads.  A segment
+// starts with a fresh history, like a new track, but early enough that the
+// windows it keeps, and the gains carried to them, are the same as in
+// one pass.
+class EffectNoiseReduction::SegmentProcessor : public EffectSegmentProcessor
+{
+public:
+   SegmentProcessor(const Settings &settings, Statistics &statistics
+#ifdef EXPERIMENTAL_SPECTRAL_EDITING
+                    , double f0, double f1
+#endif
+      )
+      : mStatistics(statistics)
+      , mWorker(settings, statistics.mRate
+#ifdef EXPERIMENTAL_SPECTRAL_EDITING
+                , f0, f1
+#endif
+         )
+   {
+   }
+
+   virtual sampleCount GetAlignment()
+   {
+      return mWorker.mStepSize;
+   }
+
+   virtual sampleCount GetWarmUp()
+   {
+      int steps = mWorker.WarmUpSteps();
+      return steps < 0 ? -1 : steps * sampleCount(mWorker.mStepSize);
+   }
+
+   virtual sampleCount GetLookAhead()
+   {
+      // The output of a window is complete once the history has passed it
+      return mWorker.mHistoryLen * mWorker.mStepSize + mWorker.mWindowSize;
+   }
+
+   virtual void Reset()
+   {
+      mWorker.StartNewTrack();
+   }
+
+   virtual void Process(float *buffer, sampleCount len, WaveTrack *output)
+   {
+      mWorker.mInSampleCount += len;
+      mWorker.ProcessSamples(mStatistics, output, len, buffer);
+   }
+
+   virtual void Finish(WaveTrack *output)
+   {
+      mWorker.FinishTrack(mStatistics, output);
+   }
+
+private:
+   Statistics &mStatistics;
+   Worker mWorker;
+};
+
+EffectSegmentProcessor *EffectNoiseReduction::CreateSegmentProcessor()
+{
+   // Only the reduction, not the profile, can be done in segments
+   if (mSettings->mDoProfile)
+      return NULL;
+
+   return new SegmentProcessor(*mSettings, *mStatistics
+#ifdef EXPERIMENTAL_SPECTRAL_EDITING
+                               , mF0, mF1
+#endif
+      );
+}
+
+#endif // EXPERIMENTAL_SEGMENTED_EFFECTS
+
 //----------------------------------------------------------------------------
 // EffectNoiseReduction::Dialog
 //----------------------------------------------------------------------------
@@ -24,6 +24,7 @@ public:
    virtual ~EffectNoiseReduction();
 
    using Effect::TrackProgress;
+   using Effect::ProcessSegments;
 
    virtual wxString GetEffectName();
    virtual std::set<wxString> GetEffectCategories();
@@ -45,6 +46,11 @@ private:
    class Worker;
    friend class Dialog;
 
+#ifdef EXPERIMENTAL_SEGMENTED_EFFECTS
+   class SegmentProcessor;
+   virtual EffectSegmentProcessor *CreateSegmentProcessor();
+#endif
+
    std::auto_ptr<Settings> mSettings;
    std::auto_ptr<Statistics> mStatistics;
 };
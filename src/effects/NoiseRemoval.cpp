@@ -282,7 +282,7 @@ void EffectNoiseRemoval::Initialize()
    }
 
    // Initialize the FFT
-   hFFT = InitializeFFT(mWindowSize);
+   hFFT = GetFFT(mWindowSize);
 
    mFFTBuffer = new float[mWindowSize];
    mInWaveBuffer = new float[mWindowSize];
@@ -303,7 +303,7 @@ void EffectNoiseRemoval::Cleanup()
 {
    int i;
 
-   EndFFT(hFFT);
+   ReleaseFFT(hFFT);
 
    if (mDoProfile) {
       ApplyFreqSmoothing(mNoiseThreshold);
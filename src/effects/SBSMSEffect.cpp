@@ -16,17 +16,124 @@ effect that uses SBSMS to do its processing (TimeScale)
 #if USE_SBSMS
 
 #include <math.h>
+#include <string.h>
+#include <deque>
+
+#include <wx/thread.h>
 
 #include "SBSMSEffect.h"
 #include "../LabelTrack.h"
 #include "../WaveTrack.h"
 #include "../Project.h"
+#include "../Prefs.h"
+#include "../ondemand/ODTaskThread.h"
 #include "TimeWarper.h"
 
 enum {
-  SBSMSOutBlockSize = 512
+  SBSMSOutBlockSize = 512,
+  SBSMSReadBlocks = 4,       // blocks read ahead of SBSMS
+  SBSMSWriteBlocks = 64      // blocks of output waiting to be written
+};
+
+// A bounded queue of blocks of audio, passed from one thread to another
+class SBSMSBlockQueue
+{
+public:
+   SBSMSBlockQueue(int maxBlocks)
+   :  mCondition(&mLock),
+      mMaxBlocks(maxBlocks),
+      mEnded(false),
+      mAborted(false)
+   {
+   }
+
+   ~SBSMSBlockQueue()
+   {
+      while (!mBlocks.empty()) {
+         delete [] mBlocks.front().buf;
+         mBlocks.pop_front();
+      }
+   }
+
+   // Waits for room, and adds a copy of size frames.  Returns false if
+   // aborted.
+   bool Push(audio *buf, long size)
+   {
+      Block block;
+      block.buf = new audio[size];
+      block.size = size;
+      memcpy(block.buf, buf, size * sizeof(audio));
+
+      mLock.Lock();
+      while ((int)mBlocks.size() >= mMaxBlocks && !mAborted)
+         mCondition.Wait();
+      bool ok = !mAborted;
+      if (ok) {
+         mBlocks.push_back(block);
+         mCondition.Broadcast();
+      }
+      mLock.Unlock();
+
+      if (!ok)
+         delete [] block.buf;
+      return ok;
+   }
+
+   // Waits for the next block and copies it to buf.  Returns its size, or
+   // 0 after End() or Abort().
+   long Pop(audio *buf)
+   {
+      long size = 0;
+      mLock.Lock();
+      while (mBlocks.empty() && !mEnded && !mAborted)
+         mCondition.Wait();
+      if (!mBlocks.empty() && !mAborted) {
+         Block block = mBlocks.front();
+         mBlocks.pop_front();
+         memcpy(buf, block.buf, block.size * sizeof(audio));
+         size = block.size;
+         delete [] block.buf;
+         mCondition.Broadcast();
+      }
+      mLock.Unlock();
+      return size;
+   }
+
+   // No more blocks will be pushed
+   void End()
+   {
+      mLock.Lock();
+      mEnded = true;
+      mCondition.Broadcast();
+      mLock.Unlock();
+   }
+
+   // Stops both ends
+   void Abort()
+   {
+      mLock.Lock();
+      mAborted = true;
+      mCondition.Broadcast();
+      mLock.Unlock();
+   }
+
+private:
+   struct Block {
+      audio *buf;
+      long size;
+   };
+
+   ODLock mLock;
+   ODCondition mCondition;
+   std::deque<Block> mBlocks;
+   int mMaxBlocks;
+   bool mEnded;
+   bool mAborted;
 };
 
+class SBSMSReadThread;
+class SBSMSWriteThread;
+
 class ResampleBuf
 {
 public:
@@ -44,22 +151,17 @@ public:
       SBSMSBuf = NULL;
       outputLeftTrack = NULL;
       outputRightTrack = NULL;
-   }
 
-   ~ResampleBuf()
-   {
-      if(buf)                 free(buf);
-      if(leftBuffer)          free(leftBuffer);
-      if(rightBuffer)         free(rightBuffer);
-      if(SBSMSBuf)            free(SBSMSBuf);
-      if(outputLeftTrack)     delete outputLeftTrack;
-      if(outputRightTrack)    delete outputRightTrack;
-      if(quality)             delete quality;
-      if(sbsms)               delete sbsms;
-      if(iface)           delete iface;
-      if(resampler)           delete resampler;
+      readQueue = NULL;
+      writeQueue = NULL;
+      reader = NULL;
+      writer = NULL;
    }
 
+   ~ResampleBuf();
+
+   void StopReading();
+
    bool bPitch;
    audio *buf;
    double ratio;
@@ -81,8 +183,131 @@ public:
    SBSMSQuality *quality;
    WaveTrack *outputLeftTrack;
    WaveTrack *outputRightTrack;
+
+   // When pipelined, the input is read ahead, and the output written,
+   // on threads of their own
+   SBSMSBlockQueue *readQueue;
+   SBSMSBlockQueue *writeQueue;
+   SBSMSReadThread *reader;
+   SBSMSWriteThread *writer;
+};
+
+// Reads blockSize samples, or fewer at the end, from offset into buf
+static long ReadSamples(ResampleBuf *r, sampleCount offset, audio *buf)
+{
+   long blockSize = r->leftTrack->GetBestBlockSize(offset);
+
+   //Adjust the block size if it is the final block in the track
+   if (offset + blockSize > r->end)
+      blockSize = r->end - offset;
+
+   // Get the samples from the tracks and put them in the buffers.
+   r->leftTrack->Get((samplePtr)(r->leftBuffer), floatSample, offset, blockSize);
+   r->rightTrack->Get((samplePtr)(r->rightBuffer), floatSample, offset, blockSize);
+
+   // convert to sbsms audio format
+   for(int i=0; i<blockSize; i++) {
+      buf[i][0] = r->leftBuffer[i];
+      buf[i][1] = r->rightBuffer[i];
+   }
+
+   return blockSize;
+}
+
+class SBSMSReadThread : public wxThread
+{
+public:
+   SBSMSReadThread(ResampleBuf *r)
+   :  wxThread(wxTHREAD_JOINABLE),
+      mR(r)
+   {
+   }
+
+   virtual void *Entry()
+   {
+      audio *buf = (audio*)calloc(mR->blockSize,sizeof(audio));
+      sampleCount offset = mR->offset;
+      while (offset < mR->end) {
+         long blockSize = ReadSamples(mR, offset, buf);
+         if (!mR->readQueue->Push(buf, blockSize))
+            break;
+         offset += blockSize;
+      }
+      mR->readQueue->End();
+      free(buf);
+      return NULL;
+   }
+
+private:
+   ResampleBuf *mR;
+};
+
+class SBSMSWriteThread : public wxThread
+{
+public:
+   SBSMSWriteThread(ResampleBuf *r)
+   :  wxThread(wxTHREAD_JOINABLE),
+      mR(r)
+   {
+   }
+
+   virtual void *Entry()
+   {
+      audio buf[SBSMSOutBlockSize];
+      float left[SBSMSOutBlockSize];
+      float right[SBSMSOutBlockSize];
+      long count;
+      while ((count = mR->writeQueue->Pop(buf)) > 0) {
+         for(int i = 0; i < count; i++) {
+            left[i] = buf[i][0];
+            right[i] = buf[i][1];
+         }
+         mR->outputLeftTrack->Append((samplePtr)left, floatSample, count);
+         if(mR->outputRightTrack)
+            mR->outputRightTrack->Append((samplePtr)right, floatSample, count);
+      }
+      return NULL;
+   }
+
+private:
+   ResampleBuf *mR;
 };
 
+// Stops the reader, which may still be reading ahead after the last of
+// the output
+void ResampleBuf::StopReading()
+{
+   if(reader) {
+      readQueue->Abort();
+      reader->Wait();
+      delete reader;
+      reader = NULL;
+   }
+}
+
+ResampleBuf::~ResampleBuf()
+{
+   StopReading();
+   if(writer) {
+      writeQueue->Abort();
+      writer->Wait();
+      delete writer;
+   }
+   if(readQueue)           delete readQueue;
+   if(writeQueue)          delete writeQueue;
+
+   if(buf)                 free(buf);
+   if(leftBuffer)          free(leftBuffer);
+   if(rightBuffer)         free(rightBuffer);
+   if(SBSMSBuf)            free(SBSMSBuf);
+   if(outputLeftTrack)     delete outputLeftTrack;
+   if(outputRightTrack)    delete outputRightTrack;
+   if(quality)             delete quality;
+   if(sbsms)               delete sbsms;
+   if(iface)           delete iface;
+   if(resampler)           delete resampler;
+}
+
 class SBSMSEffectInterface : public SBSMSInterfaceSliding {
 public:
    SBSMSEffectInterface(Resampler *resampler,
@@ -108,21 +333,11 @@ long resampleCB(void *cb_data, SBSMSFrame *data)
 {
    ResampleBuf *r = (ResampleBuf*) cb_data;
 
-   long blockSize = r->leftTrack->GetBestBlockSize(r->offset);
-
-   //Adjust the block size if it is the final block in the track
-   if (r->offset + blockSize > r->end)
-      blockSize = r->end - r->offset;
-
-   // Get the samples from the tracks and put them in the buffers.
-   r->leftTrack->Get((samplePtr)(r->leftBuffer), floatSample, r->offset, blockSize);
-   r->rightTrack->Get((samplePtr)(r->rightBuffer), floatSample, r->offset, blockSize);
-
-   // convert to sbsms audio format
-   for(int i=0; i<blockSize; i++) {
-      r->buf[i][0] = r->leftBuffer[i];
-      r->buf[i][1] = r->rightBuffer[i];
-   }
+   long blockSize;
+   if (r->reader)
+      blockSize = r->readQueue->Pop(r->buf);
+   else
+      blockSize = ReadSamples(r, r->offset, r->buf);
 
    data->buf = r->buf;
    data->size = blockSize;
@@ -219,6 +434,14 @@ bool EffectSBSMS::Process()
    Slide pitchSlide(pitchSlideType,pitchStart,pitchEnd);
    mTotalStretch = rateSlide.getTotalStretch();
 
+   // Run the stages of SBSMS on threads of their own, and read and write
+   // the tracks on others, if there is more than one CPU to do it
+   bool multithreaded = false;
+#ifdef EXPERIMENTAL_SBSMS_THREADS
+   gPrefs->Read(wxT("/Effects/SBSMSMultithreaded"), &multithreaded, true);
+   multithreaded = multithreaded && wxThread::GetCPUCount() > 1;
+#endif
+
    t = iter.First();
    while (t != NULL) {
       if (t->GetKind() == Track::Label &&
@@ -314,7 +537,11 @@ bool EffectSBSMS::Process()
               rb.ratio = srProcess/srTrack;
               rb.quality = new SBSMSQuality(&SBSMSQualityStandard);
               rb.resampler = new Resampler(resampleCB, &rb, srProcess==srTrack?SlideIdentity:SlideConstant);
+#ifdef SBSMS_MULTITHREADED_OPTION
+              rb.sbsms = new SBSMS(rightTrack?2:1,rb.quality,true,multithreaded);
+#else
               rb.sbsms = new SBSMS(rightTrack?2:1,rb.quality,true);
+#endif
               rb.SBSMSBlockSize = rb.sbsms->getInputFrameSize();
               rb.SBSMSBuf = (audio*)calloc(rb.SBSMSBlockSize,sizeof(audio));
 
@@ -357,6 +584,18 @@ bool EffectSBSMS::Process()
             if(rightTrack)
                rb.outputRightTrack = mFactory->NewWaveTrack(rightTrack->GetSampleFormat(),
                                                             rightTrack->GetRate());
+            if(multithreaded) {
+               rb.readQueue = new SBSMSBlockQueue(SBSMSReadBlocks);
+               rb.reader = new SBSMSReadThread(&rb);
+               rb.reader->Create();
+               rb.reader->Run();
+
+               rb.writeQueue = new SBSMSBlockQueue(SBSMSWriteBlocks);
+               rb.writer = new SBSMSWriteThread(&rb);
+               rb.writer->Create();
+               rb.writer->Run();
+            }
+
             long pos = 0;
             long outputCount = -1;
 
@@ -369,15 +608,20 @@ bool EffectSBSMS::Process()
                   frames = SBSMSOutBlockSize;
                }
                outputCount = resampler.read(outBuf,frames);
-               for(int i = 0; i < outputCount; i++) {
-                  outBufLeft[i] = outBuf[i][0];
+               pos += outputCount;
+               if(rb.writer) {
+                  if(outputCount > 0)
+                     rb.writeQueue->Push(outBuf, outputCount);
+               } else {
+                  for(int i = 0; i < outputCount; i++) {
+                     outBufLeft[i] = outBuf[i][0];
+                     if(rightTrack)
+                        outBufRight[i] = outBuf[i][1];
+                  }
+                  rb.outputLeftTrack->Append((samplePtr)outBufLeft, floatSample, outputCount);
                   if(rightTrack)
-                     outBufRight[i] = outBuf[i][1];
+                     rb.outputRightTrack->Append((samplePtr)outBufRight, floatSample, outputCount);
                }
-               pos += outputCount;
-               rb.outputLeftTrack->Append((samplePtr)outBufLeft, floatSample, outputCount);
-               if(rightTrack)
-                  rb.outputRightTrack->Append((samplePtr)outBufRight, floatSample, outputCount);
 
                double frac = (double)pos/(double)samplesOut;
                int nWhichTrack = mCurTrackNum;
@@ -394,6 +638,13 @@ bool EffectSBSMS::Process()
                if (TrackProgress(nWhichTrack, frac))
                   return false;
             }
+            rb.StopReading();
+            if(rb.writer) {
+               rb.writeQueue->End();
+               rb.writer->Wait();
+               delete rb.writer;
+               rb.writer = NULL;
+            }
             rb.outputLeftTrack->Flush();
             if(rightTrack)
                rb.outputRightTrack->Flush();
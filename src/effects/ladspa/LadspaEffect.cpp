@@ -965,7 +965,21 @@ bool LadspaEffect::RealtimeAddProcessor(int WXUNUSED(numChannels), float sampleR
       return false;
    }
 
+   // Slaves run on threads of their own when processing in parallel, so
+   // each writes its output controls to its own buffer
+   float *outputControls = new float[mData->PortCount];
+   for (unsigned long p = 0; p < mData->PortCount; p++)
+   {
+      outputControls[p] = mOutputControls[p];
+      LADSPA_PortDescriptor d = mData->PortDescriptors[p];
+      if (LADSPA_IS_PORT_CONTROL(d) && LADSPA_IS_PORT_OUTPUT(d))
+      {
+         mData->connect_port(slave, p, &outputControls[p]);
+      }
+   }
+
    mSlaves.Add(slave);
+   mSlaveOutputControls.Add(outputControls);
 
    return true;
 }
@@ -975,8 +989,10 @@ bool LadspaEffect::RealtimeFinalize()
    for (size_t i = 0, cnt = mSlaves.GetCount(); i < cnt; i++)
    {
       FreeInstance(mSlaves[i]);
+      delete [] mSlaveOutputControls[i];
    }
    mSlaves.Clear();
+   mSlaveOutputControls.Clear();
 
    return true;
 }
@@ -1018,9 +1034,31 @@ sampleCount LadspaEffect::RealtimeProcess(int group,
 
 bool LadspaEffect::RealtimeProcessEnd()
 {
+   // Show the output controls of the first processor in the dialog
+   if (mSlaveOutputControls.GetCount() > 0)
+   {
+      for (unsigned long p = 0; p < mData->PortCount; p++)
+      {
+         LADSPA_PortDescriptor d = mData->PortDescriptors[p];
+         if (LADSPA_IS_PORT_CONTROL(d) && LADSPA_IS_PORT_OUTPUT(d))
+         {
+            mOutputControls[p] = mSlaveOutputControls[0][p];
+         }
+      }
+   }
+
    return true;
 }
 
+bool LadspaEffect::SupportsParallelProcessing()
+{
+   // Each processor is an instance of its own with its own audio ports and
+   // output controls, so they can run at the same time.  They share the
+   // input controls, which they only read.  A plugin only reports its
+   // latency once it has run, which is too late for the parallel path.
+   return !(mUseLatency && mLatencyPort >= 0);
+}
+
 bool LadspaEffect::ShowInterface(wxWindow *parent, bool forceModal)
 {
    if (mDialog)
@@ -33,6 +33,7 @@ class wxCheckBox;
 ///////////////////////////////////////////////////////////////////////////////
 
 WX_DEFINE_ARRAY_PTR(LADSPA_Handle, LadspaSlaveArray);
+WX_DEFINE_ARRAY_PTR(float *, LadspaControlsArray);
 
 class LadspaEffectEventHelper;
 
@@ -95,6 +96,8 @@ public:
                                        sampleCount numSamples);
    virtual bool RealtimeProcessEnd();
 
+   virtual bool SupportsParallelProcessing();
+
    virtual bool ShowInterface(wxWindow *parent, bool forceModal = false);
 
    virtual bool GetAutomationParameters(EffectAutomationParameters & parms);
@@ -178,6 +181,8 @@ private:
 
    // Realtime processing
    LadspaSlaveArray mSlaves;
+   // The output controls of each slave, so that slaves can run at once
+   LadspaControlsArray mSlaveOutputControls;
 
    EffectUIHostInterface *mUIHost;
    LadspaEffectEventHelper *mEventHelper;
@@ -40,9 +40,12 @@
 #include <wx/tokenzr.h>
 #include <wx/intl.h>
 #include <wx/scrolwin.h>
+#include <wx/stopwatch.h>
+#include <wx/thread.h>
 #include <wx/version.h>
 
 #include "../Effect.h"
+#include "../EffectWorkQueue.h"
 #include "LoadLV2.h"
 #include "LV2Effect.h"
 #include "LV2PortGroup.h"
@@ -488,11 +491,355 @@ bool LV2Effect::PromptUser()
    return true;
 }
 
+#if defined(EXPERIMENTAL_PARALLEL_TRACK_EFFECTS)
+
+// A track, or a stereo pair for a plugin with two inputs, processed by an
+// instance of the plugin of its own
+struct LV2Group
+{
+   WaveTrack *mLeft;
+   WaveTrack *mRight;
+   sampleCount mLeftStart;
+   sampleCount mRightStart;
+   sampleCount mLen;
+
+   LilvInstance *mHandle;
+   std::vector<float> mControlOutputs;
+   float mLatency;
+
+   sampleCount mDone;      // samples read so far
+   bool mResult;
+};
+
+typedef EffectWorkQueue<LV2Group> LV2GroupQueue;
+
+class LV2GroupThread : public wxThread
+{
+public:
+   LV2GroupThread():wxThread(wxTHREAD_JOINABLE)
+   {
+      mQueue = NULL;
+      mOutput = NULL;
+      mAudioInputs = NULL;
+      mAudioOutputs = NULL;
+   }
+
+   void SetData(LV2GroupQueue *queue, EffectOutputQueue *output,
+                const std::vector<uint32_t> *audioInputs,
+                const std::vector<uint32_t> *audioOutputs)
+   {
+      mQueue = queue;
+      mOutput = output;
+      mAudioInputs = audioInputs;
+      mAudioOutputs = audioOutputs;
+   }
+
+   virtual void *Entry()
+   {
+      LV2Group *group;
+      while ((group = mQueue->Next()) != NULL)
+         mQueue->Finish(group, ProcessGroup(*group));
+      return NULL;
+   }
+
+private:
+   // As LV2Effect::ProcessStereo(), but with buffers of its own.  The
+   // instance has been activated already.  The output goes to the main
+   // thread to be set.
+   bool ProcessGroup(LV2Group & group)
+   {
+      size_t numIn = mAudioInputs->size();
+      size_t numOut = mAudioOutputs->size();
+      sampleCount blockSize = group.mLeft->GetMaxBlockSize() * 2;
+
+      // Inputs that no channel is read into stay silent
+      float **inBuffer = new float *[numIn];
+      for (size_t i = 0; i < numIn; i++)
+      {
+         inBuffer[i] = new float[blockSize];
+         for (sampleCount j = 0; j < blockSize; j++)
+         {
+            inBuffer[i][j] = 0.0;
+         }
+         lilv_instance_connect_port(group.mHandle, (*mAudioInputs)[i], inBuffer[i]);
+      }
+
+      float **outBuffer = new float *[numOut];
+      for (size_t i = 0; i < numOut; i++)
+      {
+         outBuffer[i] = new float[blockSize];
+         lilv_instance_connect_port(group.mHandle, (*mAudioOutputs)[i], outBuffer[i]);
+      }
+
+      // The latency is known once the plugin has run.  Feed it silence
+      // after the selection until the delayed output has come out, and
+      // drop the same amount from the start.
+      bool rc = true;
+      bool latencyKnown = false;
+      sampleCount toRead = group.mLen;
+      sampleCount read = 0;
+      sampleCount written = 0;
+      sampleCount skip = 0;
+
+      while (read < toRead)
+      {
+         sampleCount cnt = wxMin(blockSize, toRead - read);
+         sampleCount avail = 0;
+         if (read < group.mLen)
+         {
+            avail = wxMin(cnt, group.mLen - read);
+         }
+
+         if (avail > 0 && numIn > 0)
+         {
+            group.mLeft->Get((samplePtr) inBuffer[0], floatSample, group.mLeftStart + read, avail);
+         }
+         if (avail > 0 && group.mRight && numIn > 1)
+         {
+            group.mRight->Get((samplePtr) inBuffer[1], floatSample, group.mRightStart + read, avail);
+         }
+         for (size_t i = 0; i < numIn && i < 2; i++)
+         {
+            for (sampleCount j = avail; j < cnt; j++)
+            {
+               inBuffer[i][j] = 0.0;
+            }
+         }
+
+         lilv_instance_run(group.mHandle, cnt);
+         read += cnt;
+
+         if (!latencyKnown)
+         {
+            latencyKnown = true;
+            skip = (sampleCount) group.mLatency;
+            toRead += skip;
+         }
+
+         sampleCount drop = wxMin(skip, cnt);
+         skip -= drop;
+         if (numOut > 0)
+         {
+            mOutput->Add(group.mLeft, group.mLeftStart + written,
+                         outBuffer[0] + drop, cnt - drop);
+         }
+         if (group.mRight && numOut > 1)
+         {
+            mOutput->Add(group.mRight, group.mRightStart + written,
+                         outBuffer[1] + drop, cnt - drop);
+         }
+         written += cnt - drop;
+
+         mQueue->SetDone(&group, wxMin(read, group.mLen));
+         if (mQueue->IsCancelled())
+         {
+            rc = false;
+            break;
+         }
+      }
+
+      for (size_t i = 0; i < numIn; i++)
+      {
+         delete [] inBuffer[i];
+      }
+      delete [] inBuffer;
+
+      for (size_t i = 0; i < numOut; i++)
+      {
+         delete [] outBuffer[i];
+      }
+      delete [] outBuffer;
+
+      return rc;
+   }
+
+   LV2GroupQueue *mQueue;
+   EffectOutputQueue *mOutput;
+   const std::vector<uint32_t> *mAudioInputs;
+   const std::vector<uint32_t> *mAudioOutputs;
+};
+
+bool LV2Effect::ProcessGroups(std::vector<LV2Group> & groups)
+{
+   sampleCount total = 0;
+   for (size_t i = 0; i < groups.size(); i++)
+   {
+      total += groups[i].mLen;
+   }
+
+   // Instantiating is not thread-safe, so all of the instances are made
+   // and activated here.  The groups are not added to or moved from now
+   // on, so their ports stay put.
+   bool bGoodResult = true;
+   size_t numHandles = 0;
+   for (; numHandles < groups.size(); numHandles++)
+   {
+      LV2Group & group = groups[numHandles];
+
+      group.mHandle = lilv_plugin_instantiate(mData,
+                                              group.mLeft->GetRate(),
+                                              gLV2Features);
+      if (!group.mHandle)
+      {
+         wxMessageBox(wxString::Format(_("Unable to load plug-in %s"), pluginName.c_str()));
+         bGoodResult = false;
+         break;
+      }
+
+      for (size_t p = 0; p < mControlInputs.GetCount(); p++)
+      {
+         lilv_instance_connect_port(group.mHandle, mControlInputs[p].mIndex,
+                                    &mControlInputs[p].mControlBuffer);
+      }
+
+      // Each instance writes its control outputs to its own group
+      for (size_t p = 0; p < mControlOutputs.GetCount(); p++)
+      {
+         lilv_instance_connect_port(group.mHandle, mControlOutputs[p].mIndex,
+                                    &group.mControlOutputs[p]);
+      }
+
+      if (mLatencyPortIndex >= 0)
+      {
+         lilv_instance_connect_port(group.mHandle, mLatencyPortIndex, &group.mLatency);
+      }
+
+      lilv_instance_activate(group.mHandle);
+   }
+
+   if (bGoodResult)
+   {
+      std::vector<uint32_t> audioInputs;
+      for (size_t p = 0; p < mAudioInputs.GetCount(); p++)
+      {
+         audioInputs.push_back(mAudioInputs[p].mIndex);
+      }
+
+      std::vector<uint32_t> audioOutputs;
+      for (size_t p = 0; p < mAudioOutputs.GetCount(); p++)
+      {
+         audioOutputs.push_back(mAudioOutputs[p].mIndex);
+      }
+
+      LV2GroupQueue queue(groups);
+
+      int numThreads = wxMin(wxThread::GetCPUCount(), (int) groups.size());
+      EffectOutputQueue output(numThreads * 4);
+      LV2GroupThread *threads = new LV2GroupThread[numThreads];
+      wxStopWatch timer;
+
+      for (int t = 0; t < numThreads; t++)
+      {
+         threads[t].SetData(&queue, &output, &audioInputs, &audioOutputs);
+         threads[t].Create();
+         threads[t].Run();
+      }
+
+      // The workers' output is set into the tracks here, on the main thread
+      while (!queue.IsDone())
+      {
+         if (bGoodResult && !output.Write())
+         {
+            bGoodResult = false;
+            queue.Cancel();
+         }
+         if (bGoodResult && total > 0 &&
+             TotalProgress(queue.GetDone() / (double) total))
+         {
+            bGoodResult = false;
+            queue.Cancel();
+         }
+         if (!bGoodResult)
+         {
+            output.Discard();
+         }
+         wxMilliSleep(10);
+      }
+
+      for (int t = 0; t < numThreads; t++)
+      {
+         threads[t].Wait();
+      }
+      delete [] threads;
+
+      if (bGoodResult && !output.Write())
+      {
+         bGoodResult = false;
+      }
+
+      sampleCount processed = 0;
+      for (size_t i = 0; i < groups.size(); i++)
+      {
+         if (!groups[i].mResult)
+         {
+            bGoodResult = false;
+         }
+         processed += groups[i].mRight ? groups[i].mLen * 2 : groups[i].mLen;
+      }
+
+      if (bGoodResult)
+      {
+         LogThroughput(processed, timer.Time(), numThreads);
+      }
+   }
+
+   for (size_t i = 0; i < numHandles; i++)
+   {
+      lilv_instance_deactivate(groups[i].mHandle);
+      lilv_instance_free(groups[i].mHandle);
+   }
+
+   return bGoodResult;
+}
+
+#endif
+
 bool LV2Effect::Process()
 {
    CopyInputTracks();
    bool bGoodResult = true;
 
+#if defined(EXPERIMENTAL_PARALLEL_TRACK_EFFECTS)
+   // Synths get a note of their own on each track, so they keep to the
+   // serial path
+   if (!mMidiInput && wxThread::GetCPUCount() > 1)
+   {
+      std::vector<LV2Group> groups;
+
+      TrackListIterator giter(mOutputTracks);
+      for (Track *t = giter.First(); t; t = giter.Next())
+      {
+         LV2Group group;
+         group.mLeft = (WaveTrack *) t;
+         group.mRight = NULL;
+         group.mRightStart = 0;
+         GetSamples(group.mLeft, &group.mLeftStart, &group.mLen);
+         if (t->GetLinked() && mAudioInputs.GetCount() > 1)
+         {
+            group.mRight = (WaveTrack *) giter.Next();
+            GetSamples(group.mRight, &group.mRightStart, &group.mLen);
+         }
+         group.mHandle = NULL;
+         group.mControlOutputs.resize(mControlOutputs.GetCount());
+         group.mLatency = 0.0;
+         group.mDone = 0;
+         group.mResult = false;
+         groups.push_back(group);
+      }
+
+      if (groups.size() > 1)
+      {
+         bGoodResult = ProcessGroups(groups);
+         ReplaceProcessedTracks(bGoodResult);
+
+         return bGoodResult;
+      }
+   }
+#endif
+
+   wxStopWatch timer;
+   sampleCount processed = 0;
+
    TrackListIterator iter(mOutputTracks);
    int count = 0;
    Track *left = iter.First();
@@ -531,10 +878,16 @@ bool LV2Effect::Process()
          break;
       }
 
+      processed += right ? len * 2 : len;
       left = iter.Next();
       count++;
    }
 
+   if (bGoodResult)
+   {
+      LogThroughput(processed, timer.Time(), 1);
+   }
+
    ReplaceProcessedTracks(bGoodResult);
 
    return bGoodResult;
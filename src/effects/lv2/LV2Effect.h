@@ -27,6 +27,8 @@ class wxCheckBox;
 #define LV2EFFECTS_VERSION wxT("1.0.0.0")
 #define LV2EFFECTS_FAMILY wxT("LV2")
 
+struct LV2Group;
+
 /** A structure that contains information about a single LV2 plugin port. */
 struct LV2Port
 {
@@ -131,6 +133,12 @@ private:
                       sampleCount lstart, sampleCount rstart,
                       sampleCount len);
 
+#if defined(EXPERIMENTAL_PARALLEL_TRACK_EFFECTS)
+   /** Process each group with an instance of the plugin of its own, on
+       several threads. */
+   bool ProcessGroups(std::vector<LV2Group> & groups);
+#endif
+
    bool mValid;
    wxString pluginName;
 
@@ -87,10 +87,19 @@ effects from this one class.
 
 #define UNINITIALIZED_CONTROL ((double)99999999.99)
 
+// How many blocks of the ideal size are read from a track at a time
+#define NYQUIST_READ_BLOCKS 2
+
 WX_DEFINE_OBJARRAY(NyqControlArray);
 
 EffectNyquist::EffectNyquist(wxString fName)
 {
+   for (int i = 0; i < 2; i++) {
+      mCurBuffer[i] = NULL;
+      mCurBufferSize[i] = 0;
+   }
+   mNumAllocs = 0;
+
    mAction = _("Applying Nyquist Effect...");
    mInputCmd = wxEmptyString;
    mCmd = wxEmptyString;
@@ -138,6 +147,7 @@ EffectNyquist::EffectNyquist(wxString fName)
 
 EffectNyquist::~EffectNyquist()
 {
+   FreeBuffers();
    nyx_set_xlisp_path(NULL);
 }
 
@@ -485,6 +495,12 @@ bool EffectNyquist::Process()
    mProgressTot = 0;
    mScale = (GetEffectFlags() & PROCESS_EFFECT ? 0.5 : 1.0) / GetNumWaveGroups();
 
+   mSamplesRead = 0;
+   mSamplesCopied = 0;
+   mNumReads = 0;
+   mNumAppends = 0;
+   mNumAllocs = 0;
+
    mStop = false;
    mBreak = false;
    mCont = false;
@@ -721,6 +737,12 @@ bool EffectNyquist::Process()
       dlog.ShowModal();
    }
 
+   wxLogDebug(wxT("Nyquist: read %lld bytes from tracks in %d reads, copied %lld bytes to Nyquist, appended in %d calls, %d buffer allocations"),
+              (long long) (mSamplesRead * sizeof(float)), mNumReads,
+              (long long) (mSamplesCopied * sizeof(float)), mNumAppends,
+              mNumAllocs);
+   FreeBuffers();
+
    this->ReplaceProcessedTracks(success);
 
    mDebug = false;
@@ -933,7 +955,8 @@ bool EffectNyquist::ProcessOne()
 
    int i;
    for (i = 0; i < mCurNumChannels; i++) {
-      mCurBuffer[i] = NULL;
+      mCurBufferStart[i] = 0;
+      mCurBufferLen[i] = 0;
    }
 
    rval = nyx_eval_expression(cmd.mb_str(wxConvUTF8));
@@ -1044,7 +1067,6 @@ bool EffectNyquist::ProcessOne()
       }
 
       mOutputTrack[i] = mFactory->NewWaveTrack(format, rate);
-      mCurBuffer[i] = NULL;
    }
 
    int success = nyx_get_audio(StaticPutCallback, (void *)this);
@@ -1059,9 +1081,6 @@ bool EffectNyquist::ProcessOne()
 
    for (i = 0; i < outChannels; i++) {
       mOutputTrack[i]->Flush();
-      if (mCurBuffer[i]) {
-         DeleteSamples(mCurBuffer[i]);
-      }
       mOutputTime = mOutputTrack[i]->GetEndTime();
 
       if (mOutputTime <= 0) {
@@ -1496,42 +1515,31 @@ int EffectNyquist::StaticGetCallback(float *buffer, int channel,
 int EffectNyquist::GetCallback(float *buffer, int ch,
                                long start, long len, long WXUNUSED(totlen))
 {
-   if (mCurBuffer[ch]) {
-      if ((mCurStart[ch] + start) < mCurBufferStart[ch] ||
-          (mCurStart[ch] + start)+len >
-          mCurBufferStart[ch]+mCurBufferLen[ch]) {
-         delete[] mCurBuffer[ch];
-         mCurBuffer[ch] = NULL;
-      }
-   }
-
-   if (!mCurBuffer[ch]) {
-      mCurBufferStart[ch] = (mCurStart[ch] + start);
-      mCurBufferLen[ch] = mCurTrack[ch]->GetBestBlockSize(mCurBufferStart[ch]);
-
-      if (mCurBufferLen[ch] < len) {
-         mCurBufferLen[ch] = mCurTrack[ch]->GetIdealBlockSize();
+   sampleCount pos = mCurStart[ch] + start;
+   sampleCount remaining = len;
+
+   while (remaining > 0) {
+      if (pos < mCurBufferStart[ch] ||
+          pos >= mCurBufferStart[ch] + mCurBufferLen[ch]) {
+         if (!FillInputBuffer(ch, pos)) {
+            return -1;
+         }
       }
 
-      if (mCurBufferStart[ch] + mCurBufferLen[ch] > mCurStart[ch] + mCurLen) {
-         mCurBufferLen[ch] = mCurStart[ch] + mCurLen - mCurBufferStart[ch];
+      sampleCount offset = pos - mCurBufferStart[ch];
+      sampleCount toCopy = mCurBufferStart[ch] + mCurBufferLen[ch] - pos;
+      if (toCopy > remaining) {
+         toCopy = remaining;
       }
 
-      mCurBuffer[ch] = NewSamples(mCurBufferLen[ch], floatSample);
-      if (!mCurTrack[ch]->Get(mCurBuffer[ch], floatSample,
-                              mCurBufferStart[ch], mCurBufferLen[ch])) {
-
-         wxPrintf(wxT("GET error\n"));
+      memcpy(buffer, (float *)mCurBuffer[ch] + offset, toCopy * sizeof(float));
+      mSamplesCopied += toCopy;
 
-         return -1;
-      }
+      buffer += toCopy;
+      pos += toCopy;
+      remaining -= toCopy;
    }
 
-   long offset = (mCurStart[ch] + start) - mCurBufferStart[ch];
-   CopySamples(mCurBuffer[ch] + offset*SAMPLE_SIZE(floatSample), floatSample,
-               (samplePtr)buffer, floatSample,
-               len);
-
    if (ch == 0) {
       double progress = mScale*(((float)start+len)/mCurLen);
 
@@ -1570,11 +1578,81 @@ int EffectNyquist::PutCallback(float *buffer, int channel,
       }
    }
 
-   if (mOutputTrack[channel]->Append((samplePtr)buffer, floatSample, len)) {
-      return 0;  // success
+   // Nyquist gives a little at a time; the clip gathers it into blocks in
+   // its append buffer, so it needs no gathering here
+   if (!mOutputTrack[channel]->Append((samplePtr)buffer, floatSample, len)) {
+      return -1; // failure
+   }
+   mNumAppends++;
+
+   return 0;  // success
+}
+
+bool EffectNyquist::FillInputBuffer(int ch, sampleCount pos)
+{
+   WaveTrack *track = mCurTrack[ch];
+   sampleCount end = mCurStart[ch] + mCurLen;
+   if (pos < mCurStart[ch] || pos >= end) {
+      return false;
+   }
+
+   // Whole blocks from pos, so that the next read starts at a block too
+   sampleCount limit = NYQUIST_READ_BLOCKS * track->GetIdealBlockSize();
+   sampleCount len = 0;
+   while (pos + len < end) {
+      sampleCount blockLen = track->GetBestBlockSize(pos + len);
+      if (len > 0 && len + blockLen > limit) {
+         break;
+      }
+      len += blockLen;
+   }
+   if (pos + len > end) {
+      len = end - pos;
+   }
+
+   mCurBuffer[ch] = GrowBuffer(mCurBuffer[ch], mCurBufferSize[ch],
+                               wxMax(len, limit));
+   if (!track->Get(mCurBuffer[ch], floatSample, pos, len)) {
+
+      wxPrintf(wxT("GET error\n"));
+
+      mCurBufferLen[ch] = 0;
+      return false;
+   }
+
+   mCurBufferStart[ch] = pos;
+   mCurBufferLen[ch] = len;
+   mSamplesRead += len;
+   mNumReads++;
+
+   return true;
+}
+
+samplePtr EffectNyquist::GrowBuffer(samplePtr buffer, sampleCount & size,
+                                    sampleCount len)
+{
+   if (buffer && size >= len) {
+      return buffer;
+   }
+
+   if (buffer) {
+      DeleteSamples(buffer);
    }
+   size = len;
+   mNumAllocs++;
 
-   return -1; // failure
+   return NewSamples(size, floatSample);
+}
+
+void EffectNyquist::FreeBuffers()
+{
+   for (int i = 0; i < 2; i++) {
+      if (mCurBuffer[i]) {
+         DeleteSamples(mCurBuffer[i]);
+         mCurBuffer[i] = NULL;
+      }
+      mCurBufferSize[i] = 0;
+   }
 }
 
 void EffectNyquist::StaticOutputCallback(int c, void *This)
@@ -170,6 +170,9 @@ class AUDACITY_DLL_API EffectNyquist:public Effect
                    long start, long len, long totlen);
    int PutCallback(float *buffer, int channel,
                    long start, long len, long totlen);
+   bool FillInputBuffer(int channel, sampleCount pos);
+   samplePtr GrowBuffer(samplePtr buffer, sampleCount & size, sampleCount len);
+   void FreeBuffers();
    void OutputCallback(int c);
    void OSCallback();
 
@@ -225,12 +228,22 @@ class AUDACITY_DLL_API EffectNyquist:public Effect
    double            mProgressTot;
    double            mScale;
 
+   // Input is read a couple of blocks at a time, from where Nyquist is
+   // reading.  The buffers are kept until all the tracks are processed.
    samplePtr         mCurBuffer[2];
    sampleCount       mCurBufferStart[2];
    sampleCount       mCurBufferLen[2];
+   sampleCount       mCurBufferSize[2];
 
    WaveTrack         *mOutputTrack[2];
 
+   // For profiling the transfer of audio to and from Nyquist
+   sampleCount       mSamplesRead;     // from the tracks
+   sampleCount       mSamplesCopied;   // to Nyquist's buffers
+   int               mNumReads;
+   int               mNumAppends;
+   int               mNumAllocs;
+
    wxArrayString     mCategories;
 
    wxString          mProps;
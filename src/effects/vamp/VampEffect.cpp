@@ -31,8 +31,13 @@
 #include <wx/tokenzr.h>
 #include <wx/intl.h>
 #include <wx/scrolwin.h>
+#include <wx/thread.h>
 #include <wx/version.h>
 
+#include "../EffectWorkQueue.h"
+#include "../../Project.h"
+#include "../../TrackPanel.h"
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // VampEffect
@@ -226,10 +231,306 @@ bool VampEffect::PromptUser()
    return true;
 }
 
+#if defined(EXPERIMENTAL_PARALLEL_TRACK_EFFECTS)
+
+// A track, or a stereo pair, analyzed by an instance of the plugin of its
+// own
+struct VampGroup
+{
+   WaveTrack *mLeft;
+   WaveTrack *mRight;
+   sampleCount mLeftStart;
+   sampleCount mRightStart;
+   sampleCount mLen;
+   int mChannels;
+
+   Vamp::Plugin *mPlugin;
+   size_t mStep;
+   size_t mBlock;
+
+   LabelTrack *mLabelTrack;
+   // Features found but not yet added to the label track.  Guarded by the
+   // lock of the threads.
+   Vamp::Plugin::FeatureList mPending;
+
+   sampleCount mDone;      // samples read so far
+   bool mResult;
+};
+
+typedef EffectWorkQueue<VampGroup> VampGroupQueue;
+
+class VampGroupThread : public wxThread
+{
+public:
+   VampGroupThread():wxThread(wxTHREAD_JOINABLE)
+   {
+      mQueue = NULL;
+      mLock = NULL;
+      mOutput = 0;
+   }
+
+   void SetData(VampGroupQueue *queue, ODLock *lock, int output)
+   {
+      mQueue = queue;
+      mLock = lock;
+      mOutput = output;
+   }
+
+   virtual void *Entry()
+   {
+      VampGroup *group;
+      while ((group = mQueue->Next()) != NULL)
+         mQueue->Finish(group, ProcessGroup(*group));
+      return NULL;
+   }
+
+private:
+   // As the loop of VampEffect::Process(), for one group
+   bool ProcessGroup(VampGroup & group)
+   {
+      bool rc = true;
+      int rate = (int)(group.mLeft->GetRate() + 0.5);
+
+      float **data = new float*[group.mChannels];
+      for (int c = 0; c < group.mChannels; ++c) data[c] = new float[group.mBlock];
+
+      sampleCount len = group.mLen;
+      sampleCount ls = group.mLeftStart;
+      sampleCount rs = group.mRightStart;
+
+      while (len) {
+
+         int request = group.mBlock;
+         if (request > len) request = len;
+
+         group.mLeft->Get((samplePtr)data[0], floatSample, ls, request);
+         if (group.mRight) group.mRight->Get((samplePtr)data[1], floatSample, rs, request);
+
+         if (request < (int)group.mBlock) {
+            for (int c = 0; c < group.mChannels; ++c) {
+               for (int i = request; i < (int)group.mBlock; ++i) {
+                  data[c][i] = 0.f;
+               }
+            }
+         }
+
+         Vamp::RealTime timestamp = Vamp::RealTime::frame2RealTime(ls, rate);
+
+         Vamp::Plugin::FeatureSet features = group.mPlugin->process(data, timestamp);
+         AddPending(group, features);
+
+         if (len > (int)group.mStep) len -= group.mStep;
+         else len = 0;
+
+         ls += group.mStep;
+         rs += group.mStep;
+
+         mQueue->SetDone(&group, group.mLen - len);
+         if (mQueue->IsCancelled()) {
+            rc = false;
+            break;
+         }
+      }
+
+      if (rc) {
+         Vamp::Plugin::FeatureSet features = group.mPlugin->getRemainingFeatures();
+         AddPending(group, features);
+      }
+
+      for (int c = 0; c < group.mChannels; ++c) delete [] data[c];
+      delete [] data;
+
+      return rc;
+   }
+
+   void AddPending(VampGroup & group, Vamp::Plugin::FeatureSet & features)
+   {
+      Vamp::Plugin::FeatureList &list = features[mOutput];
+      if (list.empty())
+         return;
+
+      mLock->Lock();
+      group.mPending.insert(group.mPending.end(), list.begin(), list.end());
+      mLock->Unlock();
+   }
+
+   VampGroupQueue *mQueue;
+   ODLock *mLock;
+   int mOutput;
+};
+
+Vamp::Plugin *VampEffect::ClonePlugin(float rate)
+{
+   Vamp::HostExt::PluginLoader *loader =
+      Vamp::HostExt::PluginLoader::getInstance();
+
+   Vamp::Plugin *plugin = loader->loadPlugin
+      (mKey, rate, Vamp::HostExt::PluginLoader::ADAPT_ALL);
+   if (!plugin) return NULL;
+
+   std::string program = mPlugin->getCurrentProgram();
+   if (!program.empty()) plugin->selectProgram(program);
+
+   Vamp::Plugin::ParameterList params = mPlugin->getParameterDescriptors();
+   for (size_t i = 0; i < params.size(); ++i) {
+      plugin->setParameter(params[i].identifier,
+                           mPlugin->getParameter(params[i].identifier));
+   }
+
+   return plugin;
+}
+
+bool VampEffect::ProcessGroups(std::vector<VampGroup> & groups)
+{
+   // Vamp plugins are loaded and initialised here, as the loader is not
+   // thread-safe; only process() runs on the threads
+   bool bGoodResult = true;
+   sampleCount total = 0;
+   for (size_t i = 0; i < groups.size(); i++) {
+      VampGroup & group = groups[i];
+
+      group.mPlugin = ClonePlugin(group.mLeft->GetRate());
+      if (!group.mPlugin) {
+         wxMessageBox(_("Sorry, failed to load Vamp Plug-in."));
+         bGoodResult = false;
+         break;
+      }
+
+      size_t step = group.mPlugin->getPreferredStepSize();
+      size_t block = group.mPlugin->getPreferredBlockSize();
+      if (block == 0) {
+         if (step != 0) block = step;
+         else block = 1024;
+      }
+      if (step == 0) {
+         step = block;
+      }
+      group.mStep = step;
+      group.mBlock = block;
+
+      if (!group.mPlugin->initialise(group.mChannels, step, block)) {
+         wxMessageBox(_("Sorry, Vamp Plug-in failed to initialize."));
+         bGoodResult = false;
+         break;
+      }
+
+      total += group.mLen;
+   }
+
+   if (bGoodResult) {
+      bool multiple = GetNumWaveGroups() > 1;
+      for (size_t i = 0; i < groups.size(); i++) {
+         LabelTrack *ltrack = mFactory->NewLabelTrack();
+         if (!multiple) {
+            ltrack->SetName(GetEffectName());
+         } else {
+            ltrack->SetName(wxString::Format(wxT("%s: %s"),
+                                             groups[i].mLeft->GetName().c_str(),
+                                             GetEffectName().c_str()));
+         }
+         mTracks->Add(ltrack);
+         groups[i].mLabelTrack = ltrack;
+      }
+
+      ODLock lock;
+      VampGroupQueue queue(groups);
+
+      int numThreads = wxMin(wxThread::GetCPUCount(), (int) groups.size());
+      VampGroupThread *threads = new VampGroupThread[numThreads];
+      for (int t = 0; t < numThreads; t++) {
+         threads[t].SetData(&queue, &lock, mOutput);
+         threads[t].Create();
+         threads[t].Run();
+      }
+
+      // Add the features to the label tracks as they come, while the
+      // progress dialog keeps the window up to date and can cancel
+      bool done = false;
+      while (!done) {
+         done = queue.IsDone();
+
+         bool added = false;
+         for (size_t i = 0; i < groups.size(); i++) {
+            Vamp::Plugin::FeatureList pending;
+            lock.Lock();
+            pending.swap(groups[i].mPending);
+            lock.Unlock();
+
+            if (!pending.empty()) {
+               AddFeatures(groups[i].mLabelTrack, pending);
+               added = true;
+            }
+         }
+
+         AudacityProject *project = GetActiveProject();
+         if (added && project) {
+            project->GetTrackPanel()->Refresh(false);
+         }
+
+         if (!done) {
+            if (bGoodResult && total > 0 &&
+                TotalProgress(queue.GetDone() / (double) total)) {
+               bGoodResult = false;
+               queue.Cancel();
+            }
+            wxMilliSleep(50);
+         }
+      }
+
+      for (int t = 0; t < numThreads; t++) {
+         threads[t].Wait();
+      }
+      delete [] threads;
+
+      for (size_t i = 0; i < groups.size(); i++) {
+         if (!groups[i].mResult) bGoodResult = false;
+      }
+   }
+
+   for (size_t i = 0; i < groups.size(); i++) {
+      delete groups[i].mPlugin;
+      groups[i].mPlugin = NULL;
+   }
+
+   return bGoodResult;
+}
+
+#endif
+
 bool VampEffect::Process()
 {
    if (!mPlugin) return false;
 
+#if defined(EXPERIMENTAL_PARALLEL_TRACK_EFFECTS)
+   if (GetNumWaveGroups() > 1 && wxThread::GetCPUCount() > 1) {
+      std::vector<VampGroup> groups;
+
+      TrackListOfKindIterator giter(Track::Wave, mTracks);
+      for (WaveTrack *t = (WaveTrack *)giter.First(); t; t = (WaveTrack *)giter.Next()) {
+         VampGroup group;
+         group.mLeft = t;
+         group.mRight = NULL;
+         group.mRightStart = 0;
+         group.mChannels = 1;
+         GetSamples(t, &group.mLeftStart, &group.mLen);
+         if (t->GetLinked()) {
+            group.mRight = (WaveTrack *)giter.Next();
+            group.mChannels = 2;
+            GetSamples(group.mRight, &group.mRightStart, &group.mLen);
+         }
+         group.mPlugin = NULL;
+         group.mStep = 0;
+         group.mBlock = 0;
+         group.mLabelTrack = NULL;
+         group.mDone = 0;
+         group.mResult = false;
+         groups.push_back(group);
+      }
+
+      return ProcessGroups(groups);
+   }
+#endif
+
    TrackListOfKindIterator iter(Track::Wave, mTracks);
 
    int count = 0;
@@ -366,8 +667,14 @@ bool VampEffect::Process()
 void VampEffect::AddFeatures(LabelTrack *ltrack,
                              Vamp::Plugin::FeatureSet &features)
 {
-   for (Vamp::Plugin::FeatureList::iterator fli = features[mOutput].begin();
-        fli != features[mOutput].end(); ++fli) {
+   AddFeatures(ltrack, features[mOutput]);
+}
+
+void VampEffect::AddFeatures(LabelTrack *ltrack,
+                             Vamp::Plugin::FeatureList &features)
+{
+   for (Vamp::Plugin::FeatureList::iterator fli = features.begin();
+        fli != features.end(); ++fli) {
 
       Vamp::RealTime ftime0 = fli->timestamp;
       double ltime0 = ftime0.sec + (double(ftime0.nsec) / 1000000000.0);
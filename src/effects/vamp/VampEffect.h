@@ -11,6 +11,8 @@
 
 **********************************************************************/
 
+#include <vector>
+
 #include "../Effect.h"
 #include "../../LabelTrack.h"
 
@@ -27,6 +29,8 @@ class wxComboBox;
 #define VAMPEFFECTS_VERSION wxT("1.0.0.0")
 #define VAMPEFFECTS_FAMILY wxT("Vamp")
 
+struct VampGroup;
+
 class VampEffect : public Effect {
 
  public:
@@ -91,6 +95,17 @@ class VampEffect : public Effect {
 
    void AddFeatures(LabelTrack *track,
                     Vamp::Plugin::FeatureSet &features);
+   void AddFeatures(LabelTrack *track,
+                    Vamp::Plugin::FeatureList &features);
+
+#if defined(EXPERIMENTAL_PARALLEL_TRACK_EFFECTS)
+   // Another instance of the plugin, with the same program and parameters
+   Vamp::Plugin *ClonePlugin(float rate);
+
+   // Analyzes each group with an instance of the plugin of its own, on
+   // several threads, adding the labels as the features come in
+   bool ProcessGroups(std::vector<VampGroup> & groups);
+#endif
 };
 
 
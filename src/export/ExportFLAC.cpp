@@ -32,6 +32,8 @@ and libvorbis examples, Monty <monty@xiph.org>
 
 #include "FLAC++/encoder.h"
 
+#include "ExportFLACSegments.h"
+
 #include "../float_cast.h"
 #include "../Project.h"
 #include "../Mix.h"
@@ -40,6 +42,13 @@ and libvorbis examples, Monty <monty@xiph.org>
 #include "../Internat.h"
 #include "../Tags.h"
 
+#ifdef EXPERIMENTAL_PARALLEL_FLAC_EXPORT
+#include <deque>
+#include <wx/thread.h>
+#include "../ondemand/ODTaskThread.h"
+#include "../Tracer.h"
+#endif
+
 //----------------------------------------------------------------------------
 // ExportFLACOptions Class
 //----------------------------------------------------------------------------
@@ -166,6 +175,31 @@ static struct
    {  true,    false,   true,    false,   0, 0, 6, 0, 12 },
 };
 
+// The settings of the command line compression level, for the encoder
+// of the whole file or of each segment
+template<class Encoder>
+static void SetCompressionLevel(Encoder &encoder, int numChannels, int level)
+{
+   if (level < 0 || level > 8) {
+      level = 5;
+   }
+   encoder.set_do_exhaustive_model_search(flacLevels[level].do_exhaustive_model_search);
+   encoder.set_do_escape_coding(flacLevels[level].do_escape_coding);
+   if (numChannels != 2) {
+      encoder.set_do_mid_side_stereo(false);
+      encoder.set_loose_mid_side_stereo(false);
+   }
+   else {
+      encoder.set_do_mid_side_stereo(flacLevels[level].do_mid_side_stereo);
+      encoder.set_loose_mid_side_stereo(flacLevels[level].loose_mid_side_stereo);
+   }
+   encoder.set_qlp_coeff_precision(flacLevels[level].qlp_coeff_precision);
+   encoder.set_min_residual_partition_order(flacLevels[level].min_residual_partition_order);
+   encoder.set_max_residual_partition_order(flacLevels[level].max_residual_partition_order);
+   encoder.set_rice_parameter_search_dist(flacLevels[level].rice_parameter_search_dist);
+   encoder.set_max_lpc_order(flacLevels[level].max_lpc_order);
+}
+
 //----------------------------------------------------------------------------
 
 class ExportFLAC : public ExportPlugin
@@ -192,6 +226,18 @@ private:
 
    bool GetMetadata(AudacityProject *project, Tags *tags);
 
+#if defined(EXPERIMENTAL_PARALLEL_FLAC_EXPORT) && !defined(LEGACY_FLAC)
+   int ExportSegments(AudacityProject *project,
+                      int numChannels,
+                      wxString fName,
+                      bool selectionOnly,
+                      double t0,
+                      double t1,
+                      MixerSpec *mixerSpec,
+                      sampleFormat format,
+                      int level);
+#endif
+
    FLAC__StreamMetadata *mMetadata;
 };
 
@@ -262,24 +308,18 @@ int ExportFLAC::Export(AudacityProject *project,
    }
 
    // Duplicate the flac command line compression levels
-   if (levelPref < 0 || levelPref > 8) {
-      levelPref = 5;
-   }
-   encoder.set_do_exhaustive_model_search(flacLevels[levelPref].do_exhaustive_model_search);
-   encoder.set_do_escape_coding(flacLevels[levelPref].do_escape_coding);
-   if (numChannels != 2) {
-      encoder.set_do_mid_side_stereo(false);
-      encoder.set_loose_mid_side_stereo(false);
-   }
-   else {
-      encoder.set_do_mid_side_stereo(flacLevels[levelPref].do_mid_side_stereo);
-      encoder.set_loose_mid_side_stereo(flacLevels[levelPref].loose_mid_side_stereo);
+   SetCompressionLevel(encoder, numChannels, levelPref);
+
+#if defined(EXPERIMENTAL_PARALLEL_FLAC_EXPORT) && !defined(LEGACY_FLAC)
+   if (wxThread::GetCPUCount() > 1) {
+      int result = ExportSegments(project, numChannels, fName, selectionOnly,
+                                  t0, t1, mixerSpec, format, levelPref);
+      if (mMetadata) {
+         ::FLAC__metadata_object_delete(mMetadata);
+      }
+      return result;
    }
-   encoder.set_qlp_coeff_precision(flacLevels[levelPref].qlp_coeff_precision);
-   encoder.set_min_residual_partition_order(flacLevels[levelPref].min_residual_partition_order);
-   encoder.set_max_residual_partition_order(flacLevels[levelPref].max_residual_partition_order);
-   encoder.set_rice_parameter_search_dist(flacLevels[levelPref].rice_parameter_search_dist);
-   encoder.set_max_lpc_order(flacLevels[levelPref].max_lpc_order);
+#endif
 
 #ifdef LEGACY_FLAC
    encoder.init();
@@ -363,6 +403,299 @@ int ExportFLAC::Export(AudacityProject *project,
    return updateResult;
 }
 
+#if defined(EXPERIMENTAL_PARALLEL_FLAC_EXPORT) && !defined(LEGACY_FLAC)
+
+// Least frames of each segment; segments of a few seconds are long enough
+// that little time goes to starting encoders, and few are kept at once
+#define FLAC_FRAMES_PER_SEGMENT 64
+
+struct FLACSegmentJob
+{
+   FLACSegment *mSegment;
+   bool mDone;
+   bool mResult;
+};
+
+// The segments mixed and waiting for an encoder, in order
+class FLACSegmentQueue
+{
+public:
+   FLACSegmentQueue() : mStopped(false) {}
+
+   void Add(FLACSegmentJob *job)
+   {
+      mLock.Lock();
+      mWaiting.push_back(job);
+      mLock.Unlock();
+   }
+
+   /// The next segment to encode, or NULL when there will be no more
+   FLACSegmentJob *Next()
+   {
+      while (true) {
+         mLock.Lock();
+         if (!mWaiting.empty()) {
+            FLACSegmentJob *job = mWaiting.front();
+            mWaiting.pop_front();
+            mLock.Unlock();
+            return job;
+         }
+         bool stopped = mStopped;
+         mLock.Unlock();
+
+         if (stopped)
+            return NULL;
+         wxMilliSleep(5);
+      }
+   }
+
+   void Finish(FLACSegmentJob *job, bool result)
+   {
+      mLock.Lock();
+      job->mResult = result;
+      job->mDone = true;
+      mLock.Unlock();
+   }
+
+   bool IsDone(FLACSegmentJob *job)
+   {
+      mLock.Lock();
+      bool done = job->mDone;
+      mLock.Unlock();
+      return done;
+   }
+
+   void Stop()
+   {
+      mLock.Lock();
+      mStopped = true;
+      mLock.Unlock();
+   }
+
+private:
+   ODLock mLock;
+   std::deque<FLACSegmentJob *> mWaiting;
+   bool mStopped;
+};
+
+class FLACSegmentThread : public wxThread
+{
+public:
+   FLACSegmentThread():wxThread(wxTHREAD_JOINABLE)
+   {
+      mQueue = NULL;
+   }
+
+   void SetData(FLACSegmentQueue *queue)
+   {
+      mQueue = queue;
+   }
+
+   virtual void *Entry()
+   {
+      TRACE_THREAD_NAME("FLAC segments");
+      FLACSegmentJob *job;
+      while ((job = mQueue->Next()) != NULL) {
+         TRACE_SCOPE("FLAC segment");
+         mQueue->Finish(job, job->mSegment->Encode());
+      }
+      return NULL;
+   }
+
+private:
+   FLACSegmentQueue *mQueue;
+};
+
+// The mix is cut into segments of whole frames, each encoded on a worker
+// thread by an encoder of its own, while the next ones are mixed here.
+// FLACStitcher writes them, in order, as one stream.
+int ExportFLAC::ExportSegments(AudacityProject *project,
+                               int numChannels,
+                               wxString fName,
+                               bool selectionOnly,
+                               double t0,
+                               double t1,
+                               MixerSpec *mixerSpec,
+                               sampleFormat format,
+                               int level)
+{
+   double    rate    = project->GetRate();
+   TrackList *tracks = project->GetTracks();
+   unsigned bitsPerSample = (format == int24Sample) ? 24 : 16;
+   int updateResult = eProgressSuccess;
+
+   // The block size the serial encoder gets by default for the level, and
+   // segments that start where it would try both stereo assignments, so
+   // the frames are the ones it would make
+   if (level < 0 || level > 8) {
+      level = 5;
+   }
+   unsigned blockSize = FLACDefaultBlockSize(flacLevels[level].max_lpc_order);
+   unsigned framesPerSegment =
+      FLACFramesPerSegment(FLAC_FRAMES_PER_SEGMENT, lrint(rate), blockSize,
+                           numChannels == 2 &&
+                           flacLevels[level].loose_mid_side_stereo);
+
+   wxFFile f;     // will be closed when it goes out of scope
+   if (!f.Open(fName, wxT("w+b"))) {
+      wxMessageBox(wxString::Format(_("FLAC export couldn't open %s"), fName.c_str()));
+      return false;
+   }
+
+   // Placeholders in the seek table, for a point every ten seconds, which
+   // the stitcher fills in at the end
+   unsigned framesPerSeekPoint =
+      wxMax(1, (int)lrint(10.0 * rate / blockSize));
+   sampleCount totalFrames =
+      (sampleCount)((t1 - t0) * rate + 0.5) / blockSize + 1;
+   FLAC__StreamMetadata *metadata[2];
+   unsigned numMetadata = 0;
+   if (mMetadata) {
+      metadata[numMetadata++] = mMetadata;
+   }
+   FLAC__StreamMetadata *seekTable =
+      ::FLAC__metadata_object_new(FLAC__METADATA_TYPE_SEEKTABLE);
+   if (seekTable) {
+      ::FLAC__metadata_object_seektable_template_append_placeholders(seekTable,
+         (unsigned)(totalFrames / framesPerSeekPoint + 1));
+      metadata[numMetadata++] = seekTable;
+   }
+
+   int numWaveTracks;
+   WaveTrack **waveTracks;
+   tracks->GetWaveTracks(selectionOnly, &numWaveTracks, &waveTracks);
+   Mixer *mixer = CreateMixer(numWaveTracks, waveTracks,
+                            tracks->GetTimeTrack(),
+                            t0, t1,
+                            numChannels, SAMPLES_PER_RUN, false,
+                            rate, format, true, mixerSpec);
+   delete [] waveTracks;
+
+   ProgressDialog *progress = new ProgressDialog(wxFileName(fName).GetName(),
+         selectionOnly ?
+         _("Exporting the selected audio as FLAC") :
+         _("Exporting the entire project as FLAC"));
+
+   int numThreads = wxThread::GetCPUCount();
+   FLACSegmentQueue queue;
+   FLACSegmentThread *threads = new FLACSegmentThread[numThreads];
+   for (int t = 0; t < numThreads; t++) {
+      threads[t].SetData(&queue);
+      threads[t].Create();
+      threads[t].Run();
+   }
+
+   FLACStitcher stitcher(f, numChannels, bitsPerSample, framesPerSeekPoint);
+   const sampleCount segmentLen = (sampleCount)framesPerSegment * blockSize;
+   // Enough mixed ahead to keep the threads busy, but no more
+   const size_t maxInFlight = 2 * numThreads;
+   std::deque<FLACSegmentJob *> inFlight;
+   unsigned nextFrame = 0;
+   bool mixing = true;
+   bool written = true;
+
+   while (mixing || !inFlight.empty()) {
+      // Write the segments that are encoded, in order
+      while (!inFlight.empty() && queue.IsDone(inFlight.front())) {
+         FLACSegmentJob *job = inFlight.front();
+         inFlight.pop_front();
+         if (written && !(job->mResult && stitcher.Add(*job->mSegment))) {
+            written = false;
+         }
+         delete job->mSegment;
+         delete job;
+      }
+
+      if (!mixing || inFlight.size() >= maxInFlight) {
+         if (!inFlight.empty()) {
+            wxMilliSleep(5);
+         }
+         continue;
+      }
+
+      FLACSegment *segment =
+         new FLACSegment(nextFrame, numChannels, (unsigned)segmentLen);
+      segment->set_channels(numChannels);
+      segment->set_sample_rate(lrint(rate));
+      segment->set_bits_per_sample(bitsPerSample);
+      segment->set_blocksize(blockSize);
+      SetCompressionLevel(*segment, numChannels, level);
+      // Only the first segment writes the header of the stream
+      if (nextFrame == 0) {
+         segment->set_metadata(metadata, numMetadata);
+      }
+
+      FLAC__int32 **buffers = segment->GetBuffers();
+      sampleCount len = 0;
+      while (len < segmentLen && updateResult == eProgressSuccess) {
+         sampleCount samplesThisRun =
+            mixer->Process(wxMin((sampleCount)SAMPLES_PER_RUN, segmentLen - len));
+         if (samplesThisRun == 0) { //stop encoding
+            break;
+         }
+         for (int i = 0; i < numChannels; i++) {
+            samplePtr mixed = mixer->GetBuffer(i);
+            FLAC__int32 *buffer = buffers[i] + len;
+            if (format == int24Sample) {
+               for (sampleCount j = 0; j < samplesThisRun; j++) {
+                  buffer[j] = ((int *) mixed)[j];
+               }
+            }
+            else {
+               for (sampleCount j = 0; j < samplesThisRun; j++) {
+                  buffer[j] = ((short *) mixed)[j];
+               }
+            }
+         }
+         len += samplesThisRun;
+         updateResult = progress->Update(mixer->MixGetCurrentTime()-t0, t1-t0);
+      }
+
+      // A short segment is the last; the first is kept even if empty, for
+      // the header
+      if (len < segmentLen || updateResult != eProgressSuccess) {
+         mixing = false;
+      }
+      if (len == 0 && nextFrame > 0) {
+         delete segment;
+         continue;
+      }
+
+      segment->SetLength((unsigned)len);
+      stitcher.AddSamples(buffers, (unsigned)len);
+
+      FLACSegmentJob *job = new FLACSegmentJob;
+      job->mSegment = segment;
+      job->mDone = false;
+      job->mResult = false;
+      inFlight.push_back(job);
+      queue.Add(job);
+      nextFrame += framesPerSegment;
+   }
+
+   queue.Stop();
+   for (int t = 0; t < numThreads; t++) {
+      threads[t].Wait();
+   }
+   delete [] threads;
+
+   if (!(written && stitcher.Finish())) {
+      wxMessageBox(wxString::Format(_("FLAC export couldn't write %s"), fName.c_str()));
+      updateResult = eProgressFailed;
+   }
+
+   delete progress;
+   delete mixer;
+
+   if (seekTable) {
+      ::FLAC__metadata_object_delete(seekTable);
+   }
+
+   return updateResult;
+}
+
+#endif
+
 bool ExportFLAC::DisplayOptions(wxWindow *parent, int WXUNUSED(format))
 {
    ExportFLACOptions od(parent);
@@ -0,0 +1,484 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ExportFLACSegments.cpp
+
+*******************************************************************//**
+
+\class FLACSegment
+\brief Encodes one segment of a FLAC stream, on any thread, as frames
+numbered from the frame the segment starts at.
+
+\class FLACStitcher
+\brief Writes FLACSegment objects, in order, as one stream, with a
+STREAMINFO and a seek table for all of it.
+
+*//*******************************************************************/
+
+#include "ExportFLACSegments.h"
+
+#if defined(USE_LIBFLAC) && \
+    defined FLACPP_API_VERSION_CURRENT && FLACPP_API_VERSION_CURRENT >= 6
+
+#include <string.h>
+
+//----------------------------------------------------------------------------
+// The parts of the format that are rewritten
+//----------------------------------------------------------------------------
+
+// The header of the stream is "fLaC", then metadata blocks, each with a
+// header of a type and a length.  STREAMINFO comes first.
+static const size_t kStreamInfoOffset = 8;
+static const size_t kBlockHeaderLength = 4;
+static const size_t kSeekPointLength = 18;
+static const FLAC__byte kSeekTableType = 3;
+
+// CRC-8 (polynomial 0x07) of frame headers and CRC-16 (polynomial 0x8005)
+// of whole frames, both from zero, high bit first
+class FLACCRCTables
+{
+ public:
+   FLACCRCTables()
+   {
+      for (unsigned i = 0; i < 256; i++) {
+         unsigned crc8 = i;
+         unsigned crc16 = i << 8;
+         for (int bit = 0; bit < 8; bit++) {
+            crc8 = (crc8 & 0x80) ? ((crc8 << 1) ^ 0x07) : (crc8 << 1);
+            crc16 = (crc16 & 0x8000) ? ((crc16 << 1) ^ 0x8005) : (crc16 << 1);
+         }
+         mCRC8[i] = (FLAC__byte)crc8;
+         mCRC16[i] = (FLAC__uint16)crc16;
+      }
+   }
+
+   FLAC__byte CRC8(const FLAC__byte *data, size_t len) const
+   {
+      FLAC__byte crc = 0;
+      for (size_t i = 0; i < len; i++)
+         crc = mCRC8[crc ^ data[i]];
+      return crc;
+   }
+
+   FLAC__uint16 CRC16(const FLAC__byte *data, size_t len) const
+   {
+      FLAC__uint16 crc = 0;
+      for (size_t i = 0; i < len; i++)
+         crc = (FLAC__uint16)((crc << 8) ^ mCRC16[(crc >> 8) ^ data[i]]);
+      return crc;
+   }
+
+ private:
+   FLAC__byte mCRC8[256];
+   FLAC__uint16 mCRC16[256];
+};
+
+// Made before any thread can use them
+static const FLACCRCTables sCRCTables;
+
+// Frame numbers are coded like UTF-8 characters
+static size_t CodedNumberLength(FLAC__byte first)
+{
+   size_t len = 1;
+   while (len < 7 && (first & (0x80 >> (len - 1))))
+      len++;
+   return len == 1 ? 1 : len - 1;
+}
+
+static size_t CodeNumber(FLAC__uint32 value, FLAC__byte out[6])
+{
+   if (value < 0x80) {
+      out[0] = (FLAC__byte)value;
+      return 1;
+   }
+
+   size_t len;
+   if (value < 0x800)
+      len = 2;
+   else if (value < 0x10000)
+      len = 3;
+   else if (value < 0x200000)
+      len = 4;
+   else if (value < 0x4000000)
+      len = 5;
+   else
+      len = 6;
+
+   for (size_t i = len - 1; i > 0; i--) {
+      out[i] = (FLAC__byte)(0x80 | (value & 0x3f));
+      value >>= 6;
+   }
+   out[0] = (FLAC__byte)((0xff00 >> len) | value);
+   return len;
+}
+
+static void PutBigEndian(FLAC__byte *out, FLAC__uint64 value, int bytes)
+{
+   for (int i = bytes - 1; i >= 0; i--) {
+      out[i] = (FLAC__byte)(value & 0xff);
+      value >>= 8;
+   }
+}
+
+//----------------------------------------------------------------------------
+// Segment sizes
+//----------------------------------------------------------------------------
+
+unsigned FLACDefaultBlockSize(unsigned maxLpcOrder)
+{
+   // As init_stream_internal_() in stream_encoder.c
+   return maxLpcOrder == 0 ? 1152 : 4096;
+}
+
+unsigned FLACFramesPerSegment(unsigned minFrames, unsigned sampleRate,
+                              unsigned blockSize, bool looseMidSideStereo)
+{
+   if (!looseMidSideStereo)
+      return minFrames;
+
+   // The frames of each run, as loose_mid_side_stereo_frames in
+   // stream_encoder.c; the encoder tries both assignments at the first
+   unsigned run = (unsigned)((double)sampleRate * 0.4 / blockSize + 0.5);
+   if (run == 0)
+      run = 1;
+
+   return (minFrames + run - 1) / run * run;
+}
+
+//----------------------------------------------------------------------------
+// FLACSegment
+//----------------------------------------------------------------------------
+
+FLACSegment::FLACSegment(unsigned firstFrame, unsigned channels, unsigned length)
+:  mFirstFrame(firstFrame),
+   mChannels(channels),
+   mLength(length)
+{
+   mBuffers = new FLAC__int32*[mChannels];
+   for (unsigned i = 0; i < mChannels; i++)
+      mBuffers[i] = new FLAC__int32[length > 0 ? length : 1];
+}
+
+FLACSegment::~FLACSegment()
+{
+   for (unsigned i = 0; i < mChannels; i++)
+      delete [] mBuffers[i];
+   delete [] mBuffers;
+}
+
+bool FLACSegment::Encode()
+{
+   if (init() != FLAC__STREAM_ENCODER_INIT_STATUS_OK)
+      return false;
+
+   bool result = true;
+   if (mLength > 0)
+      result = process(mBuffers, mLength);
+
+   return finish() && result;
+}
+
+::FLAC__StreamEncoderWriteStatus FLACSegment::write_callback(
+   const FLAC__byte buffer[], size_t bytes,
+   unsigned samples, unsigned current_frame)
+{
+   if (samples == 0) {
+      // Metadata; only the header of the first segment is kept
+      if (mFirstFrame == 0 && mFrameSizes.empty())
+         mHeader.insert(mHeader.end(), buffer, buffer + bytes);
+      return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+   }
+
+   // Each frame comes whole.  Its header is the sync code and the coded
+   // frame number, with a block size and a sample rate after it for some
+   // codes, then a CRC-8; a CRC-16 of all of the frame ends it.
+   size_t numberLen = CodedNumberLength(buffer[4]);
+   size_t extraLen = 0;
+   unsigned blockSizeCode = buffer[2] >> 4;
+   unsigned rateCode = buffer[2] & 0x0f;
+   if (blockSizeCode == 6)
+      extraLen += 1;
+   else if (blockSizeCode == 7)
+      extraLen += 2;
+   if (rateCode == 12)
+      extraLen += 1;
+   else if (rateCode == 13 || rateCode == 14)
+      extraLen += 2;
+
+   size_t headerEnd = 4 + numberLen + extraLen;  // the CRC-8
+   if (headerEnd + 3 > bytes)
+      return FLAC__STREAM_ENCODER_WRITE_STATUS_FATAL_ERROR;
+
+   size_t start = mFrames.size();
+
+   FLAC__byte number[6];
+   size_t newNumberLen = CodeNumber(mFirstFrame + current_frame, number);
+
+   mFrames.insert(mFrames.end(), buffer, buffer + 4);
+   mFrames.insert(mFrames.end(), number, number + newNumberLen);
+   mFrames.insert(mFrames.end(), buffer + 4 + numberLen, buffer + headerEnd);
+   mFrames.push_back(sCRCTables.CRC8(&mFrames[start], mFrames.size() - start));
+
+   mFrames.insert(mFrames.end(), buffer + headerEnd + 1, buffer + bytes - 2);
+   FLAC__uint16 crc = sCRCTables.CRC16(&mFrames[start], mFrames.size() - start);
+   mFrames.push_back((FLAC__byte)(crc >> 8));
+   mFrames.push_back((FLAC__byte)(crc & 0xff));
+
+   mFrameSizes.push_back(mFrames.size() - start);
+
+   return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+}
+
+//----------------------------------------------------------------------------
+// FLACStitcher
+//----------------------------------------------------------------------------
+
+FLACStitcher::FLACStitcher(wxFFile &file, unsigned channels,
+                           unsigned bitsPerSample, unsigned framesPerSeekPoint)
+:  mFile(file),
+   mChannels(channels),
+   mBytesPerSample((bitsPerSample + 7) / 8),
+   mFramesPerSeekPoint(framesPerSeekPoint > 0 ? framesPerSeekPoint : 1),
+   mTotalSamples(0),
+   mFramesOffset(0),
+   mNumFrames(0),
+   mMinFrameSize(0),
+   mMaxFrameSize(0),
+   mNumSeekPoints(0),
+   mMD5Bytes(0)
+{
+   mMD5State[0] = 0x67452301;
+   mMD5State[1] = 0xefcdab89;
+   mMD5State[2] = 0x98badcfe;
+   mMD5State[3] = 0x10325476;
+}
+
+void FLACStitcher::AddSamples(FLAC__int32 *const buffers[], unsigned samples)
+{
+   // Interleaved, each sample little-endian in as few bytes as it needs
+   mMD5Buffer.resize((size_t)samples * mChannels * mBytesPerSample);
+   FLAC__byte *out = mMD5Buffer.empty() ? NULL : &mMD5Buffer[0];
+   for (unsigned i = 0; i < samples; i++) {
+      for (unsigned c = 0; c < mChannels; c++) {
+         FLAC__uint32 value = (FLAC__uint32)buffers[c][i];
+         for (unsigned b = 0; b < mBytesPerSample; b++) {
+            *out++ = (FLAC__byte)(value & 0xff);
+            value >>= 8;
+         }
+      }
+   }
+   if (!mMD5Buffer.empty())
+      MD5Update(&mMD5Buffer[0], mMD5Buffer.size());
+}
+
+bool FLACStitcher::Add(const FLACSegment &segment)
+{
+   if (mHeader.empty()) {
+      mHeader = segment.GetHeader();
+      if (mHeader.size() < kStreamInfoOffset + 34)
+         return false;
+
+      // The seek table, if any, is where its placeholders are
+      size_t pos = 4;
+      while (pos + kBlockHeaderLength <= mHeader.size()) {
+         size_t len = (mHeader[pos + 1] << 16) | (mHeader[pos + 2] << 8) |
+                      mHeader[pos + 3];
+         if ((mHeader[pos] & 0x7f) == kSeekTableType) {
+            mSeekPoints.assign(mHeader.begin() + pos + kBlockHeaderLength,
+                               mHeader.begin() + pos + kBlockHeaderLength + len);
+            break;
+         }
+         if (mHeader[pos] & 0x80)
+            break;
+         pos += kBlockHeaderLength + len;
+      }
+
+      if (!mFile.Write(&mHeader[0], mHeader.size()))
+         return false;
+   }
+
+   unsigned blockSize = (mHeader[kStreamInfoOffset] << 8) |
+                        mHeader[kStreamInfoOffset + 1];
+
+   const std::vector<unsigned> &sizes = segment.GetFrameSizes();
+   for (size_t i = 0; i < sizes.size(); i++) {
+      if (mNumFrames % mFramesPerSeekPoint == 0) {
+         unsigned frameSamples = blockSize;
+         if ((i + 1) * blockSize > segment.GetLength())
+            frameSamples = segment.GetLength() - i * blockSize;
+         AddSeekPoint(mTotalSamples + (FLAC__uint64)i * blockSize,
+                      mFramesOffset, frameSamples);
+      }
+
+      if (mNumFrames == 0 || sizes[i] < mMinFrameSize)
+         mMinFrameSize = sizes[i];
+      if (sizes[i] > mMaxFrameSize)
+         mMaxFrameSize = sizes[i];
+      mFramesOffset += sizes[i];
+      mNumFrames++;
+   }
+   mTotalSamples += segment.GetLength();
+
+   const std::vector<FLAC__byte> &frames = segment.GetFrames();
+   if (frames.empty())
+      return true;
+   return mFile.Write(&frames[0], frames.size()) == frames.size();
+}
+
+void FLACStitcher::AddSeekPoint(FLAC__uint64 sample, FLAC__uint64 offset,
+                                unsigned frameSamples)
+{
+   // Points that don't fit stay out
+   if ((mNumSeekPoints + 1) * kSeekPointLength > mSeekPoints.size())
+      return;
+
+   FLAC__byte *point = &mSeekPoints[mNumSeekPoints * kSeekPointLength];
+   PutBigEndian(point, sample, 8);
+   PutBigEndian(point + 8, offset, 8);
+   PutBigEndian(point + 16, frameSamples, 2);
+   mNumSeekPoints++;
+}
+
+bool FLACStitcher::Finish()
+{
+   if (mHeader.empty())
+      return false;
+
+   FLAC__byte *info = &mHeader[kStreamInfoOffset];
+   PutBigEndian(info + 4, mMinFrameSize, 3);
+   PutBigEndian(info + 7, mMaxFrameSize, 3);
+   info[13] = (FLAC__byte)((info[13] & 0xf0) | ((mTotalSamples >> 32) & 0x0f));
+   PutBigEndian(info + 14, mTotalSamples & 0xffffffff, 4);
+   MD5Final(info + 18);
+
+   // Put back the points in the header, after the block header of the
+   // seek table
+   if (!mSeekPoints.empty()) {
+      size_t pos = 4;
+      while (pos + kBlockHeaderLength <= mHeader.size()) {
+         size_t len = (mHeader[pos + 1] << 16) | (mHeader[pos + 2] << 8) |
+                      mHeader[pos + 3];
+         if ((mHeader[pos] & 0x7f) == kSeekTableType) {
+            memcpy(&mHeader[pos + kBlockHeaderLength], &mSeekPoints[0], len);
+            break;
+         }
+         pos += kBlockHeaderLength + len;
+      }
+   }
+
+   return mFile.Seek(0) &&
+          mFile.Write(&mHeader[0], mHeader.size()) == mHeader.size();
+}
+
+//----------------------------------------------------------------------------
+// MD5, from RFC 1321
+//----------------------------------------------------------------------------
+
+static const FLAC__uint32 kMD5Sines[64] = {
+   0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a,
+   0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+   0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340,
+   0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+   0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+   0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+   0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+   0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+   0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92,
+   0xffeff47d, 0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+   0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+static const int kMD5Shifts[64] = {
+   7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+   5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+   4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+   6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+};
+
+static void MD5Transform(FLAC__uint32 state[4], const FLAC__byte block[64])
+{
+   FLAC__uint32 m[16];
+   for (int i = 0; i < 16; i++)
+      m[i] = block[i * 4] | (block[i * 4 + 1] << 8) |
+             (block[i * 4 + 2] << 16) | ((FLAC__uint32)block[i * 4 + 3] << 24);
+
+   FLAC__uint32 a = state[0], b = state[1], c = state[2], d = state[3];
+   for (int i = 0; i < 64; i++) {
+      FLAC__uint32 f;
+      int g;
+      if (i < 16) {
+         f = (b & c) | (~b & d);
+         g = i;
+      }
+      else if (i < 32) {
+         f = (d & b) | (~d & c);
+         g = (5 * i + 1) % 16;
+      }
+      else if (i < 48) {
+         f = b ^ c ^ d;
+         g = (3 * i + 5) % 16;
+      }
+      else {
+         f = c ^ (b | ~d);
+         g = (7 * i) % 16;
+      }
+      FLAC__uint32 t = a + f + kMD5Sines[i] + m[g];
+      a = d;
+      d = c;
+      c = b;
+      b = b + ((t << kMD5Shifts[i]) | (t >> (32 - kMD5Shifts[i])));
+   }
+
+   state[0] += a;
+   state[1] += b;
+   state[2] += c;
+   state[3] += d;
+}
+
+void FLACStitcher::MD5Update(const FLAC__byte *data, size_t len)
+{
+   size_t used = (size_t)(mMD5Bytes % 64);
+   mMD5Bytes += len;
+
+   if (used > 0) {
+      size_t take = 64 - used < len ? 64 - used : len;
+      memcpy(mMD5Block + used, data, take);
+      data += take;
+      len -= take;
+      if (used + take < 64)
+         return;
+      MD5Transform(mMD5State, mMD5Block);
+   }
+
+   while (len >= 64) {
+      MD5Transform(mMD5State, data);
+      data += 64;
+      len -= 64;
+   }
+
+   memcpy(mMD5Block, data, len);
+}
+
+void FLACStitcher::MD5Final(FLAC__byte digest[16])
+{
+   FLAC__uint64 bits = mMD5Bytes * 8;
+
+   FLAC__byte padding[72];
+   size_t used = (size_t)(mMD5Bytes % 64);
+   size_t padLen = (used < 56 ? 56 : 120) - used;
+   memset(padding, 0, sizeof(padding));
+   padding[0] = 0x80;
+   MD5Update(padding, padLen);
+
+   FLAC__byte length[8];
+   for (int i = 0; i < 8; i++)
+      length[i] = (FLAC__byte)(bits >> (8 * i));
+   MD5Update(length, 8);
+
+   for (int i = 0; i < 4; i++)
+      for (int b = 0; b < 4; b++)
+         digest[i * 4 + b] = (FLAC__byte)(mMD5State[i] >> (8 * b));
+}
+
+#endif
@@ -0,0 +1,143 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ExportFLACSegments.h
+
+*******************************************************************//**
+
+\class FLACSegment
+\brief Encodes one segment of a FLAC stream, on any thread, as frames
+numbered from the frame the segment starts at.
+
+\class FLACStitcher
+\brief Writes FLACSegment objects, in order, as one stream, with a
+STREAMINFO and a seek table for all of it.
+
+  FLAC frames can be decoded on their own, so a long export is cut into
+  segments of a whole number of frames, and each is encoded by an
+  encoder of its own.  Each encoder numbers its frames from zero, so
+  FLACSegment puts the right numbers in the frame headers as they come,
+  with new CRCs.  The first segment also keeps the header of the stream,
+  which FLACStitcher writes first and fills in at the end.  It sets the
+  frame sizes, the number of samples and the MD5 of the whole stream, and
+  the seek points, which the first segment wrote as placeholders.
+
+  Only the last segment may end in a short frame, as in any stream of
+  frames of one size.
+
+  The frames are those a single encoder would make of the whole stream,
+  given the same block size, if the segments start where it keeps no
+  state from the frames before.  The only such state is that of loose
+  mid-side stereo, which tries both channel assignments again every so
+  many frames, so a segment is a whole number of those runs.
+
+*//*******************************************************************/
+
+#ifndef __AUDACITY_EXPORT_FLAC_SEGMENTS__
+#define __AUDACITY_EXPORT_FLAC_SEGMENTS__
+
+#include "../Audacity.h"
+
+#ifdef USE_LIBFLAC
+
+#include <vector>
+
+#include <wx/ffile.h>
+
+#include "FLAC++/encoder.h"
+
+#if defined FLACPP_API_VERSION_CURRENT && FLACPP_API_VERSION_CURRENT >= 6
+
+/// The block size libFLAC uses when none is set
+unsigned FLACDefaultBlockSize(unsigned maxLpcOrder);
+
+/// Frames of a segment: at least minFrames, and a whole number of the runs
+/// of frames of loose mid-side stereo, if it is on
+unsigned FLACFramesPerSegment(unsigned minFrames, unsigned sampleRate,
+                              unsigned blockSize, bool looseMidSideStereo);
+
+class FLACSegment : public FLAC::Encoder::Stream
+{
+ public:
+   /// Buffers for length samples of each channel are made here; the
+   /// encoder is set up by the caller before Encode()
+   FLACSegment(unsigned firstFrame, unsigned channels, unsigned length);
+   virtual ~FLACSegment();
+
+   FLAC__int32 **GetBuffers() { return mBuffers; }
+   unsigned GetLength() const { return mLength; }
+   /// Fewer samples than there is room for, for the last segment
+   void SetLength(unsigned length) { mLength = length; }
+
+   bool Encode();
+
+   /// The header of the stream, kept only by the segment starting at the
+   /// first frame
+   const std::vector<FLAC__byte> &GetHeader() const { return mHeader; }
+   const std::vector<FLAC__byte> &GetFrames() const { return mFrames; }
+   const std::vector<unsigned> &GetFrameSizes() const { return mFrameSizes; }
+
+ protected:
+   virtual ::FLAC__StreamEncoderWriteStatus write_callback(
+      const FLAC__byte buffer[], size_t bytes,
+      unsigned samples, unsigned current_frame);
+
+ private:
+   unsigned mFirstFrame;
+   unsigned mChannels;
+   unsigned mLength;
+   FLAC__int32 **mBuffers;
+
+   std::vector<FLAC__byte> mHeader;
+   std::vector<FLAC__byte> mFrames;
+   std::vector<unsigned> mFrameSizes;
+};
+
+class FLACStitcher
+{
+ public:
+   /// framesPerSeekPoint is how many frames apart the seek points are
+   FLACStitcher(wxFFile &file, unsigned channels, unsigned bitsPerSample,
+                unsigned framesPerSeekPoint);
+
+   /// The samples of the stream, in order, for its MD5
+   void AddSamples(FLAC__int32 *const buffers[], unsigned samples);
+   /// Writes the next segment
+   bool Add(const FLACSegment &segment);
+   /// Fills in the header of the stream
+   bool Finish();
+
+ private:
+   void AddSeekPoint(FLAC__uint64 sample, FLAC__uint64 offset,
+                     unsigned frameSamples);
+
+   wxFFile &mFile;
+   unsigned mChannels;
+   unsigned mBytesPerSample;
+   unsigned mFramesPerSeekPoint;
+
+   std::vector<FLAC__byte> mHeader;
+   FLAC__uint64 mTotalSamples;
+   FLAC__uint64 mFramesOffset;   // bytes of frames written so far
+   unsigned mNumFrames;
+   unsigned mMinFrameSize;
+   unsigned mMaxFrameSize;
+
+   std::vector<FLAC__byte> mSeekPoints;  // as in the SEEKTABLE block
+   unsigned mNumSeekPoints;
+
+   // MD5 of the samples, as libFLAC computes it
+   FLAC__uint32 mMD5State[4];
+   FLAC__uint64 mMD5Bytes;
+   FLAC__byte mMD5Block[64];
+   std::vector<FLAC__byte> mMD5Buffer;
+   void MD5Update(const FLAC__byte *data, size_t len);
+   void MD5Final(FLAC__byte digest[16]);
+};
+
+#endif
+
+#endif // USE_LIBFLAC
+
+#endif
@@ -42,6 +42,8 @@ and ImportLOF.cpp.
 #include <wx/log.h>
 #include <wx/sizer.h>         //for wxBoxSizer
 #include <wx/arrimpl.cpp>
+#include <wx/thread.h>
+#include <wx/utils.h>
 #include <wx/listimpl.cpp>
 #include "../ShuttleGui.h"
 #include "../Audacity.h"
@@ -59,6 +61,7 @@ and ImportLOF.cpp.
 #include "ImportFFmpeg.h"
 #include "ImportGStreamer.h"
 #include "../Track.h"
+#include "../Tags.h"
 #include "../Prefs.h"
 
 WX_DEFINE_LIST(ImportPluginList);
@@ -349,28 +352,13 @@ ExtImportItem *Importer::CreateDefaultImportItem()
    return new_item;
 }
 
-// returns number of tracks imported
-int Importer::Import(wxString fName,
-                     TrackFactory *trackFactory,
-                     Track *** tracks,
-                     Tags *tags,
-                     wxString &errorMessage)
+// Fills importPlugins with the plugins to try for fName, in the order they
+// should be tried
+void Importer::GetPluginsForFile(const wxString &fName, ImportPluginList &importPlugins)
 {
-   AudacityProject *pProj = GetActiveProject();
-   pProj->mbBusyImporting = true;
-
-   ImportFileHandle *inFile = NULL;
-   int numTracks = 0;
-
    wxString extension = fName.AfterLast(wxT('.'));
-
-   // This list is used to call plugins in correct order
-   ImportPluginList importPlugins;
    ImportPluginList::compatibility_iterator importPluginNode;
 
-   // This list is used to remember plugins that should have been compatible with the file.
-   ImportPluginList compatiblePlugins;
-
    // If user explicitly selected a filter,
    // then we should try importing via corresponding plugin first
    wxString type = gPrefs->Read(wxT("/LastOpenType"),wxT(""));
@@ -523,6 +511,31 @@ int Importer::Import(wxString fName,
 
       importPluginNode = importPluginNode->GetNext();
    }
+}
+
+// returns number of tracks imported
+int Importer::Import(wxString fName,
+                     TrackFactory *trackFactory,
+                     Track *** tracks,
+                     Tags *tags,
+                     wxString &errorMessage)
+{
+   AudacityProject *pProj = GetActiveProject();
+   pProj->mbBusyImporting = true;
+
+   ImportFileHandle *inFile = NULL;
+   int numTracks = 0;
+
+   wxString extension = fName.AfterLast(wxT('.'));
+
+   // This list is used to call plugins in correct order
+   ImportPluginList importPlugins;
+   ImportPluginList::compatibility_iterator importPluginNode;
+
+   // This list is used to remember plugins that should have been compatible with the file.
+   ImportPluginList compatiblePlugins;
+
+   GetPluginsForFile(fName, importPlugins);
 
    importPluginNode = importPlugins.GetFirst();
    while(importPluginNode)
@@ -727,6 +740,222 @@ int Importer::Import(wxString fName,
    return 0;
 }
 
+//-------------------------------------------------------------------------
+// Parallel import
+//-------------------------------------------------------------------------
+
+ImportJob::ImportJob(const wxString &_fileName, ImportFileHandle *_handle, Tags *_tags):
+   fileName(_fileName),
+   handle(_handle),
+   tags(_tags),
+   tracks(NULL),
+   numTracks(0),
+   result(eProgressFailed),
+   progress(NULL),
+   done(false)
+{
+}
+
+ImportJob::~ImportJob()
+{
+   if (handle)
+      delete handle;
+   delete tags;
+}
+
+/// Hands out the jobs of a parallel import to the workers, in order.
+class ImportJobQueue
+{
+public:
+   ImportJobQueue(ImportJobArray &jobs):
+      mJobs(jobs),
+      mNext(0),
+      mNumDone(0),
+      mStopResult(eProgressSuccess)
+   {
+   }
+
+   // Returns the next job to import, or NULL when there are none left
+   ImportJob *Next()
+   {
+      ImportJob *job = NULL;
+      mLock.Lock();
+      while (mNext < mJobs.GetCount()) {
+         job = mJobs[mNext++];
+         if (mStopResult == eProgressSuccess)
+            break;
+         // The user has cancelled or stopped, don't start any more files
+         job->result = mStopResult;
+         job->done = true;
+         mNumDone++;
+         job = NULL;
+      }
+      mLock.Unlock();
+      return job;
+   }
+
+   void Finish(ImportJob *job)
+   {
+      mLock.Lock();
+      job->done = true;
+      mNumDone++;
+      mLock.Unlock();
+   }
+
+   void Stop(int result)
+   {
+      mLock.Lock();
+      mStopResult = result;
+      for (size_t i = 0; i < mJobs.GetCount(); i++)
+         mJobs[i]->progress->SetResult(result);
+      mLock.Unlock();
+   }
+
+   // Progress of all the jobs, in the range [0,1000]
+   int GetValue()
+   {
+      int total = 0;
+      mLock.Lock();
+      for (size_t i = 0; i < mJobs.GetCount(); i++)
+         total += mJobs[i]->done ? 1000 : mJobs[i]->progress->GetValue();
+      mLock.Unlock();
+      return total / (int)mJobs.GetCount();
+   }
+
+   bool IsDone()
+   {
+      mLock.Lock();
+      bool done = (mNumDone == mJobs.GetCount());
+      mLock.Unlock();
+      return done;
+   }
+
+private:
+   ImportJobArray &mJobs;
+   size_t mNext;
+   size_t mNumDone;
+   int mStopResult;
+   ODLock mLock;
+};
+
+class ImportWorker : public wxThread
+{
+public:
+   ImportWorker():wxThread(wxTHREAD_JOINABLE)
+   {
+      mQueue = NULL;
+      mTrackFactory = NULL;
+   }
+
+   void SetData(ImportJobQueue *queue, TrackFactory *trackFactory)
+   {
+      mQueue = queue;
+      mTrackFactory = trackFactory;
+   }
+
+   virtual void *Entry()
+   {
+      ImportJob *job;
+      while ((job = mQueue->Next()) != NULL) {
+         job->result = job->handle->Import(mTrackFactory, &job->tracks,
+                                           &job->numTracks, job->tags);
+         mQueue->Finish(job);
+      }
+      return NULL;
+   }
+
+private:
+   ImportJobQueue *mQueue;
+   TrackFactory *mTrackFactory;
+};
+
+ImportFileHandle *Importer::OpenForParallelImport(wxString fName)
+{
+   ImportPluginList importPlugins;
+   GetPluginsForFile(fName, importPlugins);
+
+   ImportPluginList::compatibility_iterator importPluginNode = importPlugins.GetFirst();
+   while(importPluginNode)
+   {
+      ImportPlugin *plugin = importPluginNode->GetData();
+      ImportFileHandle *inFile = plugin->Open(fName);
+      if ( (inFile != NULL) && (inFile->GetStreamCount() > 0) )
+      {
+         // This is the plugin Import() would use.  Anything it might
+         // need to ask the user has to be done by Import().
+         if (inFile->GetStreamCount() == 1 && inFile->SupportsParallelImport())
+         {
+            wxLogMessage(wxT("Open(%s) with %s for parallel import"),
+                         fName.c_str(), plugin->GetPluginStringID().c_str());
+            inFile->SetStreamUsage(0, true);
+            return inFile;
+         }
+         delete inFile;
+         return NULL;
+      }
+      if (inFile)
+         delete inFile;
+      importPluginNode = importPluginNode->GetNext();
+   }
+
+   return NULL;
+}
+
+int Importer::ImportParallel(TrackFactory *trackFactory, ImportJobArray &jobs)
+{
+   if (jobs.GetCount() == 0)
+      return eProgressSuccess;
+
+   AudacityProject *pProj = GetActiveProject();
+   pProj->mbBusyImporting = true;
+
+   for (size_t i = 0; i < jobs.GetCount(); i++) {
+      jobs[i]->progress = new ImportProgress();
+      jobs[i]->handle->SetProgress(jobs[i]->progress);
+   }
+
+   ImportJobQueue queue(jobs);
+
+   int numThreads = wxThread::GetCPUCount();
+   if (numThreads < 1)
+      numThreads = 1;
+   if (numThreads > (int)jobs.GetCount())
+      numThreads = jobs.GetCount();
+
+   ImportWorker *workers = new ImportWorker[numThreads];
+   for (int i = 0; i < numThreads; i++) {
+      workers[i].SetData(&queue, trackFactory);
+      workers[i].Create();
+      workers[i].Run();
+   }
+
+   ProgressDialog progress(_("Import"),
+                           wxString::Format(_("Importing %d files"), (int)jobs.GetCount()));
+   int updateResult = eProgressSuccess;
+   while (!queue.IsDone()) {
+      if (updateResult == eProgressSuccess) {
+         updateResult = progress.Update(queue.GetValue());
+         if (updateResult != eProgressSuccess)
+            queue.Stop(updateResult);
+      }
+      wxMilliSleep(50);
+   }
+
+   for (int i = 0; i < numThreads; i++)
+      workers[i].Wait();
+   delete [] workers;
+
+   // The handles own the progress, and may hold the files open
+   for (size_t i = 0; i < jobs.GetCount(); i++) {
+      delete jobs[i]->handle;
+      jobs[i]->handle = NULL;
+      jobs[i]->progress = NULL;
+   }
+
+   pProj->mbBusyImporting = false;
+   return updateResult;
+}
+
 //-------------------------------------------------------------------------
 // ImportStreamDialog
 //-------------------------------------------------------------------------
@@ -86,6 +86,32 @@ class ExtImportItem
 
 class ImportPluginList;
 class UnusableImportPluginList;
+class ImportProgress;
+
+/**
+ * One file of a parallel import, see Importer::ImportParallel()
+ */
+class ImportJob
+{
+  public:
+  ImportJob(const wxString &_fileName, ImportFileHandle *_handle, Tags *_tags);
+  ~ImportJob();
+
+  wxString fileName;
+  /// From Importer::OpenForParallelImport(), deleted once imported
+  ImportFileHandle *handle;
+  /// Filled in by the importer; owned by the job
+  Tags *tags;
+  /// The result of the import, as for Importer::Import()
+  Track **tracks;
+  int numTracks;
+  int result;
+
+  ImportProgress *progress;
+  bool done;
+};
+
+WX_DEFINE_ARRAY_PTR(ImportJob *, ImportJobArray);
 
 class Importer {
 public:
@@ -146,7 +172,27 @@ public:
               Tags *tags,
               wxString &errorMessage);
 
+   /**
+    * Probes fName with the plugins in the same order as Import().
+    * If the plugin that opens it can import it on a worker thread
+    * (and there is only one stream, so there is nothing to ask),
+    * returns the open file.  Otherwise returns NULL, and the file
+    * should be imported with Import().
+    */
+   ImportFileHandle *OpenForParallelImport(wxString fName);
+
+   /**
+    * Imports the files of @jobs on a pool of worker threads, showing
+    * one progress dialog for all of them.  Must be called from the
+    * main thread.  Returns eProgressCancelled or eProgressStopped if
+    * the user pressed that button, eProgressSuccess otherwise; the
+    * files which were imported have their tracks in their job.
+    */
+   int ImportParallel(TrackFactory *trackFactory, ImportJobArray &jobs);
+
 private:
+   void GetPluginsForFile(const wxString &fName, ImportPluginList &importPlugins);
+
    static Importer mInstance;
 
    ExtImportItems *mExtImportItems;
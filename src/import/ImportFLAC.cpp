@@ -162,6 +162,8 @@ public:
 
    void SetStreamUsage(wxInt32 WXUNUSED(StreamID), bool WXUNUSED(Use)){}
 
+   bool SupportsParallelImport(){ return true; }
+
 private:
    sampleFormat          mFormat;
    MyFLACFile           *mFile;
@@ -84,6 +84,8 @@ extern "C" {
 }
 
 #include "../WaveTrack.h"
+#include "../ondemand/ODDecodeMP3Task.h"
+#include "../ondemand/ODManager.h"
 
 #define INPUT_BUFFER_SIZE 65535
 #define PROGRESS_SCALING_FACTOR 100000
@@ -96,7 +98,7 @@ struct private_data {
    unsigned char *inputBuffer;
    TrackFactory *trackFactory;
    WaveTrack **channels;
-   ProgressDialog *progress;
+   ImportProgress *progress;
    int numChannels;
    int updateResult;
    bool id3checked;
@@ -139,8 +141,14 @@ public:
 
    void SetStreamUsage(wxInt32 WXUNUSED(StreamID), bool WXUNUSED(Use)){}
 
+   bool SupportsParallelImport(){ return true; }
+
 private:
    void ImportID3(Tags *tags);
+#ifdef EXPERIMENTAL_OD_MP3
+   bool ImportOD(TrackFactory *trackFactory, Track ***outTracks,
+                 int *outNumTracks, int *result);
+#endif
 
    wxFile *mFile;
    void *mUserData;
@@ -209,6 +217,15 @@ int MP3ImportFileHandle::Import(TrackFactory *trackFactory, Track ***outTracks,
 
    CreateProgress();
 
+#ifdef EXPERIMENTAL_OD_MP3
+   int odResult;
+   if (ImportOD(trackFactory, outTracks, outNumTracks, &odResult)) {
+      if (odResult == eProgressSuccess || odResult == eProgressStopped)
+         ImportID3(tags);
+      return odResult;
+   }
+#endif
+
    /* Prepare decoder data, initialize decoder */
 
    mPrivateData.file        = mFile;
@@ -265,6 +282,83 @@ int MP3ImportFileHandle::Import(TrackFactory *trackFactory, Track ***outTracks,
       return mPrivateData.updateResult;
    }
 
+#ifdef EXPERIMENTAL_OD_MP3
+/// Creates tracks of ODDecodeBlockFiles from the seek index of a header scan,
+/// so no audio is decoded here.  Returns false if the file could not be
+/// indexed, in which case it should be decoded in full.
+bool MP3ImportFileHandle::ImportOD(TrackFactory *trackFactory, Track ***outTracks,
+                                   int *outNumTracks, int *result)
+{
+   ODDecodeMP3Task *task = new ODDecodeMP3Task;
+   ODMP3Decoder *decoder = (ODMP3Decoder *)task->CreateFileDecoder(mFilename);
+   if (!decoder->ReadHeader()) {
+      delete decoder;
+      delete task;
+      return false;
+   }
+
+   int numChannels = decoder->GetNumChannels();
+   sampleCount numSamples = decoder->GetNumSamples();
+   sampleFormat format = (sampleFormat) gPrefs->
+      Read(wxT("/SamplingRate/DefaultProjectSampleFormat"), floatSample);
+
+   WaveTrack **channels = new WaveTrack *[numChannels];
+   int chn;
+   for (chn = 0; chn < numChannels; chn++) {
+      channels[chn] = trackFactory->NewWaveTrack(format, decoder->GetSampleRate());
+      channels[chn]->SetChannel(Track::MonoChannel);
+   }
+
+   /* special case: 2 channels is understood to be stereo */
+   if (numChannels == 2) {
+      channels[0]->SetChannel(Track::LeftChannel);
+      channels[1]->SetChannel(Track::RightChannel);
+      channels[0]->SetLinked(true);
+   }
+
+   int updateResult = eProgressSuccess;
+   sampleCount maxBlockSize = channels[0]->GetMaxBlockSize();
+   for (sampleCount i = 0; i < numSamples; i += maxBlockSize) {
+      sampleCount blockLen = maxBlockSize;
+      if (i + blockLen > numSamples)
+         blockLen = numSamples - i;
+
+      for (chn = 0; chn < numChannels; chn++)
+         channels[chn]->AppendCoded(mFilename, i, blockLen, chn, ODTask::eODMP3);
+
+      updateResult = mProgress->Update((wxULongLong_t)i, (wxULongLong_t)numSamples);
+      if (updateResult != eProgressSuccess)
+         break;
+   }
+
+   if (updateResult == eProgressFailed || updateResult == eProgressCancelled) {
+      for (chn = 0; chn < numChannels; chn++)
+         delete channels[chn];
+      delete[] channels;
+      delete decoder;
+      delete task;
+
+      *result = updateResult;
+      return true;
+   }
+
+   //the decoder already has its seek index, so the task gets it with the tracks.
+   *outNumTracks = numChannels;
+   *outTracks = new Track *[numChannels];
+   for (chn = 0; chn < numChannels; chn++) {
+      channels[chn]->Flush();
+      task->AddWaveTrack(channels[chn]);
+      (*outTracks)[chn] = channels[chn];
+   }
+   delete[] channels;
+
+   ODManager::Instance()->AddNewTask(task);
+
+   *result = updateResult;
+   return true;
+}
+#endif
+
 MP3ImportFileHandle::~MP3ImportFileHandle()
 {
    if(mFile) {
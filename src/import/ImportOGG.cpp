@@ -76,6 +76,9 @@ void GetOGGImportPlugin(ImportPluginList *importPluginList,
 #include <vorbis/vorbisfile.h>
 
 #include "../WaveTrack.h"
+#include "../ondemand/ODDecodeOggTask.h"
+#include "../ondemand/ODManager.h"
+#include "../Prefs.h"
 #include "ImportPlugin.h"
 
 class OggImportPlugin : public ImportPlugin
@@ -144,7 +147,18 @@ public:
       }
    }
 
+   bool SupportsParallelImport()
+   {
+      return true;
+   }
+
 private:
+   void ImportComments(Tags *tags);
+#ifdef EXPERIMENTAL_OD_OGG
+   bool ImportOD(TrackFactory *trackFactory, Track ***outTracks,
+                 int *outNumTracks, int *result);
+#endif
+
    wxFFile        *mFile;
    OggVorbis_File *mVorbisFile;
 
@@ -227,6 +241,15 @@ int OggImportFileHandle::Import(TrackFactory *trackFactory, Track ***outTracks,
 
    CreateProgress();
 
+#ifdef EXPERIMENTAL_OD_OGG
+   int odResult;
+   if (ImportOD(trackFactory, outTracks, outNumTracks, &odResult)) {
+      if (odResult == eProgressSuccess || odResult == eProgressStopped)
+         ImportComments(tags);
+      return odResult;
+   }
+#endif
+
    //Number of streams used may be less than mVorbisFile->links,
    //but this way bitstream matches array index.
    mChannels = new WaveTrack **[mVorbisFile->links];
@@ -390,10 +413,17 @@ int OggImportFileHandle::Import(TrackFactory *trackFactory, Track ***outTracks,
    }
    delete[] mChannels;
 
+   ImportComments(tags);
+
+   return res;
+}
+
+void OggImportFileHandle::ImportComments(Tags *tags)
+{
    //\todo { Extract comments from each stream? }
    if (mVorbisFile->vc[0].comments > 0) {
       tags->Clear();
-      for (c = 0; c < mVorbisFile->vc[0].comments; c++) {
+      for (int c = 0; c < mVorbisFile->vc[0].comments; c++) {
          wxString comment = UTF8CTOWX(mVorbisFile->vc[0].user_comments[c]);
          wxString name = comment.BeforeFirst(wxT('='));
          wxString value = comment.AfterFirst(wxT('='));
@@ -406,9 +436,102 @@ int OggImportFileHandle::Import(TrackFactory *trackFactory, Track ***outTracks,
          tags->SetTag(name, value);
       }
    }
+}
 
-   return res;
+#ifdef EXPERIMENTAL_OD_OGG
+/// Creates tracks of ODDecodeBlockFiles, so no audio is decoded here.
+/// Returns false for chained files or if only some streams are wanted,
+/// in which case the file should be decoded in full.
+bool OggImportFileHandle::ImportOD(TrackFactory *trackFactory, Track ***outTracks,
+                                   int *outNumTracks, int *result)
+{
+   if (mVorbisFile->links != 1 || mStreamUsage[0] == 0)
+      return false;
+
+   ODDecodeOggTask *task = new ODDecodeOggTask;
+   ODOggDecoder *decoder = (ODOggDecoder *)task->CreateFileDecoder(mFilename);
+   if (!decoder->ReadHeader()) {
+      delete decoder;
+      delete task;
+      return false;
+   }
+
+   int numChannels = decoder->GetNumChannels();
+   sampleCount numSamples = decoder->GetNumSamples();
+   sampleFormat format = (sampleFormat)
+      gPrefs->Read(wxT("/SamplingRate/DefaultProjectSampleFormat"), floatSample);
+
+   WaveTrack **channels = new WaveTrack *[numChannels];
+   int c;
+   for (c = 0; c < numChannels; c++) {
+      channels[c] = trackFactory->NewWaveTrack(format, decoder->GetSampleRate());
+
+      if (numChannels == 2) {
+         switch (c) {
+         case 0:
+            channels[c]->SetChannel(Track::LeftChannel);
+            channels[c]->SetLinked(true);
+            break;
+         case 1:
+            channels[c]->SetChannel(Track::RightChannel);
+            break;
+         }
+      }
+      else {
+         channels[c]->SetChannel(Track::MonoChannel);
+      }
+   }
+
+   int updateResult = eProgressSuccess;
+   sampleCount maxBlockSize = channels[0]->GetMaxBlockSize();
+   for (sampleCount i = 0; i < numSamples; i += maxBlockSize) {
+      sampleCount blockLen = maxBlockSize;
+      if (i + blockLen > numSamples)
+         blockLen = numSamples - i;
+
+      for (c = 0; c < numChannels; c++)
+         channels[c]->AppendCoded(mFilename, i, blockLen, c, ODTask::eODOGG);
+
+      updateResult = mProgress->Update((wxULongLong_t)i, (wxULongLong_t)numSamples);
+      if (updateResult != eProgressSuccess)
+         break;
+   }
+
+   if (updateResult == eProgressFailed || updateResult == eProgressCancelled) {
+      for (c = 0; c < numChannels; c++)
+         delete channels[c];
+      delete[] channels;
+      delete decoder;
+      delete task;
+
+      *result = updateResult;
+      return true;
+   }
+
+   *outNumTracks = numChannels;
+   *outTracks = new Track *[numChannels];
+
+   //if we have mono or a linked track (stereo), we add ONE task for the one linked wave track.
+   //More channels get imported on separate tracks, so they get individual tasks.
+   bool moreThanStereo = numChannels > 2;
+   for (c = 0; c < numChannels; c++) {
+      channels[c]->Flush();
+      (*outTracks)[c] = channels[c];
+      task->AddWaveTrack(channels[c]);
+      if (moreThanStereo) {
+         ODManager::Instance()->AddNewTask(task);
+         if (c + 1 < numChannels)
+            task = (ODDecodeOggTask *)task->Clone();
+      }
+   }
+   if (!moreThanStereo)
+      ODManager::Instance()->AddNewTask(task);
+   delete[] channels;
+
+   *result = updateResult;
+   return true;
 }
+#endif
 
 OggImportFileHandle::~OggImportFileHandle()
 {
@@ -60,7 +60,7 @@ but little else.
 #include <wx/string.h>
 #include <wx/list.h>
 
-#include "../widgets/ProgressDialog.h"
+#include "ImportProgress.h"
 
 class TrackFactory;
 class Track;
@@ -133,17 +133,35 @@ public:
    }
 
    // The importer should call this to create the progress dialog and
-   // identify the filename being imported.
+   // identify the filename being imported.  If the file is imported on
+   // a worker thread, the progress has already been set with SetProgress().
    void CreateProgress()
    {
+      if (mProgress != NULL)
+         return;
+
       wxFileName f(mFilename);
       wxString title;
 
       title.Printf(_("Importing %s"), GetFileDescription().c_str());
-      mProgress = new ProgressDialog(title,
+      mProgress = new ImportProgress(title,
                                      f.GetFullName());
    }
 
+   // Used by a parallel import to record the progress instead of showing
+   // a dialog.  The handle takes ownership of progress.
+   void SetProgress(ImportProgress *progress)
+   {
+      if (mProgress != NULL)
+         delete mProgress;
+      mProgress = progress;
+   }
+
+   // Return true if Import() can run on a worker thread: it must not show
+   // any dialogs, and must only use the TrackFactory, the Tags and the
+   // progress passed to it.
+   virtual bool SupportsParallelImport() { return false; }
+
    // This is similar to GetImporterDescription, but if possible the
    // importer will return a more specific description of the
    // specific file that is open.
@@ -170,7 +188,7 @@ public:
 
 protected:
    wxString mFilename;
-   ProgressDialog *mProgress;
+   ImportProgress *mProgress;
 };
 
 
@@ -0,0 +1,120 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ImportProgress.cpp
+
+*******************************************************************//**
+
+\class ImportProgress
+\brief The progress of importing one file, either in its own dialog
+or recorded for the combined dialog of a parallel import.
+
+*//*******************************************************************/
+
+#include "../Audacity.h"
+
+#include "ImportProgress.h"
+
+ImportProgress::ImportProgress(const wxString & title, const wxString & message)
+:  mDialog(new ProgressDialog(title, message)),
+   mValue(0),
+   mResult(eProgressSuccess)
+{
+}
+
+ImportProgress::ImportProgress()
+:  mDialog(NULL),
+   mValue(0),
+   mResult(eProgressSuccess)
+{
+}
+
+ImportProgress::~ImportProgress()
+{
+   if (mDialog)
+      delete mDialog;
+}
+
+int ImportProgress::Update(int value, const wxString & message)
+{
+   if (mDialog)
+      return mDialog->Update(value, message);
+
+   if (value < 0)
+      value = 0;
+   if (value > 1000)
+      value = 1000;
+
+   mLock.Lock();
+   mValue = value;
+   int result = mResult;
+   mLock.Unlock();
+
+   return result;
+}
+
+int ImportProgress::Update(double current, const wxString & message)
+{
+   if (mDialog)
+      return mDialog->Update(current, message);
+
+   return Update((int)(current * 1000), message);
+}
+
+int ImportProgress::Update(double current, double total, const wxString & message)
+{
+   if (mDialog)
+      return mDialog->Update(current, total, message);
+
+   return Update(total != 0 ? (int)(current * 1000.0 / total) : 1000, message);
+}
+
+int ImportProgress::Update(wxULongLong_t current, wxULongLong_t total, const wxString & message)
+{
+   if (mDialog)
+      return mDialog->Update(current, total, message);
+
+   return Update(total != 0 ? (int)(current * 1000 / total) : 1000, message);
+}
+
+int ImportProgress::Update(wxLongLong current, wxLongLong total, const wxString & message)
+{
+   if (mDialog)
+      return mDialog->Update(current, total, message);
+
+   return Update(total.GetValue() != 0 ?
+                 (int)(current.GetValue() * 1000ll / total.GetValue()) : 1000, message);
+}
+
+int ImportProgress::Update(wxLongLong_t current, wxLongLong_t total, const wxString & message)
+{
+   if (mDialog)
+      return mDialog->Update(current, total, message);
+
+   return Update(total != 0 ? (int)(current * 1000ll / total) : 1000, message);
+}
+
+int ImportProgress::Update(int current, int total, const wxString & message)
+{
+   if (mDialog)
+      return mDialog->Update(current, total, message);
+
+   return Update(total != 0 ? (int)(current * ((double)(1000.0 / total))) : 1000, message);
+}
+
+int ImportProgress::GetValue()
+{
+   mLock.Lock();
+   int value = mValue;
+   mLock.Unlock();
+
+   return value;
+}
+
+void ImportProgress::SetResult(int result)
+{
+   mLock.Lock();
+   mResult = result;
+   mLock.Unlock();
+}
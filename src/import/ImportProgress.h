@@ -0,0 +1,63 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ImportProgress.h
+
+*******************************************************************//**
+
+\class ImportProgress
+\brief The progress of importing one file.
+
+  When the file is imported on the main thread this is just a
+  ProgressDialog.  When several files are imported in parallel, each
+  worker thread only records how far it has got; the main thread adds
+  the values up into one dialog for all the files, and passes a
+  cancel or stop back to the workers through SetResult().
+
+  The Update() overloads are the same as those of ProgressDialog, so
+  the importers call them in the same way.
+
+*//*******************************************************************/
+
+#ifndef __AUDACITY_IMPORT_PROGRESS__
+#define __AUDACITY_IMPORT_PROGRESS__
+
+#include <wx/string.h>
+
+#include "../widgets/ProgressDialog.h"
+#include "../ondemand/ODTaskThread.h"
+
+class ImportProgress
+{
+public:
+   // Shows the progress in a dialog of its own
+   ImportProgress(const wxString & title, const wxString & message);
+   // Only records the progress, for a file imported on a worker thread
+   ImportProgress();
+   ~ImportProgress();
+
+   int Update(int value, const wxString & message = wxEmptyString);
+   int Update(double current, const wxString & message = wxEmptyString);
+   int Update(double current, double total, const wxString & message = wxEmptyString);
+   int Update(wxULongLong_t current, wxULongLong_t total, const wxString & message = wxEmptyString);
+   int Update(wxLongLong current, wxLongLong total, const wxString & message = wxEmptyString);
+   int Update(wxLongLong_t current, wxLongLong_t total, const wxString & message = wxEmptyString);
+   int Update(int current, int total, const wxString & message = wxEmptyString);
+
+   // Last value passed to Update(), in the range [0,1000]
+   int GetValue();
+
+   // The value Update() returns from now on, e.g. eProgressCancelled
+   // when the user cancels the combined dialog
+   void SetResult(int result);
+
+private:
+   ProgressDialog *mDialog;
+
+   ODLock mLock;
+   int mValue;
+   int mResult;
+};
+
+#endif
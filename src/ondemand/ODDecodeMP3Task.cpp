@@ -0,0 +1,328 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ODDecodeMP3Task.cpp
+
+  Audacity(R) is copyright (c) 1999-2015 Audacity Team.
+  License: GPL v2.  See License.txt.
+
+******************************************************************//**
+
+\class ODMP3Decoder
+\brief Decodes blocks of an MP3 file with libmad, using a seek index of
+frame offsets built by a header-only scan.
+
+Layer III frames may take some of their data from earlier frames (the
+bit reservoir), and the synthesis filterbank carries state from frame to
+frame, so each decode starts a few frames early and throws that output away.
+
+*//*******************************************************************/
+
+#include "ODDecodeMP3Task.h"
+
+#if defined(USE_LIBMAD) && defined(EXPERIMENTAL_OD_MP3)
+
+#include <algorithm>
+#include <wx/file.h>
+
+extern "C" {
+#include "mad.h"
+
+#ifdef USE_LIBID3TAG
+#include <id3tag.h>
+#endif
+}
+
+/// Size of the buffer used for the header scan
+#define kMP3ScanBufferSize 65536
+
+/// Number of frames decoded and discarded before the first frame we want.
+/// The bit reservoir can reach back 511 bytes, which is several frames at low bitrates.
+#define kMP3PrerollFrames 10
+
+static inline float scale(mad_fixed_t sample)
+{
+   return (float) (sample / (float) (1L << MAD_F_FRACBITS));
+}
+
+ODDecodeMP3Task::~ODDecodeMP3Task()
+{
+}
+
+ODTask* ODDecodeMP3Task::Clone()
+{
+   ODDecodeMP3Task* clone = new ODDecodeMP3Task;
+   clone->mDemandSample=GetDemandSample();
+
+   //the decoders and blockfiles should not be copied.  They are created as the task runs.
+   return clone;
+}
+
+///Creates an ODFileDecoder that decodes a file of filetype the subclass handles.
+ODFileDecoder* ODDecodeMP3Task::CreateFileDecoder(const wxString & fileName)
+{
+   ODMP3Decoder *decoder = new ODMP3Decoder(fileName);
+
+   mDecoders.push_back(decoder);
+   return decoder;
+}
+
+
+ODMP3Decoder::ODMP3Decoder(const wxString & fileName)
+:  ODFileDecoder(fileName)
+{
+   mEndOffset = 0;
+   mTotalSamples = 0;
+   mSampleRate = 0;
+   mNumChannels = 0;
+   mNumSamples = 0;
+
+   mCacheStart = 0;
+   mCacheLen = 0;
+   mCacheCapacity = 0;
+}
+
+ODMP3Decoder::~ODMP3Decoder()
+{
+   for (size_t c = 0; c < mCache.size(); c++)
+      delete [] mCache[c];
+}
+
+///Walks the frame headers of the whole file.  No audio is decoded, so this is
+///much faster than an import, but it gives us the exact sample position of
+///every frame.
+bool ODMP3Decoder::ReadHeader()
+{
+   wxFile file;
+   if (!file.Open(mFName))
+      return false;
+
+   wxFileOffset fileLen = file.Length();
+   wxFileOffset bufferOffset = 0; // the file offset of buffer[0]
+
+#ifdef USE_LIBID3TAG
+   // Skip any ID3v2 tag, libmad could find false syncs in it.
+   id3_byte_t query[ID3_TAG_QUERYSIZE];
+   if (file.Read(query, ID3_TAG_QUERYSIZE) == ID3_TAG_QUERYSIZE) {
+      long tagLen = id3_tag_query(query, ID3_TAG_QUERYSIZE);
+      if (tagLen > 0)
+         bufferOffset = tagLen;
+   }
+#endif
+   file.Seek(bufferOffset);
+
+   unsigned char *buffer = new unsigned char[kMP3ScanBufferSize + MAD_BUFFER_GUARD];
+   size_t bufferLen = 0;
+   bool needData = true;
+   bool eof = false;
+
+   struct mad_stream stream;
+   struct mad_header header;
+   mad_stream_init(&stream);
+   mad_header_init(&header);
+
+   mFrameOffsets.clear();
+   mFrameStarts.clear();
+   mTotalSamples = 0;
+   mEndOffset = bufferOffset;
+
+   while (true) {
+      if (needData) {
+         if (eof)
+            break;
+
+         // Keep the unconsumed part of the buffer, as in the import input callback.
+         size_t unconsumed = 0;
+         if (stream.next_frame) {
+            unconsumed = buffer + bufferLen - stream.next_frame;
+            bufferOffset += stream.next_frame - buffer;
+            memmove(buffer, stream.next_frame, unconsumed);
+         }
+
+         ssize_t bytesRead = file.Read(buffer + unconsumed, kMP3ScanBufferSize - unconsumed);
+         if (bytesRead < 0)
+            bytesRead = 0;
+         bufferLen = unconsumed + bytesRead;
+
+         // libmad needs MAD_BUFFER_GUARD bytes after the last frame to decode it.
+         if (bufferOffset + (wxFileOffset)bufferLen >= fileLen) {
+            memset(buffer + bufferLen, 0, MAD_BUFFER_GUARD);
+            bufferLen += MAD_BUFFER_GUARD;
+            eof = true;
+         }
+
+         mad_stream_buffer(&stream, buffer, bufferLen);
+         needData = false;
+      }
+
+      if (mad_header_decode(&header, &stream) == -1) {
+         if (stream.error == MAD_ERROR_BUFLEN)
+            needData = true;
+         else if (!MAD_RECOVERABLE(stream.error))
+            break;
+         continue;
+      }
+
+      if (mFrameOffsets.empty()) {
+         mSampleRate = header.samplerate;
+         mNumChannels = MAD_NCHANNELS(&header);
+      }
+
+      mFrameOffsets.push_back(bufferOffset + (stream.this_frame - buffer));
+      mFrameStarts.push_back(mTotalSamples);
+      mTotalSamples += 32 * MAD_NSBSAMPLES(&header);
+      mEndOffset = bufferOffset + (stream.next_frame - buffer);
+   }
+
+   mad_header_finish(&header);
+   mad_stream_finish(&stream);
+   delete [] buffer;
+
+   if (mEndOffset > fileLen)
+      mEndOffset = fileLen;
+
+   if (mFrameOffsets.empty() || mNumChannels == 0)
+      return false;
+
+   mNumSamples = (unsigned int)mTotalSamples;
+
+   MarkInitialized();
+   return true;
+}
+
+size_t ODMP3Decoder::FindFrame(sampleCount sample)
+{
+   std::vector<sampleCount>::iterator it =
+      std::upper_bound(mFrameStarts.begin(), mFrameStarts.end(), sample);
+   if (it == mFrameStarts.begin())
+      return 0;
+   return (it - mFrameStarts.begin()) - 1;
+}
+
+bool ODMP3Decoder::FillCache(sampleCount start, sampleCount len)
+{
+   if (mFrameOffsets.empty() || start >= mTotalSamples)
+      return false;
+
+   if (len > mCacheCapacity || mCache.size() != mNumChannels) {
+      for (size_t c = 0; c < mCache.size(); c++)
+         delete [] mCache[c];
+      mCache.resize(mNumChannels);
+      for (size_t c = 0; c < mCache.size(); c++)
+         mCache[c] = new float[len];
+      mCacheCapacity = len;
+   }
+   mCacheStart = 0;
+   mCacheLen = 0;
+   for (size_t c = 0; c < mCache.size(); c++)
+      memset(mCache[c], 0, len * sizeof(float));
+
+   size_t first = FindFrame(start);
+   size_t last = FindFrame(start + len - 1);
+   size_t preroll = first > kMP3PrerollFrames ? first - kMP3PrerollFrames : 0;
+
+   wxFileOffset readStart = mFrameOffsets[preroll];
+   wxFileOffset readEnd = last + 1 < mFrameOffsets.size() ? mFrameOffsets[last + 1] : mEndOffset;
+   size_t readLen = (size_t)(readEnd - readStart);
+
+   wxFile file;
+   if (!file.Open(mFName) || file.Seek(readStart) == wxInvalidOffset)
+      return false;
+
+   unsigned char *buffer = new unsigned char[readLen + MAD_BUFFER_GUARD];
+   ssize_t bytesRead = file.Read(buffer, readLen);
+   if (bytesRead < 0)
+      bytesRead = 0;
+   memset(buffer + bytesRead, 0, MAD_BUFFER_GUARD);
+
+   struct mad_stream stream;
+   struct mad_frame frame;
+   struct mad_synth synth;
+   mad_stream_init(&stream);
+   mad_frame_init(&frame);
+   mad_synth_init(&synth);
+   mad_stream_buffer(&stream, buffer, bytesRead + MAD_BUFFER_GUARD);
+
+   size_t frameIndex = preroll;
+   while (frameIndex <= last) {
+      int result = mad_frame_decode(&frame, &stream);
+      if (result == -1 && !MAD_RECOVERABLE(stream.error))
+         break;
+
+      // Find the frame of the index from where libmad is in the file.
+      // After a resync it may have skipped damaged frames, which stay
+      // silent, or stopped at a false sync word the index doesn't have,
+      // which is dropped.
+      wxFileOffset offset = readStart + (stream.this_frame - buffer);
+      std::vector<wxFileOffset>::iterator it =
+         std::lower_bound(mFrameOffsets.begin() + frameIndex, mFrameOffsets.end(), offset);
+      if (it == mFrameOffsets.end() || *it != offset)
+         continue;
+      frameIndex = it - mFrameOffsets.begin();
+      if (frameIndex > last)
+         break;
+
+      // A damaged frame, or one whose reservoir lies before the preroll.
+      // Keep the timeline of the index by producing silence.
+      if (result == -1)
+         mad_frame_mute(&frame);
+      mad_synth_frame(&synth, &frame);
+
+      if (frameIndex >= first) {
+         sampleCount frameStart = mFrameStarts[frameIndex];
+         sampleCount frameEnd = frameIndex + 1 < mFrameStarts.size() ?
+            mFrameStarts[frameIndex + 1] : mTotalSamples;
+         if (frameEnd > frameStart + synth.pcm.length)
+            frameEnd = frameStart + synth.pcm.length;
+
+         sampleCount from = wxMax(start, frameStart);
+         sampleCount to = wxMin(start + len, frameEnd);
+
+         for (unsigned int c = 0; c < mNumChannels; c++) {
+            // protect us from libmad glitching on the number of channels
+            unsigned int srcChannel = c < synth.pcm.channels ? c : 0;
+            mad_fixed_t const *src = synth.pcm.samples[srcChannel] + (from - frameStart);
+            float *dst = mCache[c] + (from - start);
+            for (sampleCount s = from; s < to; s++)
+               *dst++ = scale(*src++);
+         }
+      }
+      frameIndex++;
+   }
+
+   mad_synth_finish(&synth);
+   mad_frame_finish(&frame);
+   mad_stream_finish(&stream);
+   delete [] buffer;
+
+   mCacheStart = start;
+   mCacheLen = len;
+   return true;
+}
+
+///Decodes the samples for this blockfile from the real file into a float buffer.
+int ODMP3Decoder::Decode(samplePtr & data, sampleFormat & format, sampleCount start, sampleCount len, unsigned int channel)
+{
+   mDecodeLock.Lock();
+
+   //the other channels of the block we just decoded are usually asked for next.
+   if (mCacheLen == 0 || start < mCacheStart || start + len > mCacheStart + mCacheLen) {
+      if (!FillCache(start, len)) {
+         mDecodeLock.Unlock();
+         return -1;
+      }
+   }
+
+   if (channel >= mNumChannels)
+      channel = mNumChannels - 1;
+
+   format = floatSample;
+   data = NewSamples(len, floatSample);
+   memcpy(data, mCache[channel] + (start - mCacheStart), len * sizeof(float));
+
+   mDecodeLock.Unlock();
+   return 1;
+}
+
+#endif //defined(USE_LIBMAD) && defined(EXPERIMENTAL_OD_MP3)
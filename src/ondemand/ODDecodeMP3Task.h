@@ -0,0 +1,96 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ODDecodeMP3Task.h
+
+  Audacity(R) is copyright (c) 1999-2015 Audacity Team.
+  License: GPL v2.  See License.txt.
+
+******************************************************************//**
+
+\class ODDecodeMP3Task
+\brief Decodes an MP3 file into ODDecodeBlockFiles in the background, using libmad.
+
+The MP3 decoder scans the frame headers once (which is much faster than
+decoding) and keeps a seek index of frame offsets, so any block can be
+decoded on its own, starting from the point the user demanded.
+
+*//*******************************************************************/
+
+#ifndef __AUDACITY_ODDecodeMP3Task__
+#define __AUDACITY_ODDecodeMP3Task__
+
+#include "../Audacity.h"
+#include "../Experimental.h"
+
+#if defined(USE_LIBMAD) && defined(EXPERIMENTAL_OD_MP3)
+
+#include <vector>
+#include "ODDecodeTask.h"
+#include "ODTaskThread.h"
+
+class ODFileDecoder;
+class WaveTrack;
+
+/// A class representing a modular task to be used with the On-Demand structures.
+class ODDecodeMP3Task:public ODDecodeTask
+{
+ public:
+
+   /// Constructs an ODTask
+   ODDecodeMP3Task(){}
+   virtual ~ODDecodeMP3Task();
+
+   virtual ODTask* Clone();
+   ///Creates an ODFileDecoder that decodes a file of filetype the subclass handles.
+   virtual ODFileDecoder* CreateFileDecoder(const wxString & fileName);
+
+   ///Lets other classes know that this class handles mp3
+   ///Subclasses should override to return respective type.
+   virtual unsigned int GetODType(){return eODMP3;}
+};
+
+///class to decode a particular mp3 file (one per file).  Holds the seek index built by ReadHeader().
+class ODMP3Decoder:public ODFileDecoder
+{
+public:
+   ODMP3Decoder(const wxString & fileName);
+   virtual ~ODMP3Decoder();
+
+   ///Decodes the samples for this blockfile from the mp3 file into a float buffer.
+   ///All channels of the range are kept, so the other channels of the same block are served without decoding again.
+   virtual int Decode(samplePtr & data, sampleFormat & format, sampleCount start, sampleCount len, unsigned int channel);
+
+   ///Scans the frame headers of the file without decoding any audio and builds the seek index.
+   virtual bool ReadHeader();
+
+   unsigned int GetSampleRate(){return mSampleRate;}
+   unsigned int GetNumChannels(){return mNumChannels;}
+   sampleCount GetNumSamples(){return mTotalSamples;}
+
+private:
+   ///returns the index of the frame that contains the sample.
+   size_t FindFrame(sampleCount sample);
+
+   ///decodes [start, start+len) for all channels into mCache.  Call with mDecodeLock held.
+   bool FillCache(sampleCount start, sampleCount len);
+
+   ///byte offset in the file of the frame header
+   std::vector<wxFileOffset> mFrameOffsets;
+   ///first sample of each frame, from the beginning of the stream
+   std::vector<sampleCount>  mFrameStarts;
+   ///the offset just after the last frame
+   wxFileOffset mEndOffset;
+   sampleCount  mTotalSamples;
+
+   ODLock mDecodeLock;
+   std::vector<float*> mCache;
+   sampleCount mCacheStart;
+   sampleCount mCacheLen;
+   sampleCount mCacheCapacity;
+};
+
+#endif //defined(USE_LIBMAD) && defined(EXPERIMENTAL_OD_MP3)
+
+#endif
@@ -0,0 +1,195 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ODDecodeOggTask.cpp
+
+  Audacity(R) is copyright (c) 1999-2015 Audacity Team.
+  License: GPL v2.  See License.txt.
+
+******************************************************************//**
+
+\class ODOggDecoder
+\brief Decodes blocks of an Ogg Vorbis file with vorbisfile.
+
+ov_pcm_seek() is sample accurate, and blocks are usually asked for in order,
+so we only seek when the block does not start where the last one ended.
+
+*//*******************************************************************/
+
+#include "ODDecodeOggTask.h"
+
+#if defined(USE_LIBVORBIS) && defined(EXPERIMENTAL_OD_OGG)
+
+/* The number of samples per channel to get from the codec in each run */
+#define kOggTransferSize 4096
+
+ODDecodeOggTask::~ODDecodeOggTask()
+{
+}
+
+ODTask* ODDecodeOggTask::Clone()
+{
+   ODDecodeOggTask* clone = new ODDecodeOggTask;
+   clone->mDemandSample=GetDemandSample();
+
+   //the decoders and blockfiles should not be copied.  They are created as the task runs.
+   return clone;
+}
+
+///Creates an ODFileDecoder that decodes a file of filetype the subclass handles.
+ODFileDecoder* ODDecodeOggTask::CreateFileDecoder(const wxString & fileName)
+{
+   ODOggDecoder *decoder = new ODOggDecoder(fileName);
+
+   mDecoders.push_back(decoder);
+   return decoder;
+}
+
+
+ODOggDecoder::ODOggDecoder(const wxString & fileName)
+:  ODFileDecoder(fileName)
+{
+   mFile = NULL;
+   mVorbisFile = NULL;
+   mTotalSamples = 0;
+   mSampleRate = 0;
+   mNumChannels = 0;
+   mNumSamples = 0;
+
+   mCacheStart = 0;
+   mCacheLen = 0;
+   mCacheCapacity = 0;
+}
+
+ODOggDecoder::~ODOggDecoder()
+{
+   Close();
+   for (size_t c = 0; c < mCache.size(); c++)
+      delete [] mCache[c];
+}
+
+void ODOggDecoder::Close()
+{
+   if (mVorbisFile) {
+      ov_clear(mVorbisFile);
+      mFile->Detach();    // ov_clear() closed the file already
+      delete mVorbisFile;
+      mVorbisFile = NULL;
+   }
+   if (mFile) {
+      delete mFile;
+      mFile = NULL;
+   }
+}
+
+bool ODOggDecoder::ReadHeader()
+{
+   Close();
+
+   mFile = new wxFFile(mFName, wxT("rb"));
+   if (!mFile->IsOpened()) {
+      Close();
+      return false;
+   }
+
+   // Use the FILE * from wxFFile, since vorbisfile can't open Unicode names (under Windows).
+   OggVorbis_File *vorbisFile = new OggVorbis_File;
+   if (ov_open(mFile->fp(), vorbisFile, NULL, 0) < 0) {
+      delete vorbisFile;
+      Close();
+      return false;
+   }
+   mVorbisFile = vorbisFile;
+
+   // Chained streams may change rate and channels, and become separate tracks.
+   if (mVorbisFile->links != 1 || !ov_seekable(mVorbisFile)) {
+      Close();
+      return false;
+   }
+
+   vorbis_info *vi = ov_info(mVorbisFile, 0);
+   mSampleRate = vi->rate;
+   mNumChannels = vi->channels;
+   mTotalSamples = ov_pcm_total(mVorbisFile, -1);
+   if (mNumChannels == 0 || mTotalSamples <= 0) {
+      Close();
+      return false;
+   }
+   mNumSamples = (unsigned int)mTotalSamples;
+
+   MarkInitialized();
+   return true;
+}
+
+bool ODOggDecoder::FillCache(sampleCount start, sampleCount len)
+{
+   if (!mVorbisFile || start >= mTotalSamples)
+      return false;
+
+   if (len > mCacheCapacity || mCache.size() != mNumChannels) {
+      for (size_t c = 0; c < mCache.size(); c++)
+         delete [] mCache[c];
+      mCache.resize(mNumChannels);
+      for (size_t c = 0; c < mCache.size(); c++)
+         mCache[c] = new float[len];
+      mCacheCapacity = len;
+   }
+   mCacheStart = 0;
+   mCacheLen = 0;
+
+   //blocks are mostly decoded in order, so the decoder is often already there.
+   if (ov_pcm_tell(mVorbisFile) != start && ov_pcm_seek(mVorbisFile, start) != 0)
+      return false;
+
+   sampleCount got = 0;
+   int bitstream = 0;
+   while (got < len) {
+      float **pcm;
+      long samplesRead = ov_read_float(mVorbisFile, &pcm,
+                                       (int)wxMin((sampleCount)kOggTransferSize, len - got),
+                                       &bitstream);
+      if (samplesRead == OV_HOLE)
+         continue;
+      if (samplesRead <= 0)
+         break;
+
+      for (unsigned int c = 0; c < mNumChannels; c++)
+         memcpy(mCache[c] + got, pcm[c], samplesRead * sizeof(float));
+      got += samplesRead;
+   }
+
+   //a truncated file gives silence at the end, as the block lengths are already set.
+   for (unsigned int c = 0; c < mNumChannels; c++)
+      memset(mCache[c] + got, 0, (len - got) * sizeof(float));
+
+   mCacheStart = start;
+   mCacheLen = len;
+   return true;
+}
+
+///Decodes the samples for this blockfile from the real file into a float buffer.
+int ODOggDecoder::Decode(samplePtr & data, sampleFormat & format, sampleCount start, sampleCount len, unsigned int channel)
+{
+   mDecodeLock.Lock();
+
+   //the other channels of the block we just decoded are usually asked for next.
+   if (mCacheLen == 0 || start < mCacheStart || start + len > mCacheStart + mCacheLen) {
+      if (!FillCache(start, len)) {
+         mDecodeLock.Unlock();
+         return -1;
+      }
+   }
+
+   if (channel >= mNumChannels)
+      channel = mNumChannels - 1;
+
+   format = floatSample;
+   data = NewSamples(len, floatSample);
+   memcpy(data, mCache[channel] + (start - mCacheStart), len * sizeof(float));
+
+   mDecodeLock.Unlock();
+   return 1;
+}
+
+#endif //defined(USE_LIBVORBIS) && defined(EXPERIMENTAL_OD_OGG)
@@ -0,0 +1,93 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ODDecodeOggTask.h
+
+  Audacity(R) is copyright (c) 1999-2015 Audacity Team.
+  License: GPL v2.  See License.txt.
+
+******************************************************************//**
+
+\class ODDecodeOggTask
+\brief Decodes an Ogg Vorbis file into ODDecodeBlockFiles in the background.
+
+Only files with a single logical bitstream are decoded on demand.  Vorbisfile
+keeps the page offsets it found when the file was opened, so ov_pcm_seek()
+finds any block quickly.
+
+*//*******************************************************************/
+
+#ifndef __AUDACITY_ODDecodeOggTask__
+#define __AUDACITY_ODDecodeOggTask__
+
+#include "../Audacity.h"
+#include "../Experimental.h"
+
+#if defined(USE_LIBVORBIS) && defined(EXPERIMENTAL_OD_OGG)
+
+#include <vector>
+#include <wx/ffile.h>
+#include <vorbis/vorbisfile.h>
+#include "ODDecodeTask.h"
+#include "ODTaskThread.h"
+
+class ODFileDecoder;
+class WaveTrack;
+
+/// A class representing a modular task to be used with the On-Demand structures.
+class ODDecodeOggTask:public ODDecodeTask
+{
+ public:
+
+   /// Constructs an ODTask
+   ODDecodeOggTask(){}
+   virtual ~ODDecodeOggTask();
+
+   virtual ODTask* Clone();
+   ///Creates an ODFileDecoder that decodes a file of filetype the subclass handles.
+   virtual ODFileDecoder* CreateFileDecoder(const wxString & fileName);
+
+   ///Lets other classes know that this class handles ogg vorbis
+   ///Subclasses should override to return respective type.
+   virtual unsigned int GetODType(){return eODOGG;}
+};
+
+///class to decode a particular ogg vorbis file (one per file).
+class ODOggDecoder:public ODFileDecoder
+{
+public:
+   ODOggDecoder(const wxString & fileName);
+   virtual ~ODOggDecoder();
+
+   ///Decodes the samples for this blockfile from the ogg file into a float buffer.
+   ///All channels of the range are kept, so the other channels of the same block are served without decoding again.
+   virtual int Decode(samplePtr & data, sampleFormat & format, sampleCount start, sampleCount len, unsigned int channel);
+
+   ///Opens the file with vorbisfile.  Fails for chained files, which are imported the usual way.
+   virtual bool ReadHeader();
+
+   unsigned int GetSampleRate(){return mSampleRate;}
+   unsigned int GetNumChannels(){return mNumChannels;}
+   sampleCount GetNumSamples(){return mTotalSamples;}
+
+private:
+   ///decodes [start, start+len) for all channels into mCache.  Call with mDecodeLock held.
+   bool FillCache(sampleCount start, sampleCount len);
+
+   void Close();
+
+   wxFFile        *mFile;
+   OggVorbis_File *mVorbisFile;
+   sampleCount     mTotalSamples;
+
+   ODLock mDecodeLock;
+   std::vector<float*> mCache;
+   sampleCount mCacheStart;
+   sampleCount mCacheLen;
+   sampleCount mCacheCapacity;
+};
+
+#endif //defined(USE_LIBVORBIS) && defined(EXPERIMENTAL_OD_OGG)
+
+#endif
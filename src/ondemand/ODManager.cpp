@@ -19,6 +19,7 @@ ODTask requests and internals.
 #include "ODTaskThread.h"
 #include "ODWaveTrackTaskQueue.h"
 #include "../Project.h"
+#include "../blockfile/SndFileReaderPool.h"
 #include <NonGuiThread.h>
 #include <wx/utils.h>
 #include <wx/wx.h>
@@ -39,6 +40,8 @@ pfodman ODManager::Instance = &(ODManager::InstanceFirstTime);
 
 //libsndfile is not threadsafe - this deals with it
 static ODLock sLibSndFileMutex;
+//times a thread found the mutex held by another one
+static int sLibSndFileContention = 0;
 
 DEFINE_EVENT_TYPE(EVT_ODTASK_UPDATE)
 
@@ -52,7 +55,10 @@ int CompareNoCaseFileName(const wxString& first, const wxString& second)
 
 void ODManager::LockLibSndFileMutex()
 {
-   sLibSndFileMutex.Lock();
+   if (sLibSndFileMutex.TryLock() != wxMUTEX_NO_ERROR) {
+      sLibSndFileMutex.Lock();
+      sLibSndFileContention++;
+   }
 }
 
 void ODManager::UnlockLibSndFileMutex()
@@ -60,6 +66,14 @@ void ODManager::UnlockLibSndFileMutex()
    sLibSndFileMutex.Unlock();
 }
 
+int ODManager::GetLibSndFileContention()
+{
+   sLibSndFileMutex.Lock();
+   int contention = sLibSndFileContention;
+   sLibSndFileMutex.Unlock();
+   return contention;
+}
+
 
 //private constructor - Singleton.
 ODManager::ODManager()
@@ -379,6 +393,12 @@ void ODManager::Quit()
       pMan->mTerminatedMutex.Unlock();
       delete pMan;
    }
+
+#ifdef EXPERIMENTAL_POOLED_ALIAS_READERS
+   SndFileReaderPool::Get().LogStats();
+   SndFileReaderPool::Get().CloseAll();
+#endif
+   wxLogDebug(wxT("libsndfile mutex: %d waits"), GetLibSndFileContention());
 }
 
 ///removes a wavetrack and notifies its associated tasks to stop using its reference.
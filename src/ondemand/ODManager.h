@@ -112,6 +112,8 @@ class ODManager
 
    static void LockLibSndFileMutex();
    static void UnlockLibSndFileMutex();
+   ///the number of times a thread had to wait for the libsndfile mutex
+   static int GetLibSndFileContention();
 
 
 
@@ -22,6 +22,7 @@ in a background thread.
 #include "ODManager.h"
 #include "../WaveTrack.h"
 #include "../Project.h"
+#include "../Tracer.h"
 //temporarilly commented out till it is added to all projects
 //#include "../Profiler.h"
 
@@ -68,6 +69,8 @@ void ODTask::TerminateAndBlock()
 /// will do the smallest unit of work possible
 void ODTask::DoSome(float amountWork)
 {
+   TRACE_SCOPE("ODTask::DoSome");
+
    SetIsRunning(true);
    mBlockUntilTerminateMutex.Lock();
 
@@ -43,6 +43,7 @@ class ODTask
       eODFLAC     =  0x00000001,
       eODMP3      =  0x00000002,
       eODFFMPEG   =  0x00000004,
+      eODOGG      =  0x00000008,
       eODPCMSummary  = 0x00001000,
       eODOTHER    =  0x10000000,
    } ODTypeEnum;
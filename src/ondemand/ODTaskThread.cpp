@@ -19,6 +19,7 @@
 #include "ODTaskThread.h"
 #include "ODTask.h"
 #include "ODManager.h"
+#include "../Tracer.h"
 
 
 ODTaskThread::ODTaskThread(ODTask* task)
@@ -42,6 +43,8 @@ void *ODTaskThread::Entry()
 
 #endif
 {
+   TRACE_THREAD_NAME("On-Demand task");
+
    //TODO: Figure out why this has no effect at all.
    //wxThread::This()->SetPriority( 40);
    //Do at least 5 percent of the task
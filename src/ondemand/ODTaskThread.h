@@ -92,6 +92,12 @@ class ODLock {
       pthread_mutex_lock (mutex);
    }
 
+   ///as wxMutex::TryLock, returns wxMUTEX_BUSY when another thread has it
+   wxMutexError TryLock()
+   {
+      return pthread_mutex_trylock (mutex) == 0 ? wxMUTEX_NO_ERROR : wxMUTEX_BUSY;
+   }
+
    void Unlock()
    {
       pthread_mutex_unlock (mutex);
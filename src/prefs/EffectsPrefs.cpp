@@ -131,6 +131,12 @@ void EffectsPrefs::PopulateOrExchange(ShuttleGui & S)
                              5);
       }
       S.EndMultiColumn();
+
+#if USE_SBSMS && defined(EXPERIMENTAL_SBSMS_THREADS)
+      S.TieCheckBox(_("Use multiple &threads for Sliding Time Scale/Pitch Shift"),
+                    wxT("/Effects/SBSMSMultithreaded"),
+                    true);
+#endif
    }
    S.EndStatic();
 
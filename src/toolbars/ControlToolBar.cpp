@@ -62,6 +62,8 @@
 #include "../Project.h"
 #include "../Theme.h"
 #include "../Track.h"
+#include "../WaveTrack.h"
+#include "../ondemand/ODManager.h"
 #include "../widgets/AButton.h"
 #include "../widgets/Meter.h"
 
@@ -611,6 +613,14 @@ void ControlToolBar::PlayPlayRegion(double t0, double t1,
          if (!timetrack) {
             timetrack = t->GetTimeTrack();
          }
+         //On-Demand: have the tasks decode from where we start playing.
+         if (ODManager::IsInstanceCreated()) {
+            TrackListIterator iter(t);
+            for (Track *tr = iter.First(); tr; tr = iter.Next()) {
+               if (tr->GetKind() == Track::Wave)
+                  ODManager::Instance()->DemandTrackUpdate((WaveTrack*)tr, t0);
+            }
+         }
          token = gAudioIO->StartStream(t->GetWaveTrackArray(false),
                                        WaveTrackArray(),
 #ifdef EXPERIMENTAL_MIDI_OUT
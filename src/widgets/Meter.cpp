@@ -907,6 +907,27 @@ void Meter::UpdateDisplay(int numChannels, int numFrames, float *sampleData)
    mQueue.Put(msg);
 }
 
+#ifdef EXPERIMENTAL_MIXER_METER_TAPS
+void Meter::UpdateDisplay(int numChannels, int numFrames,
+                          const float *peak, const float *rms, const int *peakRun)
+{
+   int j;
+   int num = intmin(numChannels, mNumBars);
+   MeterUpdateMsg msg;
+
+   memset(&msg, 0, sizeof(msg));
+   msg.numFrames = numFrames;
+
+   for(j=0; j<num; j++) {
+      msg.peak[j] = peak[j];
+      msg.rms[j] = rms[j];
+      msg.clipping[j] = (peakRun[j] > mNumPeakSamplesToClip);
+   }
+
+   mQueue.Put(msg);
+}
+#endif
+
 // Vaughan, 2010-11-29: This not currently used. See comments in MixerTrackCluster::UpdateMeter().
 //void Meter::UpdateDisplay(int numChannels, int numFrames,
 //                           // Need to make these double-indexed arrays if we handle more than 2 channels.
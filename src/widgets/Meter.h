@@ -22,6 +22,7 @@
 
 #include "../SampleFormat.h"
 #include "../Sequence.h"
+#include "../Experimental.h"
 #include "Ruler.h"
 
 // Event used to notify all meters of preference changes
@@ -153,12 +154,21 @@ class Meter : public wxPanel
    void UpdateDisplay(int numChannels,
                       int numFrames, float *sampleData);
 
+#ifdef EXPERIMENTAL_MIXER_METER_TAPS
+   /** \brief Update the meters with the peak and RMS of numFrames frames
+    * already measured, and the longest run of full scale samples in each
+    * channel, as the Mixer Board gets them from AudioIO.
+    */
+   void UpdateDisplay(int numChannels, int numFrames,
+                      const float *peak, const float *rms, const int *peakRun);
+#else
    // Vaughan, 2010-11-29: This not currently used. See comments in MixerTrackCluster::UpdateMeter().
    //void UpdateDisplay(int numChannels, int numFrames,
    //                     // Need to make these double-indexed max and min arrays if we handle more than 2 channels.
    //                     float* maxLeft, float* rmsLeft,
    //                     float* maxRight, float* rmsRight,
    //                     const sampleCount kSampleCount);
+#endif
 
    /** \brief Find out if the level meter is disabled or not.
     *
@@ -0,0 +1,605 @@
+
+#include <iostream>
+#include <ostream>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <wx/defs.h>
+#include <wx/init.h>
+#include <wx/fileconf.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/stopwatch.h>
+
+#include "Experimental.h"
+#include "BlockFile.h"
+#include "BlockManifest.h"
+#include "DirManager.h"
+#include "FFT.h"
+#include "Prefs.h"
+#include "Resample.h"
+#include "Sequence.h"
+#include "effects/Biquad.h"
+#include "effects/Reverb_libSoX.h"
+#include "xml/XMLFileReader.h"
+#include "xml/XMLWriter.h"
+
+// Times the work that most of Audacity's time goes to, without the GUI:
+// block file I/O, the random edits of BenchmarkDialog, resampling,
+// spectrograms, the DSP of some effects, and saving and opening the
+// sequences of a project.  The inputs come from a fixed seed, so that runs
+// on one machine can be compared, and the results are written to stdout
+// as one JSON object per line:
+//
+//    {"name":"sequence-read","unit":"samples","items":16777216,
+//     "runs":3,"best_s":0.112,"mean_s":0.120,"per_s":149796571}
+//
+// Progress goes to stderr.  It is a benchmark, so it is built by
+// "make check" but not run by it:
+//
+//    ./AudacityBench [-r runs] [scenario...]
+//
+// The scenarios are blockio, sequence, resample, spectrogram, effects and
+// project; all of them are run when none is given.
+// The exit status is 1 when a scenario gets a wrong answer.
+//
+// It links only libaudacity, which has the sequences, block files and DSP
+// but not the tracks, and so what needs the tracks is measured a level
+// below them or not at all:
+//
+//  - The edits of BenchmarkDialog are made to the sequence under a track.
+//  - The project scenario saves and opens the <sequence> tags of a project
+//    and its block manifest, not the tracks and clips around them.
+//  - The effects are the DSP of Reverb and of the Biquad filters, which
+//    stand alone; the other effects keep theirs in Effect classes.
+//  - The Mixer mixes tracks, and UndoManager pushes TrackLists, which
+//    bring in the project, and so there are no mixer and undo scenarios.
+
+static const int kRate = 44100;
+static const unsigned int kSeed = 234657; // as BenchmarkDialog
+
+class AudacityBench {
+   struct Stat {
+      std::string unit;
+      double items;
+      int runs;
+      double best;
+      double total;
+   };
+
+   std::map<std::string, Stat> mStats;
+   std::vector<std::string> mOrder;
+
+   DirManager *mDirManager;
+   wxString mTempDir;
+
+public:
+   AudacityBench(const wxString &tempDir)
+   :  mTempDir(tempDir)
+   {
+      mDirManager = new DirManager();
+   }
+
+   ~AudacityBench()
+   {
+      mDirManager->Deref();
+   }
+
+   // Wall time, as most of these use several threads
+   class Timer {
+      wxLongLong mStart;
+   public:
+      Timer() { mStart = wxGetLocalTimeMillis(); }
+      double Seconds() { return (wxGetLocalTimeMillis() - mStart).ToDouble() / 1000.0; }
+   };
+
+   void Report(const char *name, double seconds, double items, const char *unit)
+   {
+      std::map<std::string, Stat>::iterator it = mStats.find(name);
+      if (it == mStats.end()) {
+         Stat stat;
+         stat.unit = unit;
+         stat.items = items;
+         stat.runs = 0;
+         stat.best = seconds;
+         stat.total = 0;
+         it = mStats.insert(std::make_pair(std::string(name), stat)).first;
+         mOrder.push_back(name);
+      }
+
+      Stat &stat = it->second;
+      stat.runs++;
+      stat.total += seconds;
+      if (seconds < stat.best)
+         stat.best = seconds;
+
+      std::cerr << "\t" << name << ": " << seconds << " s\n";
+   }
+
+   void Print()
+   {
+      for (size_t i = 0; i < mOrder.size(); i++) {
+         const Stat &stat = mStats[mOrder[i]];
+         printf("{\"name\":\"%s\",\"unit\":\"%s\",\"items\":%.0f,"
+                "\"runs\":%d,\"best_s\":%.6f,\"mean_s\":%.6f,\"per_s\":%.0f}\n",
+                mOrder[i].c_str(), stat.unit.c_str(), stat.items,
+                stat.runs, stat.best, stat.total / stat.runs,
+                stat.best > 0 ? stat.items / stat.best : 0.0);
+      }
+      fflush(stdout);
+   }
+
+   static void Noise(float *buffer, int len)
+   {
+      for (int i = 0; i < len; i++)
+         buffer[i] = (rand() / (float)RAND_MAX) * 2.0f - 1.0f;
+   }
+
+   Sequence *NoiseSequence(double seconds)
+   {
+      Sequence *t = new Sequence(mDirManager, floatSample);
+      int len = (int)(seconds * kRate);
+      int chunk = 65536;
+      float *buffer = new float[chunk];
+      for (int done = 0; done < len; done += chunk) {
+         int n = wxMin(chunk, len - done);
+         Noise(buffer, n);
+         t->Append((samplePtr)buffer, floatSample, n);
+      }
+      delete[] buffer;
+      return t;
+   }
+
+   //
+   // Writing and reading simple block files
+   //
+   bool BlockIO()
+   {
+      const int numBlocks = 256;
+      const int len = 65536;
+
+      float *buffer = new float[len];
+      float *check = new float[len];
+      std::vector<BlockFile *> blocks;
+      std::vector<float> firsts;
+
+      Timer write;
+      for (int b = 0; b < numBlocks; b++) {
+         Noise(buffer, len);
+         firsts.push_back(buffer[0]);
+         blocks.push_back(mDirManager->NewSimpleBlockFile((samplePtr)buffer, len, floatSample));
+      }
+      Report("blockio-write", write.Seconds(), (double)numBlocks * len, "samples");
+
+      bool ok = true;
+      Timer read;
+      for (int b = 0; b < numBlocks; b++) {
+         if (blocks[b]->ReadData((samplePtr)check, floatSample, 0, len) != len ||
+             check[0] != firsts[b])
+            ok = false;
+      }
+      Report("blockio-read", read.Seconds(), (double)numBlocks * len, "samples");
+
+      for (int b = 0; b < numBlocks; b++)
+         mDirManager->Deref(blocks[b]);
+
+      delete[] buffer;
+      delete[] check;
+      return ok;
+   }
+
+   //
+   // The random cuts and pastes of BenchmarkDialog, with its defaults of
+   // 64 KB blocks, 32 MB of data and 100 edits, and its check.  The
+   // dialog edits a track; here the sequence under it is edited.
+   //
+   bool SequenceEdits()
+   {
+      const int blockSize = 64;
+      const int dataSize = 32;
+      const int numEdits = 100;
+
+      int oldBlockSize = Sequence::GetMaxDiskBlockSize();
+      Sequence::SetMaxDiskBlockSize(blockSize * 1024);
+
+      Sequence *t = new Sequence(mDirManager, int16Sample);
+      Sequence *tmp = NULL;
+
+      int nChunks, chunkSize;
+      chunkSize = 200 + (rand() % 100);
+      nChunks = (dataSize * 1048576) / (chunkSize*sizeof(short));
+      while(nChunks < 20 || chunkSize > (blockSize*1024)/4) {
+         chunkSize = (chunkSize / 2) + (rand() % 100);
+         nChunks = (dataSize * 1048576) / (chunkSize*sizeof(short));
+      }
+
+      short *small1 = new short[nChunks];
+      short *small2 = new short[nChunks];
+      short *block = new short[chunkSize];
+      int i, b;
+
+      // In one go, as a sequence rewrites a short last block on each append
+      // where a track buffers them
+      short *data = new short[nChunks * chunkSize];
+      for (i = 0; i < nChunks; i++) {
+         short v = short(rand());
+         small1[i] = v;
+         for (b = 0; b < chunkSize; b++)
+            data[i * chunkSize + b] = v;
+      }
+      t->Append((samplePtr)data, int16Sample, nChunks * chunkSize);
+      delete[] data;
+
+      bool ok = true;
+      Timer edit;
+      for (int z = 0; ok && z < numEdits; z++) {
+         int x0 = rand() % nChunks;
+         int xlen = 1 + (rand() % (nChunks - x0));
+         if (!t->Copy(x0 * chunkSize, (x0 + xlen) * chunkSize, &tmp) || !tmp ||
+             !t->Delete(x0 * chunkSize, xlen * chunkSize)) {
+            ok = false;
+            break;
+         }
+
+         int y0 = rand() % (nChunks - xlen);
+         if (!t->Paste(y0 * chunkSize, tmp))
+            ok = false;
+         delete tmp;
+         tmp = NULL;
+
+         for (i = 0; i < xlen; i++)
+            small2[i] = small1[x0 + i];
+         for (i = 0; i < (nChunks - x0 - xlen); i++)
+            small1[x0 + i] = small1[x0 + xlen + i];
+         for (i = 0; i < (nChunks - xlen - y0); i++)
+            small1[nChunks - i - 1] = small1[nChunks - i - 1 - xlen];
+         for (i = 0; i < xlen; i++)
+            small1[y0 + i] = small2[i];
+      }
+      Report("sequence-edit", edit.Seconds(), numEdits, "edits");
+
+      Timer read;
+      for (i = 0; ok && i < nChunks; i++) {
+         t->Get((samplePtr)block, int16Sample, i * chunkSize, chunkSize);
+         for (b = 0; b < chunkSize; b++)
+            if (block[b] != small1[i]) {
+               ok = false;
+               break;
+            }
+      }
+      Report("sequence-read", read.Seconds(), (double)nChunks * chunkSize, "samples");
+
+      if (!ok)
+         std::cerr << "\tsequence: the edited sequence is wrong\n";
+
+      delete t;
+      delete[] small1;
+      delete[] small2;
+      delete[] block;
+
+      Sequence::SetMaxDiskBlockSize(oldBlockSize);
+      return ok;
+   }
+
+   //
+   // Resampling from 44100 Hz to 48000 Hz with the best method
+   //
+   bool Resampling()
+   {
+      const int len = 60 * kRate;
+      const int chunk = 16384;
+      const double factor = 48000.0 / kRate;
+
+      float *in = new float[len];
+      Noise(in, len);
+      int outLen = (int)(chunk * factor) + 16;
+      float *out = new float[outLen];
+
+      Resample resample(true, factor, factor);
+
+      sampleCount produced = 0;
+      int pos = 0;
+      Timer timer;
+      while (pos < len) {
+         int n = wxMin(chunk, len - pos);
+         bool last = (pos + n == len);
+         int used = 0;
+         produced += resample.Process(factor, in + pos, n, last, &used, out, outLen);
+         pos += used;
+         if (used == 0)
+            break;
+      }
+      Report("resample", timer.Seconds(), (double)len, "samples");
+
+      delete[] in;
+      delete[] out;
+
+      sampleCount expected = (sampleCount)(len * factor);
+      if (produced < expected / 2) {
+         std::cerr << "\tresample: " << produced << " samples, expected about "
+                   << expected << "\n";
+         return false;
+      }
+      return true;
+   }
+
+   //
+   // The windows and power spectra of a spectrogram
+   //
+   bool Spectrogram()
+   {
+      const int len = 60 * kRate;
+      const int windowSize = 1024;
+      const int hop = 256;
+
+      float *in = new float[len];
+      Noise(in, len);
+      float *window = new float[windowSize];
+      float *out = new float[windowSize];
+#ifdef EXPERIMENTAL_USE_REALFFTF
+      HFFT hFFT = GetFFT(windowSize);
+      float *scratch = new float[windowSize];
+#endif
+
+      int windows = 0;
+      Timer timer;
+      for (int start = 0; start + windowSize <= len; start += hop) {
+         memcpy(window, in + start, windowSize * sizeof(float));
+         WindowFunc(3, windowSize, window);
+#ifdef EXPERIMENTAL_USE_REALFFTF
+         PowerSpectrum(hFFT, window, out, scratch);
+#else
+         PowerSpectrum(windowSize, window, out);
+#endif
+         windows++;
+      }
+      Report("spectrogram", timer.Seconds(), windows, "windows");
+
+#ifdef EXPERIMENTAL_USE_REALFFTF
+      delete[] scratch;
+      ReleaseFFT(hFFT);
+#endif
+      delete[] in;
+      delete[] window;
+      delete[] out;
+      return true;
+   }
+
+   //
+   // The DSP of Reverb and of the Biquad filters (Bass and Treble,
+   // Scientific Filter), on buffers, as the effects run it
+   //
+   bool Effects()
+   {
+      const int len = 30 * kRate;
+      const int block = 0x4000; // as EffectReverb
+
+      float *in = new float[len];
+      Noise(in, len);
+      float *out = new float[len];
+
+      // One reverb for each of two channels, wet only, default settings
+      reverb_t reverb[2];
+      float *wet[2][2];
+      for (int c = 0; c < 2; c++)
+         reverb_create(&reverb[c], kRate, -1, 75, 50, 50, 10, 100, 100, 100,
+                       block, wet[c]);
+
+      Timer timer;
+      for (int pos = 0; pos < len; pos += block) {
+         int n = wxMin(block, len - pos);
+         for (int c = 0; c < 2; c++) {
+            fifo_write(&reverb[c].input_fifo, n, in + pos);
+            reverb_process(&reverb[c], n);
+         }
+         for (int i = 0; i < n; i++)
+            out[pos + i] = .5 * (wet[0][0][i] + wet[1][0][i]);
+      }
+      Report("effects-reverb", timer.Seconds(), 2.0 * len, "samples");
+
+      for (int c = 0; c < 2; c++)
+         reverb_delete(&reverb[c]);
+
+      // Two low pass sections, as a Butterworth of order 4 is run
+      BiquadStruct bq[2];
+      for (int s = 0; s < 2; s++) {
+         memset(&bq[s], 0, sizeof(bq[s]));
+         bq[s].fNumerCoeffs[0] = 0.0201f;
+         bq[s].fNumerCoeffs[1] = 0.0402f;
+         bq[s].fNumerCoeffs[2] = 0.0201f;
+         bq[s].fDenomCoeffs[0] = -1.5610f;
+         bq[s].fDenomCoeffs[1] = 0.6414f;
+      }
+      bq[0].pfIn = in;
+      bq[0].pfOut = out;
+      bq[1].pfIn = out;
+      bq[1].pfOut = out;
+
+      Timer biquad;
+      Biquad_Process(&bq[0], len);
+      Biquad_Process(&bq[1], len);
+      Report("effects-biquad", biquad.Seconds(), (double)len, "samples");
+
+      bool ok = true;
+      for (int i = 0; i < len; i++)
+         if (!(fabs(out[i]) < 10.0f)) {
+            std::cerr << "\teffects: the filter output is unstable\n";
+            ok = false;
+            break;
+         }
+
+      delete[] in;
+      delete[] out;
+      return ok;
+   }
+
+   // Walks the tags of a saved file, as opening a project does before it
+   // makes the tracks
+   class TagCounter : public XMLTagHandler {
+   public:
+      int mTags;
+      TagCounter() : mTags(0) {}
+      virtual bool HandleXMLTag(const wxChar *WXUNUSED(tag), const wxChar **WXUNUSED(attrs))
+      {
+         mTags++;
+         return true;
+      }
+      virtual XMLTagHandler *HandleXMLChild(const wxChar *WXUNUSED(tag)) { return this; }
+   };
+
+   void MakeSequences(std::vector<Sequence *> &seqs, int numSequences, double seconds)
+   {
+      for (int i = 0; i < numSequences; i++)
+         seqs.push_back(NoiseSequence(seconds));
+   }
+
+   int CountBlocks(std::vector<Sequence *> &seqs)
+   {
+      int blocks = 0;
+      for (size_t i = 0; i < seqs.size(); i++)
+         blocks += seqs[i]->GetBlockArray()->GetCount();
+      return blocks;
+   }
+
+   //
+   // Writing the sequences of the tracks of a project to its XML file, and
+   // the block manifest where there is one, and reading them again.
+   // Opening only parses the file, as making the tracks needs a project.
+   //
+   bool Project()
+   {
+      std::vector<Sequence *> seqs;
+      MakeSequences(seqs, 8, 30.0);
+      int blocks = CountBlocks(seqs);
+
+      wxString fileName = mTempDir + wxFILE_SEP_PATH + wxT("bench.aup");
+      wxString manifestName = mTempDir + wxFILE_SEP_PATH + wxT("bench.manifest");
+      bool ok = true;
+
+      Timer save;
+      try {
+         XMLFileWriter saveFile;
+         saveFile.Open(fileName, wxT("wb"));
+         saveFile.StartTag(wxT("project"));
+         for (size_t i = 0; i < seqs.size(); i++)
+            seqs[i]->WriteXML(saveFile);
+         saveFile.EndTag(wxT("project"));
+         saveFile.Close();
+      }
+      catch (XMLFileWriterException &) {
+         ok = false;
+      }
+#ifdef EXPERIMENTAL_BLOCK_MANIFEST
+      if (ok) {
+         BlockManifest manifest;
+         for (size_t i = 0; i < seqs.size(); i++) {
+            Sequence *seq = seqs[i];
+            manifest.AddSequence(seq->GetMaxBlockSize(), seq->GetSampleFormat(),
+                                 seq->GetNumSamples(), seq->GetBlockArray());
+         }
+         ok = manifest.Write(manifestName, fileName);
+      }
+#endif
+      Report("project-save", save.Seconds(), blocks, "blocks");
+
+      Timer open;
+      TagCounter counter;
+      XMLFileReader reader;
+      if (ok && !reader.Parse(&counter, fileName))
+         ok = false;
+#ifdef EXPERIMENTAL_BLOCK_MANIFEST
+      if (ok) {
+         BlockManifest manifest;
+         ok = manifest.Read(manifestName, fileName);
+      }
+#endif
+      Report("project-open", open.Seconds(), blocks, "blocks");
+
+      if (ok && counter.mTags < blocks)
+         ok = false;
+      if (!ok)
+         std::cerr << "\tproject: the saved project could not be read\n";
+
+      for (size_t i = 0; i < seqs.size(); i++)
+         delete seqs[i];
+      wxRemoveFile(fileName);
+      wxRemoveFile(manifestName);
+      return ok;
+   }
+
+   bool Run(const std::string &scenario)
+   {
+      std::cerr << "==> " << scenario << "\n";
+
+      // Each scenario from the same start, whichever others are run
+      srand(kSeed);
+
+      if (scenario == "blockio")
+         return BlockIO();
+      if (scenario == "sequence")
+         return SequenceEdits();
+      if (scenario == "resample")
+         return Resampling();
+      if (scenario == "spectrogram")
+         return Spectrogram();
+      if (scenario == "effects")
+         return Effects();
+      if (scenario == "project")
+         return Project();
+
+      std::cerr << "Unknown scenario " << scenario << "\n";
+      return false;
+   }
+};
+
+int main(int argc, char *argv[])
+{
+   wxInitializer initializer;
+
+   int runs = 3;
+   std::vector<std::string> scenarios;
+   for (int i = 1; i < argc; i++) {
+      if (!strcmp(argv[i], "-r") && i + 1 < argc)
+         runs = wxMax(1, atoi(argv[++i]));
+      else
+         scenarios.push_back(argv[i]);
+   }
+   if (scenarios.empty()) {
+      const char *all[] = { "blockio", "sequence", "resample", "spectrogram",
+                            "effects", "project" };
+      scenarios.assign(all, all + sizeof(all) / sizeof(all[0]));
+   }
+
+   wxString tempDir = wxFileName::GetTempDir() + wxFILE_SEP_PATH + wxT("audacity-bench");
+   if (!wxDirExists(tempDir))
+      wxMkdir(tempDir);
+   DirManager::SetTempDir(tempDir);
+
+   // Preferences of its own, with the defaults, so that the user's don't
+   // change the results
+   wxString prefsName = tempDir + wxFILE_SEP_PATH + wxT("bench.cfg");
+   wxRemoveFile(prefsName);
+   gPrefs = new wxFileConfig(wxT("AudacityBench"), wxEmptyString, prefsName,
+                             wxEmptyString, wxCONFIG_USE_LOCAL_FILE);
+
+   bool ok = true;
+   {
+      AudacityBench bench(tempDir);
+      for (int run = 0; run < runs; run++)
+         for (size_t s = 0; s < scenarios.size(); s++)
+            ok = bench.Run(scenarios[s]) && ok;
+      bench.Print();
+   }
+
+   DeinitFFT();
+   delete gPrefs;
+   gPrefs = NULL;
+   wxRemoveFile(prefsName);
+
+   return ok ? 0 : 1;
+}
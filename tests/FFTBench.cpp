@@ -0,0 +1,148 @@
+
+#include <iostream>
+#include <ostream>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+
+#include <wx/defs.h>
+
+#include "Experimental.h"
+#include "FFT.h"
+
+// Times the power spectrum of many windows of one size, done the old way
+// (the complex FFT, whose tables are recomputed on every call) and through
+// a cached plan from GetFFT() with a caller-supplied scratch buffer, and
+// checks that both give the same answer.  This is a benchmark, not a
+// test, so it is built by "make check" but not run by it:
+//
+//    ./FFTBench [windowSize] [windows]
+
+class FFTBench {
+   int mWindowSize;
+   int mWindows;
+
+   float *mIn;
+   float *mLegacy;
+   float *mPlan;
+
+public:
+   FFTBench(int windowSize, int windows)
+   :  mWindowSize(windowSize),
+      mWindows(windows)
+   {
+      std::cout << "==> Benchmarking FFT, window size " << mWindowSize
+                << ", " << mWindows << " windows\n";
+
+      mIn = new float[mWindowSize];
+      mLegacy = new float[mWindowSize];
+      mPlan = new float[mWindowSize];
+
+      srand(1);
+      for (int i = 0; i < mWindowSize; i++)
+         mIn[i] = (rand() / (float)RAND_MAX) * 2.0f - 1.0f;
+   }
+
+   ~FFTBench()
+   {
+      delete[] mIn;
+      delete[] mLegacy;
+      delete[] mPlan;
+   }
+
+   double Seconds(clock_t start)
+   {
+      return (clock() - start) / (double)CLOCKS_PER_SEC;
+   }
+
+   // The complex transform, as the spectral code used before plans
+   double TimeLegacy()
+   {
+      float *re = new float[mWindowSize];
+      float *im = new float[mWindowSize];
+      int half = mWindowSize / 2;
+
+      clock_t start = clock();
+      for (int w = 0; w < mWindows; w++) {
+         FFT(mWindowSize, false, mIn, NULL, re, im);
+         for (int i = 0; i < half; i++)
+            mLegacy[i] = re[i] * re[i] + im[i] * im[i];
+      }
+      double seconds = Seconds(start);
+
+      delete[] re;
+      delete[] im;
+      return seconds;
+   }
+
+   double TimePlan()
+   {
+#ifdef EXPERIMENTAL_USE_REALFFTF
+      HFFT hFFT = GetFFT(mWindowSize);
+      float *scratch = new float[mWindowSize];
+
+      clock_t start = clock();
+      for (int w = 0; w < mWindows; w++)
+         PowerSpectrum(hFFT, mIn, mPlan, scratch);
+      double seconds = Seconds(start);
+
+      delete[] scratch;
+      ReleaseFFT(hFFT);
+      return seconds;
+#else
+      clock_t start = clock();
+      for (int w = 0; w < mWindows; w++)
+         PowerSpectrum(mWindowSize, mIn, mPlan);
+      return Seconds(start);
+#endif
+   }
+
+   bool Compare()
+   {
+      int half = mWindowSize / 2;
+      float peak = 0;
+      for (int i = 0; i < half; i++)
+         if (mLegacy[i] > peak)
+            peak = mLegacy[i];
+
+      for (int i = 0; i < half; i++) {
+         if (fabs(mLegacy[i] - mPlan[i]) > peak * 1e-4) {
+            std::cout << "Mismatch at bin " << i << ": " << mLegacy[i]
+                      << " != " << mPlan[i] << "\n";
+            return false;
+         }
+      }
+      return true;
+   }
+
+   bool Run()
+   {
+      double legacy = TimeLegacy();
+      double plan = TimePlan();
+
+      std::cout << "legacy: " << legacy << " s\n";
+      std::cout << "plan:   " << plan << " s";
+      if (plan > 0)
+         std::cout << " (" << legacy / plan << "x)";
+      std::cout << "\n";
+
+      if (!Compare())
+         return false;
+
+      std::cout << "OK\n";
+      return true;
+   }
+};
+
+int main(int argc, char *argv[])
+{
+   int windowSize = argc > 1 ? atoi(argv[1]) : 4096;
+   int windows = argc > 2 ? atoi(argv[2]) : 2000;
+
+   FFTBench bench(windowSize, windows);
+   bool ok = bench.Run();
+
+   DeinitFFT();
+
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,279 @@
+
+#include <iostream>
+#include <ostream>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <wx/ffile.h>
+
+#include "export/ExportFLACSegments.h"
+
+#if defined(USE_LIBFLAC) && \
+    defined FLACPP_API_VERSION_CURRENT && FLACPP_API_VERSION_CURRENT >= 6
+
+#include "FLAC++/decoder.h"
+#include "FLAC/metadata.h"
+
+// The settings of the levels of the flac command line, as ExportFLAC has
+// them
+static const struct
+{
+   bool exhaustive;
+   bool midSide;
+   bool looseMidSide;
+   unsigned minPartitionOrder;
+   unsigned maxPartitionOrder;
+   unsigned maxLpcOrder;
+} levels[] = {
+   {  false,   false,   false,   2, 2, 0  },
+   {  false,   true,    true,    2, 2, 0  },
+   {  false,   true,    false,   0, 3, 0  },
+   {  false,   false,   false,   3, 3, 6  },
+   {  false,   true,    true,    3, 3, 8  },
+   {  false,   true,    false,   3, 3, 8  },
+   {  false,   true,    false,   0, 4, 8  },
+   {  true,    true,    false,   0, 6, 8  },
+   {  true,    true,    false,   0, 6, 12 },
+};
+
+static void SetLevel(FLAC::Encoder::Stream &encoder, unsigned channels,
+                     unsigned rate, int level)
+{
+   encoder.set_channels(channels);
+   encoder.set_sample_rate(rate);
+   encoder.set_bits_per_sample(16);
+   encoder.set_do_exhaustive_model_search(levels[level].exhaustive);
+   encoder.set_do_escape_coding(false);
+   encoder.set_do_mid_side_stereo(channels == 2 && levels[level].midSide);
+   encoder.set_loose_mid_side_stereo(channels == 2 && levels[level].looseMidSide);
+   encoder.set_qlp_coeff_precision(0);
+   encoder.set_min_residual_partition_order(levels[level].minPartitionOrder);
+   encoder.set_max_residual_partition_order(levels[level].maxPartitionOrder);
+   encoder.set_rice_parameter_search_dist(0);
+   encoder.set_max_lpc_order(levels[level].maxLpcOrder);
+}
+
+// Keeps the samples of a stream, interleaved
+class SampleDecoder : public FLAC::Decoder::File
+{
+public:
+   std::vector<FLAC__int32> mSamples;
+   bool mError;
+
+   SampleDecoder() : mError(false) {}
+
+protected:
+   virtual ::FLAC__StreamDecoderWriteStatus write_callback(
+      const ::FLAC__Frame *frame, const FLAC__int32 *const buffer[])
+   {
+      for (unsigned i = 0; i < frame->header.blocksize; i++)
+         for (unsigned c = 0; c < frame->header.channels; c++)
+            mSamples.push_back(buffer[c][i]);
+      return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+   }
+
+   virtual void error_callback(::FLAC__StreamDecoderErrorStatus)
+   {
+      mError = true;
+   }
+};
+
+// Encodes the same samples with one encoder and in segments, as the
+// export does, and compares the streams and what they decode to.
+class FLACSegmentTest {
+   unsigned channels;
+   unsigned rate;
+   unsigned length;
+   std::vector< std::vector<FLAC__int32> > samples;
+
+   static const char *SerialName() { return "flac-segment-test-serial.flac"; }
+   static const char *SegmentsName() { return "flac-segment-test-segments.flac"; }
+
+public:
+   FLACSegmentTest()
+   {
+      std::cout << "==> Testing FLACSegment and FLACStitcher\n";
+   }
+
+   void setUp(unsigned c, unsigned r, unsigned len) {
+      channels = c;
+      rate = r;
+      length = len;
+
+      // Tones with some noise, with the channels alike for a while and
+      // then not, so that stereo assignments change
+      srand(1);
+      samples.assign(channels, std::vector<FLAC__int32>(length));
+      for (unsigned i = 0; i < length; i++) {
+         for (unsigned ch = 0; ch < channels; ch++) {
+            double tone = sin(i * 0.01 * ((i / 20000) % 2 ? ch + 1 : 1));
+            samples[ch][i] = (FLAC__int32)(8000 * tone) + rand() % 200 - 100;
+         }
+      }
+   }
+
+   void tearDown() {
+      remove(SerialName());
+      remove(SegmentsName());
+   }
+
+   void encodeSerial(int level) {
+      // The block size left for libFLAC to choose, as ExportFLAC does
+      FLAC::Encoder::File encoder;
+      SetLevel(encoder, channels, rate, level);
+      assert(encoder.init(SerialName()) == FLAC__STREAM_ENCODER_INIT_STATUS_OK);
+
+      std::vector<const FLAC__int32 *> buffers(channels);
+      for (unsigned ch = 0; ch < channels; ch++)
+         buffers[ch] = &samples[ch][0];
+      assert(encoder.process(&buffers[0], length));
+      assert(encoder.finish());
+   }
+
+   void encodeSegments(int level) {
+      unsigned blockSize = FLACDefaultBlockSize(levels[level].maxLpcOrder);
+      unsigned framesPerSegment =
+         FLACFramesPerSegment(64, rate, blockSize,
+                              channels == 2 && levels[level].looseMidSide);
+      unsigned segmentLen = framesPerSegment * blockSize;
+      unsigned framesPerSeekPoint = 10 * rate / blockSize;
+
+      FLAC__StreamMetadata *seekTable =
+         ::FLAC__metadata_object_new(FLAC__METADATA_TYPE_SEEKTABLE);
+      ::FLAC__metadata_object_seektable_template_append_placeholders(seekTable,
+         length / blockSize / framesPerSeekPoint + 1);
+
+      wxFFile file;
+      assert(file.Open(wxT("flac-segment-test-segments.flac"), wxT("w+b")));
+      FLACStitcher stitcher(file, channels, 16, framesPerSeekPoint);
+
+      unsigned firstFrame = 0;
+      for (unsigned start = 0; start == 0 || start < length; start += segmentLen) {
+         unsigned len = wxMin(segmentLen, length - start);
+
+         FLACSegment segment(firstFrame, channels, segmentLen);
+         SetLevel(segment, channels, rate, level);
+         segment.set_blocksize(blockSize);
+         if (firstFrame == 0)
+            segment.set_metadata(&seekTable, 1);
+
+         for (unsigned ch = 0; ch < channels; ch++)
+            memcpy(segment.GetBuffers()[ch], &samples[ch][start],
+                   len * sizeof(FLAC__int32));
+         segment.SetLength(len);
+         stitcher.AddSamples(segment.GetBuffers(), len);
+
+         assert(segment.Encode());
+         assert(stitcher.Add(segment));
+         firstFrame += framesPerSegment;
+      }
+      assert(stitcher.Finish());
+      file.Close();
+
+      ::FLAC__metadata_object_delete(seekTable);
+   }
+
+   static std::vector<FLAC__byte> readFile(const char *name) {
+      std::vector<FLAC__byte> bytes;
+      FILE *fp = fopen(name, "rb");
+      assert(fp);
+      int c;
+      while ((c = fgetc(fp)) != EOF)
+         bytes.push_back((FLAC__byte)c);
+      fclose(fp);
+      return bytes;
+   }
+
+   // Offset of the first frame, after the metadata blocks
+   static size_t framesOffset(const std::vector<FLAC__byte> &bytes) {
+      size_t pos = 4;
+      for (;;) {
+         assert(pos + 4 <= bytes.size());
+         bool last = (bytes[pos] & 0x80) != 0;
+         pos += 4 + ((bytes[pos + 1] << 16) | (bytes[pos + 2] << 8) | bytes[pos + 3]);
+         if (last)
+            return pos;
+      }
+   }
+
+   void assertDecodes(const char *name) {
+      SampleDecoder decoder;
+      decoder.set_md5_checking(true);
+      assert(decoder.init(name) == FLAC__STREAM_DECODER_INIT_STATUS_OK);
+      assert(decoder.process_until_end_of_stream());
+      // finish() fails if the MD5 of the samples doesn't match STREAMINFO
+      assert(decoder.finish());
+      assert(!decoder.mError);
+
+      assert(decoder.mSamples.size() == (size_t)length * channels);
+      for (unsigned i = 0; i < length; i++)
+         for (unsigned ch = 0; ch < channels; ch++)
+            assert(decoder.mSamples[i * channels + ch] == samples[ch][i]);
+   }
+
+   void testLevel(int level) {
+      std::cout << "\tlevel " << level << ", " << channels << " channel(s) at "
+                << rate << " Hz should give the frames of one encoder...";
+      std::cout << std::flush;
+
+      encodeSerial(level);
+      encodeSegments(level);
+
+      std::vector<FLAC__byte> serial = readFile(SerialName());
+      std::vector<FLAC__byte> segments = readFile(SegmentsName());
+
+      // The STREAMINFO, with the frame sizes, the length and the MD5
+      assert(serial.size() >= 42 && segments.size() >= 42);
+      assert(memcmp(&serial[8], &segments[8], 34) == 0);
+
+      // The frames, after metadata that differs by the seek table
+      size_t serialFrames = framesOffset(serial);
+      size_t segmentFrames = framesOffset(segments);
+      assert(serial.size() - serialFrames == segments.size() - segmentFrames);
+      assert(memcmp(&serial[serialFrames], &segments[segmentFrames],
+                    serial.size() - serialFrames) == 0);
+
+      assertDecodes(SegmentsName());
+
+      std::cout << "OK\n";
+   }
+};
+
+int main()
+{
+   FLACSegmentTest tester;
+
+   // Lengths that end in a short segment and a short frame
+   for (int level = 0; level <= 8; level++) {
+      tester.setUp(2, 44100, 3 * 75 * 4096 + 12345);
+      tester.testLevel(level);
+      tester.tearDown();
+   }
+
+   // Other runs of loose mid-side stereo
+   tester.setUp(2, 48000, 2 * 65 * 4096 + 777);
+   tester.testLevel(1);
+   tester.testLevel(4);
+   tester.tearDown();
+
+   tester.setUp(1, 22050, 100 * 1152 + 5);
+   tester.testLevel(0);
+   tester.testLevel(5);
+   tester.tearDown();
+
+   return 0;
+}
+
+#else
+
+int main()
+{
+   std::cout << "==> FLACSegment needs libFLAC++ 1.1.3 or later; not tested\n";
+   return 0;
+}
+
+#endif
@@ -0,0 +1,178 @@
+
+#include <iostream>
+#include <ostream>
+#include <cmath>
+#include <cstdlib>
+#include <sys/time.h>
+
+#include "sbsms.h"
+
+using namespace _sbsms_;
+
+// Times a sliding tempo change of a few seconds of stereo audio through
+// SBSMS, with the stages of its pipeline run in turn on one thread and on
+// threads of their own, and checks that both give the same answer.  The
+// threads only exist when libsbsms is built with MULTITHREADED.  This is
+// a benchmark, not a test, so it is built by "make check" but not run by
+// it:
+//
+//    ./SBSMSBench [seconds] [rateStart] [rateEnd]
+
+class SBSMSBenchInterface : public SBSMSInterfaceSliding {
+public:
+   SBSMSBenchInterface(Slide *rateSlide, Slide *pitchSlide,
+                       audio *in, long len, SBSMSQuality *quality)
+   :  SBSMSInterfaceSliding(rateSlide, pitchSlide, false, len, 0, quality)
+   {
+      mIn = in;
+      mLen = len;
+      mPos = 0;
+   }
+
+   long samples(audio *buf, long n)
+   {
+      if (n > mLen - mPos)
+         n = mLen - mPos;
+      for (long i = 0; i < n; i++) {
+         buf[i][0] = mIn[mPos + i][0];
+         buf[i][1] = mIn[mPos + i][1];
+      }
+      mPos += n;
+      return n;
+   }
+
+private:
+   audio *mIn;
+   long mLen;
+   long mPos;
+};
+
+class SBSMSBench {
+   enum { rate = 44100, blockSize = 512 };
+
+   long mLen;
+   float mRateStart;
+   float mRateEnd;
+
+   audio *mIn;
+   audio *mSerial;
+   audio *mThreaded;
+   long mSerialLen;
+   long mThreadedLen;
+
+public:
+   SBSMSBench(double seconds, float rateStart, float rateEnd)
+   :  mLen((long)(seconds * rate)),
+      mRateStart(rateStart),
+      mRateEnd(rateEnd)
+   {
+      std::cout << "==> Benchmarking SBSMS, " << seconds << " s of stereo, rate "
+                << mRateStart << " to " << mRateEnd << "\n";
+
+      mIn = new audio[mLen];
+      srand(1);
+      for (long i = 0; i < mLen; i++) {
+         double t = i / (double)rate;
+         float noise = (rand() / (float)RAND_MAX) * 0.1f - 0.05f;
+         mIn[i][0] = 0.4f * sin(2 * M_PI * 440 * t) + noise;
+         mIn[i][1] = 0.4f * sin(2 * M_PI * 660 * t) * sin(2 * M_PI * 3 * t) + noise;
+      }
+
+      mSerial = NULL;
+      mThreaded = NULL;
+      mSerialLen = 0;
+      mThreadedLen = 0;
+   }
+
+   ~SBSMSBench()
+   {
+      delete[] mIn;
+      delete[] mSerial;
+      delete[] mThreaded;
+   }
+
+   double Seconds(const struct timeval & start)
+   {
+      struct timeval now;
+      gettimeofday(&now, NULL);
+      return (now.tv_sec - start.tv_sec) + (now.tv_usec - start.tv_usec) / 1e6;
+   }
+
+   // The same calls as EffectSBSMS makes for Sliding Time Scale
+   double Time(bool bMultithreaded, audio *&out, long &outLen)
+   {
+      Slide rateSlide(SlideLinearOutputRate, mRateStart, mRateEnd);
+      Slide pitchSlide(SlideIdentity);
+      SBSMSQuality quality(&SBSMSQualityStandard);
+#ifdef SBSMS_MULTITHREADED_OPTION
+      SBSMS sbsms(2, &quality, true, bMultithreaded);
+#else
+      SBSMS sbsms(2, &quality, true);
+#endif
+      SBSMSBenchInterface iface(&rateSlide, &pitchSlide, mIn, mLen, &quality);
+
+      long samplesOut = (long)iface.getSamplesToOutput();
+      out = new audio[samplesOut + blockSize];
+      outLen = 0;
+
+      struct timeval start;
+      gettimeofday(&start, NULL);
+      while (outLen < samplesOut) {
+         long n = sbsms.read(&iface, out + outLen, blockSize);
+         if (n == 0)
+            break;
+         outLen += n;
+      }
+      return Seconds(start);
+   }
+
+   bool Compare()
+   {
+      if (mSerialLen != mThreadedLen) {
+         std::cout << "Lengths differ: " << mSerialLen << " != " << mThreadedLen << "\n";
+         return false;
+      }
+
+      for (long i = 0; i < mSerialLen; i++) {
+         for (int c = 0; c < 2; c++) {
+            if (mSerial[i][c] != mThreaded[i][c]) {
+               std::cout << "Mismatch at sample " << i << ": " << mSerial[i][c]
+                         << " != " << mThreaded[i][c] << "\n";
+               return false;
+            }
+         }
+      }
+      return true;
+   }
+
+   bool Run()
+   {
+      double serial = Time(false, mSerial, mSerialLen);
+      double threaded = Time(true, mThreaded, mThreadedLen);
+
+      std::cout << "serial:   " << serial << " s, "
+                << mLen / serial << " samples/s\n";
+      std::cout << "threaded: " << threaded << " s, "
+                << mLen / threaded << " samples/s";
+      if (threaded > 0)
+         std::cout << " (" << serial / threaded << "x)";
+      std::cout << "\n";
+
+      if (!Compare())
+         return false;
+
+      std::cout << "OK\n";
+      return true;
+   }
+};
+
+int main(int argc, char *argv[])
+{
+   double seconds = argc > 1 ? atof(argv[1]) : 20.0;
+   float rateStart = argc > 2 ? (float)atof(argv[2]) : 1.0f;
+   float rateEnd = argc > 3 ? (float)atof(argv[3]) : 1.5f;
+
+   SBSMSBench bench(seconds, rateStart, rateEnd);
+
+   return bench.Run() ? 0 : 1;
+}
@@ -1,6 +1,9 @@
 
 #include "Sequence.h"
 #include "DirManager.h"
+#include "xml/XMLFileReader.h"
+#include "xml/XMLWriter.h"
+#include <wx/filefn.h>
 #include <wx/hash.h>
 #include <vector>
 #include <iostream>
@@ -81,7 +84,54 @@ public:
       delete mSequence;
       mSequence = NULL;
 
-      assert(mDirManager->blockFileHash->GetCount() == 0);
+      assert(mDirManager->mBlockFileHash.size() == 0);
+
+      std::cout << "ok\n";
+   }
+
+   void TestReplaceFromXML()
+   {
+      /* An auto-save journal replaces a clip by the one it reads, which
+       * names the same block files as the clip it replaces.  Read the
+       * replacement while the old sequence is still there, as the journal
+       * handler does, then delete the old one: the block files must stay
+       * for the new sequence. */
+
+      std::cout << "\ta sequence read from XML should keep the block files of the one it replaces..." << std::flush;
+
+      int len = (int)(mSequence->GetMaxBlockSize() * 3.5);
+      float *samples = new float[len];
+      int i;
+      for(i = 0; i < len; i++)
+         samples[i] = (float)(rand() % 2000 - 1000) / 1000.0f;
+      mSequence->Append((samplePtr)samples, floatSample, len);
+
+      wxString fileName = wxT("/tmp/sequence-test-replace.xml");
+      XMLFileWriter writer;
+      writer.Open(fileName, wxT("wb"));
+      mSequence->WriteXML(writer);
+      writer.Close();
+
+      Sequence *replacement = new Sequence(mDirManager, floatSample);
+      XMLFileReader reader;
+      assert(reader.Parse(replacement, fileName));
+      wxRemoveFile(fileName);
+
+      delete mSequence;
+      mSequence = replacement;
+
+      assert(mSequence->GetNumSamples() == len);
+      float *read = new float[len];
+      assert(mSequence->Get((samplePtr)read, floatSample, 0, len));
+      for(i = 0; i < len; i++)
+         assert(read[i] == samples[i]);
+
+      delete[] read;
+      delete[] samples;
+
+      delete mSequence;
+      mSequence = NULL;
+      assert(mDirManager->mBlockFileHash.size() == 0);
 
       std::cout << "ok\n";
    }
@@ -141,6 +191,10 @@ int main()
    tester.TestReferencing();
    tester.TearDown();
 
+   tester.SetUp();
+   tester.TestReplaceFromXML();
+   tester.TearDown();
+
    tester.SetUp();
    tester.TestSetGarbageInput();
    tester.TearDown();
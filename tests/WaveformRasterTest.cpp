@@ -0,0 +1,167 @@
+
+#include <iostream>
+#include <ostream>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "WaveformRaster.h"
+
+// Renders rasters of random columns and compares them with a plain
+// painting of the same spans, one pixel at a time, in drawing order.
+class WaveformRasterTest {
+   int width;
+   int height;
+   WaveformRaster *raster;
+   std::vector<unsigned char> expected;
+
+public:
+   WaveformRasterTest()
+   {
+      std::cout << "==> Testing WaveformRaster\n";
+   }
+
+   void setUp(int w, int h) {
+      width = w;
+      height = h;
+      raster = new WaveformRaster(width, height);
+      expected.assign(width * height, WaveformRaster::Blank);
+
+      for (int c = 0; c < WaveformRaster::NumColors; c++)
+         raster->SetColor((WaveformRaster::Color)c, c * 20, 255 - c * 20, c);
+   }
+
+   void tearDown() {
+      delete raster;
+   }
+
+   void paint(int x, int top, int bottom, unsigned char color) {
+      for (int y = top; y <= bottom; y++)
+         if (y >= 0 && y < height)
+            expected[y * width + x] = color;
+   }
+
+   int randomRow() {
+      // Sometimes outside of the raster
+      return rand() % (height + 4) - 2;
+   }
+
+   void assertRendered() {
+      std::vector<unsigned char> rgb(width * height * 3, 0xcd);
+      raster->Render(&rgb[0]);
+
+      unsigned char palette[WaveformRaster::NumColors][3];
+      for (int c = 0; c < WaveformRaster::NumColors; c++) {
+         palette[c][0] = c * 20;
+         palette[c][1] = 255 - c * 20;
+         palette[c][2] = c;
+      }
+
+      for (int i = 0; i < width * height; i++)
+         assert(memcmp(&rgb[i * 3], palette[expected[i]], 3) == 0);
+   }
+
+   void testBlank() {
+      std::cout << "\tan empty raster should be all blank...";
+      std::cout << std::flush;
+
+      assertRendered();
+
+      std::cout << "OK\n";
+   }
+
+   void testColumns() {
+      std::cout << "\tcolumns should be drawn like the spans painted in order...";
+      std::cout << std::flush;
+
+      std::vector<int> backTop1(width), backBottom1(width);
+      std::vector<int> backTop2(width), backBottom2(width);
+      std::vector<bool> selected(width);
+      std::vector<int> waveTop(width), waveBottom(width);
+      std::vector<int> rmsTop(width), rmsBottom(width);
+      std::vector<bool> clipped(width);
+
+      for (int x = 0; x < width; x++) {
+         backTop1[x] = randomRow();
+         backBottom1[x] = randomRow();
+         backTop2[x] = randomRow();
+         backBottom2[x] = randomRow();
+         selected[x] = (rand() % 2 == 0);
+         waveTop[x] = randomRow();
+         waveBottom[x] = randomRow();
+         rmsTop[x] = randomRow();
+         rmsBottom[x] = randomRow();
+         clipped[x] = (rand() % 10 == 0);
+
+         raster->SetBackground(x, backTop1[x], backBottom1[x],
+                               backTop2[x], backBottom2[x], selected[x]);
+         raster->SetWave(x, waveTop[x], waveBottom[x]);
+         raster->SetRms(x, rmsTop[x], rmsBottom[x]);
+         if (clipped[x])
+            raster->SetClipped(x);
+      }
+      int zeroLine = height / 2;
+      raster->SetZeroLine(zeroLine);
+
+      for (int x = 0; x < width; x++) {
+         unsigned char back =
+            selected[x] ? WaveformRaster::Selected : WaveformRaster::Unselected;
+         paint(x, backTop1[x], backBottom1[x], back);
+         paint(x, backTop2[x], backBottom2[x], back);
+         paint(x, zeroLine, zeroLine, WaveformRaster::ZeroLine);
+         paint(x, waveTop[x], waveBottom[x], WaveformRaster::Sample);
+         paint(x, rmsTop[x], rmsBottom[x], WaveformRaster::Rms);
+         if (clipped[x])
+            paint(x, 0, height - 1, WaveformRaster::Clipped);
+      }
+
+      assertRendered();
+
+      std::cout << "OK\n";
+   }
+
+   void testLoading() {
+      std::cout << "\tcolumns still loading should have stripes and a dot...";
+      std::cout << std::flush;
+
+      for (int x = 0; x < width; x += 3) {
+         int dotY = x % height;
+         raster->SetLoading(x, -1 - x % 2, dotY);
+
+         unsigned char stripe = (x % 2) ?
+            WaveformRaster::LoadingEven : WaveformRaster::LoadingOdd;
+         for (int y = x % 25; y < height; y += 25)
+            paint(x, y, y + 6, stripe);
+         paint(x, dotY, dotY, WaveformRaster::LoadingWave);
+      }
+
+      assertRendered();
+
+      std::cout << "OK\n";
+   }
+};
+
+int main()
+{
+   WaveformRasterTest tester;
+
+   tester.setUp(37, 23);
+   tester.testBlank();
+   tester.tearDown();
+
+   // Widths that are and aren't multiples of what may be done at once
+   tester.setUp(64, 40);
+   tester.testColumns();
+   tester.tearDown();
+
+   tester.setUp(1021, 97);
+   tester.testColumns();
+   tester.tearDown();
+
+   tester.setUp(300, 120);
+   tester.testLoading();
+   tester.tearDown();
+
+   return 0;
+}